@@ -0,0 +1,195 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <gphoto2/gphoto2.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CameraWidget.h"
+
+using std::string;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace gphotow
+{
+static const string NOT_A_GOOD_SERIAL = "NOT_A_GOOD_SERIAL";
+
+struct CameraPath
+{
+    string folder;
+    string name;
+
+    CameraPath() : folder(""), name("") {}
+
+    CameraPath(CameraFilePath path) : folder(path.folder), name(path.name) {}
+
+    string getPath() const { return folder + "/" + name; }
+
+    CameraFilePath toCameraFilePath() const
+    {
+        CameraFilePath path;
+        strcpy(path.name, name.c_str());
+        strcpy(path.folder, folder.c_str());
+
+        return path;
+    }
+};
+
+using CameraEvent = std::pair<CameraEventType, std::optional<CameraPath>>;
+
+/**
+ * @brief Interface of a camera, as used by the CameraController.
+ * Implemented by CameraWrapper for real cameras through libgphoto2, and by
+ * SimulatedCamera for hardware-free testing.
+ * Unless otherwise specified, all the methods throw GPhotoError (or another
+ * CameraException) on failure.
+ */
+class CameraBase
+{
+public:
+    struct ShutterSpeedConfig
+    {
+        int32_t shutter_speed;
+        bool bulb;
+    };
+
+    virtual ~CameraBase() {}
+
+    /**
+     * @brief Connects to a camera and returns its serial.
+     */
+    virtual string connect() = 0;
+
+    /**
+     * @brief Disconnects from a connected camera.
+     */
+    virtual bool disconnect() = 0;
+
+    /**
+     * @brief True if connected to a camera.
+     */
+    virtual bool isConnected() = 0;
+
+    /**
+     * @brief Polls the camera to see if it's responsive. Does not throw.
+     */
+    virtual bool isResponsive() = 0;
+
+    /**
+     * @brief Port the camera is opened on at the next connect(), eg:
+     * "usb:001,005". Empty to use the first camera found.
+     */
+    virtual string getPort()           = 0;
+    virtual void setPort(string port) = 0;
+
+    virtual string getSerialNumber() = 0;
+    virtual string getCameraInfo()   = 0;
+
+    /**
+     * @brief Returns the current exposure time in useconds.
+     */
+    virtual ShutterSpeedConfig getShutterSpeed() = 0;
+
+    /**
+     * @brief Sets the exposure time in useconds. Values longer than the
+     * longest available exposure time select bulb mode.
+     */
+    virtual void setShutterSpeed(int32_t shutter_speed) = 0;
+
+    /**
+     * @brief Lists all the available exposure times in useconds.
+     */
+    virtual vector<int32_t> getShutterSpeedChoices(
+        bool include_bulb = true) = 0;
+
+    /**
+     * @brief Returns the current aperture (F-Number * 100).
+     */
+    virtual int32_t getAperture()                = 0;
+    virtual void setAperture(int32_t aperture)   = 0;
+    virtual vector<int32_t> getApertureChoices() = 0;
+
+    virtual int32_t getISO()                = 0;
+    virtual void setISO(int32_t iso)        = 0;
+    virtual vector<int32_t> getIsoChoices() = 0;
+
+    virtual int getBatteryPercent()     = 0;
+    virtual string getExposureProgram() = 0;
+    virtual string getFocusMode()       = 0;
+    virtual void nextFocusMode()        = 0;
+    virtual int getFocalLength()        = 0;
+
+    virtual bool getLongExpNR()            = 0;
+    virtual void setLongExpNR(bool nr)     = 0;
+    virtual bool getAutoISO()              = 0;
+    virtual void setAutoISO(bool auto_iso) = 0;
+
+    virtual void setCaptureTarget(string capture_target) = 0;
+    virtual string getCaptureTarget()                    = 0;
+
+    virtual float getLightMeter()                         = 0;
+    virtual CameraWidgetRange::Range getLightMeterRange() = 0;
+
+    /**
+     * @brief Moves the lens focus by the given number of drive steps: positive
+     * values move it towards infinity, negative ones towards the closest
+     * focusing distance. Returns once the body accepted the move.
+     */
+    virtual void manualFocusDrive(int32_t steps) = 0;
+
+    /**
+     * @brief Runs a single autofocus cycle.
+     */
+    virtual void autoFocusDrive() = 0;
+
+    /**
+     * @brief Captures a photo with the current settings, using bulb mode if
+     * selected, and returns its path on the camera.
+     */
+    virtual CameraPath capture() = 0;
+
+    /**
+     * @brief Downloads a file from the camera to @p destination
+     */
+    virtual void downloadFile(CameraFilePath path, string destination) = 0;
+
+    /**
+     * @brief Waits up to @p timeout ms for an event from the camera. With a
+     * zero timeout it is the cheapest way to check that the camera is still
+     * answering, without touching its settings.
+     * @return GP_EVENT_TIMEOUT if no event was received
+     * @throw GPhotoError if the camera could not be queried
+     */
+    virtual CameraEvent waitForEvent(int timeout) = 0;
+};
+
+}  // namespace gphotow
@@ -8,6 +8,7 @@
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <system_error>
@@ -19,7 +20,9 @@
 using namespace std::this_thread;
 using std::bind;
 using std::max;
+using std::lock_guard;
 using std::min;
+using std::mutex;
 using std::optional;
 using std::pair;
 using std::stringstream;
@@ -43,6 +46,84 @@ bool endsWith (std::string const &fullString, std::string const &ending) {
 
 CameraWrapper::CameraWrapper() : context(gp_context_new()) {}
 
+CameraWrapper::CameraWrapper(string port)
+    : port(port), context(gp_context_new())
+{
+}
+
+vector<CameraWrapper::DetectedCamera> CameraWrapper::autodetect()
+{
+    CameraList* list;
+    int result = gp_list_new(&list);
+    if (result < GP_OK)
+        throw GPhotoError(result);
+
+    GPContext* ctx = gp_context_new();
+    result         = gp_camera_autodetect(list, ctx);
+
+    vector<DetectedCamera> cameras;
+    for (int i = 0; i < result; ++i)
+    {
+        const char* model;
+        const char* port;
+        gp_list_get_name(list, i, &model);
+        gp_list_get_value(list, i, &port);
+        cameras.push_back({model, port});
+    }
+
+    gp_list_free(list);
+    gp_context_unref(ctx);
+
+    if (result < GP_OK)
+        throw GPhotoError(result);
+
+    return cameras;
+}
+
+// Loading the port drivers takes a while, so the list is loaded once and
+// shared by all the cameras. Paths of the devices plugged later are added to
+// it by gp_port_info_list_lookup_path().
+static mutex port_list_mtx;
+static GPPortInfoList* port_list = nullptr;
+
+void CameraWrapper::selectPort()
+{
+    GPPortInfo info;
+    int result;
+    {
+        lock_guard<mutex> lock(port_list_mtx);
+        if (port_list == nullptr)
+        {
+            result = gp_port_info_list_new(&port_list);
+            if (result < GP_OK)
+            {
+                port_list = nullptr;
+                throw GPhotoError(result);
+            }
+
+            result = gp_port_info_list_load(port_list);
+            if (result < GP_OK)
+            {
+                gp_port_info_list_free(port_list);
+                port_list = nullptr;
+                throw GPhotoError(result);
+            }
+        }
+
+        result = gp_port_info_list_lookup_path(port_list, port.c_str());
+        if (result >= GP_OK)
+            result = gp_port_info_list_get_info(port_list, result, &info);
+    }
+
+    if (result >= GP_OK)
+        result = gp_camera_set_port_info(camera, info);
+    if (result >= GP_OK && has_abilities)
+        result = gp_camera_set_abilities(camera, abilities);
+
+    if (result < GP_OK)
+        throw GPhotoError(result);
+}
+
 CameraWrapper::~CameraWrapper() { disconnect(); }
 
 void CameraWrapper::freeCamera()
@@ -59,32 +140,65 @@ string CameraWrapper::connect()
 {
     if (!connected)
     {
-        int result = gp_camera_new(&camera);
-
-        if (result != GP_OK)
+        try
+        {
+            initCamera();
+        }
+        catch (GPhotoError& gpe)
         {
-            throw GPhotoError(result);
+            if (!has_abilities)
+                throw;
+
+            // May be a different model on the same port: probe it again
+            has_abilities = false;
+            initCamera();
         }
 
-        result = gp_camera_init(camera, context);
+        if (!port.empty())
+            has_abilities =
+                gp_camera_get_abilities(camera, &abilities) >= GP_OK;
+
+        serial = getSerialNumber();
+        updateBulbConfig();
+        // Sleep for 2 seconds to avoid errors if capturing too early
+        // std::this_thread::sleep_for(seconds(2));
+        connected = true;
+    }
+
+    return serial;
+}
+
+void CameraWrapper::initCamera()
+{
+    int result = gp_camera_new(&camera);
 
-        if (result == GP_OK)
+    if (result != GP_OK)
+    {
+        throw GPhotoError(result);
+    }
+
+    if (!port.empty())
+    {
+        try
         {
-            serial = getSerialNumber();
-            updateBulbConfig();
-            // Sleep for 2 seconds to avoid errors if capturing too early
-            // std::this_thread::sleep_for(seconds(2));
-            connected = true;
-            return serial;
+            selectPort();
         }
-        else
+        catch (GPhotoError& gpe)
         {
             gp_camera_free(camera);
-            throw GPhotoError(result);
+            camera = nullptr;
+            throw;
         }
     }
 
-    return serial;
+    result = gp_camera_init(camera, context);
+
+    if (result != GP_OK)
+    {
+        gp_camera_free(camera);
+        camera = nullptr;
+        throw GPhotoError(result);
+    }
 }
 
 bool CameraWrapper::disconnect()
@@ -344,6 +458,27 @@ CameraWidgetRange::Range CameraWrapper::getLightMeterRange()
     return widget.getRange();
 }
 
+void CameraWrapper::manualFocusDrive(int32_t steps)
+{
+    CameraWidgetRange widget{*this, CONFIG_MANUAL_FOCUS};
+    int32_t max_steps = static_cast<int32_t>(widget.getRange().max);
+
+    do
+    {
+        int32_t drive = max(-max_steps, min(steps, max_steps));
+        widget.setValue(static_cast<float>(drive));
+        widget.apply();
+        steps -= drive;
+    } while (steps != 0);
+}
+
+void CameraWrapper::autoFocusDrive()
+{
+    CameraWidgetToggle widget{*this, CONFIG_AUTOFOCUS};
+    widget.setValue(1);
+    widget.apply();
+}
+
 string CameraWrapper::getFocusMode()
 {
     CameraWidgetRadio widget{*this, CONFIG_FOCUS_MODE};
@@ -475,7 +610,10 @@ CameraEvent CameraWrapper::waitForEvent(int timeout)
 
     void* eventdata = nullptr;
     CameraEventType event_type;
-    gp_camera_wait_for_event(camera, timeout, &event_type, &eventdata, context);
+    int result = gp_camera_wait_for_event(camera, timeout, &event_type,
+                                          &eventdata, context);
+    if (result < GP_OK)
+        throw GPhotoError(result);
 
     optional<CameraPath> opt = std::nullopt;
 
@@ -36,6 +36,7 @@
 #include <utility>
 #include <vector>
 
+#include "CameraBase.h"
 #include "CameraExceptions.h"
 #include "CameraWidget.h"
 #include "PrintLogger.h"
@@ -51,44 +52,39 @@ using std::chrono::seconds;
 
 namespace gphotow
 {
-static const string NOT_A_GOOD_SERIAL = "NOT_A_GOOD_SERIAL";
-
-struct CameraPath
-{
-    string folder;
-    string name;
-
-    CameraPath() : folder(""), name("") {}
-
-    CameraPath(CameraFilePath path) : folder(path.folder), name(path.name) {}
-
-    string getPath() const { return folder + "/" + name; }
-
-    CameraFilePath toCameraFilePath() const
-    {
-        CameraFilePath path;
-        strcpy(path.name, name.c_str());
-        strcpy(path.folder, folder.c_str());
-
-        return path;
-    }
-};
-
-using CameraEvent = std::pair<CameraEventType, std::optional<CameraPath>>;
-
-class CameraWrapper
+/**
+ * @brief Camera implementation using libgphoto2
+ */
+class CameraWrapper : public CameraBase
 {
     friend class CameraWidgetBase;
 
 public:
-    struct ShutterSpeedConfig
+    /**
+     * @brief A camera found by autodetect()
+     */
+    struct DetectedCamera
     {
-        int32_t shutter_speed;
-        bool bulb;
+        string model;
+        string port;
     };
 
     CameraWrapper();
-    ~CameraWrapper();
+
+    /**
+     * @brief Creates a wrapper connecting to the camera on @p port, as
+     * returned by autodetect(). An empty port connects to the first camera
+     * found.
+     */
+    explicit CameraWrapper(string port);
+
+    ~CameraWrapper() override;
+
+    /**
+     * @brief Lists the cameras connected to the system
+     * @throw GPhotoError
+     */
+    static vector<DetectedCamera> autodetect();
 
     CameraWrapper(CameraWrapper const&) = delete;
     void operator=(CameraWrapper const&) = delete;
@@ -98,34 +94,37 @@ public:
      *
      * @throw GPhotoError
      */
-    string connect();
+    string connect() override;
 
     /**
      * @brief Disconnects from a connected camera.
      *
      */
-    bool disconnect();
+    bool disconnect() override;
 
     /**
      * @brief True if connected to a camera.
      *
      * @return Wether a camera is connected or not.
      */
-    bool isConnected();
+    bool isConnected() override;
 
     /**
      * @brief Pools the camera to see if it's responsive.
      *
      * @return Wether a camera is responsive or not.
      */
-    bool isResponsive();
+    bool isResponsive() override;
+
+    string getPort() override { return port; }
+    void setPort(string port) override { this->port = port; }
 
     /**
      * @brief Returns the serial number of the connected camera.
      * @throw GPhotoError
      * @return string Serial number
      */
-    string getSerialNumber();
+    string getSerialNumber() override;
 
     /**
      * @brief Returns the manufacturer of the connected camera.
@@ -154,14 +153,14 @@ public:
      * @throw GPhotoError
      * @return string Serial number
      */
-    string getCameraInfo();
+    string getCameraInfo() override;
 
     /**
      * @brief Returns the current exposure time in useconds.
      * @throw GPhotoError
      * @return exposure time in usec or 0 if error, -1 if BULB
      */
-    ShutterSpeedConfig getShutterSpeed();
+    ShutterSpeedConfig getShutterSpeed() override;
 
     /**
      * @brief Sets the exposure time
@@ -169,7 +168,7 @@ public:
      * @param    exposuretime Exposure time in us. Must be one of the values
      * returned in listExposureTimes
      */
-    void setShutterSpeed(int32_t shutter_speed);
+    void setShutterSpeed(int32_t shutter_speed) override;
 
     /**
      * @brief Lists all the available exposure times in the current exposure
@@ -177,7 +176,7 @@ public:
      * @throw GPhotoError
      * @return list of exposure times, or empty list if error.
      */
-    vector<int32_t> getShutterSpeedChoices(bool include_bulb = true);
+    vector<int32_t> getShutterSpeedChoices(bool include_bulb = true) override;
 
     /**
      * @brief Lists all the available exposure times in the current exposure
@@ -193,7 +192,7 @@ public:
      * @throw GPhotoError
      * @return F Number * 100, 0 if error
      */
-    int32_t getAperture();
+    int32_t getAperture() override;
 
     /**
      * @brief Sets the aperture
@@ -201,14 +200,14 @@ public:
      * @param    aperture F-Number * 100. Must be one of the values
      * returned in listApertures()
      */
-    void setAperture(int32_t aperture);
+    void setAperture(int32_t aperture) override;
 
     /**
      * @brief Lists all the available apertures.
      * @throw GPhotoError
      * @return list of apertures (F-Number * 100), or empty list if error.
      */
-    vector<int32_t> getApertureChoices();
+    vector<int32_t> getApertureChoices() override;
 
     /**
      * @brief Lists all the available apertures.
@@ -221,21 +220,21 @@ public:
      * @throw GPhotoError
      * @return ISO, 0 if error
      */
-    int32_t getISO();
+    int32_t getISO() override;
 
     /**
      * @brief Sets the aperture
      * @throw GPhotoError
      * @param    iso Must be one of the values returned in listISOs()
      */
-    void setISO(int32_t iso);
+    void setISO(int32_t iso) override;
 
     /**
      * @brief Lists all the available ISOs.
      * @throw GPhotoError
      * @return list of ISOs, or empty list if error.
      */
-    vector<int32_t> getIsoChoices();
+    vector<int32_t> getIsoChoices() override;
 
     /**
      * @brief Lists all the available ISOs.
@@ -249,25 +248,25 @@ public:
      * @throw GPhotoError
      * @return Battery percent, or -1 if error
      */
-    int getBatteryPercent();
+    int getBatteryPercent() override;
 
     /**
      * @brief Get the current Exposure Program of the camera
      * @throw GPhotoError
      */
-    string getExposureProgram();
+    string getExposureProgram() override;
 
     /**
      * @brief Get focus mode
      * @throw GPhotoError
      */
-    string getFocusMode();
+    string getFocusMode() override;
 
     /**
      * @brief Get focus mode
      * @throw GPhotoError
      */
-    void nextFocusMode();
+    void nextFocusMode() override;
 
     /**
      * @brief Returns the current trigger mode.
@@ -279,39 +278,52 @@ public:
      * @brief Returns the current focal length.
      * @throw GPhotoError
      */
-    int getFocalLength();
+    int getFocalLength() override;
 
-    bool getLongExpNR();
-    void setLongExpNR(bool nr);
+    bool getLongExpNR() override;
+    void setLongExpNR(bool nr) override;
 
-    bool getAutoISO();
+    bool getAutoISO() override;
 
-    void setAutoISO(bool auto_iso);
+    void setAutoISO(bool auto_iso) override;
 
     /**
      * @brief Sets the Capture Target
      * @throw GPhotoError
      */
-    void setCaptureTarget(string capture_target);
+    void setCaptureTarget(string capture_target) override;
 
     /**
      * @brief Gets the Capture Target
      * @throw GPhotoError
      */
-    string getCaptureTarget();
+    string getCaptureTarget() override;
 
-    float getLightMeter();
-    CameraWidgetRange::Range getLightMeterRange();
+    float getLightMeter() override;
+    CameraWidgetRange::Range getLightMeterRange() override;
 
-    CameraPath capture();
+    /**
+     * @brief Drives the focus by the given number of steps. Moves larger than
+     * the range of the widget are split in multiple drives.
+     * @throw GPhotoError
+     */
+    void manualFocusDrive(int32_t steps) override;
+
+    /**
+     * @brief Runs a single autofocus cycle
+     * @throw GPhotoError
+     */
+    void autoFocusDrive() override;
+
+    CameraPath capture() override;
     CameraPath cameraCapture();
     CameraPath bulbCapture(int exposure_time,
                            milliseconds timeout = seconds(60));
 
     void triggerCapture();
-    void downloadFile(CameraFilePath path, string destination);
+    void downloadFile(CameraFilePath path, string destination) override;
 
-    CameraEvent waitForEvent(int timeout);
+    CameraEvent waitForEvent(int timeout) override;
 
 private:
     /**
@@ -322,6 +334,20 @@ private:
 
     void freeCamera();
 
+    /**
+     * @brief Makes gp_camera_init() open the camera on the selected port,
+     * using the abilities found at the last connection if any, so that it
+     * does not need to load the camera drivers and probe the camera again.
+     * @throw GPhotoError
+     */
+    void selectPort();
+
+    /**
+     * @brief Creates the camera and runs gp_camera_init()
+     * @throw GPhotoError
+     */
+    void initCamera();
+
     void updateBulbConfig();
 
     vector<int32_t> choicesStringToInt(CameraWidgetRadio& widget,
@@ -330,8 +356,13 @@ private:
 
     bool connected = false;
 
+    string port   = "";
     string serial = "";
 
+    // Abilities of the camera found at the last connection on a port
+    CameraAbilities abilities;
+    bool has_abilities = false;
+
     unsigned int bulb_choice = 0;
     int max_shutter_speed    = 0;  // Maximum shutter speed without Bulb
     int bulb_shutter_speed   = 0;
@@ -0,0 +1,387 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SimulatedCamera.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#include "CameraExceptions.h"
+#include "CameraWrapper.h"
+
+using std::ofstream;
+using std::chrono::microseconds;
+using std::this_thread::sleep_for;
+
+namespace gphotow
+{
+
+static const vector<int32_t> SHUTTER_SPEEDS{
+    250,    500,    1000,   2000,    4000,    8000,    16667,   33333,  66667,
+    125000, 250000, 500000, 1000000, 2000000, 4000000, 8000000, 15000000,
+    30000000};
+
+static const vector<int32_t> APERTURES{180, 200, 280,  400, 560,
+                                       800, 1100, 1600, 2200};
+
+static const vector<int32_t> ISOS{100, 200, 400, 800, 1600, 3200, 6400, 12800};
+
+static const vector<string> FOCUS_MODES{"AF-S", "AF-C", "MF"};
+
+static constexpr size_t MAX_PENDING_EVENTS = 64;
+
+SimulatedCamera::SimulatedCamera(SimulatedCameraConfig config)
+    : cfg(config), rng(config.seed)
+{
+}
+
+void SimulatedCamera::checkOperation()
+{
+    if (!connected || unplugged)
+        throw GPhotoError(GP_ERROR_IO);
+
+    if (cfg.failure_rate > 0 &&
+        std::uniform_real_distribution<float>{0, 1}(rng) < cfg.failure_rate)
+    {
+        ++stats.failures;
+        throw GPhotoError(GP_ERROR_IO);
+    }
+}
+
+void SimulatedCamera::configOp()
+{
+    sleep_for(cfg.config_rtt);
+    ++stats.config_ops;
+    checkOperation();
+}
+
+void SimulatedCamera::checkExposureWritable()
+{
+    if (exposure_locked)
+        throw GPhotoError(GP_ERROR_NOT_SUPPORTED);
+}
+
+string SimulatedCamera::connect()
+{
+    if (!connected)
+    {
+        sleep_for(cfg.connect_time);
+
+        if (unplugged)
+            throw GPhotoError(GP_ERROR_MODEL_NOT_FOUND);
+
+        if (cfg.failure_rate > 0 &&
+            std::uniform_real_distribution<float>{0, 1}(rng) <
+                cfg.failure_rate)
+        {
+            ++stats.failures;
+            throw GPhotoError(GP_ERROR_MODEL_NOT_FOUND);
+        }
+
+        connected = true;
+        LOG_INFO(log, "Connected to simulated camera");
+    }
+    return cfg.serial;
+}
+
+bool SimulatedCamera::disconnect()
+{
+    if (connected)
+    {
+        connected = false;
+        events.clear();
+        return true;
+    }
+    return false;
+}
+
+bool SimulatedCamera::isConnected() { return connected; }
+
+bool SimulatedCamera::isResponsive()
+{
+    try
+    {
+        return getSerialNumber() == cfg.serial;
+    }
+    catch (CameraException& e)
+    {
+        return false;
+    }
+}
+
+string SimulatedCamera::getSerialNumber()
+{
+    configOp();
+    return cfg.serial;
+}
+
+string SimulatedCamera::getCameraInfo()
+{
+    configOp();
+    return "Simulated Camera (1.0) SN:" + cfg.serial;
+}
+
+CameraBase::ShutterSpeedConfig SimulatedCamera::getShutterSpeed()
+{
+    configOp();
+    if (bulb)
+        return {.shutter_speed = bulb_time, .bulb = true};
+    else
+        return {.shutter_speed = SHUTTER_SPEEDS.at(shutter_speed_id),
+                .bulb          = false};
+}
+
+void SimulatedCamera::setShutterSpeed(int32_t shutter_speed)
+{
+    configOp();
+    checkExposureWritable();
+    if (shutter_speed > SHUTTER_SPEEDS.back())
+    {
+        bulb      = true;
+        bulb_time = shutter_speed;
+    }
+    else
+    {
+        bulb = false;
+        shutter_speed_id =
+            CameraStringConversion::findNearest(SHUTTER_SPEEDS, shutter_speed);
+    }
+}
+
+vector<int32_t> SimulatedCamera::getShutterSpeedChoices(bool include_bulb)
+{
+    configOp();
+    vector<int32_t> choices = SHUTTER_SPEEDS;
+    if (include_bulb)
+        choices.push_back(-1);
+    return choices;
+}
+
+int32_t SimulatedCamera::getAperture()
+{
+    configOp();
+    return APERTURES.at(aperture_id);
+}
+
+void SimulatedCamera::setAperture(int32_t aperture)
+{
+    configOp();
+    checkExposureWritable();
+    aperture_id = CameraStringConversion::findNearest(APERTURES, aperture);
+}
+
+vector<int32_t> SimulatedCamera::getApertureChoices()
+{
+    configOp();
+    return APERTURES;
+}
+
+int32_t SimulatedCamera::getISO()
+{
+    configOp();
+    return ISOS.at(iso_id);
+}
+
+void SimulatedCamera::setISO(int32_t iso)
+{
+    configOp();
+    checkExposureWritable();
+    iso_id = CameraStringConversion::findNearest(ISOS, iso);
+}
+
+vector<int32_t> SimulatedCamera::getIsoChoices()
+{
+    configOp();
+    return ISOS;
+}
+
+int SimulatedCamera::getBatteryPercent()
+{
+    configOp();
+    return 100;
+}
+
+string SimulatedCamera::getExposureProgram()
+{
+    configOp();
+    return "M";
+}
+
+string SimulatedCamera::getFocusMode()
+{
+    configOp();
+    return FOCUS_MODES.at(focus_mode_id);
+}
+
+void SimulatedCamera::nextFocusMode()
+{
+    configOp();
+    focus_mode_id = (focus_mode_id + 1) % FOCUS_MODES.size();
+}
+
+int SimulatedCamera::getFocalLength()
+{
+    configOp();
+    return 50;
+}
+
+bool SimulatedCamera::getLongExpNR()
+{
+    configOp();
+    return long_exp_nr;
+}
+
+void SimulatedCamera::setLongExpNR(bool nr)
+{
+    configOp();
+    long_exp_nr = nr;
+}
+
+bool SimulatedCamera::getAutoISO()
+{
+    configOp();
+    return auto_iso;
+}
+
+void SimulatedCamera::setAutoISO(bool auto_iso)
+{
+    configOp();
+    this->auto_iso = auto_iso;
+}
+
+void SimulatedCamera::setCaptureTarget(string capture_target)
+{
+    configOp();
+    this->capture_target = capture_target;
+}
+
+string SimulatedCamera::getCaptureTarget()
+{
+    configOp();
+    return capture_target;
+}
+
+float SimulatedCamera::getLightMeter()
+{
+    configOp();
+    return std::normal_distribution<float>{cfg.light_meter, 0.5f}(rng);
+}
+
+CameraWidgetRange::Range SimulatedCamera::getLightMeterRange()
+{
+    configOp();
+    return {.min = -5, .max = 5, .step = 0.1f};
+}
+
+void SimulatedCamera::manualFocusDrive(int32_t steps)
+{
+    configOp();
+    sleep_for(cfg.focus_step_time * std::abs(steps));
+    focus_position += steps;
+    ++stats.focus_drives;
+}
+
+void SimulatedCamera::autoFocusDrive()
+{
+    configOp();
+    sleep_for(cfg.autofocus_time);
+    ++stats.focus_drives;
+}
+
+CameraPath SimulatedCamera::capture()
+{
+    checkOperation();
+
+    int32_t exposure = bulb ? bulb_time : SHUTTER_SPEEDS.at(shutter_speed_id);
+    if (cfg.wait_exposure)
+    {
+        // Long exposure noise reduction takes a dark frame as long as the
+        // exposure itself
+        sleep_for(microseconds(long_exp_nr ? 2 * exposure : exposure));
+    }
+    sleep_for(cfg.capture_time);
+
+    CameraPath p;
+    p.folder = "/store_00010001/DCIM/100SIMCM";
+    p.name   = fmt::format("DSC_{:04}.JPG", file_counter++ % 10000);
+
+    events.push_back({GP_EVENT_FILE_ADDED, p});
+    events.push_back({GP_EVENT_CAPTURE_COMPLETE, std::nullopt});
+
+    // Nobody may be waiting for the events: only keep the most recent ones
+    while (events.size() > MAX_PENDING_EVENTS)
+        events.pop_front();
+
+    ++stats.captures;
+    return p;
+}
+
+void SimulatedCamera::downloadFile(CameraFilePath path, string destination)
+{
+    checkOperation();
+
+    if (cfg.usb_throughput > 0)
+        sleep_for(microseconds(cfg.file_size * 1000000 / cfg.usb_throughput));
+
+    if (cfg.write_files)
+    {
+        ofstream out{destination, std::ios::binary};
+        if (!out)
+            throw CameraException("Cannot open file " + destination);
+
+        vector<char> buf(64 * 1024, 0);
+        for (uint64_t written = 0; written < cfg.file_size;
+             written += buf.size())
+        {
+            out.write(buf.data(),
+                      std::min<uint64_t>(buf.size(), cfg.file_size - written));
+        }
+    }
+
+    ++stats.downloads;
+    stats.bytes_downloaded += cfg.file_size;
+}
+
+CameraEvent SimulatedCamera::waitForEvent(int timeout)
+{
+    sleep_for(cfg.event_rtt);
+    checkOperation();
+
+    if (body_change.exchange(false))
+    {
+        iso_id = (iso_id + 1) % ISOS.size();
+        return {GP_EVENT_UNKNOWN, std::nullopt};
+    }
+
+    if (events.empty())
+    {
+        sleep_for(milliseconds(timeout));
+        return {GP_EVENT_TIMEOUT, std::nullopt};
+    }
+
+    CameraEvent ev = events.front();
+    events.pop_front();
+    return ev;
+}
+
+}  // namespace gphotow
@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CameraBase.h"
+#include "PrintLogger.h"
+
+using std::deque;
+using std::string;
+using std::vector;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+namespace gphotow
+{
+
+/**
+ * @brief Behaviour of a SimulatedCamera
+ */
+struct SimulatedCameraConfig
+{
+    // Serial number reported by the camera
+    string serial = "SIM000001";
+
+    // Time needed to connect to the camera
+    milliseconds connect_time{200};
+    // Round trip time of each config read or write
+    milliseconds config_rtt{10};
+    // Round trip time of each check for camera events
+    microseconds event_rtt{500};
+    // Time needed to capture a photo, on top of the exposure time
+    milliseconds capture_time{150};
+    // Whether captures also take the selected exposure time
+    bool wait_exposure = true;
+    // Time needed to move the focus by one lens drive step
+    microseconds focus_step_time{50};
+    // Time needed for an autofocus cycle
+    milliseconds autofocus_time{300};
+
+    // Size of each captured file, in bytes
+    uint64_t file_size = 8000000;
+    // Download speed, in bytes per second
+    uint64_t usb_throughput = 20000000;
+    // Actually write the downloaded files to disk
+    bool write_files = false;
+
+    // Mean of the light meter readings, in EV
+    float light_meter = 0;
+
+    // Probability of each operation failing with GP_ERROR_IO
+    float failure_rate = 0;
+    // Seed for the failure injection and the light meter noise
+    uint32_t seed = 0;
+};
+
+/**
+ * @brief In-process camera simulator, modelling the latencies, file sizes and
+ * event sequences of a real camera, with optional failure injection.
+ * Every capture queues a GP_EVENT_FILE_ADDED followed by a
+ * GP_EVENT_CAPTURE_COMPLETE, returned by waitForEvent(). Settings changed on
+ * the body are reported as GP_EVENT_UNKNOWN, like libgphoto2 does.
+ */
+class SimulatedCamera : public CameraBase
+{
+public:
+    struct Stats
+    {
+        std::atomic<uint64_t> config_ops{0};
+        std::atomic<uint64_t> captures{0};
+        std::atomic<uint64_t> downloads{0};
+        std::atomic<uint64_t> bytes_downloaded{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> focus_drives{0};
+    };
+
+    SimulatedCamera(SimulatedCameraConfig config = {});
+
+    SimulatedCamera(const SimulatedCamera&) = delete;
+    SimulatedCamera& operator=(const SimulatedCamera&) = delete;
+
+    const Stats& getStats() const { return stats; }
+
+    /**
+     * @brief Position of the simulated focus, in lens drive steps from the
+     * initial one
+     */
+    int32_t getFocusPosition() const { return focus_position; }
+
+    /**
+     * @brief Simulates a setting being changed on the body: the ISO is
+     * increased and a property change event is queued. Can be called from any
+     * thread.
+     */
+    void simulateBodyChange() { body_change = true; }
+
+    /**
+     * @brief Simulates the camera being unplugged or plugged back: while
+     * unplugged every operation fails. Can be called from any thread.
+     */
+    void setUnplugged(bool unplugged) { this->unplugged = unplugged; }
+
+    /**
+     * @brief Simulates the exposure being locked on the body (eg. the mode
+     * dial not in M): while locked, setting the shutter speed, aperture or ISO
+     * fails with GP_ERROR_NOT_SUPPORTED, but the camera keeps answering. Can
+     * be called from any thread.
+     */
+    void setExposureLocked(bool locked) { exposure_locked = locked; }
+
+    string connect() override;
+    bool disconnect() override;
+    bool isConnected() override;
+    bool isResponsive() override;
+
+    string getPort() override { return port; }
+    void setPort(string port) override { this->port = port; }
+
+    string getSerialNumber() override;
+    string getCameraInfo() override;
+
+    ShutterSpeedConfig getShutterSpeed() override;
+    void setShutterSpeed(int32_t shutter_speed) override;
+    vector<int32_t> getShutterSpeedChoices(bool include_bulb = true) override;
+
+    int32_t getAperture() override;
+    void setAperture(int32_t aperture) override;
+    vector<int32_t> getApertureChoices() override;
+
+    int32_t getISO() override;
+    void setISO(int32_t iso) override;
+    vector<int32_t> getIsoChoices() override;
+
+    int getBatteryPercent() override;
+    string getExposureProgram() override;
+    string getFocusMode() override;
+    void nextFocusMode() override;
+    int getFocalLength() override;
+
+    bool getLongExpNR() override;
+    void setLongExpNR(bool nr) override;
+    bool getAutoISO() override;
+    void setAutoISO(bool auto_iso) override;
+
+    void setCaptureTarget(string capture_target) override;
+    string getCaptureTarget() override;
+
+    float getLightMeter() override;
+    CameraWidgetRange::Range getLightMeterRange() override;
+
+    void manualFocusDrive(int32_t steps) override;
+    void autoFocusDrive() override;
+
+    CameraPath capture() override;
+    void downloadFile(CameraFilePath path, string destination) override;
+    CameraEvent waitForEvent(int timeout) override;
+
+private:
+    /**
+     * @brief Simulates a config round trip: checks the connection, waits
+     * config_rtt and injects failures.
+     * @throw GPhotoError
+     */
+    void configOp();
+
+    /**
+     * @brief Throws GPhotoError if not connected or if a failure is injected
+     */
+    void checkOperation();
+
+    /**
+     * @brief Throws GPhotoError if the exposure is locked
+     */
+    void checkExposureWritable();
+
+    SimulatedCameraConfig cfg;
+    Stats stats;
+
+    std::mt19937 rng;
+
+    bool connected = false;
+    string port    = "";
+
+    int shutter_speed_id   = 10;
+    bool bulb              = false;
+    int bulb_time          = 0;
+    int aperture_id        = 3;
+    int iso_id             = 0;
+    int focus_mode_id      = 0;
+    int32_t focus_position = 0;
+    bool long_exp_nr       = false;
+    bool auto_iso          = false;
+    string capture_target  = "Internal RAM";
+
+    unsigned int file_counter = 0;
+    deque<CameraEvent> events;
+    std::atomic<bool> body_change{false};
+    std::atomic<bool> unplugged{false};
+    std::atomic<bool> exposure_locked{false};
+
+    PrintLogger log = Logging::getLogger("SimCamera");
+};
+
+}  // namespace gphotow
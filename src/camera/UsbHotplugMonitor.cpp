@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "UsbHotplugMonitor.h"
+
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "EventBroker.h"
+#include "Events.h"
+
+using std::ifstream;
+using std::make_shared;
+using std::filesystem::path;
+
+UsbHotplugMonitor::UsbHotplugMonitor(string sysfs_root)
+    : ActiveObject(ThreadSpec{"hotplug"}), sysfs_root(sysfs_root)
+{
+}
+
+UsbHotplugMonitor::~UsbHotplugMonitor()
+{
+    stop();
+    if (sock >= 0)
+        close(sock);
+}
+
+bool UsbHotplugMonitor::start()
+{
+    if (sock < 0)
+    {
+        sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC,
+                      NETLINK_KOBJECT_UEVENT);
+        if (sock < 0)
+        {
+            LOG_ERR(log, "Cannot open the uevent socket: {}", strerror(errno));
+            return false;
+        }
+
+        sockaddr_nl addr{};
+        addr.nl_family = AF_NETLINK;
+        addr.nl_pid    = 0;
+        // Kernel messages, not the ones re-broadcast by udev
+        addr.nl_groups = 1;
+
+        if (bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0)
+        {
+            LOG_ERR(log, "Cannot bind the uevent socket: {}", strerror(errno));
+            close(sock);
+            sock = -1;
+            return false;
+        }
+    }
+
+    return ActiveObject::start();
+}
+
+void UsbHotplugMonitor::run()
+{
+    char buf[4096];
+    pollfd pfd{sock, POLLIN, 0};
+
+    while (!shouldStop())
+    {
+        int ret = poll(&pfd, 1, POLL_TIMEOUT_MS);
+        if (ret <= 0)
+            continue;
+
+        ssize_t len = recv(sock, buf, sizeof(buf), 0);
+        if (len <= 0)
+            continue;
+
+        if (EventPtr ev = parseUevent(buf, len))
+        {
+            LOG_DEBUG(log, "{}", ev->to_string());
+            sBroker.post(ev, TOPIC_CAMERA_CMD);
+        }
+    }
+}
+
+EventPtr UsbHotplugMonitor::parseUevent(const char* msg, size_t len) const
+{
+    // "action@devpath" followed by null terminated KEY=VALUE pairs
+    map<string, string> env;
+    size_t i = strnlen(msg, len) + 1;
+    while (i < len)
+    {
+        string entry{msg + i, strnlen(msg + i, len - i)};
+        i += entry.size() + 1;
+
+        size_t eq = entry.find('=');
+        if (eq != string::npos)
+            env[entry.substr(0, eq)] = entry.substr(eq + 1);
+    }
+
+    if (env["SUBSYSTEM"] != "usb")
+        return nullptr;
+
+    const string& action = env["ACTION"];
+    if (action == "add" && env["DEVTYPE"] == "usb_interface" &&
+        env["INTERFACE"].rfind(STILL_IMAGE_CLASS, 0) == 0)
+    {
+        // The bus and device numbers are attributes of the parent device
+        string device = path{env["DEVPATH"]}.parent_path().string();
+        string busnum = readSysfsAttr(device, "busnum");
+        string devnum = readSysfsAttr(device, "devnum");
+        if (busnum.empty() || devnum.empty())
+            return nullptr;
+
+        return make_shared<const EventUsbDeviceAdded>(
+            portName(busnum, devnum));
+    }
+    else if (action == "remove" && env["DEVTYPE"] == "usb_device")
+    {
+        // Whether it was a camera cannot be told anymore
+        return make_shared<const EventUsbDeviceRemoved>(
+            portName(env["BUSNUM"], env["DEVNUM"]));
+    }
+
+    return nullptr;
+}
+
+string UsbHotplugMonitor::portName(const string& busnum,
+                                   const string& devnum)
+{
+    // Same format as the gphoto USB port paths
+    return fmt::format("usb:{:0>3},{:0>3}", busnum, devnum);
+}
+
+string UsbHotplugMonitor::readSysfsAttr(const string& devpath,
+                                        const string& attr) const
+{
+    ifstream f{path{sysfs_root} / path{devpath}.relative_path() / attr};
+    string value;
+    f >> value;
+    return value;
+}
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include "EventBase.h"
+#include "utils/ActiveObject.h"
+#include "utils/logger/PrintLogger.h"
+
+using std::map;
+using std::string;
+
+/**
+ * @brief Listens to the kernel USB hot-plug notifications (the same ones
+ * udev receives) and posts EventUsbDeviceAdded when a still image device
+ * (PTP camera) appears and EventUsbDeviceRemoved when a USB device goes away,
+ * on TOPIC_CAMERA_CMD, with the gphoto port of the device (eg: usb:001,005).
+ */
+class UsbHotplugMonitor : public ActiveObject
+{
+public:
+    /**
+     * @param sysfs_root Where sysfs is mounted, used to find the bus and
+     * device number of the cameras being added
+     */
+    UsbHotplugMonitor(string sysfs_root = "/sys");
+
+    ~UsbHotplugMonitor();
+
+    /**
+     * @brief Opens the netlink socket and starts listening
+     * @return False if the notifications are not available, eg: in a
+     * container. The cameras are still recovered by the periodic retries.
+     */
+    bool start() override;
+
+    /**
+     * @brief Converts a kernel uevent message into the event to post
+     * @return nullptr if the message is not about a camera
+     */
+    EventPtr parseUevent(const char* msg, size_t len) const;
+
+protected:
+    void run() override;
+
+private:
+    // USB interface class of still image devices (PTP)
+    static constexpr const char* STILL_IMAGE_CLASS = "6/";
+    // How often to check if the monitor should stop
+    static constexpr int POLL_TIMEOUT_MS = 200;
+
+    static string portName(const string& busnum, const string& devnum);
+
+    string readSysfsAttr(const string& devpath, const string& attr) const;
+
+    string sysfs_root;
+    int sock = -1;
+
+    PrintLogger log = Logging::getLogger("Hotplug");
+};
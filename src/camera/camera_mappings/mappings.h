@@ -46,5 +46,7 @@ static const string CONFIG_LONG_EXP_NR      = "longexpnr";
 static const string CONFIG_LIGHT_METER      = "lightmeter";
 static const string CONFIG_FOCUS_MODE       = "focusmode";
 static const string CONFIG_AUTO_ISO         = "autoiso";
+static const string CONFIG_MANUAL_FOCUS     = "manualfocusdrive";
+static const string CONFIG_AUTOFOCUS        = "autofocusdrive";
 
 
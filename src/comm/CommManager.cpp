@@ -22,50 +22,280 @@
 
 #include "CommManager.h"
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
-#include "EventBroker.h"
 #include "Events.h"
+#include "JsonReader.h"
 
 using namespace nlohmann;
 using namespace std::placeholders;
 
-CommManager::CommManager(uint16_t port)
-    : server(port, std::bind(&CommManager::messageHandler, this, _1))
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+CommManager::CommManager(uint16_t port, float max_rate)
+    : ActiveObject(ThreadSpecs::network("comm")),
+      default_filter{defaultTopics(), {}, max_rate}, filter(default_filter),
+      server(port, std::bind(&CommManager::messageHandler, this, _1),
+             std::bind(&CommManager::onConnection, this, _1))
+{
+    tap_id = sEventBroker.addTap(std::bind(&CommManager::onEvent, this, _1, _2),
+                                 default_filter.topics);
+
+    start();
+}
+
+CommManager::~CommManager()
 {
-    sEventBroker.subscribe(this, TOPIC_CAMERA_CONFIG);
-    sEventBroker.subscribe(this, TOPIC_CAMERA_EVENT);
-    sEventBroker.subscribe(this, TOPIC_MODE_STATE);
-    sEventBroker.subscribe(this, TOPIC_HEARTBEAT);
+    sEventBroker.removeTap(tap_id);
+    stop();
 }
 
-CommManager::~CommManager() { sEventBroker.unsubscribe(this); }
+void CommManager::stop()
+{
+    if (started && !stopped)
+    {
+        {
+            lock_guard<mutex> lock(mtx);
+            should_stop = true;
+        }
+        cv.notify_one();
+
+        if (thread_obj->joinable())
+            thread_obj->join();
+        stopped = true;
+    }
+}
 
-void CommManager::doPostEvent(const EventPtr& ev)
+TopicMask CommManager::defaultTopics()
 {
-    if(server.isConnected())
-        server.send(ev->to_json());
+    TopicMask topics;
+    topics.set(TOPIC_CAMERA_CONFIG)
+        .set(TOPIC_CAMERA_EVENT)
+        .set(TOPIC_MODE_STATE)
+        .set(TOPIC_HEARTBEAT)
+        .set(TOPIC_DIAGNOSTICS);
+    return topics;
 }
 
-void CommManager::messageHandler(const nlohmann::json& j)
+void CommManager::onEvent(const EventPtr& ev, uint8_t topic)
 {
-    if (j.contains("event_id"))  // Event json
+    bool connected = server.isConnected();
+    if (topic != TOPIC_CAMERA_CONFIG && !connected)
+        return;
+
     {
-        if (j.at("event_id").is_number_unsigned())
+        lock_guard<mutex> lock(mtx);
+
+        // Serialized into the snapshot by the forwarder thread, not here on
+        // the thread of the publisher
+        bool notify = topic == TOPIC_CAMERA_CONFIG &&
+                      snapshot_queue.push(ev, true);
+
+        if (connected && filter.topics.test(topic) &&
+            (filter.events.empty() || filter.events.count(ev->getID())))
         {
-            try
-            {
-                sBroker.post(jsonToEvent(j), TOPIC_REMOTE_CMD);
-            }
-            catch (nlohmann::json::exception& jsone)
-            {
-                LOG_ERR(log, "Could not parse JSON to Event: what: {} json: {}",
-                        jsone.what(), j.dump());
-            }
+            notify = queue.push(ev, isCoalescable(ev)) || notify;
         }
-        else
+
+        if (!notify)
+            return;
+    }
+    cv.notify_one();
+}
+
+void CommManager::updateSnapshot()
+{
+    lock_guard<mutex> snapshot_lock(mtx_snapshot);
+
+    vector<EventPtr> events;
+    {
+        lock_guard<mutex> lock(mtx);
+        while (!snapshot_queue.empty())
+            events.push_back(snapshot_queue.pop());
+    }
+
+    for (const EventPtr& ev : events)
+        snapshot.update(ev);
+}
+
+void CommManager::onConnection(bool connected)
+{
+    lock_guard<mutex> lock(mtx);
+
+    // Filters are per client: start from the defaults, and forget anything
+    // that was meant for the previous one
+    filter = default_filter;
+    queue.clear();
+
+    if (!connected)
+    {
+        LOG_DEBUG(log, "Client disconnected. Coalesced: {}, dropped: {}",
+                  queue.getCoalescedCount(), queue.getDroppedCount());
+    }
+}
+
+void CommManager::run()
+{
+    steady_clock::time_point next_send = steady_clock::now();
+
+    unique_lock<mutex> lock(mtx);
+    while (!shouldStop())
+    {
+        cv.wait(lock,
+                [&] {
+                    return shouldStop() || !queue.empty() ||
+                           !snapshot_queue.empty();
+                });
+        if (shouldStop())
+            break;
+
+        if (!snapshot_queue.empty())
+        {
+            lock.unlock();
+            updateSnapshot();
+            lock.lock();
+            continue;
+        }
+
+        auto now = steady_clock::now();
+        if (now < next_send)
         {
-            LOG_ERR(log, "Received invalid event: {}", j.dump());
+            cv.wait_until(lock, next_send, [&] { return shouldStop(); });
+            continue;
         }
+
+        // Let events accumulate (and coalesce) while the socket is busy
+        if (server.getOutgoingCount() > 0)
+        {
+            lock.unlock();
+            server.waitOutgoingCount(0, BUSY_WAIT_TIMEOUT);
+            lock.lock();
+            continue;
+        }
+
+        EventPtr ev = queue.pop();
+        if (filter.max_rate > 0)
+            next_send = now + microseconds((int64_t)(1e6f / filter.max_rate));
+
+        lock.unlock();
+        json_buf.clear();
+        ev->write_json(json_buf);
+        server.sendSerialized({json_buf.data(), json_buf.size()});
+        lock.lock();
     }
-}
\ No newline at end of file
+}
+
+bool CommManager::isCoalescable(const EventPtr& ev)
+{
+    auto it = coalescable.find(ev->getID());
+    if (it == coalescable.end())
+    {
+        it = coalescable
+                 .emplace(ev->getID(),
+                          ev->name().starts_with("EventConfigValue"))
+                 .first;
+    }
+    return it->second;
+}
+
+void CommManager::configure(const nlohmann::json& j)
+{
+    try
+    {
+        CommFilter f = default_filter;
+
+        if (j.contains("topics"))
+        {
+            f.topics.reset();
+            for (uint8_t t : j.at("topics").get<std::vector<uint8_t>>())
+                f.topics.set(t);
+        }
+
+        if (j.contains("events"))
+            f.events = j.at("events").get<std::set<uint16_t>>();
+
+        if (j.contains("max_rate"))
+            f.max_rate = std::max(j.at("max_rate").get<float>(), 0.0f);
+
+        // Events on topics outside the default ones are not tapped
+        if ((f.topics & ~default_filter.topics).any())
+        {
+            LOG_WARN(log, "Only topics forwarded by default can be selected");
+            f.topics &= default_filter.topics;
+        }
+
+        LOG_INFO(log, "Client filter: {} topics, {} events, max rate: {}",
+                 f.topics.count(), f.events.size(), f.max_rate);
+
+        lock_guard<mutex> lock(mtx);
+        filter = f;
+    }
+    catch (nlohmann::json::exception& jsone)
+    {
+        LOG_ERR(log, "Invalid comm_config: what: {} json: {}", jsone.what(),
+                j.dump());
+    }
+}
+
+void CommManager::syncConfig(const nlohmann::json& j)
+{
+    try
+    {
+        uint64_t epoch   = j.value("epoch", (uint64_t)0);
+        uint64_t version = j.value("version", (uint64_t)0);
+
+        // Include the changes the forwarder has not stored yet
+        updateSnapshot();
+        json reply = snapshot.changesSince(epoch, version);
+        LOG_DEBUG(log, "Config sync from version {}: {} changes", version,
+                  reply["config_sync"]["changes"].size());
+
+        server.send(std::move(reply));
+    }
+    catch (nlohmann::json::exception& jsone)
+    {
+        LOG_ERR(log, "Invalid config_sync: what: {} json: {}", jsone.what(),
+                j.dump());
+    }
+}
+
+void CommManager::messageHandler(string_view packet)
+{
+    try
+    {
+        // Events are decoded straight from the packet. Other messages are
+        // rare, they go through a json object.
+        uint16_t id;
+        if (JsonReader::readEventId(packet, id))
+        {
+            sBroker.post(jsonStringToEvent(id, packet), TOPIC_REMOTE_CMD);
+            return;
+        }
+
+        json j = json::parse(packet);
+        if (j.contains("comm_config"))
+        {
+            configure(j.at("comm_config"));
+        }
+        else if (j.contains("config_sync"))
+        {
+            syncConfig(j.at("config_sync"));
+        }
+    }
+    catch (json::parse_error& pe)
+    {
+        LOG_ERR(log, "Error parsing JSON packet: {}", pe.what());
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERR(log, "Could not parse JSON to Event: what: {} json: {}",
+                e.what(), packet);
+    }
+}
@@ -22,17 +22,62 @@
 
 #pragma once
 
+#include <fmt/format.h>
+
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
 #include <nlohmann/json.hpp>
+#include <set>
+#include <unordered_map>
 
-#include "EventHandler.h"
+#include "ConfigSnapshot.h"
+#include "EventBroker.h"
+#include "ForwardQueue.h"
 #include "JsonTcpServer.h"
 #include "PrintLogger.h"
+#include "utils/ActiveObject.h"
 
-class CommManager : public EventHandlerBase
+/**
+ * Forwarding options of the connected client. They are reset to the
+ * defaults every time a client connects, and can be changed by the client
+ * sending a "comm_config" message, for example:
+ * {"comm_config": {"topics": [1, 3], "events": [39, 40], "max_rate": 10}}
+ */
+struct CommFilter
+{
+    // Topics forwarded to the client
+    TopicMask topics{};
+    // Ids of the events forwarded to the client. Empty: all events
+    std::set<uint16_t> events{};
+    // Maximum number of messages per second. 0: unlimited
+    float max_rate = 0;
+};
+
+/**
+ * Forwards events to the remote client and posts the events received from
+ * it on TOPIC_REMOTE_CMD.
+ * Events are queued and serialized by a dedicated thread, that sends at most
+ * one message at a time to the server and respects the client's max_rate.
+ * While the socket is busy, only the latest value of each EventConfigValue*
+ * event is kept in the queue.
+ * The state of the camera is kept in a versioned snapshot: a (re)connecting
+ * client can send {"config_sync": {"epoch": E, "version": N}} to receive
+ * everything that changed after version N in a single message, instead of
+ * requesting all the configuration again. See ConfigSnapshot. The snapshot
+ * is updated by the forwarder thread, so that publishers on
+ * TOPIC_CAMERA_CONFIG do not pay for serializing the events.
+ */
+class CommManager : public ActiveObject
 {
 public:
-    CommManager(uint16_t port);
+    /**
+     * @param port Port to listen on
+     * @param max_rate Default maximum number of messages per second sent to
+     * the client. 0: unlimited
+     */
+    CommManager(uint16_t port, float max_rate = 0);
 
     CommManager(const CommManager& other) = delete;
     CommManager(CommManager&& other) = delete;
@@ -42,13 +87,57 @@ public:
 
     ~CommManager();
 
+    void stop() override;
+
 protected:
-    void doPostEvent(const EventPtr& ev) override;
+    void run() override;
 
 private:
-    void messageHandler(const nlohmann::json& j);
+    void onEvent(const EventPtr& ev, uint8_t topic);
+    void onConnection(bool connected);
 
-    JsonTcpServer server;
+    void messageHandler(string_view packet);
+    void configure(const nlohmann::json& j);
+    void syncConfig(const nlohmann::json& j);
+
+    bool isCoalescable(const EventPtr& ev);
+
+    /**
+     * @brief Stores the queued TOPIC_CAMERA_CONFIG events in the snapshot
+     */
+    void updateSnapshot();
+
+    static TopicMask defaultTopics();
+
+    static constexpr size_t QUEUE_SIZE = 1000;
+
+    // Max time to wait for the socket to finish sending before checking
+    // again if the forwarder should stop
+    static constexpr std::chrono::milliseconds BUSY_WAIT_TIMEOUT{100};
+
+    CommFilter default_filter;
+    CommFilter filter;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    ForwardQueue queue{QUEUE_SIZE};
+
+    // Latest TOPIC_CAMERA_CONFIG events not yet stored in the snapshot.
+    // Protected by mtx
+    ForwardQueue snapshot_queue{QUEUE_SIZE};
+    // Held while updating the snapshot, so that events are stored in order
+    std::mutex mtx_snapshot;
+    ConfigSnapshot snapshot;
+    std::unordered_map<uint16_t, bool> coalescable{};
+
+    // Outgoing events are serialized here, only used by the forwarder thread
+    fmt::memory_buffer json_buf;
+
+    uint16_t tap_id;
 
     PrintLogger log = Logging::getLogger("ComMgr");
-};
\ No newline at end of file
+
+    // Last member: its threads call back into this object
+    JsonTcpServer server;
+};
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "ConfigSnapshot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using nlohmann::json;
+using std::lock_guard;
+using std::mutex;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::system_clock;
+
+ConfigSnapshot::ConfigSnapshot()
+    : epoch(duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+                .count())
+{
+}
+
+bool ConfigSnapshot::update(const EventPtr& ev)
+{
+    json value = ev->to_json();
+
+    lock_guard<mutex> lock(mtx);
+
+    auto it = entries.find(ev->getID());
+    if (it != entries.end())
+    {
+        if (it->second.value == value)
+            return false;
+
+        it->second = {++version, std::move(value)};
+    }
+    else
+    {
+        entries.emplace(ev->getID(), Entry{++version, std::move(value)});
+    }
+    return true;
+}
+
+json ConfigSnapshot::changesSince(uint64_t epoch, uint64_t version)
+{
+    lock_guard<mutex> lock(mtx);
+
+    bool full = epoch != this->epoch || version > this->version;
+    if (full)
+        version = 0;
+
+    vector<const Entry*> changed;
+    for (const auto& [id, entry] : entries)
+    {
+        if (entry.version > version)
+            changed.push_back(&entry);
+    }
+
+    std::sort(changed.begin(), changed.end(),
+              [](const Entry* a, const Entry* b)
+              { return a->version < b->version; });
+
+    json changes = json::array();
+    for (const Entry* e : changed)
+        changes.push_back(e->value);
+
+    json j;
+    j["config_sync"] = {{"epoch", this->epoch},
+                        {"version", this->version},
+                        {"full", full},
+                        {"changes", std::move(changes)}};
+    return j;
+}
+
+uint64_t ConfigSnapshot::getVersion()
+{
+    lock_guard<mutex> lock(mtx);
+    return version;
+}
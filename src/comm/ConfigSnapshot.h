@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+#include "EventBase.h"
+
+/**
+ * Versioned snapshot of the camera state, built from the latest event of each
+ * type posted on TOPIC_CAMERA_CONFIG.
+ * Every time an event changes the stored value, the global version is
+ * incremented and assigned to it, so that a client that already knows the
+ * state at version N can ask for only what changed since then.
+ * The epoch identifies this instance of the snapshot: versions from a
+ * different epoch (eg: before a restart) are meaningless, and result in the
+ * full state being returned.
+ */
+class ConfigSnapshot
+{
+public:
+    ConfigSnapshot();
+
+    /**
+     * @brief Stores the event as the current value for its type
+     * @return true if the value changed, false if it was already up to date
+     */
+    bool update(const EventPtr& ev);
+
+    /**
+     * @brief Returns all the values that changed after the given version, as
+     * a single message:
+     * {"config_sync": {"epoch": E, "version": V, "full": bool,
+     *                  "changes": [event_json, ...]}}
+     * Changes are sorted by version. If the epoch does not match, or the
+     * version is in the future, the full state is returned.
+     */
+    nlohmann::json changesSince(uint64_t epoch, uint64_t version);
+
+    uint64_t getEpoch() const { return epoch; }
+    uint64_t getVersion();
+
+private:
+    struct Entry
+    {
+        uint64_t version;
+        nlohmann::json value;
+    };
+
+    std::mutex mtx;
+
+    const uint64_t epoch;
+    uint64_t version = 0;
+    std::map<uint16_t, Entry> entries;
+};
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+#include "EventBase.h"
+
+using std::deque;
+using std::unordered_map;
+
+/**
+ * Bounded FIFO of events waiting to be forwarded to a remote client.
+ * Events pushed with coalesce = true keep at most one pending instance per
+ * event id: a newer event replaces the pending one, keeping its position in
+ * the queue. Not thread safe.
+ */
+class ForwardQueue
+{
+public:
+    ForwardQueue(size_t capacity) : capacity(capacity) {}
+
+    /**
+     * @brief Adds an event to the queue
+     *
+     * @param ev Event to add
+     * @param coalesce Replace any pending event with the same id
+     * @return false if the queue is full and the event was dropped
+     */
+    bool push(const EventPtr& ev, bool coalesce)
+    {
+        if (coalesce)
+        {
+            auto it = latest.find(ev->getID());
+            if (it != latest.end())
+            {
+                it->second = ev;
+                ++num_coalesced;
+                return true;
+            }
+        }
+
+        if (entries.size() >= capacity)
+        {
+            ++num_dropped;
+            return false;
+        }
+
+        if (coalesce)
+        {
+            latest[ev->getID()] = ev;
+            entries.push_back({ev->getID(), nullptr});
+        }
+        else
+        {
+            entries.push_back({0, ev});
+        }
+        return true;
+    }
+
+    /**
+     * @brief Removes and returns the oldest event. The queue must not be
+     * empty.
+     */
+    EventPtr pop()
+    {
+        Entry e = std::move(entries.front());
+        entries.pop_front();
+
+        if (e.ev == nullptr)
+        {
+            auto it = latest.find(e.coalesce_id);
+            e.ev    = std::move(it->second);
+            latest.erase(it);
+        }
+        return e.ev;
+    }
+
+    void clear()
+    {
+        entries.clear();
+        latest.clear();
+    }
+
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+
+    uint64_t getCoalescedCount() const { return num_coalesced; }
+    uint64_t getDroppedCount() const { return num_dropped; }
+
+private:
+    /**
+     * Queue entry. Coalesced events are stored in the 'latest' map and
+     * referenced by id, so that they can be replaced in place.
+     */
+    struct Entry
+    {
+        uint16_t coalesce_id;
+        EventPtr ev;
+    };
+
+    size_t capacity;
+    deque<Entry> entries;
+    unordered_map<uint16_t, EventPtr> latest;
+
+    uint64_t num_coalesced = 0;
+    uint64_t num_dropped   = 0;
+};
@@ -23,6 +23,8 @@
 #include "JsonTcpServer.h"
 
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #include <chrono>
 #include <csignal>
@@ -35,13 +37,16 @@
 using std::lock_guard;
 using std::make_pair;
 using std::make_unique;
+using std::mutex;
 using std::unique_lock;
 using std::unique_ptr;
 using std::chrono::seconds;
 using std::this_thread::sleep_for;
 
-JsonTcpServer::JsonTcpServer(uint16_t port, JsonTcpServer::ReceiverFun fun)
-    : fun(fun), acc(port)
+JsonTcpServer::JsonTcpServer(uint16_t port, JsonTcpServer::ReceiverFun fun,
+                             JsonTcpServer::ConnectionFun on_connection)
+    : ActiveObject(ThreadSpecs::network("tcp-server")), fun(fun),
+      on_connection(on_connection), acc(port)
 {
     if (!acc)
     {
@@ -74,16 +79,28 @@ bool JsonTcpServer::isConnected()
     return is_connected;
 }
 
-void JsonTcpServer::send(json&& j)
+void JsonTcpServer::send(const json& j)
 {
     // LOG_DEBUG(log, "Sending json packet: {}", j.dump(-1));
-    buf_out.put(std::move(j));
+    sendSerialized(j.dump());
 }
 
-void JsonTcpServer::send(const json& j)
+void JsonTcpServer::sendSerialized(string_view json_str)
 {
-    // LOG_DEBUG(log, "Sending json packet: {}", j.dump(-1));
-    buf_out.put(j);
+    buf_out.put(pack(json_str));
+}
+
+size_t JsonTcpServer::getOutgoingCount()
+{
+    return buf_out.count() + (packet_pending ? 1 : 0);
+}
+
+bool JsonTcpServer::waitOutgoingCount(size_t max_count,
+                                      std::chrono::milliseconds timeout)
+{
+    unique_lock<mutex> lock(mtx_sent);
+    return cv_sent.wait_for(lock, timeout, [&]
+                            { return getOutgoingCount() <= max_count; });
 }
 
 void JsonTcpServer::run()
@@ -99,8 +116,18 @@ void JsonTcpServer::run()
             continue;
         }
         LOG_DEBUG(log, "Accepted connection from: {}", peer.to_string());
+
+        // Packets are small and latency sensitive: don't let Nagle's
+        // algorithm hold them back waiting for the client's delayed ACKs
+        if (!sock.set_option(IPPROTO_TCP, TCP_NODELAY, 1))
+        {
+            LOG_WARN(log, "Cannot set TCP_NODELAY: {}", sock.last_error_str());
+        }
         is_connected = true;
 
+        if (on_connection)
+            on_connection(true);
+
         auto sock_rcv = sock.clone();
         unique_ptr<Receiver> receiver =
             make_unique<Receiver>(std::move(sock_rcv), *this);
@@ -109,13 +136,15 @@ void JsonTcpServer::run()
         {
             if (last_packet.size() == 0)
             {
-                json j = buf_out.popBlocking();
+                vector<uint8_t> packet = buf_out.popBlocking();
 
-                // Empty json, stop sender
-                if (j.is_null())
+                // Empty packet, stop sender
+                if (packet.empty())
                     break;
                 else
-                    last_packet = std::move(pack(j));
+                    last_packet = std::move(packet);
+
+                packet_pending = true;
             }
 
             int res = sock.write_n(last_packet.data(), last_packet.size());
@@ -140,24 +169,31 @@ void JsonTcpServer::run()
             {
                 // Successfully sent, clear the vector
                 last_packet.clear();
+                {
+                    lock_guard<mutex> lock(mtx_sent);
+                    packet_pending = false;
+                }
+                cv_sent.notify_all();
             }
         }
 
         is_connected = false;
         receiver->stop();
         LOG_DEBUG(log, "Receiver stopped!");
+
+        if (on_connection)
+            on_connection(false);
     }
 }
 
-vector<uint8_t> JsonTcpServer::pack(const json& j)
+vector<uint8_t> JsonTcpServer::pack(string_view json_str)
 {
-    string str = j.dump();
     vector<uint8_t> v;
-    v.resize(str.length() + 4);
+    v.resize(json_str.length() + 4);
 
-    uint32_t len = htonl(str.length());
+    uint32_t len = htonl(json_str.length());
     memcpy(v.data(), &len, 4);
-    memcpy(v.data() + 4, str.data(), str.length());
+    memcpy(v.data() + 4, json_str.data(), json_str.length());
 
     return v;
 }
@@ -170,7 +206,8 @@ void JsonTcpServer::stopSender()
 
 JsonTcpServer::Receiver::Receiver(sockpp::tcp_socket&& sock,
                                   JsonTcpServer& parent)
-    : sock(std::move(sock)), parent(parent), log(parent.log.getChild("Rcv"))
+    : ActiveObject(ThreadSpecs::network("tcp-receiver")),
+      sock(std::move(sock)), parent(parent), log(parent.log.getChild("Rcv"))
 {
     start();
 }
@@ -213,10 +250,9 @@ void JsonTcpServer::Receiver::run()
         memcpy(&len, len_arr, 4);
         len = ntohl(len);
 
-        vector<uint8_t> v;
-        v.resize(len);
+        packet.resize(len);
 
-        res = sock.read_n(v.data(), len);
+        res = sock.read_n(packet.data(), len);
         if (res == 0)
         {
             LOG_INFO(log, "{} disconnected", sock.peer_address().to_string());
@@ -229,14 +265,7 @@ void JsonTcpServer::Receiver::run()
             break;
         }
 
-        try
-        {
-            parent.fun(json::parse(v));
-        }
-        catch (json::parse_error& e)
-        {
-            LOG_ERR(log, "Error parsing JSON packet");
-        }
+        parent.fun({packet.data(), packet.size()});
     }
 
     sock.shutdown();
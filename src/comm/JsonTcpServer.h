@@ -25,7 +25,11 @@
 #include <sockpp/tcp_acceptor.h>
 #include <nlohmann/json.hpp>
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <exception>
 #include <functional>
 #include <utility>
@@ -36,15 +40,26 @@
 #include "PrintLogger.h"
 
 using std::function;
+using std::string_view;
 using std::vector;
 using nlohmann::json;
 
 class JsonTcpServer : public ActiveObject
 {  
 public:
-    using ReceiverFun = function<void(const json&)>;
-
-    JsonTcpServer(uint16_t port, ReceiverFun fun);
+    using ReceiverFun   = function<void(string_view)>;
+    using ConnectionFun = function<void(bool)>;
+
+    /**
+     * @param port Port to listen on
+     * @param fun Called from the receiver thread with the json text of each
+     * received packet, which is only valid during the call
+     * @param on_connection Optional, called from the server thread when a
+     * client connects (true) or disconnects (false). On connection, it is
+     * called before any packet is received from the new client.
+     */
+    JsonTcpServer(uint16_t port, ReceiverFun fun,
+                  ConnectionFun on_connection = nullptr);
 
     JsonTcpServer(const JsonTcpServer& other) = delete;
     JsonTcpServer(JsonTcpServer&& other) = delete;
@@ -59,7 +74,25 @@ public:
     void stop();
 
     void send(const json& j);
-    void send(json&& j);
+
+    /**
+     * @brief Sends a json document that has already been serialized, e.g. by
+     * Event::write_json(), without parsing it again
+     */
+    void sendSerialized(string_view json_str);
+
+    /**
+     * @brief Number of packets queued for sending, including the one being
+     * currently written on the socket.
+     */
+    size_t getOutgoingCount();
+
+    /**
+     * @brief Waits until at most @p max_count packets are queued for sending
+     *
+     * @return false if the timeout expired first
+     */
+    bool waitOutgoingCount(size_t max_count, std::chrono::milliseconds timeout);
 
     struct TcpAcceptorError : public std::exception
     { 
@@ -75,7 +108,7 @@ protected:
     void run() override;
 
 private:
-    vector<uint8_t> pack(const json& j);
+    vector<uint8_t> pack(string_view json_str);
 
     void stopSender();
 
@@ -94,16 +127,26 @@ private:
         sockpp::tcp_socket sock;
         JsonTcpServer& parent;
         PrintLogger log;
+
+        // Reused for every packet
+        vector<char> packet{};
     };
 
     static constexpr unsigned int BUFFER_SIZE = 1000;   
-    SyncCircularBuffer<json, BUFFER_SIZE> buf_out{};
+    // Packets are framed when queued: the sender thread only writes them.
+    // An empty packet stops the sender.
+    SyncCircularBuffer<vector<uint8_t>, BUFFER_SIZE> buf_out{};
 
     ReceiverFun fun;
+    ConnectionFun on_connection;
 
     sockpp::tcp_acceptor acc;
 
-    atomic_bool is_connected = false;
+    atomic_bool is_connected   = false;
+    atomic_bool packet_pending = false;
+
+    std::mutex mtx_sent;
+    std::condition_variable cv_sent;
     vector<uint8_t> last_packet{};
 
     PrintLogger log = Logging::getLogger("TcpServ");
@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "Coroutine.h"
+
+using std::lock_guard;
+using std::unique_lock;
+
+CoroutineHost::CoroutineHost(EventHandlerBase& handler, ThreadSpec spec)
+    : ActiveObject(std::move(spec)), handler(handler)
+{
+}
+
+CoroutineHost::~CoroutineHost() { stop(); }
+
+void CoroutineHost::resume(int32_t token)
+{
+    auto it = suspended.find(token);
+    if (it == suspended.end())
+        return;
+
+    std::coroutine_handle<> handle = it->second;
+    suspended.erase(it);
+    handle.resume();
+}
+
+void CoroutineHost::stop()
+{
+    if (started && !stopped)
+    {
+        {
+            lock_guard<mutex> lock(mtx_jobs);
+            should_stop = true;
+        }
+        cv_jobs.notify_one();
+
+        if (thread_obj->joinable())
+            thread_obj->join();
+        stopped = true;
+    }
+
+    // The operations they wait for will never complete
+    for (auto& s : suspended)
+        s.second.destroy();
+    suspended.clear();
+}
+
+int32_t CoroutineHost::suspend(std::coroutine_handle<> handle)
+{
+    int32_t token = next_token++;
+    suspended.emplace(token, handle);
+    return token;
+}
+
+void CoroutineHost::schedule(int32_t token, steady_clock::time_point at,
+                             function<void()> job)
+{
+    if (!started)
+        start();
+
+    {
+        lock_guard<mutex> lock(mtx_jobs);
+        jobs.emplace(at, Job{token, std::move(job)});
+    }
+    cv_jobs.notify_one();
+}
+
+void CoroutineHost::run()
+{
+    unique_lock<mutex> lock(mtx_jobs);
+    while (!shouldStop())
+    {
+        if (jobs.empty())
+        {
+            cv_jobs.wait(lock);
+            continue;
+        }
+
+        auto first = jobs.begin();
+        if (first->first > steady_clock::now())
+        {
+            // Woken up earlier if a job is scheduled before this one
+            cv_jobs.wait_until(lock, first->first);
+            continue;
+        }
+
+        Job job = std::move(first->second);
+        jobs.erase(first);
+
+        lock.unlock();
+        if (job.fun)
+            job.fun();
+        handler.postEvent(EventCoroutineResume_Internal{job.token});
+        lock.lock();
+    }
+}
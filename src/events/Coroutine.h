@@ -0,0 +1,254 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include "EventHandler.h"
+#include "Events.h"
+#include "utils/ActiveObject.h"
+
+using std::condition_variable;
+using std::function;
+using std::multimap;
+using std::mutex;
+using std::unordered_map;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/**
+ * @brief Return type of the coroutines started by a state handler. They run
+ * on the thread of the state machine until their first co_await, and are
+ * resumed on it between two events once what they wait for is done: other
+ * events are handled in the meantime.
+ * Nobody waits for them: results are posted back to the state machine as
+ * events. Exceptions must be caught inside the coroutine.
+ */
+struct StateTask
+{
+    struct promise_type
+    {
+        StateTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/**
+ * @brief Runs the blocking operations and the timers awaited by the
+ * coroutines of an event handler on a worker thread, then posts an
+ * EventCoroutineResume_Internal to the handler, which resumes the coroutine
+ * on its own thread with resume().
+ * Operations run one at a time, in the order they are awaited: calls to a
+ * device that is not thread safe stay serialized, as long as the handler does
+ * not touch it while one is in flight. The worker is started by the first
+ * co_await.
+ */
+class CoroutineHost : private ActiveObject
+{
+public:
+    CoroutineHost(EventHandlerBase& handler, ThreadSpec spec = {});
+    ~CoroutineHost();
+
+    /**
+     * @brief Awaits fun() running on the worker thread. The co_await
+     * evaluates to what fun() returns, or throws what it throws.
+     * fun is stored in the awaiter until it has run. A lambda written in the
+     * co_await expression may only capture by reference, eg: the locals of
+     * the coroutine, which live until it returns; store one capturing by value
+     * in a local first, it is copied. Checked at compile time.
+     */
+    template <typename Fun>
+    auto offload(Fun&& fun);
+
+    /**
+     * @brief Awaits the expiration of the delay, without blocking the worker
+     */
+    auto sleepFor(milliseconds delay);
+
+    /**
+     * @brief Resumes the coroutine that was given the token. To be called by
+     * the handler, on its thread, when receiving an
+     * EventCoroutineResume_Internal. Unknown tokens are ignored.
+     */
+    void resume(int32_t token);
+
+    /**
+     * @brief Waits for the running operation, stops the worker and destroys
+     * the suspended coroutines without resuming them. Stop the handler first.
+     */
+    void stop() override;
+
+    using ActiveObject::setThreadSpec;
+
+    size_t getNumSuspended() const { return suspended.size(); }
+
+private:
+    template <typename Fun>
+    class OffloadAwaiter;
+    class SleepAwaiter;
+
+    /**
+     * @brief Registers a suspended coroutine
+     * @return Token to resume it
+     */
+    int32_t suspend(std::coroutine_handle<> handle);
+
+    /**
+     * @brief Runs the job on the worker at the given time, then resumes the
+     * coroutine with the token
+     */
+    void schedule(int32_t token, steady_clock::time_point at,
+                  function<void()> job);
+
+    void run() override;
+
+    struct Job
+    {
+        int32_t token;
+        function<void()> fun;
+    };
+
+    EventHandlerBase& handler;
+
+    // Only accessed on the thread of the handler
+    unordered_map<int32_t, std::coroutine_handle<>> suspended;
+    int32_t next_token = 0;
+
+    mutex mtx_jobs;
+    condition_variable cv_jobs;
+    // Ordered by time, then by scheduling order
+    multimap<steady_clock::time_point, Job> jobs;
+};
+
+template <typename Fun>
+class CoroutineHost::OffloadAwaiter
+{
+    using Result = std::invoke_result_t<Fun>;
+    using Storage =
+        std::conditional_t<std::is_void_v<Result>, std::monostate, Result>;
+
+public:
+    template <typename F>
+    OffloadAwaiter(CoroutineHost& host, F&& fun)
+        : host(host), fun(std::forward<F>(fun))
+    {
+    }
+
+    bool await_ready() { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        host.schedule(host.suspend(handle), steady_clock::now(),
+                      [this]
+                      {
+                          try
+                          {
+                              if constexpr (std::is_void_v<Result>)
+                              {
+                                  fun();
+                                  result.emplace();
+                              }
+                              else
+                              {
+                                  result.emplace(fun());
+                              }
+                          }
+                          catch (...)
+                          {
+                              error = std::current_exception();
+                          }
+                      });
+    }
+
+    Result await_resume()
+    {
+        if (error)
+            std::rethrow_exception(error);
+
+        if constexpr (!std::is_void_v<Result>)
+            return std::move(*result);
+    }
+
+private:
+    CoroutineHost& host;
+    Fun fun;
+
+    // Written by the worker before posting the resume event
+    std::optional<Storage> result;
+    std::exception_ptr error;
+};
+
+class CoroutineHost::SleepAwaiter
+{
+public:
+    SleepAwaiter(CoroutineHost& host, milliseconds delay)
+        : host(host), delay(delay)
+    {
+    }
+
+    bool await_ready() { return delay.count() <= 0; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        host.schedule(host.suspend(handle), steady_clock::now() + delay, {});
+    }
+
+    void await_resume() {}
+
+private:
+    CoroutineHost& host;
+    milliseconds delay;
+};
+
+template <typename Fun>
+auto CoroutineHost::offload(Fun&& fun)
+{
+    // GCC 12 destroys twice the closure of a lambda created in a co_await
+    // expression: one owning memory, eg: capturing a string by value, would
+    // free it twice
+    static_assert(std::is_lvalue_reference_v<Fun> ||
+                      std::is_trivially_destructible_v<std::decay_t<Fun>>,
+                  "Store a lambda capturing by value in a local before "
+                  "offloading it");
+
+    return OffloadAwaiter<std::decay_t<Fun>>(*this, std::forward<Fun>(fun));
+}
+
+inline auto CoroutineHost::sleepFor(milliseconds delay)
+{
+    return SleepAwaiter(*this, delay);
+}
@@ -0,0 +1,272 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "DispatchWatchdog.h"
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <optional>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "utils/logger/PrintLogger.h"
+
+using std::lock_guard;
+using std::unique_lock;
+using std::chrono::duration_cast;
+
+static PrintLogger wlog = Logging::getLogger("DispatchWatchdog");
+
+void DispatchHistogram::record(microseconds duration)
+{
+    uint64_t us = std::max<int64_t>(duration.count(), 0);
+
+    unsigned int bucket = us > 0 ? std::bit_width(us) - 1 : 0;
+    ++buckets[std::min(bucket, NUM_BUCKETS - 1)];
+
+    ++count;
+    total_us += us;
+    max_us = std::max(max_us, us);
+}
+
+uint64_t DispatchHistogram::percentile(float p) const
+{
+    if (count == 0)
+        return 0;
+
+    uint64_t rank = std::max<uint64_t>(std::ceil(count * p / 100), 1);
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+            return std::min((uint64_t)1 << (i + 1), max_us);
+    }
+    return max_us;
+}
+
+DispatchMonitor::DispatchMonitor(string name) : name(std::move(name)) {}
+
+void DispatchMonitor::begin(const string& state, const EventPtr& ev)
+{
+    lock_guard<mutex> lock(mtx);
+
+    running     = true;
+    reported    = false;
+    this->state = &state;
+    event       = ev;
+    start       = steady_clock::now();
+}
+
+void DispatchMonitor::end()
+{
+    std::optional<EventHandlerOverrun> overrun;
+    {
+        lock_guard<mutex> lock(mtx);
+        if (!running)
+            return;
+
+        auto duration =
+            duration_cast<microseconds>(steady_clock::now() - start);
+
+        auto key = std::make_pair(state, event->getID());
+        auto it  = stats.find(key);
+        if (it == stats.end())
+            it = stats.emplace(key, Entry{event->name(), {}}).first;
+        it->second.histogram.record(duration);
+
+        if (duration > getBudget())
+        {
+            ++num_overruns;
+            overrun = report(duration, true);
+        }
+
+        running = false;
+        event.reset();
+    }
+
+    // Not under the lock: the watchdog may be waiting for it
+    if (overrun)
+        sBroker.post(std::move(*overrun), TOPIC_DIAGNOSTICS);
+}
+
+std::optional<EventHandlerOverrun> DispatchMonitor::check(
+    steady_clock::time_point now)
+{
+    lock_guard<mutex> lock(mtx);
+    if (!running || reported)
+        return {};
+
+    auto duration = duration_cast<microseconds>(now - start);
+    if (duration > getBudget())
+        return report(duration, false);
+
+    return {};
+}
+
+EventHandlerOverrun DispatchMonitor::report(microseconds duration,
+                                            bool finished)
+{
+    int32_t duration_ms = duration_cast<milliseconds>(duration).count();
+
+    if (finished)
+        LOG_WARN(wlog, "{}: {} in state {} took {} ms", name, event->name(),
+                 *state, duration_ms);
+    else
+        LOG_WARN(wlog, "{}: {} in state {} running for {} ms", name,
+                 event->name(), *state, duration_ms);
+
+    reported = true;
+    return EventHandlerOverrun{name, *state, event->name(), duration_ms,
+                               finished};
+}
+
+milliseconds DispatchMonitor::getBudget() const
+{
+    milliseconds budget{budget_ms};
+    if (budget.count() == 0)
+        return DispatchWatchdog::getInstance().getDefaultBudget();
+    return budget;
+}
+
+void DispatchMonitor::setName(string name)
+{
+    lock_guard<mutex> lock(mtx);
+    this->name = std::move(name);
+}
+
+string DispatchMonitor::getName()
+{
+    lock_guard<mutex> lock(mtx);
+    return name;
+}
+
+vector<DispatchStats> DispatchMonitor::getStats()
+{
+    lock_guard<mutex> lock(mtx);
+
+    vector<DispatchStats> out;
+    out.reserve(stats.size());
+    for (const auto& s : stats)
+        out.push_back({*s.first.first, s.second.event, s.second.histogram});
+
+    return out;
+}
+
+void DispatchMonitor::logStats()
+{
+    auto all = getStats();
+    if (all.empty())
+        return;
+
+    string name = getName();
+    LOG_INFO(wlog, "{}: {} dispatches over budget", name, getNumOverruns());
+    for (const auto& s : all)
+        LOG_INFO(wlog,
+                 "{}: {} in {}: n={} mean={} us p50={} us p99={} us max={} us",
+                 name, s.event, s.state, s.histogram.count, s.histogram.mean(),
+                 s.histogram.percentile(50), s.histogram.percentile(99),
+                 s.histogram.max_us);
+}
+
+DispatchWatchdog::DispatchWatchdog() : ActiveObject(ThreadSpec{"watchdog"}) {}
+
+DispatchWatchdog::~DispatchWatchdog() { stop(); }
+
+void DispatchWatchdog::add(DispatchMonitor* monitor)
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        monitors.push_back(monitor);
+    }
+
+    // Handlers may be started concurrently
+    std::call_once(start_flag, [this] { start(); });
+}
+
+void DispatchWatchdog::remove(DispatchMonitor* monitor)
+{
+    lock_guard<mutex> lock(mtx);
+    monitors.erase(std::remove(monitors.begin(), monitors.end(), monitor),
+                   monitors.end());
+}
+
+void DispatchWatchdog::stop()
+{
+    if (started && !stopped)
+    {
+        {
+            lock_guard<mutex> lock(mtx);
+            should_stop = true;
+        }
+        cv.notify_one();
+
+        if (thread_obj->joinable())
+            thread_obj->join();
+        stopped = true;
+    }
+}
+
+void DispatchWatchdog::run()
+{
+    vector<EventHandlerOverrun> overruns;
+
+    unique_lock<mutex> lock(mtx);
+    while (!shouldStop())
+    {
+        cv.wait_for(lock, milliseconds(period_ms));
+
+        auto now = steady_clock::now();
+        for (DispatchMonitor* monitor : monitors)
+        {
+            if (auto overrun = monitor->check(now))
+                overruns.push_back(std::move(*overrun));
+        }
+
+        if (overruns.empty())
+            continue;
+
+        // Not under the lock: posting may block, and add() and remove()
+        // wait for it
+        lock.unlock();
+        for (auto& overrun : overruns)
+            sBroker.post(std::move(overrun), TOPIC_DIAGNOSTICS);
+        overruns.clear();
+        lock.lock();
+    }
+}
+
+string demangle(const char* name)
+{
+    int status;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status != 0)
+        return name;
+
+    string out{demangled};
+    std::free(demangled);
+    return out;
+}
@@ -0,0 +1,264 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "EventBase.h"
+#include "Events.h"
+#include "utils/ActiveObject.h"
+#include "utils/Singleton.h"
+
+using std::array;
+using std::condition_variable;
+using std::map;
+using std::mutex;
+using std::pair;
+using std::string;
+using std::vector;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/**
+ * @brief Distribution of the durations of a dispatch, in power of two
+ * buckets: bucket i counts the durations in [2^i, 2^(i+1)) us, the first one
+ * also the shorter ones and the last one also the longer ones.
+ */
+struct DispatchHistogram
+{
+    static constexpr unsigned int NUM_BUCKETS = 24;
+
+    array<uint64_t, NUM_BUCKETS> buckets{};
+    uint64_t count    = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us   = 0;
+
+    void record(microseconds duration);
+
+    /**
+     * @brief Upper bound of the bucket containing the given percentile (0 to
+     * 100), capped at the longest duration recorded
+     */
+    uint64_t percentile(float p) const;
+
+    uint64_t mean() const { return count > 0 ? total_us / count : 0; }
+};
+
+/**
+ * @brief Durations of the dispatches of an event in a state
+ */
+struct DispatchStats
+{
+    string state;
+    string event;
+    DispatchHistogram histogram;
+};
+
+/**
+ * @brief Times the dispatches of an event handler: begin() and end() are
+ * called by the handler around each one, on its own thread. A dispatch
+ * taking longer than the budget is reported with an EventHandlerOverrun on
+ * TOPIC_DIAGNOSTICS: by the DispatchWatchdog while it is still running, so
+ * that a handler stuck for good is noticed, and again when it finishes.
+ */
+class DispatchMonitor
+{
+public:
+    /**
+     * @param name Name of the handler in the reports
+     */
+    DispatchMonitor(string name = "");
+
+    DispatchMonitor(const DispatchMonitor& other) = delete;
+    DispatchMonitor& operator=(const DispatchMonitor& other) = delete;
+
+    /**
+     * @brief A dispatch starts
+     * @param state Name of the active state. Must outlive the monitor.
+     * @param ev Event being dispatched
+     */
+    void begin(const string& state, const EventPtr& ev);
+
+    /**
+     * @brief The dispatch started by the last begin() is over
+     */
+    void end();
+
+    /**
+     * @brief Times a dispatch for the lifetime of the scope, whichever way
+     * the handler returns
+     */
+    class Scope
+    {
+    public:
+        Scope(DispatchMonitor& monitor, const string& state,
+              const EventPtr& ev)
+            : monitor(monitor)
+        {
+            monitor.begin(state, ev);
+        }
+
+        ~Scope() { monitor.end(); }
+
+        Scope(const Scope& other) = delete;
+        Scope& operator=(const Scope& other) = delete;
+
+    private:
+        DispatchMonitor& monitor;
+    };
+
+    /**
+     * @brief Checks if the running dispatch has just gone over the budget.
+     * Called periodically by the DispatchWatchdog.
+     *
+     * @return The report to post, if any
+     */
+    std::optional<EventHandlerOverrun> check(steady_clock::time_point now);
+
+    /**
+     * @brief Sets the budget of a dispatch. 0: use the default of the
+     * DispatchWatchdog.
+     */
+    void setBudget(milliseconds budget) { budget_ms = budget.count(); }
+
+    milliseconds getBudget() const;
+
+    void setName(string name);
+
+    string getName();
+
+    /**
+     * @brief Durations of the dispatches so far, by state and event
+     */
+    vector<DispatchStats> getStats();
+
+    /**
+     * @brief Logs a summary of the durations of the dispatches, one line per
+     * state and event
+     */
+    void logStats();
+
+    /**
+     * @brief Number of dispatches that went over the budget
+     */
+    uint64_t getNumOverruns() const { return num_overruns; }
+
+private:
+    struct Entry
+    {
+        string event;
+        DispatchHistogram histogram;
+    };
+
+    /**
+     * @brief Logs the running dispatch as an overrun
+     * @return The event to post once the lock is released
+     */
+    EventHandlerOverrun report(microseconds duration, bool finished);
+
+    mutex mtx;
+    string name;
+
+    // The running dispatch
+    bool running        = false;
+    bool reported       = false;
+    const string* state = nullptr;
+    EventPtr event;
+    steady_clock::time_point start;
+
+    map<pair<const string*, uint16_t>, Entry> stats;
+
+    std::atomic<int64_t> budget_ms{0};
+    std::atomic<uint64_t> num_overruns{0};
+};
+
+/**
+ * @brief Checks periodically that none of the registered handlers is stuck
+ * in a dispatch for longer than its budget. Started once, by the first add().
+ */
+class DispatchWatchdog : public Singleton<DispatchWatchdog>,
+                         private ActiveObject
+{
+    friend class Singleton<DispatchWatchdog>;
+
+public:
+    static constexpr milliseconds DEFAULT_BUDGET{1000};
+    static constexpr milliseconds DEFAULT_PERIOD{100};
+
+    ~DispatchWatchdog();
+
+    void add(DispatchMonitor* monitor);
+
+    void remove(DispatchMonitor* monitor);
+
+    /**
+     * @brief Budget of the monitors that do not have their own
+     */
+    void setDefaultBudget(milliseconds budget)
+    {
+        default_budget_ms = budget.count();
+    }
+
+    milliseconds getDefaultBudget() const
+    {
+        return milliseconds(default_budget_ms);
+    }
+
+    /**
+     * @brief Sets how often the monitors are checked: an overrun is reported
+     * up to this late.
+     */
+    void setPeriod(milliseconds period) { period_ms = period.count(); }
+
+    void stop() override;
+
+private:
+    DispatchWatchdog();
+
+    void run() override;
+
+    mutex mtx;
+    condition_variable cv;
+    vector<DispatchMonitor*> monitors;
+
+    std::once_flag start_flag;
+
+    std::atomic<int64_t> default_budget_ms{DEFAULT_BUDGET.count()};
+    std::atomic<int64_t> period_ms{DEFAULT_PERIOD.count()};
+};
+
+/**
+ * @brief Readable name of a type, eg: "CameraController"
+ */
+string demangle(const char* name);
@@ -32,6 +32,8 @@
 #include <nlohmann/json.hpp>
 #include <string>
 
+#include "JsonWriter.h"
+
 using std::shared_ptr;
 using std::string;
 
@@ -72,6 +74,22 @@ struct Event
     virtual string to_string(int indent = -1) const = 0;
     virtual nlohmann::json to_json() const = 0;
 
+    /**
+     * @brief Appends the event to the buffer as json, exactly as
+     * to_json().dump() would, without building the json object
+     */
+    virtual void write_json(fmt::memory_buffer& out) const = 0;
+
+    /**
+     * @brief Same as to_json().dump()
+     */
+    string dump() const
+    {
+        fmt::memory_buffer buf;
+        write_json(buf);
+        return fmt::to_string(buf);
+    }
+
     void print() const { fmt::print(to_string()); }
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(Event);
@@ -95,6 +113,10 @@ struct EventSMEntry : public Event
     string name() const override { return "EventSMEntry"; }
     string to_string(int indent = -1) const override { return name(); }
     nlohmann::json to_json() const override { return nlohmann::json{*this}; }
+    void write_json(fmt::memory_buffer& out) const override
+    {
+        JsonWriter(out).field("event_id", id).end();
+    }
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventSMEntry);
 };
@@ -108,6 +130,10 @@ struct EventSMExit : public Event
     string name() const override { return "EventSMExit"; }
     string to_string(int indent = -1) const override { return name(); }
     nlohmann::json to_json() const override { return nlohmann::json{*this}; }
+    void write_json(fmt::memory_buffer& out) const override
+    {
+        JsonWriter(out).field("event_id", id).end();
+    }
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventSMExit);
 };
@@ -121,6 +147,10 @@ struct EventSMEmpty : public Event
     string name() const override { return "EventSMEmpty"; }
     string to_string(int indent = -1) const override { return name(); }
     nlohmann::json to_json() const override { return nlohmann::json{*this}; }
+    void write_json(fmt::memory_buffer& out) const override
+    {
+        JsonWriter(out).field("event_id", id).end();
+    }
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventSMEmpty);
 };
@@ -134,6 +164,10 @@ struct EventSMInit : public Event
     string name() const override { return "EventSMInit"; }
     string to_string(int indent = -1) const override { return name(); }
     nlohmann::json to_json() const override { return nlohmann::json{*this}; }
+    void write_json(fmt::memory_buffer& out) const override
+    {
+        JsonWriter(out).field("event_id", id).end();
+    }
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventSMInit);
 };
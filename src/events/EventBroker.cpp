@@ -22,9 +22,11 @@
 
 #include "EventBroker.h"
 
+#include <algorithm>
+
 using std::unique_lock;
 
-EventBroker::EventBroker() {}
+EventBroker::EventBroker() : ActiveObject(ThreadSpec{"broker"}) {}
 
 EventBroker::~EventBroker() {stop();}
 
@@ -43,30 +45,73 @@ void EventBroker::stop()
 void EventBroker::post(const shared_ptr<const Event>& ev, uint8_t topic)
 {
     lock_guard<mutex> lock(mtx_subscribers);
-    if (subscribers.count(topic) > 0)
+
+    // TODO: This may cause a deadlock if subscribe(...) in called in
+    // postEvent(...), but it should never happen anyway. What to do?
+    for (EventHandlerBase* sub : subscribers[topic])
+    {
+        sub->postEvent(ev);
+    }
+
+    for (Tap& tap : taps)
     {
-        vector<EventHandlerBase*>& subs = subscribers.at(topic);
-        auto begin                      = subs.begin();
-        auto end                        = subs.end();
+        if (tap.topics.test(topic))
+            tap.fun(ev, topic);
+    }
+}
+
+void EventBroker::post(EventValue&& ev, uint8_t topic)
+{
+    lock_guard<mutex> lock(mtx_subscribers);
+
+    vector<EventHandlerBase*>& subs = subscribers[topic];
 
-        for (auto it = begin; it != end; it++)
+    size_t num_values = std::count_if(subs.begin(), subs.end(),
+                                      [](EventHandlerBase* sub)
+                                      { return sub->storesValues(); });
+    bool needs_ptr =
+        num_values < subs.size() ||
+        std::any_of(taps.begin(), taps.end(),
+                    [&](const Tap& tap) { return tap.topics.test(topic); });
+
+    // The last one to receive the event takes the original
+    EventPtr ptr;
+    if (needs_ptr)
+        ptr = toEventPtr(num_values > 0 ? EventValue{ev} : std::move(ev));
+
+    for (EventHandlerBase* sub : subs)
+    {
+        if (!sub->storesValues())
+            sub->postEvent(ptr);
+        else if (--num_values > 0)
+            sub->postEvent(EventValue{ev});
+        else
+            sub->postEvent(std::move(ev));
+    }
+
+    if (ptr)
+    {
+        for (Tap& tap : taps)
         {
-            // TODO: This may cause a deadlock if subscribe(...) in called in
-            // postEvent(...), but it should never happen anyway. What to do?
-            (*it)->postEvent(ev);
+            if (tap.topics.test(topic))
+                tap.fun(ptr, topic);
         }
     }
 }
 
 uint16_t EventBroker::postDelayed(const EventPtr& ev, uint8_t topic,
                                   unsigned int delay_ms)
+{
+    return postAt(ev, topic, steady_clock::now() + milliseconds(delay_ms));
+}
+
+uint16_t EventBroker::postAt(const EventPtr& ev, uint8_t topic,
+                             steady_clock::time_point deadline)
 {
     unique_lock<mutex> lock(mtx_delayed_events);
 
     uint16_t sched_id = eventCounter++;
-    auto deadline     = system_clock::now() + milliseconds(delay_ms);
-    // DelayedEvent dev{eventCounter++, ev, topic, getTick() + delay_ticks};
-    bool added = false;
+    bool added        = false;
 
     // Add the new event in the list, ordered by deadline (first = nearest
     // deadline)
@@ -123,7 +168,7 @@ void EventBroker::run()
         if (delayed_events.size() > 0)
         {
             // Check if the deadline has expired
-            if (delayed_events.front().deadline <= system_clock::now())
+            if (delayed_events.front().deadline <= steady_clock::now())
             {
                 DelayedEvent dev = delayed_events.front();
                 delayed_events.erase(delayed_events.begin());
@@ -146,19 +191,53 @@ void EventBroker::subscribe(EventHandlerBase* subscriber, uint8_t topic)
     subscribers[topic].push_back(subscriber);
 }
 
+void EventBroker::subscribe(EventHandlerBase* subscriber,
+                            const TopicMask& topics)
+{
+    lock_guard<mutex> lock(mtx_subscribers);
+    for (unsigned int t = 0; t < NUM_TOPICS; ++t)
+    {
+        if (topics.test(t))
+            subscribers[t].push_back(subscriber);
+    }
+}
+
 void EventBroker::unsubscribe(EventHandlerBase* subscriber, uint8_t topic)
 {
     lock_guard<mutex> lock(mtx_subscribers);
 
-    deleteSubscriber(subscribers.at(topic), subscriber);
+    deleteSubscriber(subscribers[topic], subscriber);
 }
 
 void EventBroker::unsubscribe(EventHandlerBase* subscriber)
 {
     lock_guard<mutex> lock(mtx_subscribers);
-    for (auto it = subscribers.begin(); it != subscribers.end(); it++)
+    for (auto& subs : subscribers)
     {
-        deleteSubscriber(it->second, subscriber);
+        deleteSubscriber(subs, subscriber);
+    }
+}
+
+uint16_t EventBroker::addTap(EventTap tap, const TopicMask& topics)
+{
+    lock_guard<mutex> lock(mtx_subscribers);
+
+    uint16_t id = tapCounter++;
+    taps.push_back({id, topics, std::move(tap)});
+
+    return id;
+}
+
+void EventBroker::removeTap(uint16_t id)
+{
+    lock_guard<mutex> lock(mtx_subscribers);
+    for (auto it = taps.begin(); it != taps.end(); it++)
+    {
+        if (it->id == id)
+        {
+            taps.erase(it);
+            break;
+        }
     }
 }
 
@@ -25,9 +25,11 @@
 #include <stdint.h>
 #include <fmt/core.h>
 
+#include <array>
+#include <bitset>
 #include <chrono>
 #include <condition_variable>
-#include <map>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <type_traits>
@@ -38,7 +40,8 @@
 #include "utils/ActiveObject.h"
 #include "utils/Singleton.h"
 
-using std::map;
+using std::array;
+using std::function;
 using std::vector;
 
 using std::condition_variable;
@@ -48,11 +51,23 @@ using std::unique_lock;
 using std::mutex;
 
 using std::chrono::milliseconds;
-using std::chrono::system_clock;
+using std::chrono::steady_clock;
 
 // Minimum guaranteed delay for an event posted with postDelayed(...) in ms
 static constexpr unsigned int EVENT_BROKER_MIN_DELAY = 50;
 
+static constexpr unsigned int NUM_TOPICS = 256;
+
+/**
+ * Set of topics, one bit per topic id.
+ */
+using TopicMask = std::bitset<NUM_TOPICS>;
+
+/**
+ * Callback receiving an event together with the topic it was posted on.
+ */
+using EventTap = function<void(const EventPtr&, uint8_t)>;
+
 /**
  * The EventBroker class implements the pub-sub paradigm to dispatch events to
  * multiple objects. An object of type FSM can subscribe to a topic in the
@@ -71,6 +86,15 @@ public:
      */
     void post(const EventPtr& ev, uint8_t topic);
 
+    /**
+     * Posts an event by value to the specified topic. Handlers that store
+     * events by value get their own copy, the other subscribers and the taps
+     * share a single EventPtr, only allocated if any of them is listening.
+     * @param ev
+     * @param topic
+     */
+    void post(EventValue&& ev, uint8_t topic);
+
     /**
      * Posts an event to the specified topic.
      * @param ev
@@ -81,7 +105,11 @@ public:
         typename = std::enable_if_t<std::is_base_of<Event, EventClass>::value>>
     void post(EventClass&& ev, uint8_t topic)
     {
-        post(std::make_shared<const EventClass>(ev), topic);
+        if constexpr (is_event_value_v<EventClass>)
+            post(EventValue{std::in_place_type<EventClass>, std::move(ev)},
+                 topic);
+        else
+            post(std::make_shared<const EventClass>(ev), topic);
     }
 
     /**
@@ -94,7 +122,10 @@ public:
         typename = std::enable_if_t<std::is_base_of<Event, EventClass>::value>>
     void post(const EventClass& ev, uint8_t topic)
     {
-        post(std::make_shared<const EventClass>(ev), topic);
+        if constexpr (is_event_value_v<EventClass>)
+            post(EventValue{std::in_place_type<EventClass>, ev}, topic);
+        else
+            post(std::make_shared<const EventClass>(ev), topic);
     }
 
     /**
@@ -126,6 +157,37 @@ public:
                            delay_ms);
     }
 
+    /**
+     * Posts an event at the specified point in time. Deadlines are taken on the
+     * monotonic clock, so they are not affected by wall clock adjustments. If
+     * the deadline is already in the past, the event is posted as soon as
+     * possible.
+     *
+     * @param event
+     * @param topic
+     * @param deadline When to post the event.
+     * @return Unique id of the delayed event.
+     */
+    uint16_t postAt(const EventPtr& ev, uint8_t topic,
+                    steady_clock::time_point deadline);
+
+    /**
+     * Posts an event at the specified point in time.
+     *
+     * @param event
+     * @param topic
+     * @param deadline When to post the event.
+     * @return Unique id of the delayed event.
+     */
+    template <
+        typename EventClass,
+        typename = std::enable_if_t<std::is_base_of<Event, EventClass>::value>>
+    uint16_t postAt(const EventClass&& ev, uint8_t topic,
+                    steady_clock::time_point deadline)
+    {
+        return postAt(std::make_shared<const EventClass>(ev), topic, deadline);
+    }
+
     /**
      * Removes a delayed event before it is posted.
      * @param id The id returned by postDelayed(...).
@@ -140,6 +202,33 @@ public:
      */
     void subscribe(EventHandlerBase* subscriber, uint8_t topic);
 
+    /**
+     * Subscribe to all the topics set in the mask.
+     * DO NOT call it in response to an event, or it will cause a deadlock.
+     * @param subscriber
+     * @param topics
+     */
+    void subscribe(EventHandlerBase* subscriber, const TopicMask& topics);
+
+    /**
+     * @brief Registers a tap, receiving every event posted on any of the
+     * topics in @p topics along with its topic id. Matching costs a single
+     * bit test per tap, regardless of the number of topics.
+     * Taps are called synchronously from post(...): keep them short.
+     * DO NOT call it in response to an event, or it will cause a deadlock.
+     *
+     * @param tap Callback to call for each event
+     * @param topics Topics to receive, all of them by default
+     * @return Unique id of the tap, to be used with removeTap(...)
+     */
+    uint16_t addTap(EventTap tap, const TopicMask& topics = TopicMask{}.set());
+
+    /**
+     * @brief Removes a tap added with addTap(...)
+     * @param id The id returned by addTap(...)
+     */
+    void removeTap(uint16_t id);
+
     /**
      * @brief Unsubscribe an EventHandler from a specific topic
      * This function should be used only for testing purposes
@@ -182,10 +271,10 @@ private:
         uint16_t sched_id;
         EventPtr event;
         uint8_t topic;
-        system_clock::time_point deadline;
+        steady_clock::time_point deadline;
 
         DelayedEvent(uint16_t sched_id, EventPtr event, uint8_t topic,
-                     system_clock::time_point deadline)
+                     steady_clock::time_point deadline)
             : sched_id(sched_id), event(event), topic(topic), deadline(deadline)
         {
         }
@@ -196,6 +285,16 @@ private:
      */
     void run() override;
 
+    /**
+     * Private structure for holding a tap in the list.
+     */
+    struct Tap
+    {
+        uint16_t id;
+        TopicMask topics;
+        EventTap fun;
+    };
+
     void deleteSubscriber(vector<EventHandlerBase*>& sub_vector,
                           EventHandlerBase* subscriber);
 
@@ -203,10 +302,12 @@ private:
     mutex mtx_delayed_events;
     condition_variable cv_delayed_events;
 
-    map<uint8_t, vector<EventHandlerBase*>> subscribers;
+    array<vector<EventHandlerBase*>, NUM_TOPICS> subscribers;
+    vector<Tap> taps;
     mutex mtx_subscribers;
 
     uint16_t eventCounter = 0;
+    uint16_t tapCounter   = 0;
 };
 
 #define sEventBroker Singleton<EventBroker>::getInstance()
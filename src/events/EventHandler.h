@@ -24,15 +24,33 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "EventBase.h"
+#include "EventPriority.h"
+#include "Events.h"
 #include "utils/ActiveObject.h"
-#include "utils/collections/SyncCircularBuffer.h"
+#include "utils/Executor.h"
+#include "utils/collections/SyncMultiLevelQueue.h"
 
 using std::make_shared;
 using std::shared_ptr;
 
+/**
+ * How an event posted to a handler is coalesced with a queued event of the
+ * same type
+ */
+enum class Coalescing : uint8_t
+{
+    NONE   = 0,  // Always queued
+    LATEST = 1,  // Replaces the queued one, eg. setters: the last value wins
+    FIRST  = 2   // Dropped, eg. getters: the queued one answers both
+};
+
 class EventHandlerBase
 {
 public:
@@ -42,51 +60,300 @@ public:
 
     void postEvent(const EventPtr& ev) { doPostEvent(ev); };
 
+    /**
+     * @brief Posts an event by value. Handlers that store events in place
+     * (see ValueEventHandler) keep it as is, the others receive an EventPtr.
+     */
+    void postEvent(EventValue&& ev) { doPostValue(std::move(ev)); }
+
     template <
         typename EventClass,
         typename = std::enable_if_t<std::is_base_of<Event, EventClass>::value>>
     void postEvent(const EventClass&& ev)
     {
-        doPostEvent(std::make_shared<const EventClass>(ev));
+        if constexpr (is_event_value_v<EventClass>)
+            doPostValue(EventValue{std::in_place_type<EventClass>, ev});
+        else
+            doPostEvent(std::make_shared<const EventClass>(ev));
     }
 
+    /**
+     * @brief True if the handler stores the events in its queue by value:
+     * posting an EventValue to it does not need an allocation.
+     */
+    virtual bool storesValues() const { return false; }
+
+    /**
+     * @brief Number of events that were coalesced with a queued one instead
+     * of being queued.
+     */
+    uint64_t getCoalescedCount() const { return coalesced; }
+
 protected:
     virtual void doPostEvent(const EventPtr& ev) = 0;
+
+    virtual void doPostValue(EventValue&& ev)
+    {
+        doPostEvent(toEventPtr(std::move(ev)));
+    }
+
+    /**
+     * @brief Priority class of an event posted to this handler. Override it
+     * to change the defaults of getEventPriority().
+     */
+    virtual EventPriority getPriority(uint16_t id) const
+    {
+        return getEventPriority(id);
+    }
+
+    /**
+     * @brief Declares how the events of type EventClass posted to this handler
+     * are coalesced. Rules must be declared before the handler is started.
+     */
+    template <typename EventClass>
+    void setCoalescing(Coalescing rule)
+    {
+        setCoalescing(EventClass::id, rule);
+    }
+
+    void setCoalescing(uint16_t id, Coalescing rule) { coalescing[id] = rule; }
+
+    Coalescing getCoalescing(uint16_t id) const
+    {
+        auto it = coalescing.find(id);
+        return it != coalescing.end() ? it->second : Coalescing::NONE;
+    }
+
+    /**
+     * @brief Puts the event in the given level of the queue, or coalesces it
+     * with a queued event of the same type according to its rule.
+     * Events are only coalesced across events that have a rule themselves:
+     * the others (eg. a capture) keep the order of what comes before and
+     * after them.
+     */
+    template <typename Queue, typename EventType>
+    void enqueue(Queue& queue, EventType ev, unsigned int level)
+    {
+        Coalescing rule = getCoalescing(idOf(ev));
+        if (rule == Coalescing::NONE)
+        {
+            queue.put(std::move(ev), level);
+            return;
+        }
+
+        bool merged = queue.putOrMerge(
+            std::move(ev), level,
+            [&](EventType& queued, EventType& elem)
+            {
+                uint16_t queued_id = idOf(queued);
+                if (queued_id == idOf(elem))
+                {
+                    if (rule == Coalescing::LATEST)
+                        queued = std::move(elem);
+                    return MergeResult::MERGED;
+                }
+                return getCoalescing(queued_id) != Coalescing::NONE
+                           ? MergeResult::SKIP
+                           : MergeResult::STOP;
+            });
+
+        if (merged)
+            ++coalesced;
+    }
+
+private:
+    static uint16_t idOf(const EventPtr& ev) { return ev->getID(); }
+    static uint16_t idOf(const EventValue& ev) { return asEvent(ev).getID(); }
+
+    std::unordered_map<uint16_t, Coalescing> coalescing;
+    std::atomic<uint64_t> coalesced{0};
 };
 
-template <unsigned Size = 100>
-class EventHandler : public EventHandlerBase, public ActiveObject
+/**
+ * @brief Common implementation of the event handlers: events are queued by
+ * priority class (see EventPriority), Size events per class, and handled one
+ * at a time, in order within each class, either on a thread of the handler
+ * (start()) or on the workers of an Executor (start(Executor&)).
+ */
+template <typename EventType, unsigned Size>
+class QueuedEventHandler : public EventHandlerBase,
+                           public ActiveObject,
+                           private ExecutorTask
 {
 public:
-    EventHandler() : ActiveObject() {}
+    /**
+     * @param wake_up Event posted by stop() to wake up the thread, not handled
+     */
+    QueuedEventHandler(EventType wake_up)
+        : ActiveObject(), wake_up(std::move(wake_up))
+    {
+    }
 
-    virtual ~EventHandler(){};
+    virtual ~QueuedEventHandler(){};
+
+    using ActiveObject::start;
+
+    /**
+     * @brief Starts handling the events on the workers of the executor,
+     * instead of on a thread of the handler. Events are still handled one at a
+     * time and in order, but the handler only takes a worker while it has
+     * events to handle: it must not block for long.
+     * The handler must be stopped before the executor.
+     */
+    virtual bool start(Executor& executor)
+    {
+        if (started || stopped)
+            return false;
+
+        this->executor = &executor;
+        started        = true;
 
+        // Events posted before starting
+        schedule();
+        return true;
+    }
 
     virtual void stop() override
     {
         if (started && !stopped)
         {
             should_stop = true;
-            eventList.put(C_EV_EMPTY);
-            if (thread_obj->joinable())
-                thread_obj->join();
+            if (executor != nullptr)
+            {
+                unique_lock<mutex> lock(mtx_schedule);
+                cv_schedule.wait(lock, [&] { return !scheduled; });
+            }
+            else
+            {
+                eventList.put(wake_up, (unsigned)EventPriority::COMMAND);
+                if (thread_obj->joinable())
+                    thread_obj->join();
+            }
             stopped = true;
         }
     }
 
 protected:
-    virtual void doPostEvent(const EventPtr& ev) override { eventList.put(ev); }
+    virtual void handleEvent(const EventType&) = 0;
 
-    virtual void handleEvent(const EventPtr&) = 0;
+    void queueEvent(EventType ev, unsigned int priority)
+    {
+        enqueue(eventList, std::move(ev), priority);
+        if (executor != nullptr)
+            schedule();
+    }
 
     void run() override
     {
         while (!shouldStop())
         {
-            handleEvent(eventList.popBlocking());
+            EventType ev = eventList.popBlocking();
+            if (!shouldStop())
+                handleEvent(ev);
+        }
+    }
+
+    SyncMultiLevelQueue<EventType, Size, NUM_EVENT_PRIORITIES> eventList;
+
+private:
+    // Max events handled before giving the worker to the next handler
+    static constexpr unsigned int EXECUTOR_BATCH_SIZE = 16;
+
+    /**
+     * @brief Submits the handler to the executor, unless it already is
+     */
+    void schedule()
+    {
+        {
+            lock_guard<mutex> lock(mtx_schedule);
+            if (scheduled || shouldStop())
+                return;
+            scheduled = true;
+        }
+        executor->submit(this);
+    }
+
+    void execute() override
+    {
+        for (unsigned int i = 0; i < EXECUTOR_BATCH_SIZE && !shouldStop() &&
+                                 !eventList.isEmpty();
+             ++i)
+        {
+            handleEvent(eventList.pop());
+        }
+
+        // Events posted in the meantime find the handler still scheduled
+        bool again;
+        {
+            lock_guard<mutex> lock(mtx_schedule);
+            again     = !shouldStop() && !eventList.isEmpty();
+            scheduled = again;
+
+            // Under the lock: stop() may return and destroy the handler as
+            // soon as it is released
+            cv_schedule.notify_all();
         }
+
+        if (again)
+            executor->submit(this);
+    }
+
+    EventType wake_up;
+
+    Executor* executor = nullptr;
+    mutex mtx_schedule;
+    condition_variable cv_schedule;
+    bool scheduled = false;
+};
+
+/**
+ * @brief Event handler receiving the events as EventPtr.
+ */
+template <unsigned Size = 100>
+class EventHandler : public QueuedEventHandler<EventPtr, Size>
+{
+public:
+    EventHandler() : QueuedEventHandler<EventPtr, Size>(C_EV_EMPTY) {}
+
+    virtual ~EventHandler(){};
+
+protected:
+    virtual void doPostEvent(const EventPtr& ev) override
+    {
+        this->queueEvent(ev, (unsigned)this->getPriority(ev->getID()));
+    }
+};
+
+/**
+ * @brief Event handler storing the events by value, directly in the slots of
+ * its queue: events posted as EventValue (or through the broker) are neither
+ * allocated on the heap nor reference counted. handleEvent() dispatches on
+ * the alternative with std::visit.
+ * Events posted as EventPtr are copied in the queue: they must be one of the
+ * alternatives of EventValue.
+ */
+template <unsigned Size = 100>
+class ValueEventHandler : public QueuedEventHandler<EventValue, Size>
+{
+public:
+    ValueEventHandler() : QueuedEventHandler<EventValue, Size>(EventValue{})
+    {
     }
 
-    SyncCircularBuffer<EventPtr, Size> eventList;
+    virtual ~ValueEventHandler(){};
+
+    bool storesValues() const override { return true; }
+
+protected:
+    virtual void doPostEvent(const EventPtr& ev) override
+    {
+        unsigned priority = (unsigned)this->getPriority(ev->getID());
+        this->queueEvent(toEventValue(*ev), priority);
+    }
+
+    virtual void doPostValue(EventValue&& ev) override
+    {
+        unsigned priority = (unsigned)this->getPriority(asEvent(ev).getID());
+        this->queueEvent(std::move(ev), priority);
+    }
 };
@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Priority classes of the events posted to an EventHandler. Each class has its
+ * own queue: events of the same class are handled in order, before the ones
+ * of the classes below. See SyncMultiLevelQueue for the starvation guarantee.
+ */
+enum class EventPriority : uint8_t
+{
+    COMMAND   = 0,  // Commands changing the state of the camera
+    CONTROL   = 1,  // Notifications, internal events and everything else
+    TELEMETRY = 2   // Read-only requests: the answer can wait
+};
+
+static constexpr unsigned int NUM_EVENT_PRIORITIES = 3;
+
+/**
+ * @brief Default priority class of the event with the given id, declared next
+ * to the event in events.txt.
+ *
+ * Only the commands handled by the camera controllers have a class other than
+ * CONTROL: setters and commands are COMMAND, getters and the periodic polling
+ * of the camera are TELEMETRY. Setters and captures share the same class, so
+ * that a capture never overtakes a setting requested before it.
+ * Everything else, camera notifications and mode commands included, is
+ * CONTROL: the modes handle their events in the order they were posted.
+ */
+EventPriority getEventPriority(uint16_t id);
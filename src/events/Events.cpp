@@ -30,37 +30,34 @@
 
 #include "Events.h"
 
-#include <map>
+#include <fmt/ranges.h>
+
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 
+#include "EventPriority.h"
+#include "JsonReader.h"
+
 using std::make_shared;
-using std::map;
-
-const map<uint8_t, string> topic_string_map = {
-    {TOPIC_CAMERA_CONFIG, "TOPIC_CAMERA_CONFIG"},
-    {TOPIC_CAMERA_CMD, "TOPIC_CAMERA_CMD"},
-    {TOPIC_CAMERA_EVENT, "TOPIC_CAMERA_EVENT"},
-    {TOPIC_REMOTE_CMD, "TOPIC_REMOTE_CMD"},
-    {TOPIC_MODE_CONTROLLER, "TOPIC_MODE_CONTROLLER"},
-    {TOPIC_MODE_FSM, "TOPIC_MODE_FSM"},
-    {TOPIC_MODE_STATE, "TOPIC_MODE_STATE"},
-    {TOPIC_HEARTBEAT, "TOPIC_HEARTBEAT"}};
-
-const map<string, uint8_t> topic_id_map = {
-    {"TOPIC_CAMERA_CONFIG", TOPIC_CAMERA_CONFIG},
-    {"TOPIC_CAMERA_CMD", TOPIC_CAMERA_CMD},
-    {"TOPIC_CAMERA_EVENT", TOPIC_CAMERA_EVENT},
-    {"TOPIC_REMOTE_CMD", TOPIC_REMOTE_CMD},
-    {"TOPIC_MODE_CONTROLLER", TOPIC_MODE_CONTROLLER},
-    {"TOPIC_MODE_FSM", TOPIC_MODE_FSM},
-    {"TOPIC_MODE_STATE", TOPIC_MODE_STATE},
-    {"TOPIC_HEARTBEAT", TOPIC_HEARTBEAT}};
+
+// Indexed by topic id
+static constexpr const char* topic_names[] = {
+    "TOPIC_CAMERA_CONFIG",
+    "TOPIC_CAMERA_CMD",
+    "TOPIC_CAMERA_EVENT",
+    "TOPIC_REMOTE_CMD",
+    "TOPIC_MODE_CONTROLLER",
+    "TOPIC_MODE_FSM",
+    "TOPIC_MODE_STATE",
+    "TOPIC_HEARTBEAT",
+    "TOPIC_DIAGNOSTICS",
+};
 
 string getTopicName(uint8_t topic)
 {
-    if (topic_string_map.count(topic) > 0)
-        return topic_string_map.at(topic);
+    if (topic < std::size(topic_names))
+        return topic_names[topic];
     else
     {
         return std::to_string(topic);
@@ -69,12 +66,12 @@ string getTopicName(uint8_t topic)
 
 uint8_t getTopicID(string topic_str)
 {
-    if (topic_id_map.count(topic_str) > 0)
-        return topic_id_map.at(topic_str);
-    else
+    for (uint8_t t = 0; t < std::size(topic_names); ++t)
     {
-        return 255;
+        if (topic_str == topic_names[t])
+            return t;
     }
+    return 255;
 }
 
 EventHeartBeat::EventHeartBeat() : Event(id) {}
@@ -83,26 +80,34 @@ string EventHeartBeat::name() const { return "EventHeartBeat"; }
 
 string EventHeartBeat::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventHeartBeat::to_json() const { return nlohmann::json(*this); }
 
+void EventHeartBeat::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventHeartBeat::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCmdRestart::EventCmdRestart() : Event(id) {}
 
 string EventCmdRestart::name() const { return "EventCmdRestart"; }
 
 string EventCmdRestart::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCmdRestart::to_json() const
@@ -110,32 +115,50 @@ nlohmann::json EventCmdRestart::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCmdRestart::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCmdRestart::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCmdReboot::EventCmdReboot() : Event(id) {}
 
 string EventCmdReboot::name() const { return "EventCmdReboot"; }
 
 string EventCmdReboot::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCmdReboot::to_json() const { return nlohmann::json(*this); }
 
+void EventCmdReboot::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCmdReboot::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCmdShutdown::EventCmdShutdown() : Event(id) {}
 
 string EventCmdShutdown::name() const { return "EventCmdShutdown"; }
 
 string EventCmdShutdown::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCmdShutdown::to_json() const
@@ -143,17 +166,26 @@ nlohmann::json EventCmdShutdown::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCmdShutdown::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCmdShutdown::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraCmdConnect::EventCameraCmdConnect() : Event(id) {}
 
 string EventCameraCmdConnect::name() const { return "EventCameraCmdConnect"; }
 
 string EventCameraCmdConnect::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCmdConnect::to_json() const
@@ -161,6 +193,16 @@ nlohmann::json EventCameraCmdConnect::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCmdConnect::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdConnect::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraCmdDisconnect::EventCameraCmdDisconnect() : Event(id) {}
 
 string EventCameraCmdDisconnect::name() const
@@ -170,11 +212,10 @@ string EventCameraCmdDisconnect::name() const
 
 string EventCameraCmdDisconnect::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCmdDisconnect::to_json() const
@@ -182,6 +223,16 @@ nlohmann::json EventCameraCmdDisconnect::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCmdDisconnect::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdDisconnect::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraCmdRecoverError::EventCameraCmdRecoverError() : Event(id) {}
 
 string EventCameraCmdRecoverError::name() const
@@ -191,11 +242,10 @@ string EventCameraCmdRecoverError::name() const
 
 string EventCameraCmdRecoverError::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCmdRecoverError::to_json() const
@@ -203,6 +253,16 @@ nlohmann::json EventCameraCmdRecoverError::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCmdRecoverError::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdRecoverError::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraCaptureStarted::EventCameraCaptureStarted() : Event(id) {}
 
 string EventCameraCaptureStarted::name() const
@@ -212,11 +272,10 @@ string EventCameraCaptureStarted::name() const
 
 string EventCameraCaptureStarted::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCaptureStarted::to_json() const
@@ -224,17 +283,26 @@ nlohmann::json EventCameraCaptureStarted::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCaptureStarted::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCaptureStarted::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraCmdCapture::EventCameraCmdCapture() : Event(id) {}
 
 string EventCameraCmdCapture::name() const { return "EventCameraCmdCapture"; }
 
 string EventCameraCmdCapture::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCmdCapture::to_json() const
@@ -242,6 +310,16 @@ nlohmann::json EventCameraCmdCapture::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCmdCapture::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdCapture::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraCmdCapture_Internal::EventCameraCmdCapture_Internal() : Event(id) {}
 
 string EventCameraCmdCapture_Internal::name() const
@@ -251,11 +329,10 @@ string EventCameraCmdCapture_Internal::name() const
 
 string EventCameraCmdCapture_Internal::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCmdCapture_Internal::to_json() const
@@ -263,6 +340,16 @@ nlohmann::json EventCameraCmdCapture_Internal::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCmdCapture_Internal::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdCapture_Internal::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraCmdDownload::EventCameraCmdDownload(bool download)
     : Event(id), download(download)
 {
@@ -272,11 +359,11 @@ string EventCameraCmdDownload::name() const { return "EventCameraCmdDownload"; }
 
 string EventCameraCmdDownload::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventCameraCmdDownload {{download = {}}}",
+                           download);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCmdDownload::to_json() const
@@ -284,6 +371,16 @@ nlohmann::json EventCameraCmdDownload::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCmdDownload::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("download", download).field("event_id", id).end();
+}
+
+void EventCameraCmdDownload::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("download", download).read();
+}
+
 EventCameraCmdDownload_Internal::EventCameraCmdDownload_Internal() : Event(id)
 {
 }
@@ -295,11 +392,10 @@ string EventCameraCmdDownload_Internal::name() const
 
 string EventCameraCmdDownload_Internal::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCmdDownload_Internal::to_json() const
@@ -307,17 +403,26 @@ nlohmann::json EventCameraCmdDownload_Internal::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCmdDownload_Internal::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdDownload_Internal::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraConnected::EventCameraConnected() : Event(id) {}
 
 string EventCameraConnected::name() const { return "EventCameraConnected"; }
 
 string EventCameraConnected::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraConnected::to_json() const
@@ -325,17 +430,26 @@ nlohmann::json EventCameraConnected::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraConnected::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraConnected::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraReady::EventCameraReady() : Event(id) {}
 
 string EventCameraReady::name() const { return "EventCameraReady"; }
 
 string EventCameraReady::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraReady::to_json() const
@@ -343,17 +457,26 @@ nlohmann::json EventCameraReady::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraReady::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraReady::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraBusyOrError::EventCameraBusyOrError() : Event(id) {}
 
 string EventCameraBusyOrError::name() const { return "EventCameraBusyOrError"; }
 
 string EventCameraBusyOrError::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraBusyOrError::to_json() const
@@ -361,6 +484,16 @@ nlohmann::json EventCameraBusyOrError::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraBusyOrError::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraBusyOrError::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraDisconnected::EventCameraDisconnected() : Event(id) {}
 
 string EventCameraDisconnected::name() const
@@ -370,11 +503,10 @@ string EventCameraDisconnected::name() const
 
 string EventCameraDisconnected::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraDisconnected::to_json() const
@@ -382,6 +514,16 @@ nlohmann::json EventCameraDisconnected::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraDisconnected::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraDisconnected::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraConnectionError::EventCameraConnectionError() : Event(id) {}
 
 string EventCameraConnectionError::name() const
@@ -391,11 +533,10 @@ string EventCameraConnectionError::name() const
 
 string EventCameraConnectionError::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraConnectionError::to_json() const
@@ -403,17 +544,26 @@ nlohmann::json EventCameraConnectionError::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraConnectionError::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraConnectionError::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraError::EventCameraError() : Event(id) {}
 
 string EventCameraError::name() const { return "EventCameraError"; }
 
 string EventCameraError::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraError::to_json() const
@@ -421,17 +571,26 @@ nlohmann::json EventCameraError::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraError::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraError::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraIgnoreError::EventCameraIgnoreError() : Event(id) {}
 
 string EventCameraIgnoreError::name() const { return "EventCameraIgnoreError"; }
 
 string EventCameraIgnoreError::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraIgnoreError::to_json() const
@@ -439,6 +598,16 @@ nlohmann::json EventCameraIgnoreError::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraIgnoreError::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraIgnoreError::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraCmdLowLatency::EventCameraCmdLowLatency(bool low_latency)
     : Event(id), low_latency(low_latency)
 {
@@ -451,11 +620,11 @@ string EventCameraCmdLowLatency::name() const
 
 string EventCameraCmdLowLatency::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventCameraCmdLowLatency {{low_latency = {}}}",
+                           low_latency);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCmdLowLatency::to_json() const
@@ -463,6 +632,19 @@ nlohmann::json EventCameraCmdLowLatency::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCmdLowLatency::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("low_latency", low_latency)
+        .end();
+}
+
+void EventCameraCmdLowLatency::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("low_latency", low_latency).read();
+}
+
 EventCameraCaptureDone::EventCameraCaptureDone(bool downloaded,
                                                string download_dir, string file)
     : Event(id), downloaded(downloaded), download_dir(download_dir), file(file)
@@ -473,11 +655,13 @@ string EventCameraCaptureDone::name() const { return "EventCameraCaptureDone"; }
 
 string EventCameraCaptureDone::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventCameraCaptureDone {{downloaded = {}, download_dir = {}, "
+            "file = {}}}",
+            downloaded, download_dir, file);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraCaptureDone::to_json() const
@@ -485,6 +669,25 @@ nlohmann::json EventCameraCaptureDone::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraCaptureDone::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("download_dir", download_dir)
+        .field("downloaded", downloaded)
+        .field("event_id", id)
+        .field("file", file)
+        .end();
+}
+
+void EventCameraCaptureDone::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("downloaded", downloaded)
+        .field("download_dir", download_dir)
+        .field("file", file)
+        .read();
+}
+
 EventGetCameraControllerState::EventGetCameraControllerState() : Event(id) {}
 
 string EventGetCameraControllerState::name() const
@@ -494,11 +697,10 @@ string EventGetCameraControllerState::name() const
 
 string EventGetCameraControllerState::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventGetCameraControllerState::to_json() const
@@ -506,11 +708,27 @@ nlohmann::json EventGetCameraControllerState::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventGetCameraControllerState::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventGetCameraControllerState::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventCameraControllerState::EventCameraControllerState(string state,
                                                        bool camera_connected,
-                                                       bool download_enabled)
+                                                       bool download_enabled,
+                                                       bool low_latency,
+                                                       int32_t probe_latency_us,
+                                                       int32_t probe_period_ms,
+                                                       int32_t recovery_time_ms)
     : Event(id), state(state), camera_connected(camera_connected),
-      download_enabled(download_enabled)
+      download_enabled(download_enabled), low_latency(low_latency),
+      probe_latency_us(probe_latency_us), probe_period_ms(probe_period_ms),
+      recovery_time_ms(recovery_time_ms)
 {
 }
 
@@ -521,11 +739,15 @@ string EventCameraControllerState::name() const
 
 string EventCameraControllerState::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventCameraControllerState {{state = {}, camera_connected = {}, "
+            "download_enabled = {}, low_latency = {}, probe_latency_us = {}, "
+            "probe_period_ms = {}, recovery_time_ms = {}}}",
+            state, camera_connected, download_enabled, low_latency,
+            probe_latency_us, probe_period_ms, recovery_time_ms);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventCameraControllerState::to_json() const
@@ -533,6 +755,33 @@ nlohmann::json EventCameraControllerState::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventCameraControllerState::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("camera_connected", camera_connected)
+        .field("download_enabled", download_enabled)
+        .field("event_id", id)
+        .field("low_latency", low_latency)
+        .field("probe_latency_us", probe_latency_us)
+        .field("probe_period_ms", probe_period_ms)
+        .field("recovery_time_ms", recovery_time_ms)
+        .field("state", state)
+        .end();
+}
+
+void EventCameraControllerState::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("state", state)
+        .field("camera_connected", camera_connected)
+        .field("download_enabled", download_enabled)
+        .field("low_latency", low_latency)
+        .field("probe_latency_us", probe_latency_us)
+        .field("probe_period_ms", probe_period_ms)
+        .field("recovery_time_ms", recovery_time_ms)
+        .read();
+}
+
 EventConfigGetShutterSpeed::EventConfigGetShutterSpeed() : Event(id) {}
 
 string EventConfigGetShutterSpeed::name() const
@@ -542,11 +791,10 @@ string EventConfigGetShutterSpeed::name() const
 
 string EventConfigGetShutterSpeed::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetShutterSpeed::to_json() const
@@ -554,6 +802,16 @@ nlohmann::json EventConfigGetShutterSpeed::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetShutterSpeed::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetShutterSpeed::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigGetChoicesShutterSpeed::EventConfigGetChoicesShutterSpeed()
     : Event(id)
 {
@@ -566,11 +824,10 @@ string EventConfigGetChoicesShutterSpeed::name() const
 
 string EventConfigGetChoicesShutterSpeed::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetChoicesShutterSpeed::to_json() const
@@ -578,6 +835,16 @@ nlohmann::json EventConfigGetChoicesShutterSpeed::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetChoicesShutterSpeed::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetChoicesShutterSpeed::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigSetShutterSpeed::EventConfigSetShutterSpeed(int32_t shutter_speed)
     : Event(id), shutter_speed(shutter_speed)
 {
@@ -590,11 +857,11 @@ string EventConfigSetShutterSpeed::name() const
 
 string EventConfigSetShutterSpeed::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigSetShutterSpeed {{shutter_speed = {}}}",
+                           shutter_speed);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigSetShutterSpeed::to_json() const
@@ -602,6 +869,19 @@ nlohmann::json EventConfigSetShutterSpeed::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigSetShutterSpeed::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("shutter_speed", shutter_speed)
+        .end();
+}
+
+void EventConfigSetShutterSpeed::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("shutter_speed", shutter_speed).read();
+}
+
 EventConfigValueShutterSpeed::EventConfigValueShutterSpeed(
     int32_t shutter_speed, bool bulb)
     : Event(id), shutter_speed(shutter_speed), bulb(bulb)
@@ -615,11 +895,12 @@ string EventConfigValueShutterSpeed::name() const
 
 string EventConfigValueShutterSpeed::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventConfigValueShutterSpeed {{shutter_speed = {}, bulb = {}}}",
+            shutter_speed, bulb);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueShutterSpeed::to_json() const
@@ -627,6 +908,23 @@ nlohmann::json EventConfigValueShutterSpeed::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueShutterSpeed::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("bulb", bulb)
+        .field("event_id", id)
+        .field("shutter_speed", shutter_speed)
+        .end();
+}
+
+void EventConfigValueShutterSpeed::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("shutter_speed", shutter_speed)
+        .field("bulb", bulb)
+        .read();
+}
+
 EventConfigChoicesShutterSpeed::EventConfigChoicesShutterSpeed(
     vector<int32_t> shutter_speed_choices)
     : Event(id), shutter_speed_choices(shutter_speed_choices)
@@ -640,11 +938,12 @@ string EventConfigChoicesShutterSpeed::name() const
 
 string EventConfigChoicesShutterSpeed::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventConfigChoicesShutterSpeed {{shutter_speed_choices = {}}}",
+            shutter_speed_choices);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigChoicesShutterSpeed::to_json() const
@@ -652,17 +951,31 @@ nlohmann::json EventConfigChoicesShutterSpeed::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigChoicesShutterSpeed::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("shutter_speed_choices", shutter_speed_choices)
+        .end();
+}
+
+void EventConfigChoicesShutterSpeed::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("shutter_speed_choices", shutter_speed_choices)
+        .read();
+}
+
 EventConfigGetAperture::EventConfigGetAperture() : Event(id) {}
 
 string EventConfigGetAperture::name() const { return "EventConfigGetAperture"; }
 
 string EventConfigGetAperture::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetAperture::to_json() const
@@ -670,6 +983,16 @@ nlohmann::json EventConfigGetAperture::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetAperture::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetAperture::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigGetChoicesAperture::EventConfigGetChoicesAperture() : Event(id) {}
 
 string EventConfigGetChoicesAperture::name() const
@@ -679,11 +1002,10 @@ string EventConfigGetChoicesAperture::name() const
 
 string EventConfigGetChoicesAperture::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetChoicesAperture::to_json() const
@@ -691,6 +1013,16 @@ nlohmann::json EventConfigGetChoicesAperture::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetChoicesAperture::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetChoicesAperture::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigSetAperture::EventConfigSetAperture(int32_t aperture)
     : Event(id), aperture(aperture)
 {
@@ -700,11 +1032,11 @@ string EventConfigSetAperture::name() const { return "EventConfigSetAperture"; }
 
 string EventConfigSetAperture::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigSetAperture {{aperture = {}}}",
+                           aperture);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigSetAperture::to_json() const
@@ -712,6 +1044,16 @@ nlohmann::json EventConfigSetAperture::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigSetAperture::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("aperture", aperture).field("event_id", id).end();
+}
+
+void EventConfigSetAperture::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("aperture", aperture).read();
+}
+
 EventConfigValueAperture::EventConfigValueAperture(int32_t aperture)
     : Event(id), aperture(aperture)
 {
@@ -724,11 +1066,11 @@ string EventConfigValueAperture::name() const
 
 string EventConfigValueAperture::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueAperture {{aperture = {}}}",
+                           aperture);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueAperture::to_json() const
@@ -736,6 +1078,16 @@ nlohmann::json EventConfigValueAperture::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueAperture::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("aperture", aperture).field("event_id", id).end();
+}
+
+void EventConfigValueAperture::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("aperture", aperture).read();
+}
+
 EventConfigChoicesAperture::EventConfigChoicesAperture(
     vector<int32_t> aperture_choices)
     : Event(id), aperture_choices(aperture_choices)
@@ -749,11 +1101,12 @@ string EventConfigChoicesAperture::name() const
 
 string EventConfigChoicesAperture::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventConfigChoicesAperture {{aperture_choices = {}}}",
+            aperture_choices);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigChoicesAperture::to_json() const
@@ -761,17 +1114,29 @@ nlohmann::json EventConfigChoicesAperture::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigChoicesAperture::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("aperture_choices", aperture_choices)
+        .field("event_id", id)
+        .end();
+}
+
+void EventConfigChoicesAperture::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("aperture_choices", aperture_choices).read();
+}
+
 EventConfigGetISO::EventConfigGetISO() : Event(id) {}
 
 string EventConfigGetISO::name() const { return "EventConfigGetISO"; }
 
 string EventConfigGetISO::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetISO::to_json() const
@@ -779,6 +1144,16 @@ nlohmann::json EventConfigGetISO::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetISO::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetISO::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigGetChoicesISO::EventConfigGetChoicesISO() : Event(id) {}
 
 string EventConfigGetChoicesISO::name() const
@@ -788,11 +1163,10 @@ string EventConfigGetChoicesISO::name() const
 
 string EventConfigGetChoicesISO::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetChoicesISO::to_json() const
@@ -800,17 +1174,26 @@ nlohmann::json EventConfigGetChoicesISO::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetChoicesISO::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetChoicesISO::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigSetISO::EventConfigSetISO(int32_t iso) : Event(id), iso(iso) {}
 
 string EventConfigSetISO::name() const { return "EventConfigSetISO"; }
 
 string EventConfigSetISO::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigSetISO {{iso = {}}}", iso);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigSetISO::to_json() const
@@ -818,17 +1201,26 @@ nlohmann::json EventConfigSetISO::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigSetISO::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("iso", iso).end();
+}
+
+void EventConfigSetISO::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("iso", iso).read();
+}
+
 EventConfigValueISO::EventConfigValueISO(int32_t iso) : Event(id), iso(iso) {}
 
 string EventConfigValueISO::name() const { return "EventConfigValueISO"; }
 
 string EventConfigValueISO::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueISO {{iso = {}}}", iso);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueISO::to_json() const
@@ -836,6 +1228,16 @@ nlohmann::json EventConfigValueISO::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueISO::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("iso", iso).end();
+}
+
+void EventConfigValueISO::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("iso", iso).read();
+}
+
 EventConfigChoicesISO::EventConfigChoicesISO(vector<int32_t> iso_choices)
     : Event(id), iso_choices(iso_choices)
 {
@@ -845,11 +1247,11 @@ string EventConfigChoicesISO::name() const { return "EventConfigChoicesISO"; }
 
 string EventConfigChoicesISO::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigChoicesISO {{iso_choices = {}}}",
+                           iso_choices);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigChoicesISO::to_json() const
@@ -857,17 +1259,29 @@ nlohmann::json EventConfigChoicesISO::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigChoicesISO::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("iso_choices", iso_choices)
+        .end();
+}
+
+void EventConfigChoicesISO::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("iso_choices", iso_choices).read();
+}
+
 EventConfigGetBattery::EventConfigGetBattery() : Event(id) {}
 
 string EventConfigGetBattery::name() const { return "EventConfigGetBattery"; }
 
 string EventConfigGetBattery::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetBattery::to_json() const
@@ -875,6 +1289,16 @@ nlohmann::json EventConfigGetBattery::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetBattery::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetBattery::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigValueBattery::EventConfigValueBattery(int32_t battery)
     : Event(id), battery(battery)
 {
@@ -887,11 +1311,10 @@ string EventConfigValueBattery::name() const
 
 string EventConfigValueBattery::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueBattery {{battery = {}}}", battery);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueBattery::to_json() const
@@ -899,6 +1322,16 @@ nlohmann::json EventConfigValueBattery::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueBattery::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("battery", battery).field("event_id", id).end();
+}
+
+void EventConfigValueBattery::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("battery", battery).read();
+}
+
 EventConfigGetFocalLength::EventConfigGetFocalLength() : Event(id) {}
 
 string EventConfigGetFocalLength::name() const
@@ -908,11 +1341,10 @@ string EventConfigGetFocalLength::name() const
 
 string EventConfigGetFocalLength::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetFocalLength::to_json() const
@@ -920,6 +1352,16 @@ nlohmann::json EventConfigGetFocalLength::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetFocalLength::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetFocalLength::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigValueFocalLength::EventConfigValueFocalLength(int32_t focal_length)
     : Event(id), focal_length(focal_length)
 {
@@ -932,11 +1374,11 @@ string EventConfigValueFocalLength::name() const
 
 string EventConfigValueFocalLength::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueFocalLength {{focal_length = {}}}",
+                           focal_length);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueFocalLength::to_json() const
@@ -944,6 +1386,19 @@ nlohmann::json EventConfigValueFocalLength::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueFocalLength::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("focal_length", focal_length)
+        .end();
+}
+
+void EventConfigValueFocalLength::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("focal_length", focal_length).read();
+}
+
 EventConfigGetFocusMode::EventConfigGetFocusMode() : Event(id) {}
 
 string EventConfigGetFocusMode::name() const
@@ -953,11 +1408,10 @@ string EventConfigGetFocusMode::name() const
 
 string EventConfigGetFocusMode::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetFocusMode::to_json() const
@@ -965,6 +1419,16 @@ nlohmann::json EventConfigGetFocusMode::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetFocusMode::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetFocusMode::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigNextFocusMode::EventConfigNextFocusMode() : Event(id) {}
 
 string EventConfigNextFocusMode::name() const
@@ -974,11 +1438,10 @@ string EventConfigNextFocusMode::name() const
 
 string EventConfigNextFocusMode::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigNextFocusMode::to_json() const
@@ -986,6 +1449,16 @@ nlohmann::json EventConfigNextFocusMode::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigNextFocusMode::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigNextFocusMode::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigValueFocusMode::EventConfigValueFocusMode(string focus_mode)
     : Event(id), focus_mode(focus_mode)
 {
@@ -998,11 +1471,11 @@ string EventConfigValueFocusMode::name() const
 
 string EventConfigValueFocusMode::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueFocusMode {{focus_mode = {}}}",
+                           focus_mode);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueFocusMode::to_json() const
@@ -1010,6 +1483,16 @@ nlohmann::json EventConfigValueFocusMode::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueFocusMode::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("focus_mode", focus_mode).end();
+}
+
+void EventConfigValueFocusMode::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("focus_mode", focus_mode).read();
+}
+
 EventConfigGetLongExpNR::EventConfigGetLongExpNR() : Event(id) {}
 
 string EventConfigGetLongExpNR::name() const
@@ -1019,11 +1502,10 @@ string EventConfigGetLongExpNR::name() const
 
 string EventConfigGetLongExpNR::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetLongExpNR::to_json() const
@@ -1031,6 +1513,16 @@ nlohmann::json EventConfigGetLongExpNR::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetLongExpNR::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetLongExpNR::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigSetLongExpNR::EventConfigSetLongExpNR(bool long_exp_nr)
     : Event(id), long_exp_nr(long_exp_nr)
 {
@@ -1043,11 +1535,11 @@ string EventConfigSetLongExpNR::name() const
 
 string EventConfigSetLongExpNR::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigSetLongExpNR {{long_exp_nr = {}}}",
+                           long_exp_nr);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigSetLongExpNR::to_json() const
@@ -1055,6 +1547,19 @@ nlohmann::json EventConfigSetLongExpNR::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigSetLongExpNR::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("long_exp_nr", long_exp_nr)
+        .end();
+}
+
+void EventConfigSetLongExpNR::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("long_exp_nr", long_exp_nr).read();
+}
+
 EventConfigValueLongExpNR::EventConfigValueLongExpNR(bool long_exp_nr)
     : Event(id), long_exp_nr(long_exp_nr)
 {
@@ -1067,11 +1572,11 @@ string EventConfigValueLongExpNR::name() const
 
 string EventConfigValueLongExpNR::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueLongExpNR {{long_exp_nr = {}}}",
+                           long_exp_nr);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueLongExpNR::to_json() const
@@ -1079,17 +1584,29 @@ nlohmann::json EventConfigValueLongExpNR::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueLongExpNR::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("long_exp_nr", long_exp_nr)
+        .end();
+}
+
+void EventConfigValueLongExpNR::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("long_exp_nr", long_exp_nr).read();
+}
+
 EventConfigGetVibRed::EventConfigGetVibRed() : Event(id) {}
 
 string EventConfigGetVibRed::name() const { return "EventConfigGetVibRed"; }
 
 string EventConfigGetVibRed::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetVibRed::to_json() const
@@ -1097,17 +1614,26 @@ nlohmann::json EventConfigGetVibRed::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetVibRed::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetVibRed::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigSetVibRed::EventConfigSetVibRed(bool vr) : Event(id), vr(vr) {}
 
 string EventConfigSetVibRed::name() const { return "EventConfigSetVibRed"; }
 
 string EventConfigSetVibRed::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigSetVibRed {{vr = {}}}", vr);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigSetVibRed::to_json() const
@@ -1115,17 +1641,26 @@ nlohmann::json EventConfigSetVibRed::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigSetVibRed::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("vr", vr).end();
+}
+
+void EventConfigSetVibRed::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("vr", vr).read();
+}
+
 EventConfigValueVibRed::EventConfigValueVibRed(bool vr) : Event(id), vr(vr) {}
 
 string EventConfigValueVibRed::name() const { return "EventConfigValueVibRed"; }
 
 string EventConfigValueVibRed::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueVibRed {{vr = {}}}", vr);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueVibRed::to_json() const
@@ -1133,6 +1668,16 @@ nlohmann::json EventConfigValueVibRed::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueVibRed::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("vr", vr).end();
+}
+
+void EventConfigValueVibRed::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("vr", vr).read();
+}
+
 EventConfigGetCaptureTarget::EventConfigGetCaptureTarget() : Event(id) {}
 
 string EventConfigGetCaptureTarget::name() const
@@ -1142,11 +1687,10 @@ string EventConfigGetCaptureTarget::name() const
 
 string EventConfigGetCaptureTarget::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetCaptureTarget::to_json() const
@@ -1154,6 +1698,16 @@ nlohmann::json EventConfigGetCaptureTarget::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetCaptureTarget::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetCaptureTarget::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigSetCaptureTarget::EventConfigSetCaptureTarget(string target)
     : Event(id), target(target)
 {
@@ -1166,11 +1720,11 @@ string EventConfigSetCaptureTarget::name() const
 
 string EventConfigSetCaptureTarget::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigSetCaptureTarget {{target = {}}}",
+                           target);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigSetCaptureTarget::to_json() const
@@ -1178,6 +1732,16 @@ nlohmann::json EventConfigSetCaptureTarget::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigSetCaptureTarget::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("target", target).end();
+}
+
+void EventConfigSetCaptureTarget::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("target", target).read();
+}
+
 EventConfigValueCaptureTarget::EventConfigValueCaptureTarget(string target)
     : Event(id), target(target)
 {
@@ -1190,11 +1754,11 @@ string EventConfigValueCaptureTarget::name() const
 
 string EventConfigValueCaptureTarget::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueCaptureTarget {{target = {}}}",
+                           target);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueCaptureTarget::to_json() const
@@ -1202,6 +1766,16 @@ nlohmann::json EventConfigValueCaptureTarget::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueCaptureTarget::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("target", target).end();
+}
+
+void EventConfigValueCaptureTarget::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("target", target).read();
+}
+
 EventConfigGetExposureProgram::EventConfigGetExposureProgram() : Event(id) {}
 
 string EventConfigGetExposureProgram::name() const
@@ -1211,11 +1785,10 @@ string EventConfigGetExposureProgram::name() const
 
 string EventConfigGetExposureProgram::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetExposureProgram::to_json() const
@@ -1223,6 +1796,16 @@ nlohmann::json EventConfigGetExposureProgram::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetExposureProgram::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetExposureProgram::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigValueExposureProgram::EventConfigValueExposureProgram(
     string exposure_program)
     : Event(id), exposure_program(exposure_program)
@@ -1236,11 +1819,12 @@ string EventConfigValueExposureProgram::name() const
 
 string EventConfigValueExposureProgram::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventConfigValueExposureProgram {{exposure_program = {}}}",
+            exposure_program);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueExposureProgram::to_json() const
@@ -1248,6 +1832,19 @@ nlohmann::json EventConfigValueExposureProgram::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueExposureProgram::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("exposure_program", exposure_program)
+        .end();
+}
+
+void EventConfigValueExposureProgram::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("exposure_program", exposure_program).read();
+}
+
 EventConfigGetLightMeter::EventConfigGetLightMeter() : Event(id) {}
 
 string EventConfigGetLightMeter::name() const
@@ -1257,11 +1854,10 @@ string EventConfigGetLightMeter::name() const
 
 string EventConfigGetLightMeter::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetLightMeter::to_json() const
@@ -1269,6 +1865,16 @@ nlohmann::json EventConfigGetLightMeter::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetLightMeter::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetLightMeter::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigValueLightMeter::EventConfigValueLightMeter(float light_meter,
                                                        float min, float max)
     : Event(id), light_meter(light_meter), min(min), max(max)
@@ -1282,11 +1888,13 @@ string EventConfigValueLightMeter::name() const
 
 string EventConfigValueLightMeter::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventConfigValueLightMeter {{light_meter = {}, min = {}, max = "
+            "{}}}",
+            light_meter, min, max);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueLightMeter::to_json() const
@@ -1294,17 +1902,35 @@ nlohmann::json EventConfigValueLightMeter::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueLightMeter::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("light_meter", light_meter)
+        .field("max", max)
+        .field("min", min)
+        .end();
+}
+
+void EventConfigValueLightMeter::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("light_meter", light_meter)
+        .field("min", min)
+        .field("max", max)
+        .read();
+}
+
 EventConfigGetAutoISO::EventConfigGetAutoISO() : Event(id) {}
 
 string EventConfigGetAutoISO::name() const { return "EventConfigGetAutoISO"; }
 
 string EventConfigGetAutoISO::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetAutoISO::to_json() const
@@ -1312,6 +1938,16 @@ nlohmann::json EventConfigGetAutoISO::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetAutoISO::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetAutoISO::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventConfigSetAutoISO::EventConfigSetAutoISO(bool auto_iso)
     : Event(id), auto_iso(auto_iso)
 {
@@ -1321,11 +1957,10 @@ string EventConfigSetAutoISO::name() const { return "EventConfigSetAutoISO"; }
 
 string EventConfigSetAutoISO::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigSetAutoISO {{auto_iso = {}}}", auto_iso);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigSetAutoISO::to_json() const
@@ -1333,6 +1968,16 @@ nlohmann::json EventConfigSetAutoISO::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigSetAutoISO::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("auto_iso", auto_iso).field("event_id", id).end();
+}
+
+void EventConfigSetAutoISO::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("auto_iso", auto_iso).read();
+}
+
 EventConfigValueAutoISO::EventConfigValueAutoISO(bool auto_iso)
     : Event(id), auto_iso(auto_iso)
 {
@@ -1345,11 +1990,11 @@ string EventConfigValueAutoISO::name() const
 
 string EventConfigValueAutoISO::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventConfigValueAutoISO {{auto_iso = {}}}",
+                           auto_iso);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigValueAutoISO::to_json() const
@@ -1357,17 +2002,26 @@ nlohmann::json EventConfigValueAutoISO::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigValueAutoISO::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("auto_iso", auto_iso).field("event_id", id).end();
+}
+
+void EventConfigValueAutoISO::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("auto_iso", auto_iso).read();
+}
+
 EventConfigGetAll::EventConfigGetAll() : Event(id) {}
 
 string EventConfigGetAll::name() const { return "EventConfigGetAll"; }
 
 string EventConfigGetAll::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventConfigGetAll::to_json() const
@@ -1375,17 +2029,26 @@ nlohmann::json EventConfigGetAll::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventConfigGetAll::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventConfigGetAll::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventGetCurrentMode::EventGetCurrentMode() : Event(id) {}
 
 string EventGetCurrentMode::name() const { return "EventGetCurrentMode"; }
 
 string EventGetCurrentMode::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventGetCurrentMode::to_json() const
@@ -1393,6 +2056,16 @@ nlohmann::json EventGetCurrentMode::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventGetCurrentMode::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventGetCurrentMode::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventValueCurrentMode::EventValueCurrentMode(string mode)
     : Event(id), mode(mode)
 {
@@ -1402,11 +2075,10 @@ string EventValueCurrentMode::name() const { return "EventValueCurrentMode"; }
 
 string EventValueCurrentMode::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format("EventValueCurrentMode {{mode = {}}}", mode);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventValueCurrentMode::to_json() const
@@ -1414,17 +2086,26 @@ nlohmann::json EventValueCurrentMode::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventValueCurrentMode::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("mode", mode).end();
+}
+
+void EventValueCurrentMode::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("mode", mode).read();
+}
+
 EventModeStopped::EventModeStopped() : Event(id) {}
 
 string EventModeStopped::name() const { return "EventModeStopped"; }
 
 string EventModeStopped::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventModeStopped::to_json() const
@@ -1432,21 +2113,40 @@ nlohmann::json EventModeStopped::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventModeStopped::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventModeStopped::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventModeStop::EventModeStop() : Event(id) {}
 
 string EventModeStop::name() const { return "EventModeStop"; }
 
 string EventModeStop::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventModeStop::to_json() const { return nlohmann::json(*this); }
 
+void EventModeStop::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventModeStop::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventModeIntervalometer::EventModeIntervalometer(int32_t intervalms,
                                                  int32_t total_captures)
     : Event(id), intervalms(intervalms), total_captures(total_captures)
@@ -1460,11 +2160,12 @@ string EventModeIntervalometer::name() const
 
 string EventModeIntervalometer::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventModeIntervalometer {{intervalms = {}, total_captures = {}}}",
+            intervalms, total_captures);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventModeIntervalometer::to_json() const
@@ -1472,9 +2173,28 @@ nlohmann::json EventModeIntervalometer::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventModeIntervalometer::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("intervalms", intervalms)
+        .field("total_captures", total_captures)
+        .end();
+}
+
+void EventModeIntervalometer::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("intervalms", intervalms)
+        .field("total_captures", total_captures)
+        .read();
+}
+
 EventIntervalometerStart::EventIntervalometerStart(int32_t intervalms,
-                                                   int32_t total_captures)
-    : Event(id), intervalms(intervalms), total_captures(total_captures)
+                                                   int32_t total_captures,
+                                                   string missed_policy)
+    : Event(id), intervalms(intervalms), total_captures(total_captures),
+      missed_policy(missed_policy)
 {
 }
 
@@ -1485,11 +2205,13 @@ string EventIntervalometerStart::name() const
 
 string EventIntervalometerStart::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventIntervalometerStart {{intervalms = {}, total_captures = {}, "
+            "missed_policy = {}}}",
+            intervalms, total_captures, missed_policy);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventIntervalometerStart::to_json() const
@@ -1497,6 +2219,25 @@ nlohmann::json EventIntervalometerStart::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventIntervalometerStart::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("intervalms", intervalms)
+        .field("missed_policy", missed_policy)
+        .field("total_captures", total_captures)
+        .end();
+}
+
+void EventIntervalometerStart::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("intervalms", intervalms)
+        .field("total_captures", total_captures)
+        .field("missed_policy", missed_policy)
+        .read();
+}
+
 EventIntervalometerDeadlineExpired::EventIntervalometerDeadlineExpired()
     : Event(id)
 {
@@ -1509,11 +2250,10 @@ string EventIntervalometerDeadlineExpired::name() const
 
 string EventIntervalometerDeadlineExpired::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventIntervalometerDeadlineExpired::to_json() const
@@ -1521,12 +2261,27 @@ nlohmann::json EventIntervalometerDeadlineExpired::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventIntervalometerDeadlineExpired::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventIntervalometerDeadlineExpired::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventIntervalometerState::EventIntervalometerState(string state,
                                                    int32_t intervalms,
                                                    int32_t num_captures,
-                                                   int32_t total_captures)
+                                                   int32_t total_captures,
+                                                   int32_t missed_frames,
+                                                   int32_t timing_error_us,
+                                                   int32_t max_timing_error_us)
     : Event(id), state(state), intervalms(intervalms),
-      num_captures(num_captures), total_captures(total_captures)
+      num_captures(num_captures), total_captures(total_captures),
+      missed_frames(missed_frames), timing_error_us(timing_error_us),
+      max_timing_error_us(max_timing_error_us)
 {
 }
 
@@ -1537,11 +2292,15 @@ string EventIntervalometerState::name() const
 
 string EventIntervalometerState::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return fmt::format(
+            "EventIntervalometerState {{state = {}, intervalms = {}, "
+            "num_captures = {}, total_captures = {}, missed_frames = {}, "
+            "timing_error_us = {}, max_timing_error_us = {}}}",
+            state, intervalms, num_captures, total_captures, missed_frames,
+            timing_error_us, max_timing_error_us);
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventIntervalometerState::to_json() const
@@ -1549,6 +2308,33 @@ nlohmann::json EventIntervalometerState::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventIntervalometerState::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("intervalms", intervalms)
+        .field("max_timing_error_us", max_timing_error_us)
+        .field("missed_frames", missed_frames)
+        .field("num_captures", num_captures)
+        .field("state", state)
+        .field("timing_error_us", timing_error_us)
+        .field("total_captures", total_captures)
+        .end();
+}
+
+void EventIntervalometerState::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("state", state)
+        .field("intervalms", intervalms)
+        .field("num_captures", num_captures)
+        .field("total_captures", total_captures)
+        .field("missed_frames", missed_frames)
+        .field("timing_error_us", timing_error_us)
+        .field("max_timing_error_us", max_timing_error_us)
+        .read();
+}
+
 EventEnableEventPassThrough::EventEnableEventPassThrough() : Event(id) {}
 
 string EventEnableEventPassThrough::name() const
@@ -1558,11 +2344,10 @@ string EventEnableEventPassThrough::name() const
 
 string EventEnableEventPassThrough::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventEnableEventPassThrough::to_json() const
@@ -1570,6 +2355,16 @@ nlohmann::json EventEnableEventPassThrough::to_json() const
     return nlohmann::json(*this);
 }
 
+void EventEnableEventPassThrough::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventEnableEventPassThrough::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
 EventDisableEventPassThrough::EventDisableEventPassThrough() : Event(id) {}
 
 string EventDisableEventPassThrough::name() const
@@ -1579,11 +2374,10 @@ string EventDisableEventPassThrough::name() const
 
 string EventDisableEventPassThrough::to_string(int indent) const
 {
-    nlohmann::json j = to_json();
     if (indent < 0)
-        return fmt::format("{} {}", name(), j.dump(indent));
+        return name();
     else
-        return fmt::format("{}\n{}", name(), j.dump(indent));
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
 }
 
 nlohmann::json EventDisableEventPassThrough::to_json() const
@@ -1591,290 +2385,1685 @@ nlohmann::json EventDisableEventPassThrough::to_json() const
     return nlohmann::json(*this);
 }
 
-EventPtr jsonToEvent(const nlohmann::json& j)
+void EventDisableEventPassThrough::write_json(fmt::memory_buffer& out) const
 {
-    switch (static_cast<uint16_t>(j.at("event_id")))
-    {
-        case EventHeartBeat::id:
-            return make_shared<EventHeartBeat>(j.get<EventHeartBeat>());
-            break;
-        case EventCmdRestart::id:
-            return make_shared<EventCmdRestart>(j.get<EventCmdRestart>());
-            break;
-        case EventCmdReboot::id:
-            return make_shared<EventCmdReboot>(j.get<EventCmdReboot>());
-            break;
-        case EventCmdShutdown::id:
-            return make_shared<EventCmdShutdown>(j.get<EventCmdShutdown>());
-            break;
-        case EventCameraCmdConnect::id:
-            return make_shared<EventCameraCmdConnect>(
-                j.get<EventCameraCmdConnect>());
-            break;
-        case EventCameraCmdDisconnect::id:
-            return make_shared<EventCameraCmdDisconnect>(
-                j.get<EventCameraCmdDisconnect>());
-            break;
-        case EventCameraCmdRecoverError::id:
-            return make_shared<EventCameraCmdRecoverError>(
-                j.get<EventCameraCmdRecoverError>());
-            break;
-        case EventCameraCaptureStarted::id:
-            return make_shared<EventCameraCaptureStarted>(
-                j.get<EventCameraCaptureStarted>());
-            break;
-        case EventCameraCmdCapture::id:
-            return make_shared<EventCameraCmdCapture>(
-                j.get<EventCameraCmdCapture>());
-            break;
-        case EventCameraCmdCapture_Internal::id:
-            return make_shared<EventCameraCmdCapture_Internal>(
-                j.get<EventCameraCmdCapture_Internal>());
-            break;
-        case EventCameraCmdDownload::id:
-            return make_shared<EventCameraCmdDownload>(
-                j.get<EventCameraCmdDownload>());
-            break;
-        case EventCameraCmdDownload_Internal::id:
-            return make_shared<EventCameraCmdDownload_Internal>(
-                j.get<EventCameraCmdDownload_Internal>());
-            break;
-        case EventCameraConnected::id:
-            return make_shared<EventCameraConnected>(
-                j.get<EventCameraConnected>());
-            break;
-        case EventCameraReady::id:
-            return make_shared<EventCameraReady>(j.get<EventCameraReady>());
-            break;
-        case EventCameraBusyOrError::id:
-            return make_shared<EventCameraBusyOrError>(
-                j.get<EventCameraBusyOrError>());
-            break;
-        case EventCameraDisconnected::id:
-            return make_shared<EventCameraDisconnected>(
-                j.get<EventCameraDisconnected>());
-            break;
-        case EventCameraConnectionError::id:
-            return make_shared<EventCameraConnectionError>(
-                j.get<EventCameraConnectionError>());
-            break;
-        case EventCameraError::id:
-            return make_shared<EventCameraError>(j.get<EventCameraError>());
-            break;
-        case EventCameraIgnoreError::id:
-            return make_shared<EventCameraIgnoreError>(
-                j.get<EventCameraIgnoreError>());
-            break;
-        case EventCameraCmdLowLatency::id:
-            return make_shared<EventCameraCmdLowLatency>(
-                j.get<EventCameraCmdLowLatency>());
-            break;
-        case EventCameraCaptureDone::id:
-            return make_shared<EventCameraCaptureDone>(
-                j.get<EventCameraCaptureDone>());
-            break;
-        case EventGetCameraControllerState::id:
-            return make_shared<EventGetCameraControllerState>(
-                j.get<EventGetCameraControllerState>());
-            break;
-        case EventCameraControllerState::id:
-            return make_shared<EventCameraControllerState>(
-                j.get<EventCameraControllerState>());
-            break;
-        case EventConfigGetShutterSpeed::id:
-            return make_shared<EventConfigGetShutterSpeed>(
-                j.get<EventConfigGetShutterSpeed>());
-            break;
-        case EventConfigGetChoicesShutterSpeed::id:
-            return make_shared<EventConfigGetChoicesShutterSpeed>(
-                j.get<EventConfigGetChoicesShutterSpeed>());
-            break;
-        case EventConfigSetShutterSpeed::id:
-            return make_shared<EventConfigSetShutterSpeed>(
-                j.get<EventConfigSetShutterSpeed>());
-            break;
-        case EventConfigValueShutterSpeed::id:
-            return make_shared<EventConfigValueShutterSpeed>(
-                j.get<EventConfigValueShutterSpeed>());
-            break;
-        case EventConfigChoicesShutterSpeed::id:
-            return make_shared<EventConfigChoicesShutterSpeed>(
-                j.get<EventConfigChoicesShutterSpeed>());
-            break;
-        case EventConfigGetAperture::id:
-            return make_shared<EventConfigGetAperture>(
-                j.get<EventConfigGetAperture>());
-            break;
-        case EventConfigGetChoicesAperture::id:
-            return make_shared<EventConfigGetChoicesAperture>(
-                j.get<EventConfigGetChoicesAperture>());
-            break;
-        case EventConfigSetAperture::id:
-            return make_shared<EventConfigSetAperture>(
-                j.get<EventConfigSetAperture>());
-            break;
-        case EventConfigValueAperture::id:
-            return make_shared<EventConfigValueAperture>(
-                j.get<EventConfigValueAperture>());
-            break;
-        case EventConfigChoicesAperture::id:
-            return make_shared<EventConfigChoicesAperture>(
-                j.get<EventConfigChoicesAperture>());
-            break;
-        case EventConfigGetISO::id:
-            return make_shared<EventConfigGetISO>(j.get<EventConfigGetISO>());
-            break;
-        case EventConfigGetChoicesISO::id:
-            return make_shared<EventConfigGetChoicesISO>(
-                j.get<EventConfigGetChoicesISO>());
-            break;
-        case EventConfigSetISO::id:
-            return make_shared<EventConfigSetISO>(j.get<EventConfigSetISO>());
-            break;
-        case EventConfigValueISO::id:
-            return make_shared<EventConfigValueISO>(
-                j.get<EventConfigValueISO>());
-            break;
-        case EventConfigChoicesISO::id:
-            return make_shared<EventConfigChoicesISO>(
-                j.get<EventConfigChoicesISO>());
-            break;
-        case EventConfigGetBattery::id:
-            return make_shared<EventConfigGetBattery>(
-                j.get<EventConfigGetBattery>());
-            break;
-        case EventConfigValueBattery::id:
-            return make_shared<EventConfigValueBattery>(
-                j.get<EventConfigValueBattery>());
-            break;
-        case EventConfigGetFocalLength::id:
-            return make_shared<EventConfigGetFocalLength>(
-                j.get<EventConfigGetFocalLength>());
-            break;
-        case EventConfigValueFocalLength::id:
-            return make_shared<EventConfigValueFocalLength>(
-                j.get<EventConfigValueFocalLength>());
-            break;
-        case EventConfigGetFocusMode::id:
-            return make_shared<EventConfigGetFocusMode>(
-                j.get<EventConfigGetFocusMode>());
-            break;
-        case EventConfigNextFocusMode::id:
-            return make_shared<EventConfigNextFocusMode>(
-                j.get<EventConfigNextFocusMode>());
-            break;
-        case EventConfigValueFocusMode::id:
-            return make_shared<EventConfigValueFocusMode>(
-                j.get<EventConfigValueFocusMode>());
-            break;
-        case EventConfigGetLongExpNR::id:
-            return make_shared<EventConfigGetLongExpNR>(
-                j.get<EventConfigGetLongExpNR>());
-            break;
-        case EventConfigSetLongExpNR::id:
-            return make_shared<EventConfigSetLongExpNR>(
-                j.get<EventConfigSetLongExpNR>());
-            break;
-        case EventConfigValueLongExpNR::id:
-            return make_shared<EventConfigValueLongExpNR>(
-                j.get<EventConfigValueLongExpNR>());
-            break;
-        case EventConfigGetVibRed::id:
-            return make_shared<EventConfigGetVibRed>(
-                j.get<EventConfigGetVibRed>());
-            break;
-        case EventConfigSetVibRed::id:
-            return make_shared<EventConfigSetVibRed>(
-                j.get<EventConfigSetVibRed>());
-            break;
-        case EventConfigValueVibRed::id:
-            return make_shared<EventConfigValueVibRed>(
-                j.get<EventConfigValueVibRed>());
-            break;
-        case EventConfigGetCaptureTarget::id:
-            return make_shared<EventConfigGetCaptureTarget>(
-                j.get<EventConfigGetCaptureTarget>());
-            break;
-        case EventConfigSetCaptureTarget::id:
-            return make_shared<EventConfigSetCaptureTarget>(
-                j.get<EventConfigSetCaptureTarget>());
-            break;
-        case EventConfigValueCaptureTarget::id:
-            return make_shared<EventConfigValueCaptureTarget>(
-                j.get<EventConfigValueCaptureTarget>());
-            break;
-        case EventConfigGetExposureProgram::id:
-            return make_shared<EventConfigGetExposureProgram>(
-                j.get<EventConfigGetExposureProgram>());
-            break;
-        case EventConfigValueExposureProgram::id:
-            return make_shared<EventConfigValueExposureProgram>(
-                j.get<EventConfigValueExposureProgram>());
-            break;
-        case EventConfigGetLightMeter::id:
-            return make_shared<EventConfigGetLightMeter>(
-                j.get<EventConfigGetLightMeter>());
-            break;
-        case EventConfigValueLightMeter::id:
-            return make_shared<EventConfigValueLightMeter>(
-                j.get<EventConfigValueLightMeter>());
-            break;
-        case EventConfigGetAutoISO::id:
-            return make_shared<EventConfigGetAutoISO>(
-                j.get<EventConfigGetAutoISO>());
-            break;
-        case EventConfigSetAutoISO::id:
-            return make_shared<EventConfigSetAutoISO>(
-                j.get<EventConfigSetAutoISO>());
-            break;
-        case EventConfigValueAutoISO::id:
-            return make_shared<EventConfigValueAutoISO>(
-                j.get<EventConfigValueAutoISO>());
-            break;
-        case EventConfigGetAll::id:
-            return make_shared<EventConfigGetAll>(j.get<EventConfigGetAll>());
-            break;
-        case EventGetCurrentMode::id:
-            return make_shared<EventGetCurrentMode>(
-                j.get<EventGetCurrentMode>());
-            break;
-        case EventValueCurrentMode::id:
-            return make_shared<EventValueCurrentMode>(
-                j.get<EventValueCurrentMode>());
-            break;
-        case EventModeStopped::id:
-            return make_shared<EventModeStopped>(j.get<EventModeStopped>());
-            break;
-        case EventModeStop::id:
-            return make_shared<EventModeStop>(j.get<EventModeStop>());
-            break;
-        case EventModeIntervalometer::id:
-            return make_shared<EventModeIntervalometer>(
-                j.get<EventModeIntervalometer>());
-            break;
-        case EventIntervalometerStart::id:
-            return make_shared<EventIntervalometerStart>(
-                j.get<EventIntervalometerStart>());
-            break;
-        case EventIntervalometerDeadlineExpired::id:
-            return make_shared<EventIntervalometerDeadlineExpired>(
-                j.get<EventIntervalometerDeadlineExpired>());
-            break;
-        case EventIntervalometerState::id:
-            return make_shared<EventIntervalometerState>(
-                j.get<EventIntervalometerState>());
-            break;
-        case EventEnableEventPassThrough::id:
-            return make_shared<EventEnableEventPassThrough>(
-                j.get<EventEnableEventPassThrough>());
-            break;
-        case EventDisableEventPassThrough::id:
-            return make_shared<EventDisableEventPassThrough>(
-                j.get<EventDisableEventPassThrough>());
-            break;
-
-        default:
-            throw std::out_of_range{"No event with provided ID"};
-            break;
-    }
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventDisableEventPassThrough::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+EventModeIntervalometerAnchored::EventModeIntervalometerAnchored(
+    int32_t intervalms, int32_t total_captures, string missed_policy)
+    : Event(id), intervalms(intervalms), total_captures(total_captures),
+      missed_policy(missed_policy)
+{
+}
+
+string EventModeIntervalometerAnchored::name() const
+{
+    return "EventModeIntervalometerAnchored";
+}
+
+string EventModeIntervalometerAnchored::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventModeIntervalometerAnchored {{intervalms = {}, "
+            "total_captures = {}, missed_policy = {}}}",
+            intervalms, total_captures, missed_policy);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventModeIntervalometerAnchored::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventModeIntervalometerAnchored::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("intervalms", intervalms)
+        .field("missed_policy", missed_policy)
+        .field("total_captures", total_captures)
+        .end();
+}
+
+void EventModeIntervalometerAnchored::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("intervalms", intervalms)
+        .field("total_captures", total_captures)
+        .field("missed_policy", missed_policy)
+        .read();
+}
+
+EventModeBulbRamping::EventModeBulbRamping(int32_t intervalms,
+                                           int32_t total_captures,
+                                           float max_ev_step, int32_t max_iso)
+    : Event(id), intervalms(intervalms), total_captures(total_captures),
+      max_ev_step(max_ev_step), max_iso(max_iso)
+{
+}
+
+string EventModeBulbRamping::name() const { return "EventModeBulbRamping"; }
+
+string EventModeBulbRamping::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventModeBulbRamping {{intervalms = {}, total_captures = {}, "
+            "max_ev_step = {}, max_iso = {}}}",
+            intervalms, total_captures, max_ev_step, max_iso);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventModeBulbRamping::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventModeBulbRamping::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("intervalms", intervalms)
+        .field("max_ev_step", max_ev_step)
+        .field("max_iso", max_iso)
+        .field("total_captures", total_captures)
+        .end();
+}
+
+void EventModeBulbRamping::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("intervalms", intervalms)
+        .field("total_captures", total_captures)
+        .field("max_ev_step", max_ev_step)
+        .field("max_iso", max_iso)
+        .read();
+}
+
+EventBulbRampingStart::EventBulbRampingStart(int32_t intervalms,
+                                             int32_t total_captures,
+                                             float max_ev_step, int32_t max_iso)
+    : Event(id), intervalms(intervalms), total_captures(total_captures),
+      max_ev_step(max_ev_step), max_iso(max_iso)
+{
+}
+
+string EventBulbRampingStart::name() const { return "EventBulbRampingStart"; }
+
+string EventBulbRampingStart::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventBulbRampingStart {{intervalms = {}, total_captures = {}, "
+            "max_ev_step = {}, max_iso = {}}}",
+            intervalms, total_captures, max_ev_step, max_iso);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventBulbRampingStart::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventBulbRampingStart::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event_id", id)
+        .field("intervalms", intervalms)
+        .field("max_ev_step", max_ev_step)
+        .field("max_iso", max_iso)
+        .field("total_captures", total_captures)
+        .end();
+}
+
+void EventBulbRampingStart::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("intervalms", intervalms)
+        .field("total_captures", total_captures)
+        .field("max_ev_step", max_ev_step)
+        .field("max_iso", max_iso)
+        .read();
+}
+
+EventBulbRampingDeadlineExpired::EventBulbRampingDeadlineExpired() : Event(id)
+{
+}
+
+string EventBulbRampingDeadlineExpired::name() const
+{
+    return "EventBulbRampingDeadlineExpired";
+}
+
+string EventBulbRampingDeadlineExpired::to_string(int indent) const
+{
+    if (indent < 0)
+        return name();
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventBulbRampingDeadlineExpired::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventBulbRampingDeadlineExpired::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventBulbRampingDeadlineExpired::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+EventBulbRampingState::EventBulbRampingState(string state, int32_t num_captures,
+                                             int32_t total_captures,
+                                             int32_t shutter_speed, int32_t iso,
+                                             int32_t aperture,
+                                             float exposure_ev,
+                                             float light_meter,
+                                             int32_t late_writes,
+                                             int32_t write_overrun_ms)
+    : Event(id), state(state), num_captures(num_captures),
+      total_captures(total_captures), shutter_speed(shutter_speed), iso(iso),
+      aperture(aperture), exposure_ev(exposure_ev), light_meter(light_meter),
+      late_writes(late_writes), write_overrun_ms(write_overrun_ms)
+{
+}
+
+string EventBulbRampingState::name() const { return "EventBulbRampingState"; }
+
+string EventBulbRampingState::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventBulbRampingState {{state = {}, num_captures = {}, "
+            "total_captures = {}, shutter_speed = {}, iso = {}, aperture = "
+            "{}, exposure_ev = {}, light_meter = {}, late_writes = {}, "
+            "write_overrun_ms = {}}}",
+            state, num_captures, total_captures, shutter_speed, iso, aperture,
+            exposure_ev, light_meter, late_writes, write_overrun_ms);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventBulbRampingState::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventBulbRampingState::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("aperture", aperture)
+        .field("event_id", id)
+        .field("exposure_ev", exposure_ev)
+        .field("iso", iso)
+        .field("late_writes", late_writes)
+        .field("light_meter", light_meter)
+        .field("num_captures", num_captures)
+        .field("shutter_speed", shutter_speed)
+        .field("state", state)
+        .field("total_captures", total_captures)
+        .field("write_overrun_ms", write_overrun_ms)
+        .end();
+}
+
+void EventBulbRampingState::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("state", state)
+        .field("num_captures", num_captures)
+        .field("total_captures", total_captures)
+        .field("shutter_speed", shutter_speed)
+        .field("iso", iso)
+        .field("aperture", aperture)
+        .field("exposure_ev", exposure_ev)
+        .field("light_meter", light_meter)
+        .field("late_writes", late_writes)
+        .field("write_overrun_ms", write_overrun_ms)
+        .read();
+}
+
+EventModeBracketing::EventModeBracketing(int32_t num_frames, float ev_step,
+                                         bool pipelined)
+    : Event(id), num_frames(num_frames), ev_step(ev_step), pipelined(pipelined)
+{
+}
+
+string EventModeBracketing::name() const { return "EventModeBracketing"; }
+
+string EventModeBracketing::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventModeBracketing {{num_frames = {}, ev_step = {}, pipelined = "
+            "{}}}",
+            num_frames, ev_step, pipelined);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventModeBracketing::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventModeBracketing::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("ev_step", ev_step)
+        .field("event_id", id)
+        .field("num_frames", num_frames)
+        .field("pipelined", pipelined)
+        .end();
+}
+
+void EventModeBracketing::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("num_frames", num_frames)
+        .field("ev_step", ev_step)
+        .field("pipelined", pipelined)
+        .read();
+}
+
+EventBracketingStart::EventBracketingStart(int32_t num_frames, float ev_step,
+                                           bool pipelined)
+    : Event(id), num_frames(num_frames), ev_step(ev_step), pipelined(pipelined)
+{
+}
+
+string EventBracketingStart::name() const { return "EventBracketingStart"; }
+
+string EventBracketingStart::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventBracketingStart {{num_frames = {}, ev_step = {}, pipelined "
+            "= {}}}",
+            num_frames, ev_step, pipelined);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventBracketingStart::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventBracketingStart::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("ev_step", ev_step)
+        .field("event_id", id)
+        .field("num_frames", num_frames)
+        .field("pipelined", pipelined)
+        .end();
+}
+
+void EventBracketingStart::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("num_frames", num_frames)
+        .field("ev_step", ev_step)
+        .field("pipelined", pipelined)
+        .read();
+}
+
+EventBracketingState::EventBracketingState(string state, int32_t num_frames,
+                                           int32_t num_captures,
+                                           vector<int32_t> shutter_speeds,
+                                           bool pipelined,
+                                           int32_t bracket_time_ms)
+    : Event(id), state(state), num_frames(num_frames),
+      num_captures(num_captures), shutter_speeds(shutter_speeds),
+      pipelined(pipelined), bracket_time_ms(bracket_time_ms)
+{
+}
+
+string EventBracketingState::name() const { return "EventBracketingState"; }
+
+string EventBracketingState::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventBracketingState {{state = {}, num_frames = {}, num_captures "
+            "= {}, shutter_speeds = {}, pipelined = {}, bracket_time_ms = {}}}",
+            state, num_frames, num_captures, shutter_speeds, pipelined,
+            bracket_time_ms);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventBracketingState::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventBracketingState::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("bracket_time_ms", bracket_time_ms)
+        .field("event_id", id)
+        .field("num_captures", num_captures)
+        .field("num_frames", num_frames)
+        .field("pipelined", pipelined)
+        .field("shutter_speeds", shutter_speeds)
+        .field("state", state)
+        .end();
+}
+
+void EventBracketingState::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("state", state)
+        .field("num_frames", num_frames)
+        .field("num_captures", num_captures)
+        .field("shutter_speeds", shutter_speeds)
+        .field("pipelined", pipelined)
+        .field("bracket_time_ms", bracket_time_ms)
+        .read();
+}
+
+EventCameraCmdFocusDrive::EventCameraCmdFocusDrive(int32_t steps)
+    : Event(id), steps(steps)
+{
+}
+
+string EventCameraCmdFocusDrive::name() const
+{
+    return "EventCameraCmdFocusDrive";
+}
+
+string EventCameraCmdFocusDrive::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format("EventCameraCmdFocusDrive {{steps = {}}}", steps);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraCmdFocusDrive::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraCmdFocusDrive::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("steps", steps).end();
+}
+
+void EventCameraCmdFocusDrive::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("steps", steps).read();
+}
+
+EventCameraCmdAutofocus::EventCameraCmdAutofocus() : Event(id) {}
+
+string EventCameraCmdAutofocus::name() const
+{
+    return "EventCameraCmdAutofocus";
+}
+
+string EventCameraCmdAutofocus::to_string(int indent) const
+{
+    if (indent < 0)
+        return name();
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraCmdAutofocus::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraCmdAutofocus::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdAutofocus::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+EventCameraFocusDriveDone::EventCameraFocusDriveDone(int32_t steps,
+                                                     int32_t drive_time_ms)
+    : Event(id), steps(steps), drive_time_ms(drive_time_ms)
+{
+}
+
+string EventCameraFocusDriveDone::name() const
+{
+    return "EventCameraFocusDriveDone";
+}
+
+string EventCameraFocusDriveDone::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventCameraFocusDriveDone {{steps = {}, drive_time_ms = {}}}",
+            steps, drive_time_ms);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraFocusDriveDone::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraFocusDriveDone::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("drive_time_ms", drive_time_ms)
+        .field("event_id", id)
+        .field("steps", steps)
+        .end();
+}
+
+void EventCameraFocusDriveDone::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("steps", steps)
+        .field("drive_time_ms", drive_time_ms)
+        .read();
+}
+
+EventModeFocusStacking::EventModeFocusStacking(int32_t num_frames,
+                                               int32_t focus_steps,
+                                               bool autofocus)
+    : Event(id), num_frames(num_frames), focus_steps(focus_steps),
+      autofocus(autofocus)
+{
+}
+
+string EventModeFocusStacking::name() const { return "EventModeFocusStacking"; }
+
+string EventModeFocusStacking::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventModeFocusStacking {{num_frames = {}, focus_steps = {}, "
+            "autofocus = {}}}",
+            num_frames, focus_steps, autofocus);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventModeFocusStacking::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventModeFocusStacking::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("autofocus", autofocus)
+        .field("event_id", id)
+        .field("focus_steps", focus_steps)
+        .field("num_frames", num_frames)
+        .end();
+}
+
+void EventModeFocusStacking::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("num_frames", num_frames)
+        .field("focus_steps", focus_steps)
+        .field("autofocus", autofocus)
+        .read();
+}
+
+EventFocusStackingStart::EventFocusStackingStart(int32_t num_frames,
+                                                 int32_t focus_steps,
+                                                 bool autofocus)
+    : Event(id), num_frames(num_frames), focus_steps(focus_steps),
+      autofocus(autofocus)
+{
+}
+
+string EventFocusStackingStart::name() const
+{
+    return "EventFocusStackingStart";
+}
+
+string EventFocusStackingStart::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventFocusStackingStart {{num_frames = {}, focus_steps = {}, "
+            "autofocus = {}}}",
+            num_frames, focus_steps, autofocus);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventFocusStackingStart::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventFocusStackingStart::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("autofocus", autofocus)
+        .field("event_id", id)
+        .field("focus_steps", focus_steps)
+        .field("num_frames", num_frames)
+        .end();
+}
+
+void EventFocusStackingStart::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("num_frames", num_frames)
+        .field("focus_steps", focus_steps)
+        .field("autofocus", autofocus)
+        .read();
+}
+
+EventFocusStackingState::EventFocusStackingState(string state,
+                                                 int32_t num_frames,
+                                                 int32_t num_captures,
+                                                 int32_t focus_steps,
+                                                 int32_t capture_time_ms,
+                                                 int32_t focus_time_ms,
+                                                 int32_t step_time_ms,
+                                                 int32_t avg_step_time_ms,
+                                                 int32_t stack_time_ms)
+    : Event(id), state(state), num_frames(num_frames),
+      num_captures(num_captures), focus_steps(focus_steps),
+      capture_time_ms(capture_time_ms), focus_time_ms(focus_time_ms),
+      step_time_ms(step_time_ms), avg_step_time_ms(avg_step_time_ms),
+      stack_time_ms(stack_time_ms)
+{
+}
+
+string EventFocusStackingState::name() const
+{
+    return "EventFocusStackingState";
+}
+
+string EventFocusStackingState::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventFocusStackingState {{state = {}, num_frames = {}, "
+            "num_captures = {}, focus_steps = {}, capture_time_ms = {}, "
+            "focus_time_ms = {}, step_time_ms = {}, avg_step_time_ms = {}, "
+            "stack_time_ms = {}}}",
+            state, num_frames, num_captures, focus_steps, capture_time_ms,
+            focus_time_ms, step_time_ms, avg_step_time_ms, stack_time_ms);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventFocusStackingState::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventFocusStackingState::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("avg_step_time_ms", avg_step_time_ms)
+        .field("capture_time_ms", capture_time_ms)
+        .field("event_id", id)
+        .field("focus_steps", focus_steps)
+        .field("focus_time_ms", focus_time_ms)
+        .field("num_captures", num_captures)
+        .field("num_frames", num_frames)
+        .field("stack_time_ms", stack_time_ms)
+        .field("state", state)
+        .field("step_time_ms", step_time_ms)
+        .end();
+}
+
+void EventFocusStackingState::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("state", state)
+        .field("num_frames", num_frames)
+        .field("num_captures", num_captures)
+        .field("focus_steps", focus_steps)
+        .field("capture_time_ms", capture_time_ms)
+        .field("focus_time_ms", focus_time_ms)
+        .field("step_time_ms", step_time_ms)
+        .field("avg_step_time_ms", avg_step_time_ms)
+        .field("stack_time_ms", stack_time_ms)
+        .read();
+}
+
+EventCameraCmdPollEvents_Internal::EventCameraCmdPollEvents_Internal()
+    : Event(id)
+{
+}
+
+string EventCameraCmdPollEvents_Internal::name() const
+{
+    return "EventCameraCmdPollEvents_Internal";
+}
+
+string EventCameraCmdPollEvents_Internal::to_string(int indent) const
+{
+    if (indent < 0)
+        return name();
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraCmdPollEvents_Internal::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraCmdPollEvents_Internal::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdPollEvents_Internal::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+EventCameraCmdCaptureAll::EventCameraCmdCaptureAll() : Event(id) {}
+
+string EventCameraCmdCaptureAll::name() const
+{
+    return "EventCameraCmdCaptureAll";
+}
+
+string EventCameraCmdCaptureAll::to_string(int indent) const
+{
+    if (indent < 0)
+        return name();
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraCmdCaptureAll::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraCmdCaptureAll::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCameraCmdCaptureAll::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+EventCaptureAllDone::EventCaptureAllDone(int32_t num_cameras,
+                                         int32_t num_captured,
+                                         int32_t trigger_skew_us,
+                                         int32_t capture_time_ms)
+    : Event(id), num_cameras(num_cameras), num_captured(num_captured),
+      trigger_skew_us(trigger_skew_us), capture_time_ms(capture_time_ms)
+{
+}
+
+string EventCaptureAllDone::name() const { return "EventCaptureAllDone"; }
+
+string EventCaptureAllDone::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventCaptureAllDone {{num_cameras = {}, num_captured = {}, "
+            "trigger_skew_us = {}, capture_time_ms = {}}}",
+            num_cameras, num_captured, trigger_skew_us, capture_time_ms);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCaptureAllDone::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCaptureAllDone::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("capture_time_ms", capture_time_ms)
+        .field("event_id", id)
+        .field("num_cameras", num_cameras)
+        .field("num_captured", num_captured)
+        .field("trigger_skew_us", trigger_skew_us)
+        .end();
+}
+
+void EventCaptureAllDone::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("num_cameras", num_cameras)
+        .field("num_captured", num_captured)
+        .field("trigger_skew_us", trigger_skew_us)
+        .field("capture_time_ms", capture_time_ms)
+        .read();
+}
+
+EventGetCameraList::EventGetCameraList() : Event(id) {}
+
+string EventGetCameraList::name() const { return "EventGetCameraList"; }
+
+string EventGetCameraList::to_string(int indent) const
+{
+    if (indent < 0)
+        return name();
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventGetCameraList::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventGetCameraList::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventGetCameraList::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+EventCameraList::EventCameraList(vector<string> serials)
+    : Event(id), serials(serials)
+{
+}
+
+string EventCameraList::name() const { return "EventCameraList"; }
+
+string EventCameraList::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format("EventCameraList {{serials = {}}}", serials);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraList::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraList::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("serials", serials).end();
+}
+
+void EventCameraList::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("serials", serials).read();
+}
+
+EventCameraCmdForward::EventCameraCmdForward(string serial, string event)
+    : Event(id), serial(serial), event(event)
+{
+}
+
+string EventCameraCmdForward::name() const { return "EventCameraCmdForward"; }
+
+string EventCameraCmdForward::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format("EventCameraCmdForward {{serial = {}, event = {}}}",
+                           serial, event);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraCmdForward::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraCmdForward::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event", event)
+        .field("event_id", id)
+        .field("serial", serial)
+        .end();
+}
+
+void EventCameraCmdForward::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("serial", serial).field("event", event).read();
+}
+
+EventCameraForwarded::EventCameraForwarded(string serial, string event)
+    : Event(id), serial(serial), event(event)
+{
+}
+
+string EventCameraForwarded::name() const { return "EventCameraForwarded"; }
+
+string EventCameraForwarded::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format("EventCameraForwarded {{serial = {}, event = {}}}",
+                           serial, event);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraForwarded::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraForwarded::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("event", event)
+        .field("event_id", id)
+        .field("serial", serial)
+        .end();
+}
+
+void EventCameraForwarded::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("serial", serial).field("event", event).read();
+}
+
+EventCaptureAllFinish_Internal::EventCaptureAllFinish_Internal() : Event(id) {}
+
+string EventCaptureAllFinish_Internal::name() const
+{
+    return "EventCaptureAllFinish_Internal";
+}
+
+string EventCaptureAllFinish_Internal::to_string(int indent) const
+{
+    if (indent < 0)
+        return name();
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCaptureAllFinish_Internal::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCaptureAllFinish_Internal::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventCaptureAllFinish_Internal::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+EventUsbDeviceAdded::EventUsbDeviceAdded(string port) : Event(id), port(port) {}
+
+string EventUsbDeviceAdded::name() const { return "EventUsbDeviceAdded"; }
+
+string EventUsbDeviceAdded::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format("EventUsbDeviceAdded {{port = {}}}", port);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventUsbDeviceAdded::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventUsbDeviceAdded::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("port", port).end();
+}
+
+void EventUsbDeviceAdded::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("port", port).read();
+}
+
+EventUsbDeviceRemoved::EventUsbDeviceRemoved(string port)
+    : Event(id), port(port)
+{
+}
+
+string EventUsbDeviceRemoved::name() const { return "EventUsbDeviceRemoved"; }
+
+string EventUsbDeviceRemoved::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format("EventUsbDeviceRemoved {{port = {}}}", port);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventUsbDeviceRemoved::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventUsbDeviceRemoved::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("port", port).end();
+}
+
+void EventUsbDeviceRemoved::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("port", port).read();
+}
+
+EventCoroutineResume_Internal::EventCoroutineResume_Internal(int32_t token)
+    : Event(id), token(token)
+{
+}
+
+string EventCoroutineResume_Internal::name() const
+{
+    return "EventCoroutineResume_Internal";
+}
+
+string EventCoroutineResume_Internal::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format("EventCoroutineResume_Internal {{token = {}}}",
+                           token);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCoroutineResume_Internal::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCoroutineResume_Internal::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("token", token).end();
+}
+
+void EventCoroutineResume_Internal::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("token", token).read();
+}
+
+EventCameraOpDone_Internal::EventCameraOpDone_Internal(bool success)
+    : Event(id), success(success)
+{
+}
+
+string EventCameraOpDone_Internal::name() const
+{
+    return "EventCameraOpDone_Internal";
+}
+
+string EventCameraOpDone_Internal::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format("EventCameraOpDone_Internal {{success = {}}}",
+                           success);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventCameraOpDone_Internal::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventCameraOpDone_Internal::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).field("success", success).end();
+}
+
+void EventCameraOpDone_Internal::read_json(string_view json_str)
+{
+    JsonReader(json_str).field("success", success).read();
+}
+
+EventHandlerOverrun::EventHandlerOverrun(string handler, string state,
+                                         string event, int32_t duration_ms,
+                                         bool finished)
+    : Event(id), handler(handler), state(state), event(event),
+      duration_ms(duration_ms), finished(finished)
+{
+}
+
+string EventHandlerOverrun::name() const { return "EventHandlerOverrun"; }
+
+string EventHandlerOverrun::to_string(int indent) const
+{
+    if (indent < 0)
+        return fmt::format(
+            "EventHandlerOverrun {{handler = {}, state = {}, event = {}, "
+            "duration_ms = {}, finished = {}}}",
+            handler, state, event, duration_ms, finished);
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventHandlerOverrun::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventHandlerOverrun::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out)
+        .field("duration_ms", duration_ms)
+        .field("event", event)
+        .field("event_id", id)
+        .field("finished", finished)
+        .field("handler", handler)
+        .field("state", state)
+        .end();
+}
+
+void EventHandlerOverrun::read_json(string_view json_str)
+{
+    JsonReader(json_str)
+        .field("handler", handler)
+        .field("state", state)
+        .field("event", event)
+        .field("duration_ms", duration_ms)
+        .field("finished", finished)
+        .read();
+}
+
+EventBulbRampingReplyTimeout::EventBulbRampingReplyTimeout() : Event(id) {}
+
+string EventBulbRampingReplyTimeout::name() const
+{
+    return "EventBulbRampingReplyTimeout";
+}
+
+string EventBulbRampingReplyTimeout::to_string(int indent) const
+{
+    if (indent < 0)
+        return name();
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventBulbRampingReplyTimeout::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventBulbRampingReplyTimeout::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventBulbRampingReplyTimeout::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+EventBracketingSetTimeout::EventBracketingSetTimeout() : Event(id) {}
+
+string EventBracketingSetTimeout::name() const
+{
+    return "EventBracketingSetTimeout";
+}
+
+string EventBracketingSetTimeout::to_string(int indent) const
+{
+    if (indent < 0)
+        return name();
+    else
+        return fmt::format("{}\n{}", name(), to_json().dump(indent));
+}
+
+nlohmann::json EventBracketingSetTimeout::to_json() const
+{
+    return nlohmann::json(*this);
+}
+
+void EventBracketingSetTimeout::write_json(fmt::memory_buffer& out) const
+{
+    JsonWriter(out).field("event_id", id).end();
+}
+
+void EventBracketingSetTimeout::read_json(string_view json_str)
+{
+    JsonReader(json_str).read();
+}
+
+using EventDecoder = EventPtr (*)(const nlohmann::json&);
+
+template <typename EventClass>
+static EventPtr eventFromJson(const nlohmann::json& j)
+{
+    auto ev = make_shared<EventClass>();
+    j.get_to(*ev);
+    return ev;
+}
+
+static constexpr uint16_t FIRST_EVENT_ID = 10;
+
+// Indexed by event id - FIRST_EVENT_ID
+static constexpr EventDecoder event_decoders[] = {
+    &eventFromJson<EventHeartBeat>,
+    &eventFromJson<EventCmdRestart>,
+    &eventFromJson<EventCmdReboot>,
+    &eventFromJson<EventCmdShutdown>,
+    &eventFromJson<EventCameraCmdConnect>,
+    &eventFromJson<EventCameraCmdDisconnect>,
+    &eventFromJson<EventCameraCmdRecoverError>,
+    &eventFromJson<EventCameraCaptureStarted>,
+    &eventFromJson<EventCameraCmdCapture>,
+    &eventFromJson<EventCameraCmdCapture_Internal>,
+    &eventFromJson<EventCameraCmdDownload>,
+    &eventFromJson<EventCameraCmdDownload_Internal>,
+    &eventFromJson<EventCameraConnected>,
+    &eventFromJson<EventCameraReady>,
+    &eventFromJson<EventCameraBusyOrError>,
+    &eventFromJson<EventCameraDisconnected>,
+    &eventFromJson<EventCameraConnectionError>,
+    &eventFromJson<EventCameraError>,
+    &eventFromJson<EventCameraIgnoreError>,
+    &eventFromJson<EventCameraCmdLowLatency>,
+    &eventFromJson<EventCameraCaptureDone>,
+    &eventFromJson<EventGetCameraControllerState>,
+    &eventFromJson<EventCameraControllerState>,
+    &eventFromJson<EventConfigGetShutterSpeed>,
+    &eventFromJson<EventConfigGetChoicesShutterSpeed>,
+    &eventFromJson<EventConfigSetShutterSpeed>,
+    &eventFromJson<EventConfigValueShutterSpeed>,
+    &eventFromJson<EventConfigChoicesShutterSpeed>,
+    &eventFromJson<EventConfigGetAperture>,
+    &eventFromJson<EventConfigGetChoicesAperture>,
+    &eventFromJson<EventConfigSetAperture>,
+    &eventFromJson<EventConfigValueAperture>,
+    &eventFromJson<EventConfigChoicesAperture>,
+    &eventFromJson<EventConfigGetISO>,
+    &eventFromJson<EventConfigGetChoicesISO>,
+    &eventFromJson<EventConfigSetISO>,
+    &eventFromJson<EventConfigValueISO>,
+    &eventFromJson<EventConfigChoicesISO>,
+    &eventFromJson<EventConfigGetBattery>,
+    &eventFromJson<EventConfigValueBattery>,
+    &eventFromJson<EventConfigGetFocalLength>,
+    &eventFromJson<EventConfigValueFocalLength>,
+    &eventFromJson<EventConfigGetFocusMode>,
+    &eventFromJson<EventConfigNextFocusMode>,
+    &eventFromJson<EventConfigValueFocusMode>,
+    &eventFromJson<EventConfigGetLongExpNR>,
+    &eventFromJson<EventConfigSetLongExpNR>,
+    &eventFromJson<EventConfigValueLongExpNR>,
+    &eventFromJson<EventConfigGetVibRed>,
+    &eventFromJson<EventConfigSetVibRed>,
+    &eventFromJson<EventConfigValueVibRed>,
+    &eventFromJson<EventConfigGetCaptureTarget>,
+    &eventFromJson<EventConfigSetCaptureTarget>,
+    &eventFromJson<EventConfigValueCaptureTarget>,
+    &eventFromJson<EventConfigGetExposureProgram>,
+    &eventFromJson<EventConfigValueExposureProgram>,
+    &eventFromJson<EventConfigGetLightMeter>,
+    &eventFromJson<EventConfigValueLightMeter>,
+    &eventFromJson<EventConfigGetAutoISO>,
+    &eventFromJson<EventConfigSetAutoISO>,
+    &eventFromJson<EventConfigValueAutoISO>,
+    &eventFromJson<EventConfigGetAll>,
+    &eventFromJson<EventGetCurrentMode>,
+    &eventFromJson<EventValueCurrentMode>,
+    &eventFromJson<EventModeStopped>,
+    &eventFromJson<EventModeStop>,
+    &eventFromJson<EventModeIntervalometer>,
+    &eventFromJson<EventIntervalometerStart>,
+    &eventFromJson<EventIntervalometerDeadlineExpired>,
+    &eventFromJson<EventIntervalometerState>,
+    &eventFromJson<EventEnableEventPassThrough>,
+    &eventFromJson<EventDisableEventPassThrough>,
+    &eventFromJson<EventModeIntervalometerAnchored>,
+    &eventFromJson<EventModeBulbRamping>,
+    &eventFromJson<EventBulbRampingStart>,
+    &eventFromJson<EventBulbRampingDeadlineExpired>,
+    &eventFromJson<EventBulbRampingState>,
+    &eventFromJson<EventModeBracketing>,
+    &eventFromJson<EventBracketingStart>,
+    &eventFromJson<EventBracketingState>,
+    &eventFromJson<EventCameraCmdFocusDrive>,
+    &eventFromJson<EventCameraCmdAutofocus>,
+    &eventFromJson<EventCameraFocusDriveDone>,
+    &eventFromJson<EventModeFocusStacking>,
+    &eventFromJson<EventFocusStackingStart>,
+    &eventFromJson<EventFocusStackingState>,
+    &eventFromJson<EventCameraCmdPollEvents_Internal>,
+    &eventFromJson<EventCameraCmdCaptureAll>,
+    &eventFromJson<EventCaptureAllDone>,
+    &eventFromJson<EventGetCameraList>,
+    &eventFromJson<EventCameraList>,
+    &eventFromJson<EventCameraCmdForward>,
+    &eventFromJson<EventCameraForwarded>,
+    &eventFromJson<EventCaptureAllFinish_Internal>,
+    &eventFromJson<EventUsbDeviceAdded>,
+    &eventFromJson<EventUsbDeviceRemoved>,
+    &eventFromJson<EventCoroutineResume_Internal>,
+    &eventFromJson<EventCameraOpDone_Internal>,
+    &eventFromJson<EventHandlerOverrun>,
+    &eventFromJson<EventBulbRampingReplyTimeout>,
+    &eventFromJson<EventBracketingSetTimeout>,
+};
+
+EventPtr jsonToEvent(const nlohmann::json& j)
+{
+    uint16_t id = j.at("event_id");
+    if (id < FIRST_EVENT_ID ||
+        (size_t)(id - FIRST_EVENT_ID) >= std::size(event_decoders))
+        throw std::out_of_range{"No event with provided ID"};
+
+    return event_decoders[id - FIRST_EVENT_ID](j);
+}
+
+using EventReader = EventPtr (*)(string_view);
+
+template <typename EventClass>
+static EventPtr eventFromJsonString(string_view json_str)
+{
+    auto ev = make_shared<EventClass>();
+    ev->read_json(json_str);
+    return ev;
+}
+
+// Indexed by event id - FIRST_EVENT_ID
+static constexpr EventReader event_readers[] = {
+    &eventFromJsonString<EventHeartBeat>,
+    &eventFromJsonString<EventCmdRestart>,
+    &eventFromJsonString<EventCmdReboot>,
+    &eventFromJsonString<EventCmdShutdown>,
+    &eventFromJsonString<EventCameraCmdConnect>,
+    &eventFromJsonString<EventCameraCmdDisconnect>,
+    &eventFromJsonString<EventCameraCmdRecoverError>,
+    &eventFromJsonString<EventCameraCaptureStarted>,
+    &eventFromJsonString<EventCameraCmdCapture>,
+    &eventFromJsonString<EventCameraCmdCapture_Internal>,
+    &eventFromJsonString<EventCameraCmdDownload>,
+    &eventFromJsonString<EventCameraCmdDownload_Internal>,
+    &eventFromJsonString<EventCameraConnected>,
+    &eventFromJsonString<EventCameraReady>,
+    &eventFromJsonString<EventCameraBusyOrError>,
+    &eventFromJsonString<EventCameraDisconnected>,
+    &eventFromJsonString<EventCameraConnectionError>,
+    &eventFromJsonString<EventCameraError>,
+    &eventFromJsonString<EventCameraIgnoreError>,
+    &eventFromJsonString<EventCameraCmdLowLatency>,
+    &eventFromJsonString<EventCameraCaptureDone>,
+    &eventFromJsonString<EventGetCameraControllerState>,
+    &eventFromJsonString<EventCameraControllerState>,
+    &eventFromJsonString<EventConfigGetShutterSpeed>,
+    &eventFromJsonString<EventConfigGetChoicesShutterSpeed>,
+    &eventFromJsonString<EventConfigSetShutterSpeed>,
+    &eventFromJsonString<EventConfigValueShutterSpeed>,
+    &eventFromJsonString<EventConfigChoicesShutterSpeed>,
+    &eventFromJsonString<EventConfigGetAperture>,
+    &eventFromJsonString<EventConfigGetChoicesAperture>,
+    &eventFromJsonString<EventConfigSetAperture>,
+    &eventFromJsonString<EventConfigValueAperture>,
+    &eventFromJsonString<EventConfigChoicesAperture>,
+    &eventFromJsonString<EventConfigGetISO>,
+    &eventFromJsonString<EventConfigGetChoicesISO>,
+    &eventFromJsonString<EventConfigSetISO>,
+    &eventFromJsonString<EventConfigValueISO>,
+    &eventFromJsonString<EventConfigChoicesISO>,
+    &eventFromJsonString<EventConfigGetBattery>,
+    &eventFromJsonString<EventConfigValueBattery>,
+    &eventFromJsonString<EventConfigGetFocalLength>,
+    &eventFromJsonString<EventConfigValueFocalLength>,
+    &eventFromJsonString<EventConfigGetFocusMode>,
+    &eventFromJsonString<EventConfigNextFocusMode>,
+    &eventFromJsonString<EventConfigValueFocusMode>,
+    &eventFromJsonString<EventConfigGetLongExpNR>,
+    &eventFromJsonString<EventConfigSetLongExpNR>,
+    &eventFromJsonString<EventConfigValueLongExpNR>,
+    &eventFromJsonString<EventConfigGetVibRed>,
+    &eventFromJsonString<EventConfigSetVibRed>,
+    &eventFromJsonString<EventConfigValueVibRed>,
+    &eventFromJsonString<EventConfigGetCaptureTarget>,
+    &eventFromJsonString<EventConfigSetCaptureTarget>,
+    &eventFromJsonString<EventConfigValueCaptureTarget>,
+    &eventFromJsonString<EventConfigGetExposureProgram>,
+    &eventFromJsonString<EventConfigValueExposureProgram>,
+    &eventFromJsonString<EventConfigGetLightMeter>,
+    &eventFromJsonString<EventConfigValueLightMeter>,
+    &eventFromJsonString<EventConfigGetAutoISO>,
+    &eventFromJsonString<EventConfigSetAutoISO>,
+    &eventFromJsonString<EventConfigValueAutoISO>,
+    &eventFromJsonString<EventConfigGetAll>,
+    &eventFromJsonString<EventGetCurrentMode>,
+    &eventFromJsonString<EventValueCurrentMode>,
+    &eventFromJsonString<EventModeStopped>,
+    &eventFromJsonString<EventModeStop>,
+    &eventFromJsonString<EventModeIntervalometer>,
+    &eventFromJsonString<EventIntervalometerStart>,
+    &eventFromJsonString<EventIntervalometerDeadlineExpired>,
+    &eventFromJsonString<EventIntervalometerState>,
+    &eventFromJsonString<EventEnableEventPassThrough>,
+    &eventFromJsonString<EventDisableEventPassThrough>,
+    &eventFromJsonString<EventModeIntervalometerAnchored>,
+    &eventFromJsonString<EventModeBulbRamping>,
+    &eventFromJsonString<EventBulbRampingStart>,
+    &eventFromJsonString<EventBulbRampingDeadlineExpired>,
+    &eventFromJsonString<EventBulbRampingState>,
+    &eventFromJsonString<EventModeBracketing>,
+    &eventFromJsonString<EventBracketingStart>,
+    &eventFromJsonString<EventBracketingState>,
+    &eventFromJsonString<EventCameraCmdFocusDrive>,
+    &eventFromJsonString<EventCameraCmdAutofocus>,
+    &eventFromJsonString<EventCameraFocusDriveDone>,
+    &eventFromJsonString<EventModeFocusStacking>,
+    &eventFromJsonString<EventFocusStackingStart>,
+    &eventFromJsonString<EventFocusStackingState>,
+    &eventFromJsonString<EventCameraCmdPollEvents_Internal>,
+    &eventFromJsonString<EventCameraCmdCaptureAll>,
+    &eventFromJsonString<EventCaptureAllDone>,
+    &eventFromJsonString<EventGetCameraList>,
+    &eventFromJsonString<EventCameraList>,
+    &eventFromJsonString<EventCameraCmdForward>,
+    &eventFromJsonString<EventCameraForwarded>,
+    &eventFromJsonString<EventCaptureAllFinish_Internal>,
+    &eventFromJsonString<EventUsbDeviceAdded>,
+    &eventFromJsonString<EventUsbDeviceRemoved>,
+    &eventFromJsonString<EventCoroutineResume_Internal>,
+    &eventFromJsonString<EventCameraOpDone_Internal>,
+    &eventFromJsonString<EventHandlerOverrun>,
+    &eventFromJsonString<EventBulbRampingReplyTimeout>,
+    &eventFromJsonString<EventBracketingSetTimeout>,
+};
+
+EventPtr jsonStringToEvent(uint16_t id, string_view json_str)
+{
+    if (id < FIRST_EVENT_ID ||
+        (size_t)(id - FIRST_EVENT_ID) >= std::size(event_readers))
+    {
+        // Invalid json is reported first, as in jsonToEvent()
+        JsonReader(json_str).read();
+        throw std::out_of_range{"No event with provided ID"};
+    }
+
+    return event_readers[id - FIRST_EVENT_ID](json_str);
+}
+
+EventPtr jsonStringToEvent(string_view json_str)
+{
+    uint16_t id;
+    // Not an event: read it again to report the same error as jsonToEvent()
+    if (!JsonReader::readEventId(json_str, id))
+        JsonReader(json_str).field("event_id", id).read();
+
+    return jsonStringToEvent(id, json_str);
+}
+
+using ValueConverter = EventValue (*)(const Event&);
+
+template <typename EventClass>
+static EventValue eventToValue(const Event& ev)
+{
+    return EventValue{std::in_place_type<EventClass>,
+                      static_cast<const EventClass&>(ev)};
+}
+
+// Indexed by event id - FIRST_EVENT_ID
+static constexpr ValueConverter value_converters[] = {
+    &eventToValue<EventHeartBeat>,
+    &eventToValue<EventCmdRestart>,
+    &eventToValue<EventCmdReboot>,
+    &eventToValue<EventCmdShutdown>,
+    &eventToValue<EventCameraCmdConnect>,
+    &eventToValue<EventCameraCmdDisconnect>,
+    &eventToValue<EventCameraCmdRecoverError>,
+    &eventToValue<EventCameraCaptureStarted>,
+    &eventToValue<EventCameraCmdCapture>,
+    &eventToValue<EventCameraCmdCapture_Internal>,
+    &eventToValue<EventCameraCmdDownload>,
+    &eventToValue<EventCameraCmdDownload_Internal>,
+    &eventToValue<EventCameraConnected>,
+    &eventToValue<EventCameraReady>,
+    &eventToValue<EventCameraBusyOrError>,
+    &eventToValue<EventCameraDisconnected>,
+    &eventToValue<EventCameraConnectionError>,
+    &eventToValue<EventCameraError>,
+    &eventToValue<EventCameraIgnoreError>,
+    &eventToValue<EventCameraCmdLowLatency>,
+    &eventToValue<EventCameraCaptureDone>,
+    &eventToValue<EventGetCameraControllerState>,
+    &eventToValue<EventCameraControllerState>,
+    &eventToValue<EventConfigGetShutterSpeed>,
+    &eventToValue<EventConfigGetChoicesShutterSpeed>,
+    &eventToValue<EventConfigSetShutterSpeed>,
+    &eventToValue<EventConfigValueShutterSpeed>,
+    &eventToValue<EventConfigChoicesShutterSpeed>,
+    &eventToValue<EventConfigGetAperture>,
+    &eventToValue<EventConfigGetChoicesAperture>,
+    &eventToValue<EventConfigSetAperture>,
+    &eventToValue<EventConfigValueAperture>,
+    &eventToValue<EventConfigChoicesAperture>,
+    &eventToValue<EventConfigGetISO>,
+    &eventToValue<EventConfigGetChoicesISO>,
+    &eventToValue<EventConfigSetISO>,
+    &eventToValue<EventConfigValueISO>,
+    &eventToValue<EventConfigChoicesISO>,
+    &eventToValue<EventConfigGetBattery>,
+    &eventToValue<EventConfigValueBattery>,
+    &eventToValue<EventConfigGetFocalLength>,
+    &eventToValue<EventConfigValueFocalLength>,
+    &eventToValue<EventConfigGetFocusMode>,
+    &eventToValue<EventConfigNextFocusMode>,
+    &eventToValue<EventConfigValueFocusMode>,
+    &eventToValue<EventConfigGetLongExpNR>,
+    &eventToValue<EventConfigSetLongExpNR>,
+    &eventToValue<EventConfigValueLongExpNR>,
+    &eventToValue<EventConfigGetVibRed>,
+    &eventToValue<EventConfigSetVibRed>,
+    &eventToValue<EventConfigValueVibRed>,
+    &eventToValue<EventConfigGetCaptureTarget>,
+    &eventToValue<EventConfigSetCaptureTarget>,
+    &eventToValue<EventConfigValueCaptureTarget>,
+    &eventToValue<EventConfigGetExposureProgram>,
+    &eventToValue<EventConfigValueExposureProgram>,
+    &eventToValue<EventConfigGetLightMeter>,
+    &eventToValue<EventConfigValueLightMeter>,
+    &eventToValue<EventConfigGetAutoISO>,
+    &eventToValue<EventConfigSetAutoISO>,
+    &eventToValue<EventConfigValueAutoISO>,
+    &eventToValue<EventConfigGetAll>,
+    &eventToValue<EventGetCurrentMode>,
+    &eventToValue<EventValueCurrentMode>,
+    &eventToValue<EventModeStopped>,
+    &eventToValue<EventModeStop>,
+    &eventToValue<EventModeIntervalometer>,
+    &eventToValue<EventIntervalometerStart>,
+    &eventToValue<EventIntervalometerDeadlineExpired>,
+    &eventToValue<EventIntervalometerState>,
+    &eventToValue<EventEnableEventPassThrough>,
+    &eventToValue<EventDisableEventPassThrough>,
+    &eventToValue<EventModeIntervalometerAnchored>,
+    &eventToValue<EventModeBulbRamping>,
+    &eventToValue<EventBulbRampingStart>,
+    &eventToValue<EventBulbRampingDeadlineExpired>,
+    &eventToValue<EventBulbRampingState>,
+    &eventToValue<EventModeBracketing>,
+    &eventToValue<EventBracketingStart>,
+    &eventToValue<EventBracketingState>,
+    &eventToValue<EventCameraCmdFocusDrive>,
+    &eventToValue<EventCameraCmdAutofocus>,
+    &eventToValue<EventCameraFocusDriveDone>,
+    &eventToValue<EventModeFocusStacking>,
+    &eventToValue<EventFocusStackingStart>,
+    &eventToValue<EventFocusStackingState>,
+    &eventToValue<EventCameraCmdPollEvents_Internal>,
+    &eventToValue<EventCameraCmdCaptureAll>,
+    &eventToValue<EventCaptureAllDone>,
+    &eventToValue<EventGetCameraList>,
+    &eventToValue<EventCameraList>,
+    &eventToValue<EventCameraCmdForward>,
+    &eventToValue<EventCameraForwarded>,
+    &eventToValue<EventCaptureAllFinish_Internal>,
+    &eventToValue<EventUsbDeviceAdded>,
+    &eventToValue<EventUsbDeviceRemoved>,
+    &eventToValue<EventCoroutineResume_Internal>,
+    &eventToValue<EventCameraOpDone_Internal>,
+    &eventToValue<EventHandlerOverrun>,
+    &eventToValue<EventBulbRampingReplyTimeout>,
+    &eventToValue<EventBracketingSetTimeout>,
+};
+
+static_assert(std::size(value_converters) == std::variant_size_v<EventValue>);
+
+EventValue toEventValue(const Event& ev)
+{
+    uint16_t id = ev.getID();
+    if (id < FIRST_EVENT_ID ||
+        (size_t)(id - FIRST_EVENT_ID) >= std::size(value_converters))
+        throw std::out_of_range{"No event with provided ID"};
+
+    return value_converters[id - FIRST_EVENT_ID](ev);
+}
+
+// Indexed by event id - FIRST_EVENT_ID, declared in events.txt
+static constexpr EventPriority event_priorities[] = {
+    EventPriority::CONTROL,    // EventHeartBeat
+    EventPriority::CONTROL,    // EventCmdRestart
+    EventPriority::CONTROL,    // EventCmdReboot
+    EventPriority::CONTROL,    // EventCmdShutdown
+    EventPriority::COMMAND,    // EventCameraCmdConnect
+    EventPriority::COMMAND,    // EventCameraCmdDisconnect
+    EventPriority::COMMAND,    // EventCameraCmdRecoverError
+    EventPriority::CONTROL,    // EventCameraCaptureStarted
+    EventPriority::COMMAND,    // EventCameraCmdCapture
+    EventPriority::COMMAND,    // EventCameraCmdCapture_Internal
+    EventPriority::COMMAND,    // EventCameraCmdDownload
+    EventPriority::COMMAND,    // EventCameraCmdDownload_Internal
+    EventPriority::CONTROL,    // EventCameraConnected
+    EventPriority::CONTROL,    // EventCameraReady
+    EventPriority::CONTROL,    // EventCameraBusyOrError
+    EventPriority::CONTROL,    // EventCameraDisconnected
+    EventPriority::CONTROL,    // EventCameraConnectionError
+    EventPriority::CONTROL,    // EventCameraError
+    EventPriority::COMMAND,    // EventCameraIgnoreError
+    EventPriority::COMMAND,    // EventCameraCmdLowLatency
+    EventPriority::CONTROL,    // EventCameraCaptureDone
+    EventPriority::TELEMETRY,  // EventGetCameraControllerState
+    EventPriority::CONTROL,    // EventCameraControllerState
+    EventPriority::TELEMETRY,  // EventConfigGetShutterSpeed
+    EventPriority::TELEMETRY,  // EventConfigGetChoicesShutterSpeed
+    EventPriority::COMMAND,    // EventConfigSetShutterSpeed
+    EventPriority::CONTROL,    // EventConfigValueShutterSpeed
+    EventPriority::CONTROL,    // EventConfigChoicesShutterSpeed
+    EventPriority::TELEMETRY,  // EventConfigGetAperture
+    EventPriority::TELEMETRY,  // EventConfigGetChoicesAperture
+    EventPriority::COMMAND,    // EventConfigSetAperture
+    EventPriority::CONTROL,    // EventConfigValueAperture
+    EventPriority::CONTROL,    // EventConfigChoicesAperture
+    EventPriority::TELEMETRY,  // EventConfigGetISO
+    EventPriority::TELEMETRY,  // EventConfigGetChoicesISO
+    EventPriority::COMMAND,    // EventConfigSetISO
+    EventPriority::CONTROL,    // EventConfigValueISO
+    EventPriority::CONTROL,    // EventConfigChoicesISO
+    EventPriority::TELEMETRY,  // EventConfigGetBattery
+    EventPriority::CONTROL,    // EventConfigValueBattery
+    EventPriority::TELEMETRY,  // EventConfigGetFocalLength
+    EventPriority::CONTROL,    // EventConfigValueFocalLength
+    EventPriority::TELEMETRY,  // EventConfigGetFocusMode
+    EventPriority::COMMAND,    // EventConfigNextFocusMode
+    EventPriority::CONTROL,    // EventConfigValueFocusMode
+    EventPriority::TELEMETRY,  // EventConfigGetLongExpNR
+    EventPriority::COMMAND,    // EventConfigSetLongExpNR
+    EventPriority::CONTROL,    // EventConfigValueLongExpNR
+    EventPriority::TELEMETRY,  // EventConfigGetVibRed
+    EventPriority::COMMAND,    // EventConfigSetVibRed
+    EventPriority::CONTROL,    // EventConfigValueVibRed
+    EventPriority::TELEMETRY,  // EventConfigGetCaptureTarget
+    EventPriority::COMMAND,    // EventConfigSetCaptureTarget
+    EventPriority::CONTROL,    // EventConfigValueCaptureTarget
+    EventPriority::TELEMETRY,  // EventConfigGetExposureProgram
+    EventPriority::CONTROL,    // EventConfigValueExposureProgram
+    EventPriority::TELEMETRY,  // EventConfigGetLightMeter
+    EventPriority::CONTROL,    // EventConfigValueLightMeter
+    EventPriority::TELEMETRY,  // EventConfigGetAutoISO
+    EventPriority::COMMAND,    // EventConfigSetAutoISO
+    EventPriority::CONTROL,    // EventConfigValueAutoISO
+    EventPriority::TELEMETRY,  // EventConfigGetAll
+    EventPriority::CONTROL,    // EventGetCurrentMode
+    EventPriority::CONTROL,    // EventValueCurrentMode
+    EventPriority::CONTROL,    // EventModeStopped
+    EventPriority::CONTROL,    // EventModeStop
+    EventPriority::CONTROL,    // EventModeIntervalometer
+    EventPriority::CONTROL,    // EventIntervalometerStart
+    EventPriority::CONTROL,    // EventIntervalometerDeadlineExpired
+    EventPriority::CONTROL,    // EventIntervalometerState
+    EventPriority::CONTROL,    // EventEnableEventPassThrough
+    EventPriority::CONTROL,    // EventDisableEventPassThrough
+    EventPriority::CONTROL,    // EventModeIntervalometerAnchored
+    EventPriority::CONTROL,    // EventModeBulbRamping
+    EventPriority::CONTROL,    // EventBulbRampingStart
+    EventPriority::CONTROL,    // EventBulbRampingDeadlineExpired
+    EventPriority::CONTROL,    // EventBulbRampingState
+    EventPriority::CONTROL,    // EventModeBracketing
+    EventPriority::CONTROL,    // EventBracketingStart
+    EventPriority::CONTROL,    // EventBracketingState
+    EventPriority::COMMAND,    // EventCameraCmdFocusDrive
+    EventPriority::COMMAND,    // EventCameraCmdAutofocus
+    EventPriority::CONTROL,    // EventCameraFocusDriveDone
+    EventPriority::CONTROL,    // EventModeFocusStacking
+    EventPriority::CONTROL,    // EventFocusStackingStart
+    EventPriority::CONTROL,    // EventFocusStackingState
+    EventPriority::TELEMETRY,  // EventCameraCmdPollEvents_Internal
+    EventPriority::COMMAND,    // EventCameraCmdCaptureAll
+    EventPriority::CONTROL,    // EventCaptureAllDone
+    EventPriority::TELEMETRY,  // EventGetCameraList
+    EventPriority::CONTROL,    // EventCameraList
+    EventPriority::COMMAND,    // EventCameraCmdForward
+    EventPriority::CONTROL,    // EventCameraForwarded
+    EventPriority::CONTROL,    // EventCaptureAllFinish_Internal
+    EventPriority::CONTROL,    // EventUsbDeviceAdded
+    EventPriority::CONTROL,    // EventUsbDeviceRemoved
+    EventPriority::CONTROL,    // EventCoroutineResume_Internal
+    EventPriority::CONTROL,    // EventCameraOpDone_Internal
+    EventPriority::CONTROL,    // EventHandlerOverrun
+    EventPriority::CONTROL,    // EventBulbRampingReplyTimeout
+    EventPriority::CONTROL,    // EventBracketingSetTimeout
+};
+
+EventPriority getEventPriority(uint16_t id)
+{
+    // Internal state machine events
+    if (id < FIRST_EVENT_ID ||
+        (size_t)(id - FIRST_EVENT_ID) >= std::size(event_priorities))
+        return EventPriority::CONTROL;
+
+    return event_priorities[id - FIRST_EVENT_ID];
+}
+
+EventPtr toEventPtr(EventValue&& ev)
+{
+    return std::visit(
+        [](auto&& e) -> EventPtr
+        {
+            using EventClass = std::decay_t<decltype(e)>;
+            return make_shared<const EventClass>(std::move(e));
+        },
+        std::move(ev));
 }
\ No newline at end of file
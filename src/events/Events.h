@@ -33,12 +33,15 @@
 #include <cassert>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <variant>
 #include <vector>
 
 #include "EventBase.h"
 
 using std::string;
+using std::string_view;
 using std::vector;
 
 enum Topics : uint8_t
@@ -50,12 +53,15 @@ enum Topics : uint8_t
     TOPIC_MODE_CONTROLLER,
     TOPIC_MODE_FSM,
     TOPIC_MODE_STATE,
-    TOPIC_HEARTBEAT
+    TOPIC_HEARTBEAT,
+    TOPIC_DIAGNOSTICS
 };
 
 string getTopicName(uint8_t topic);
 uint8_t getTopicID(string topic_str);
 EventPtr jsonToEvent(const nlohmann::json& j);
+EventPtr jsonStringToEvent(string_view json_str);
+EventPtr jsonStringToEvent(uint16_t id, string_view json_str);
 
 struct EventHeartBeat : public Event
 {
@@ -69,6 +75,10 @@ struct EventHeartBeat : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventHeartBeat);
 };
 
@@ -84,6 +94,10 @@ struct EventCmdRestart : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCmdRestart);
 };
 
@@ -99,6 +113,10 @@ struct EventCmdReboot : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCmdReboot);
 };
 
@@ -114,6 +132,10 @@ struct EventCmdShutdown : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCmdShutdown);
 };
 
@@ -129,6 +151,10 @@ struct EventCameraCmdConnect : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCmdConnect);
 };
 
@@ -144,6 +170,10 @@ struct EventCameraCmdDisconnect : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCmdDisconnect);
 };
 
@@ -159,6 +189,10 @@ struct EventCameraCmdRecoverError : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCmdRecoverError);
 };
 
@@ -174,6 +208,10 @@ struct EventCameraCaptureStarted : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCaptureStarted);
 };
 
@@ -189,6 +227,10 @@ struct EventCameraCmdCapture : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCmdCapture);
 };
 
@@ -204,6 +246,10 @@ struct EventCameraCmdCapture_Internal : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCmdCapture_Internal);
 };
 
@@ -220,6 +266,10 @@ struct EventCameraCmdDownload : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool download;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraCmdDownload, download);
@@ -237,6 +287,10 @@ struct EventCameraCmdDownload_Internal : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCmdDownload_Internal);
 };
 
@@ -252,6 +306,10 @@ struct EventCameraConnected : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraConnected);
 };
 
@@ -267,6 +325,10 @@ struct EventCameraReady : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraReady);
 };
 
@@ -282,6 +344,10 @@ struct EventCameraBusyOrError : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraBusyOrError);
 };
 
@@ -297,6 +363,10 @@ struct EventCameraDisconnected : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraDisconnected);
 };
 
@@ -312,6 +382,10 @@ struct EventCameraConnectionError : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraConnectionError);
 };
 
@@ -327,6 +401,10 @@ struct EventCameraError : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraError);
 };
 
@@ -342,6 +420,10 @@ struct EventCameraIgnoreError : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraIgnoreError);
 };
 
@@ -358,6 +440,10 @@ struct EventCameraCmdLowLatency : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool low_latency;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraCmdLowLatency, low_latency);
@@ -376,6 +462,10 @@ struct EventCameraCaptureDone : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool downloaded;
     string download_dir;
     string file;
@@ -396,6 +486,10 @@ struct EventGetCameraControllerState : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventGetCameraControllerState);
 };
 
@@ -405,7 +499,10 @@ struct EventCameraControllerState : public Event
 
     EventCameraControllerState() : Event(id){};
     EventCameraControllerState(string state, bool camera_connected,
-                               bool download_enabled);
+                               bool download_enabled, bool low_latency,
+                               int32_t probe_latency_us,
+                               int32_t probe_period_ms,
+                               int32_t recovery_time_ms);
 
     string name() const override;
 
@@ -413,12 +510,22 @@ struct EventCameraControllerState : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     string state;
     bool camera_connected;
     bool download_enabled;
+    bool low_latency;
+    int32_t probe_latency_us;
+    int32_t probe_period_ms;
+    int32_t recovery_time_ms;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraControllerState, state,
-                                       camera_connected, download_enabled);
+                                       camera_connected, download_enabled,
+                                       low_latency, probe_latency_us,
+                                       probe_period_ms, recovery_time_ms);
 };
 
 struct EventConfigGetShutterSpeed : public Event
@@ -433,6 +540,10 @@ struct EventConfigGetShutterSpeed : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetShutterSpeed);
 };
 
@@ -448,6 +559,10 @@ struct EventConfigGetChoicesShutterSpeed : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(
         EventConfigGetChoicesShutterSpeed);
 };
@@ -465,6 +580,10 @@ struct EventConfigSetShutterSpeed : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t shutter_speed;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigSetShutterSpeed,
@@ -484,6 +603,10 @@ struct EventConfigValueShutterSpeed : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t shutter_speed;
     bool bulb;
 
@@ -504,6 +627,10 @@ struct EventConfigChoicesShutterSpeed : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     vector<int32_t> shutter_speed_choices;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigChoicesShutterSpeed,
@@ -522,6 +649,10 @@ struct EventConfigGetAperture : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetAperture);
 };
 
@@ -537,6 +668,10 @@ struct EventConfigGetChoicesAperture : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetChoicesAperture);
 };
 
@@ -553,6 +688,10 @@ struct EventConfigSetAperture : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t aperture;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigSetAperture, aperture);
@@ -571,6 +710,10 @@ struct EventConfigValueAperture : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t aperture;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueAperture, aperture);
@@ -589,6 +732,10 @@ struct EventConfigChoicesAperture : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     vector<int32_t> aperture_choices;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigChoicesAperture,
@@ -607,6 +754,10 @@ struct EventConfigGetISO : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetISO);
 };
 
@@ -622,6 +773,10 @@ struct EventConfigGetChoicesISO : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetChoicesISO);
 };
 
@@ -638,6 +793,10 @@ struct EventConfigSetISO : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t iso;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigSetISO, iso);
@@ -656,6 +815,10 @@ struct EventConfigValueISO : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t iso;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueISO, iso);
@@ -674,6 +837,10 @@ struct EventConfigChoicesISO : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     vector<int32_t> iso_choices;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigChoicesISO, iso_choices);
@@ -691,6 +858,10 @@ struct EventConfigGetBattery : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetBattery);
 };
 
@@ -707,6 +878,10 @@ struct EventConfigValueBattery : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t battery;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueBattery, battery);
@@ -724,6 +899,10 @@ struct EventConfigGetFocalLength : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetFocalLength);
 };
 
@@ -740,6 +919,10 @@ struct EventConfigValueFocalLength : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t focal_length;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueFocalLength,
@@ -758,6 +941,10 @@ struct EventConfigGetFocusMode : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetFocusMode);
 };
 
@@ -773,6 +960,10 @@ struct EventConfigNextFocusMode : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigNextFocusMode);
 };
 
@@ -789,6 +980,10 @@ struct EventConfigValueFocusMode : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     string focus_mode;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueFocusMode, focus_mode);
@@ -806,6 +1001,10 @@ struct EventConfigGetLongExpNR : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetLongExpNR);
 };
 
@@ -822,6 +1021,10 @@ struct EventConfigSetLongExpNR : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool long_exp_nr;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigSetLongExpNR, long_exp_nr);
@@ -840,6 +1043,10 @@ struct EventConfigValueLongExpNR : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool long_exp_nr;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueLongExpNR, long_exp_nr);
@@ -857,6 +1064,10 @@ struct EventConfigGetVibRed : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetVibRed);
 };
 
@@ -873,6 +1084,10 @@ struct EventConfigSetVibRed : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool vr;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigSetVibRed, vr);
@@ -891,6 +1106,10 @@ struct EventConfigValueVibRed : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool vr;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueVibRed, vr);
@@ -908,6 +1127,10 @@ struct EventConfigGetCaptureTarget : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetCaptureTarget);
 };
 
@@ -924,6 +1147,10 @@ struct EventConfigSetCaptureTarget : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     string target;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigSetCaptureTarget, target);
@@ -942,6 +1169,10 @@ struct EventConfigValueCaptureTarget : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     string target;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueCaptureTarget, target);
@@ -959,6 +1190,10 @@ struct EventConfigGetExposureProgram : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetExposureProgram);
 };
 
@@ -975,6 +1210,10 @@ struct EventConfigValueExposureProgram : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     string exposure_program;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueExposureProgram,
@@ -993,6 +1232,10 @@ struct EventConfigGetLightMeter : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetLightMeter);
 };
 
@@ -1009,6 +1252,10 @@ struct EventConfigValueLightMeter : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     float light_meter;
     float min;
     float max;
@@ -1029,6 +1276,10 @@ struct EventConfigGetAutoISO : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetAutoISO);
 };
 
@@ -1045,6 +1296,10 @@ struct EventConfigSetAutoISO : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool auto_iso;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigSetAutoISO, auto_iso);
@@ -1063,6 +1318,10 @@ struct EventConfigValueAutoISO : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     bool auto_iso;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventConfigValueAutoISO, auto_iso);
@@ -1080,6 +1339,10 @@ struct EventConfigGetAll : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventConfigGetAll);
 };
 
@@ -1095,6 +1358,10 @@ struct EventGetCurrentMode : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventGetCurrentMode);
 };
 
@@ -1111,6 +1378,10 @@ struct EventValueCurrentMode : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     string mode;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventValueCurrentMode, mode);
@@ -1128,6 +1399,10 @@ struct EventModeStopped : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventModeStopped);
 };
 
@@ -1143,6 +1418,10 @@ struct EventModeStop : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventModeStop);
 };
 
@@ -1159,6 +1438,10 @@ struct EventModeIntervalometer : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t intervalms;
     int32_t total_captures;
 
@@ -1171,7 +1454,8 @@ struct EventIntervalometerStart : public Event
     static constexpr uint16_t id = 77;
 
     EventIntervalometerStart() : Event(id){};
-    EventIntervalometerStart(int32_t intervalms, int32_t total_captures);
+    EventIntervalometerStart(int32_t intervalms, int32_t total_captures,
+                             string missed_policy);
 
     string name() const override;
 
@@ -1179,11 +1463,16 @@ struct EventIntervalometerStart : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     int32_t intervalms;
     int32_t total_captures;
+    string missed_policy;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventIntervalometerStart, intervalms,
-                                       total_captures);
+                                       total_captures, missed_policy);
 };
 
 struct EventIntervalometerDeadlineExpired : public Event
@@ -1198,6 +1487,10 @@ struct EventIntervalometerDeadlineExpired : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(
         EventIntervalometerDeadlineExpired);
 };
@@ -1208,7 +1501,9 @@ struct EventIntervalometerState : public Event
 
     EventIntervalometerState() : Event(id){};
     EventIntervalometerState(string state, int32_t intervalms,
-                             int32_t num_captures, int32_t total_captures);
+                             int32_t num_captures, int32_t total_captures,
+                             int32_t missed_frames, int32_t timing_error_us,
+                             int32_t max_timing_error_us);
 
     string name() const override;
 
@@ -1216,14 +1511,22 @@ struct EventIntervalometerState : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     string state;
     int32_t intervalms;
     int32_t num_captures;
     int32_t total_captures;
+    int32_t missed_frames;
+    int32_t timing_error_us;
+    int32_t max_timing_error_us;
 
     JSON_EVENT_SERIALIZATION_INTRUSIVE(EventIntervalometerState, state,
-                                       intervalms, num_captures,
-                                       total_captures);
+                                       intervalms, num_captures, total_captures,
+                                       missed_frames, timing_error_us,
+                                       max_timing_error_us);
 };
 
 struct EventEnableEventPassThrough : public Event
@@ -1238,6 +1541,10 @@ struct EventEnableEventPassThrough : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventEnableEventPassThrough);
 };
 
@@ -1253,5 +1560,828 @@ struct EventDisableEventPassThrough : public Event
 
     nlohmann::json to_json() const override;
 
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
     JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventDisableEventPassThrough);
 };
+
+struct EventModeIntervalometerAnchored : public Event
+{
+    static constexpr uint16_t id = 82;
+
+    EventModeIntervalometerAnchored() : Event(id){};
+    EventModeIntervalometerAnchored(int32_t intervalms, int32_t total_captures,
+                                    string missed_policy);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t intervalms;
+    int32_t total_captures;
+    string missed_policy;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventModeIntervalometerAnchored,
+                                       intervalms, total_captures,
+                                       missed_policy);
+};
+
+struct EventModeBulbRamping : public Event
+{
+    static constexpr uint16_t id = 83;
+
+    EventModeBulbRamping() : Event(id){};
+    EventModeBulbRamping(int32_t intervalms, int32_t total_captures,
+                         float max_ev_step, int32_t max_iso);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t intervalms;
+    int32_t total_captures;
+    float max_ev_step;
+    int32_t max_iso;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventModeBulbRamping, intervalms,
+                                       total_captures, max_ev_step, max_iso);
+};
+
+struct EventBulbRampingStart : public Event
+{
+    static constexpr uint16_t id = 84;
+
+    EventBulbRampingStart() : Event(id){};
+    EventBulbRampingStart(int32_t intervalms, int32_t total_captures,
+                          float max_ev_step, int32_t max_iso);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t intervalms;
+    int32_t total_captures;
+    float max_ev_step;
+    int32_t max_iso;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventBulbRampingStart, intervalms,
+                                       total_captures, max_ev_step, max_iso);
+};
+
+struct EventBulbRampingDeadlineExpired : public Event
+{
+    static constexpr uint16_t id = 85;
+
+    EventBulbRampingDeadlineExpired();
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventBulbRampingDeadlineExpired);
+};
+
+struct EventBulbRampingState : public Event
+{
+    static constexpr uint16_t id = 86;
+
+    EventBulbRampingState() : Event(id){};
+    EventBulbRampingState(string state, int32_t num_captures,
+                          int32_t total_captures, int32_t shutter_speed,
+                          int32_t iso, int32_t aperture, float exposure_ev,
+                          float light_meter, int32_t late_writes,
+                          int32_t write_overrun_ms);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    string state;
+    int32_t num_captures;
+    int32_t total_captures;
+    int32_t shutter_speed;
+    int32_t iso;
+    int32_t aperture;
+    float exposure_ev;
+    float light_meter;
+    int32_t late_writes;
+    int32_t write_overrun_ms;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventBulbRampingState, state,
+                                       num_captures, total_captures,
+                                       shutter_speed, iso, aperture,
+                                       exposure_ev, light_meter, late_writes,
+                                       write_overrun_ms);
+};
+
+struct EventModeBracketing : public Event
+{
+    static constexpr uint16_t id = 87;
+
+    EventModeBracketing() : Event(id){};
+    EventModeBracketing(int32_t num_frames, float ev_step, bool pipelined);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t num_frames;
+    float ev_step;
+    bool pipelined;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventModeBracketing, num_frames, ev_step,
+                                       pipelined);
+};
+
+struct EventBracketingStart : public Event
+{
+    static constexpr uint16_t id = 88;
+
+    EventBracketingStart() : Event(id){};
+    EventBracketingStart(int32_t num_frames, float ev_step, bool pipelined);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t num_frames;
+    float ev_step;
+    bool pipelined;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventBracketingStart, num_frames,
+                                       ev_step, pipelined);
+};
+
+struct EventBracketingState : public Event
+{
+    static constexpr uint16_t id = 89;
+
+    EventBracketingState() : Event(id){};
+    EventBracketingState(string state, int32_t num_frames, int32_t num_captures,
+                         vector<int32_t> shutter_speeds, bool pipelined,
+                         int32_t bracket_time_ms);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    string state;
+    int32_t num_frames;
+    int32_t num_captures;
+    vector<int32_t> shutter_speeds;
+    bool pipelined;
+    int32_t bracket_time_ms;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventBracketingState, state, num_frames,
+                                       num_captures, shutter_speeds, pipelined,
+                                       bracket_time_ms);
+};
+
+struct EventCameraCmdFocusDrive : public Event
+{
+    static constexpr uint16_t id = 90;
+
+    EventCameraCmdFocusDrive() : Event(id){};
+    EventCameraCmdFocusDrive(int32_t steps);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t steps;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraCmdFocusDrive, steps);
+};
+
+struct EventCameraCmdAutofocus : public Event
+{
+    static constexpr uint16_t id = 91;
+
+    EventCameraCmdAutofocus();
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCmdAutofocus);
+};
+
+struct EventCameraFocusDriveDone : public Event
+{
+    static constexpr uint16_t id = 92;
+
+    EventCameraFocusDriveDone() : Event(id){};
+    EventCameraFocusDriveDone(int32_t steps, int32_t drive_time_ms);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t steps;
+    int32_t drive_time_ms;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraFocusDriveDone, steps,
+                                       drive_time_ms);
+};
+
+struct EventModeFocusStacking : public Event
+{
+    static constexpr uint16_t id = 93;
+
+    EventModeFocusStacking() : Event(id){};
+    EventModeFocusStacking(int32_t num_frames, int32_t focus_steps,
+                           bool autofocus);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t num_frames;
+    int32_t focus_steps;
+    bool autofocus;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventModeFocusStacking, num_frames,
+                                       focus_steps, autofocus);
+};
+
+struct EventFocusStackingStart : public Event
+{
+    static constexpr uint16_t id = 94;
+
+    EventFocusStackingStart() : Event(id){};
+    EventFocusStackingStart(int32_t num_frames, int32_t focus_steps,
+                            bool autofocus);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t num_frames;
+    int32_t focus_steps;
+    bool autofocus;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventFocusStackingStart, num_frames,
+                                       focus_steps, autofocus);
+};
+
+struct EventFocusStackingState : public Event
+{
+    static constexpr uint16_t id = 95;
+
+    EventFocusStackingState() : Event(id){};
+    EventFocusStackingState(string state, int32_t num_frames,
+                            int32_t num_captures, int32_t focus_steps,
+                            int32_t capture_time_ms, int32_t focus_time_ms,
+                            int32_t step_time_ms, int32_t avg_step_time_ms,
+                            int32_t stack_time_ms);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    string state;
+    int32_t num_frames;
+    int32_t num_captures;
+    int32_t focus_steps;
+    int32_t capture_time_ms;
+    int32_t focus_time_ms;
+    int32_t step_time_ms;
+    int32_t avg_step_time_ms;
+    int32_t stack_time_ms;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventFocusStackingState, state,
+                                       num_frames, num_captures, focus_steps,
+                                       capture_time_ms, focus_time_ms,
+                                       step_time_ms, avg_step_time_ms,
+                                       stack_time_ms);
+};
+
+struct EventCameraCmdPollEvents_Internal : public Event
+{
+    static constexpr uint16_t id = 96;
+
+    EventCameraCmdPollEvents_Internal();
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(
+        EventCameraCmdPollEvents_Internal);
+};
+
+struct EventCameraCmdCaptureAll : public Event
+{
+    static constexpr uint16_t id = 97;
+
+    EventCameraCmdCaptureAll();
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCameraCmdCaptureAll);
+};
+
+struct EventCaptureAllDone : public Event
+{
+    static constexpr uint16_t id = 98;
+
+    EventCaptureAllDone() : Event(id){};
+    EventCaptureAllDone(int32_t num_cameras, int32_t num_captured,
+                        int32_t trigger_skew_us, int32_t capture_time_ms);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t num_cameras;
+    int32_t num_captured;
+    int32_t trigger_skew_us;
+    int32_t capture_time_ms;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCaptureAllDone, num_cameras,
+                                       num_captured, trigger_skew_us,
+                                       capture_time_ms);
+};
+
+struct EventGetCameraList : public Event
+{
+    static constexpr uint16_t id = 99;
+
+    EventGetCameraList();
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventGetCameraList);
+};
+
+struct EventCameraList : public Event
+{
+    static constexpr uint16_t id = 100;
+
+    EventCameraList() : Event(id){};
+    EventCameraList(vector<string> serials);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    vector<string> serials;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraList, serials);
+};
+
+struct EventCameraCmdForward : public Event
+{
+    static constexpr uint16_t id = 101;
+
+    EventCameraCmdForward() : Event(id){};
+    EventCameraCmdForward(string serial, string event);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    string serial;
+    string event;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraCmdForward, serial, event);
+};
+
+struct EventCameraForwarded : public Event
+{
+    static constexpr uint16_t id = 102;
+
+    EventCameraForwarded() : Event(id){};
+    EventCameraForwarded(string serial, string event);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    string serial;
+    string event;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraForwarded, serial, event);
+};
+
+struct EventCaptureAllFinish_Internal : public Event
+{
+    static constexpr uint16_t id = 103;
+
+    EventCaptureAllFinish_Internal();
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventCaptureAllFinish_Internal);
+};
+
+struct EventUsbDeviceAdded : public Event
+{
+    static constexpr uint16_t id = 104;
+
+    EventUsbDeviceAdded() : Event(id){};
+    EventUsbDeviceAdded(string port);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    string port;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventUsbDeviceAdded, port);
+};
+
+struct EventUsbDeviceRemoved : public Event
+{
+    static constexpr uint16_t id = 105;
+
+    EventUsbDeviceRemoved() : Event(id){};
+    EventUsbDeviceRemoved(string port);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    string port;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventUsbDeviceRemoved, port);
+};
+
+struct EventCoroutineResume_Internal : public Event
+{
+    static constexpr uint16_t id = 106;
+
+    EventCoroutineResume_Internal() : Event(id){};
+    EventCoroutineResume_Internal(int32_t token);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    int32_t token;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCoroutineResume_Internal, token);
+};
+
+struct EventCameraOpDone_Internal : public Event
+{
+    static constexpr uint16_t id = 107;
+
+    EventCameraOpDone_Internal() : Event(id){};
+    EventCameraOpDone_Internal(bool success);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    bool success;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventCameraOpDone_Internal, success);
+};
+
+struct EventHandlerOverrun : public Event
+{
+    static constexpr uint16_t id = 108;
+
+    EventHandlerOverrun() : Event(id){};
+    EventHandlerOverrun(string handler, string state, string event,
+                        int32_t duration_ms, bool finished);
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    string handler;
+    string state;
+    string event;
+    int32_t duration_ms;
+    bool finished;
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE(EventHandlerOverrun, handler, state,
+                                       event, duration_ms, finished);
+};
+
+struct EventBulbRampingReplyTimeout : public Event
+{
+    static constexpr uint16_t id = 109;
+
+    EventBulbRampingReplyTimeout();
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventBulbRampingReplyTimeout);
+};
+
+struct EventBracketingSetTimeout : public Event
+{
+    static constexpr uint16_t id = 110;
+
+    EventBracketingSetTimeout();
+
+    string name() const override;
+
+    string to_string(int indent = -1) const override;
+
+    nlohmann::json to_json() const override;
+
+    void write_json(fmt::memory_buffer& out) const override;
+
+    void read_json(string_view json_str);
+
+    JSON_EVENT_SERIALIZATION_INTRUSIVE_NOARGS(EventBracketingSetTimeout);
+};
+
+/**
+ * @brief Any of the events above, stored by value. Alternatives are in id
+ * order: the index of an event is its id - 10.
+ */
+using EventValue = std::variant<EventHeartBeat, EventCmdRestart, EventCmdReboot,
+                                EventCmdShutdown, EventCameraCmdConnect,
+                                EventCameraCmdDisconnect,
+                                EventCameraCmdRecoverError,
+                                EventCameraCaptureStarted,
+                                EventCameraCmdCapture,
+                                EventCameraCmdCapture_Internal,
+                                EventCameraCmdDownload,
+                                EventCameraCmdDownload_Internal,
+                                EventCameraConnected, EventCameraReady,
+                                EventCameraBusyOrError, EventCameraDisconnected,
+                                EventCameraConnectionError, EventCameraError,
+                                EventCameraIgnoreError,
+                                EventCameraCmdLowLatency,
+                                EventCameraCaptureDone,
+                                EventGetCameraControllerState,
+                                EventCameraControllerState,
+                                EventConfigGetShutterSpeed,
+                                EventConfigGetChoicesShutterSpeed,
+                                EventConfigSetShutterSpeed,
+                                EventConfigValueShutterSpeed,
+                                EventConfigChoicesShutterSpeed,
+                                EventConfigGetAperture,
+                                EventConfigGetChoicesAperture,
+                                EventConfigSetAperture,
+                                EventConfigValueAperture,
+                                EventConfigChoicesAperture, EventConfigGetISO,
+                                EventConfigGetChoicesISO, EventConfigSetISO,
+                                EventConfigValueISO, EventConfigChoicesISO,
+                                EventConfigGetBattery, EventConfigValueBattery,
+                                EventConfigGetFocalLength,
+                                EventConfigValueFocalLength,
+                                EventConfigGetFocusMode,
+                                EventConfigNextFocusMode,
+                                EventConfigValueFocusMode,
+                                EventConfigGetLongExpNR,
+                                EventConfigSetLongExpNR,
+                                EventConfigValueLongExpNR, EventConfigGetVibRed,
+                                EventConfigSetVibRed, EventConfigValueVibRed,
+                                EventConfigGetCaptureTarget,
+                                EventConfigSetCaptureTarget,
+                                EventConfigValueCaptureTarget,
+                                EventConfigGetExposureProgram,
+                                EventConfigValueExposureProgram,
+                                EventConfigGetLightMeter,
+                                EventConfigValueLightMeter,
+                                EventConfigGetAutoISO, EventConfigSetAutoISO,
+                                EventConfigValueAutoISO, EventConfigGetAll,
+                                EventGetCurrentMode, EventValueCurrentMode,
+                                EventModeStopped, EventModeStop,
+                                EventModeIntervalometer,
+                                EventIntervalometerStart,
+                                EventIntervalometerDeadlineExpired,
+                                EventIntervalometerState,
+                                EventEnableEventPassThrough,
+                                EventDisableEventPassThrough,
+                                EventModeIntervalometerAnchored,
+                                EventModeBulbRamping, EventBulbRampingStart,
+                                EventBulbRampingDeadlineExpired,
+                                EventBulbRampingState, EventModeBracketing,
+                                EventBracketingStart, EventBracketingState,
+                                EventCameraCmdFocusDrive,
+                                EventCameraCmdAutofocus,
+                                EventCameraFocusDriveDone,
+                                EventModeFocusStacking, EventFocusStackingStart,
+                                EventFocusStackingState,
+                                EventCameraCmdPollEvents_Internal,
+                                EventCameraCmdCaptureAll, EventCaptureAllDone,
+                                EventGetCameraList, EventCameraList,
+                                EventCameraCmdForward, EventCameraForwarded,
+                                EventCaptureAllFinish_Internal,
+                                EventUsbDeviceAdded, EventUsbDeviceRemoved,
+                                EventCoroutineResume_Internal,
+                                EventCameraOpDone_Internal,
+                                EventHandlerOverrun,
+                                EventBulbRampingReplyTimeout,
+                                EventBracketingSetTimeout>;
+
+/**
+ * @brief True if EventClass is one of the alternatives of EventValue
+ */
+template <typename EventClass, typename Value = EventValue>
+struct IsEventValue;
+
+template <typename EventClass, typename... Events>
+struct IsEventValue<EventClass, std::variant<Events...>>
+    : std::disjunction<std::is_same<EventClass, Events>...>
+{
+};
+
+template <typename EventClass>
+constexpr bool is_event_value_v = IsEventValue<EventClass>::value;
+
+/**
+ * @brief Copies the event in an EventValue
+ * @throw std::out_of_range if the event is not one of the above (eg. the
+ * internal state machine events)
+ */
+EventValue toEventValue(const Event& ev);
+
+/**
+ * @brief Moves the event in a new EventPtr
+ */
+EventPtr toEventPtr(EventValue&& ev);
+
+/**
+ * @brief The event held by @p ev, through the common base class
+ */
+inline const Event& asEvent(const EventValue& ev)
+{
+    return std::visit([](const Event& e) -> const Event& { return e; }, ev);
+}
@@ -28,10 +28,16 @@
 
 #include <assert.h>
 
+#include <deque>
+#include <typeinfo>
+
+#include "Coroutine.h"
+#include "DispatchWatchdog.h"
 #include "EventBase.h"
 #include "EventHandler.h"
 #include "utils/ActiveObject.h"
 #include "utils/collections/CircularBuffer.h"
+#include "utils/collections/SyncMultiLevelQueue.h"
 
 #define HSM_MAX_NEST_DEPTH 5
 
@@ -63,11 +69,34 @@ public:
 
     bool start() override
     {
+        watch();
         init();
 
         return EventHandler::start();
     }
 
+    bool start(Executor& executor) override
+    {
+        watch();
+        init();
+
+        return EventHandler::start(executor);
+    }
+
+    void stop() override
+    {
+        EventHandler::stop();
+        coroutines.stop();
+
+        if (watched)
+        {
+            DispatchWatchdog::getInstance().remove(&dispatch_monitor);
+            watched = false;
+
+            dispatch_monitor.logStats();
+        }
+    }
+
     /**
      * Performs a transiction to the next state
      * @param nextState target state
@@ -96,6 +125,12 @@ public:
     {
         return (this->state == test_state);
     }
+
+    /**
+     * @brief Times the dispatches of the events: set its budget, or read the
+     * durations by state and event
+     */
+    DispatchMonitor& getDispatchMonitor() { return dispatch_monitor; }
     
         /* Internal pointers representing the state o the HSM*/
     State (T::*state)(const EventPtr& ev);
@@ -111,6 +146,18 @@ protected:
     {
         typedef State (T::*StateHandler)(const EventPtr& ev);
 
+        DispatchMonitor::Scope dispatch{dispatch_monitor,
+                                        getStateName(this->state), e};
+
+        // A coroutine started by a state handler can go on: not an event of
+        // the states
+        if (e->getID() == EventCoroutineResume_Internal::id)
+        {
+            coroutines.resume(
+                static_cast<const EventCoroutineResume_Internal&>(*e).token);
+            return;
+        }
+
         StateHandler target = this->state;
         StateHandler source;
         State retState;
@@ -362,13 +409,32 @@ protected:
     }
 
     /**
-     * @brief Defers an event for use in a later state
+     * @brief Names a state in the reports of the dispatch monitor. Call it
+     * before start(): the other states are named after the order they are
+     * first dispatched in.
+     */
+    void nameState(State (T::*handler)(const EventPtr& ev), string name)
+    {
+        for (auto& n : state_names)
+        {
+            if (n.first == handler)
+            {
+                n.second = std::move(name);
+                return;
+            }
+        }
+        state_names.emplace_back(handler, std::move(name));
+    }
+
+    /**
+     * @brief Defers an event for use in a later state. Deferred events are
+     * coalesced with the same rules as the queued ones.
      * 
      * @param ev event
      */
     void defer(const EventPtr& ev)
     {
-        deferred_events.put(ev);
+        enqueue(deferred_events, ev, 0);
     }
 
     /**
@@ -397,7 +463,43 @@ protected:
     
     State Hsm_top(const EventPtr& ev) { return IGNORED; }
 
+    /**
+     * @brief Runs the operations awaited by the StateTask coroutines of the
+     * state handlers, eg: co_await coroutines.offload([&] { ... });
+     */
+    CoroutineHost coroutines{*this};
+
 private:
+    /**
+     * @brief Registers the dispatch monitor to the watchdog, named after the
+     * state machine and its thread
+     */
+    void watch()
+    {
+        if (watched)
+            return;
+
+        string name = demangle(typeid(T).name());
+        if (!getThreadSpec().name.empty())
+            name = fmt::format("{}[{}]", name, getThreadSpec().name);
+        dispatch_monitor.setName(name);
+
+        DispatchWatchdog::getInstance().add(&dispatch_monitor);
+        watched = true;
+    }
+
+    const string& getStateName(State (T::*handler)(const EventPtr& ev))
+    {
+        for (const auto& n : state_names)
+        {
+            if (n.first == handler)
+                return n.second;
+        }
+        return state_names
+            .emplace_back(handler, fmt::format("State{}", state_names.size()))
+            .second;
+    }
+
     /**
      * @brief Initializes the state machine executing ENTRY and INIT in the
      * state hierarchy
@@ -444,5 +546,12 @@ private:
         this->temp  = target;
     }
 
-    SyncCircularBuffer<EventPtr, DefEventSize> deferred_events;
+    SyncMultiLevelQueue<EventPtr, DefEventSize, 1> deferred_events;
+
+    DispatchMonitor dispatch_monitor;
+    bool watched = false;
+
+    // Deque: the monitor keeps references to the names
+    std::deque<std::pair<State (T::*)(const EventPtr& ev), string>>
+        state_names;
 };
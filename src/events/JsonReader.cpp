@@ -0,0 +1,676 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "JsonReader.h"
+
+#include <fmt/format.h>
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using nlohmann::json;
+
+// Guards the stack against deeply nested values in unknown keys
+static constexpr unsigned int MAX_DEPTH = 256;
+
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+void JsonReader::read()
+{
+    if (peek() != '{')
+    {
+        value_t type = typeOf(peek());
+        skipValue(0);
+        expectEnd();
+        throw typeError("object", type);
+    }
+    ++pos;
+
+    if (peek() == '}')
+        ++pos;
+    else
+    {
+        for (;;)
+        {
+            Field* field = find(parseKey());
+            expect(':');
+            readValue(field);
+
+            char c = peek();
+            ++pos;
+            if (c == '}')
+                break;
+            else if (c != ',')
+                syntaxError("expected ',' or '}'");
+        }
+    }
+    expectEnd();
+
+    // Same order as the DOM decoder, which reads the fields one by one
+    for (size_t i = 0; i < num_fields; ++i)
+    {
+        const Field& f = fields[i];
+        if (!f.found)
+            throw json::out_of_range::create(
+                403, fmt::format("key '{}' not found", f.key), nullptr);
+        if (f.error_expected != nullptr)
+            throw typeError(f.error_expected, f.error_type);
+    }
+}
+
+bool JsonReader::readEventId(string_view json_str, uint16_t& id)
+{
+    JsonReader reader{json_str};
+    if (reader.peek() != '{')
+        return false;
+    ++reader.pos;
+
+    if (reader.peek() == '}')
+        return false;
+
+    for (;;)
+    {
+        string_view key = reader.parseKey();
+        reader.expect(':');
+
+        if (key == "event_id")
+        {
+            char c = reader.peek();
+            if (c == '-' || isDigit(c))
+            {
+                Value v = reader.parseNumber();
+                if (v.type == value_t::number_unsigned &&
+                    v.uinteger <= std::numeric_limits<uint16_t>::max())
+                {
+                    id = v.uinteger;
+                    return true;
+                }
+            }
+
+            // Errors in the rest of the json come first, as nlohmann::json
+            // parses it all before looking at the values
+            uint16_t unused;
+            JsonReader(json_str).field("event_id", unused).read();
+            throw json::type_error::create(
+                302, "event_id must be an unsigned 16 bit number", nullptr);
+        }
+        reader.skipValue(1);
+
+        char c = reader.peek();
+        ++reader.pos;
+        if (c == '}')
+            return false;
+        else if (c != ',')
+            reader.syntaxError("expected ',' or '}'");
+    }
+}
+
+JsonReader::Field* JsonReader::find(string_view key)
+{
+    for (size_t i = 0; i < num_fields; ++i)
+    {
+        if (fields[i].key == key)
+            return &fields[i];
+    }
+    return nullptr;
+}
+
+void JsonReader::readValue(Field* field)
+{
+    if (field == nullptr)
+    {
+        skipValue(1);
+        return;
+    }
+
+    // The last duplicate wins
+    field->found          = true;
+    field->error_expected = nullptr;
+
+    if (field->clear == nullptr)
+    {
+        readElement(field);
+        return;
+    }
+
+    if (peek() != '[')
+    {
+        setError(field, "array", typeOf(peek()));
+        skipValue(1);
+        return;
+    }
+    ++pos;
+    field->clear(field->ptr);
+
+    if (peek() == ']')
+    {
+        ++pos;
+        return;
+    }
+
+    for (;;)
+    {
+        readElement(field);
+
+        char c = peek();
+        ++pos;
+        if (c == ']')
+            break;
+        else if (c != ',')
+            syntaxError("expected ',' or ']'");
+    }
+}
+
+void JsonReader::readElement(Field* field)
+{
+    switch (peek())
+    {
+        case '"':
+        {
+            string* str = field->str(field->ptr);
+            if (str == nullptr)
+                setError(field, field->type_name, value_t::string);
+            else
+                str->clear();
+            parseString(str);
+            break;
+        }
+        case '{':
+        case '[':
+            setError(field, field->type_name, typeOf(peek()));
+            skipValue(2);
+            break;
+        case 't':
+        case 'f':
+        case 'n':
+        {
+            Value v = parseLiteral();
+            if (!field->set(field->ptr, v))
+                setError(field, field->type_name, v.type);
+            break;
+        }
+        default:
+        {
+            Value v = parseNumber();
+            if (!field->set(field->ptr, v))
+                setError(field, field->type_name, v.type);
+            break;
+        }
+    }
+}
+
+void JsonReader::setError(Field* field, const char* expected, value_t type)
+{
+    if (field->error_expected == nullptr)
+    {
+        field->error_expected = expected;
+        field->error_type     = type;
+    }
+}
+
+void JsonReader::skipValue(unsigned int depth)
+{
+    if (depth > MAX_DEPTH)
+        syntaxError("too many nested values");
+
+    switch (peek())
+    {
+        case '{':
+            ++pos;
+            if (peek() == '}')
+            {
+                ++pos;
+                return;
+            }
+            for (;;)
+            {
+                if (peek() != '"')
+                    syntaxError("expected string literal");
+                parseString(nullptr);
+                expect(':');
+                skipValue(depth + 1);
+
+                char c = peek();
+                ++pos;
+                if (c == '}')
+                    return;
+                else if (c != ',')
+                    syntaxError("expected ',' or '}'");
+            }
+        case '[':
+            ++pos;
+            if (peek() == ']')
+            {
+                ++pos;
+                return;
+            }
+            for (;;)
+            {
+                skipValue(depth + 1);
+
+                char c = peek();
+                ++pos;
+                if (c == ']')
+                    return;
+                else if (c != ',')
+                    syntaxError("expected ',' or ']'");
+            }
+        case '"':
+            parseString(nullptr);
+            return;
+        case 't':
+        case 'f':
+        case 'n':
+            parseLiteral();
+            return;
+        default:
+            parseNumber();
+            return;
+    }
+}
+
+char JsonReader::peek()
+{
+    while (pos < end &&
+           (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r'))
+        ++pos;
+
+    // Never a valid token
+    return pos < end ? *pos : '\0';
+}
+
+void JsonReader::expect(char c)
+{
+    if (peek() != c)
+        syntaxError(c == ':' ? "expected ':'" : "unexpected token");
+    ++pos;
+}
+
+void JsonReader::expectEnd()
+{
+    peek();
+    if (pos != end)
+        syntaxError("expected end of input");
+}
+
+string_view JsonReader::parseKey()
+{
+    if (peek() != '"')
+        syntaxError("expected string literal");
+
+    // Plain keys are used in place, without copying them
+    const char* start = pos + 1;
+    const char* p     = start;
+    while (p < end && *p != '"' && *p != '\\' &&
+           (unsigned char)*p >= 0x20 && (unsigned char)*p < 0x80)
+        ++p;
+
+    if (p < end && *p == '"')
+    {
+        pos = p + 1;
+        return {start, (size_t)(p - start)};
+    }
+
+    scratch.clear();
+    parseString(&scratch);
+    return scratch;
+}
+
+void JsonReader::parseString(string* out)
+{
+    ++pos;  // Opening quote
+    const char* run = pos;
+
+    for (;;)
+    {
+        if (pos == end)
+            syntaxError("missing closing quote");
+
+        unsigned char c = *pos;
+        if (c == '"' || c == '\\')
+        {
+            if (out != nullptr)
+                out->append(run, pos);
+            ++pos;
+
+            if (c == '"')
+                return;
+
+            parseEscape(out);
+            run = pos;
+        }
+        else if (c < 0x20)
+        {
+            syntaxError("control character must be escaped");
+        }
+        else if (c < 0x80)
+        {
+            ++pos;
+        }
+        else
+        {
+            // Same UTF-8 validation as nlohmann::json (RFC 3629)
+            auto in = [&](size_t i, unsigned char lo, unsigned char hi)
+            {
+                return pos + i < end && (unsigned char)pos[i] >= lo &&
+                       (unsigned char)pos[i] <= hi;
+            };
+
+            size_t len;
+            if (c >= 0xC2 && c <= 0xDF)
+                len = in(1, 0x80, 0xBF) ? 2 : 0;
+            else if (c == 0xE0)
+                len = in(1, 0xA0, 0xBF) && in(2, 0x80, 0xBF) ? 3 : 0;
+            else if ((c >= 0xE1 && c <= 0xEC) || c == 0xEE || c == 0xEF)
+                len = in(1, 0x80, 0xBF) && in(2, 0x80, 0xBF) ? 3 : 0;
+            else if (c == 0xED)
+                len = in(1, 0x80, 0x9F) && in(2, 0x80, 0xBF) ? 3 : 0;
+            else if (c == 0xF0)
+                len = in(1, 0x90, 0xBF) && in(2, 0x80, 0xBF) &&
+                              in(3, 0x80, 0xBF)
+                          ? 4
+                          : 0;
+            else if (c >= 0xF1 && c <= 0xF3)
+                len = in(1, 0x80, 0xBF) && in(2, 0x80, 0xBF) &&
+                              in(3, 0x80, 0xBF)
+                          ? 4
+                          : 0;
+            else if (c == 0xF4)
+                len = in(1, 0x80, 0x8F) && in(2, 0x80, 0xBF) &&
+                              in(3, 0x80, 0xBF)
+                          ? 4
+                          : 0;
+            else
+                len = 0;
+
+            if (len == 0)
+                syntaxError("invalid string: ill-formed UTF-8 byte");
+            pos += len;
+        }
+    }
+}
+
+void JsonReader::parseEscape(string* out)
+{
+    if (pos == end)
+        syntaxError("missing closing quote");
+
+    char c;
+    switch (*pos++)
+    {
+        case '"':
+            c = '"';
+            break;
+        case '\\':
+            c = '\\';
+            break;
+        case '/':
+            c = '/';
+            break;
+        case 'b':
+            c = '\b';
+            break;
+        case 'f':
+            c = '\f';
+            break;
+        case 'n':
+            c = '\n';
+            break;
+        case 'r':
+            c = '\r';
+            break;
+        case 't':
+            c = '\t';
+            break;
+        case 'u':
+        {
+            uint32_t cp = parseHex4();
+            if (cp >= 0xD800 && cp <= 0xDBFF)
+            {
+                if (end - pos < 2 || pos[0] != '\\' || pos[1] != 'u')
+                    syntaxError("surrogate U+D800..U+DBFF must be followed "
+                                "by U+DC00..U+DFFF");
+                pos += 2;
+
+                uint32_t low = parseHex4();
+                if (low < 0xDC00 || low > 0xDFFF)
+                    syntaxError("surrogate U+D800..U+DBFF must be followed "
+                                "by U+DC00..U+DFFF");
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            }
+            else if (cp >= 0xDC00 && cp <= 0xDFFF)
+            {
+                syntaxError("surrogate U+DC00..U+DFFF must follow "
+                            "U+D800..U+DBFF");
+            }
+
+            if (out == nullptr)
+                return;
+
+            // UTF-8 encoding
+            if (cp < 0x80)
+                out->push_back((char)cp);
+            else if (cp < 0x800)
+            {
+                out->push_back((char)(0xC0 | (cp >> 6)));
+                out->push_back((char)(0x80 | (cp & 0x3F)));
+            }
+            else if (cp < 0x10000)
+            {
+                out->push_back((char)(0xE0 | (cp >> 12)));
+                out->push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+                out->push_back((char)(0x80 | (cp & 0x3F)));
+            }
+            else
+            {
+                out->push_back((char)(0xF0 | (cp >> 18)));
+                out->push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+                out->push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+                out->push_back((char)(0x80 | (cp & 0x3F)));
+            }
+            return;
+        }
+        default:
+            syntaxError("invalid string: forbidden character after backslash");
+    }
+
+    if (out != nullptr)
+        out->push_back(c);
+}
+
+uint32_t JsonReader::parseHex4()
+{
+    if (end - pos < 4)
+        syntaxError("invalid string: '\\u' must be followed by 4 hex digits");
+
+    uint32_t cp = 0;
+    auto res    = std::from_chars(pos, pos + 4, cp, 16);
+    if (res.ec != std::errc() || res.ptr != pos + 4)
+        syntaxError("invalid string: '\\u' must be followed by 4 hex digits");
+
+    pos += 4;
+    return cp;
+}
+
+JsonReader::Value JsonReader::parseLiteral()
+{
+    auto literal = [&](const char* str, size_t len)
+    { return (size_t)(end - pos) >= len && memcmp(pos, str, len) == 0; };
+
+    Value v{};
+    if (literal("true", 4))
+    {
+        v.type    = value_t::boolean;
+        v.boolean = true;
+        pos += 4;
+    }
+    else if (literal("false", 5))
+    {
+        v.type = value_t::boolean;
+        pos += 5;
+    }
+    else if (literal("null", 4))
+    {
+        v.type = value_t::null;
+        pos += 4;
+    }
+    else
+        syntaxError("invalid literal");
+
+    return v;
+}
+
+JsonReader::Value JsonReader::parseNumber()
+{
+    const char* start = pos;
+    bool negative     = pos < end && *pos == '-';
+    if (negative)
+        ++pos;
+
+    if (pos < end && *pos == '0')
+        ++pos;
+    else if (pos < end && isDigit(*pos))
+        while (pos < end && isDigit(*pos))
+            ++pos;
+    else
+        syntaxError("invalid number");
+
+    bool is_float = false;
+    if (pos < end && *pos == '.')
+    {
+        ++pos;
+        if (pos == end || !isDigit(*pos))
+            syntaxError("invalid number: expected digit after '.'");
+        while (pos < end && isDigit(*pos))
+            ++pos;
+        is_float = true;
+    }
+    if (pos < end && (*pos == 'e' || *pos == 'E'))
+    {
+        ++pos;
+        if (pos < end && (*pos == '+' || *pos == '-'))
+            ++pos;
+        if (pos == end || !isDigit(*pos))
+            syntaxError("invalid number: expected digit after exponent");
+        while (pos < end && isDigit(*pos))
+            ++pos;
+        is_float = true;
+    }
+
+    Value v{};
+    if (!is_float)
+    {
+        // Integers that do not fit are stored as floats, as nlohmann::json
+        // does
+        if (negative)
+        {
+            v.type = value_t::number_integer;
+            if (std::from_chars(start, pos, v.integer).ec == std::errc())
+                return v;
+        }
+        else
+        {
+            v.type = value_t::number_unsigned;
+            if (std::from_chars(start, pos, v.uinteger).ec == std::errc())
+                return v;
+        }
+    }
+
+    v.type  = value_t::number_float;
+    auto ec = std::from_chars(start, pos, v.number).ec;
+    if (ec == std::errc::result_out_of_range)
+    {
+        // Same result as the strtod() used by nlohmann::json: 0 or a
+        // denormal on underflow, inf on overflow
+        v.number = std::strtod(string(start, pos).c_str(), nullptr);
+    }
+
+    if (!std::isfinite(v.number))
+        throw json::out_of_range::create(
+            406,
+            fmt::format("number overflow parsing '{}'",
+                        string_view(start, pos - start)),
+            nullptr);
+
+    return v;
+}
+
+JsonReader::value_t JsonReader::typeOf(char c)
+{
+    switch (c)
+    {
+        case '{':
+            return value_t::object;
+        case '[':
+            return value_t::array;
+        case '"':
+            return value_t::string;
+        case 't':
+        case 'f':
+            return value_t::boolean;
+        case 'n':
+            return value_t::null;
+        default:
+            return value_t::number_float;
+    }
+}
+
+void JsonReader::syntaxError(const char* what)
+{
+    throw json::parse_error::create(
+        101, (size_t)(pos - begin) + 1,
+        fmt::format("syntax error while parsing value - {}", what), nullptr);
+}
+
+json::type_error JsonReader::typeError(const char* expected, value_t type)
+{
+    // Same names used by nlohmann::json::type_name()
+    const char* name;
+    switch (type)
+    {
+        case value_t::null:
+            name = "null";
+            break;
+        case value_t::object:
+            name = "object";
+            break;
+        case value_t::array:
+            name = "array";
+            break;
+        case value_t::string:
+            name = "string";
+            break;
+        case value_t::boolean:
+            name = "boolean";
+            break;
+        default:
+            name = "number";
+            break;
+    }
+
+    return json::type_error::create(
+        302, fmt::format("type must be {}, but is {}", expected, name),
+        nullptr);
+}
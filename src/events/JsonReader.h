@@ -0,0 +1,258 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+/**
+ * @brief On-demand json decoder: reads a json object in place, assigning the
+ * values of the registered fields directly to their variables, without
+ * building a nlohmann::json first.
+ *
+ * Behaves as nlohmann::json::parse() followed by get() on each field: the
+ * whole json is validated, numbers are converted to any numeric type,
+ * unknown keys are ignored, while invalid json, missing keys and mismatched
+ * types throw the same kind of nlohmann::json::exception.
+ */
+class JsonReader
+{
+public:
+    // event_gen.py rejects the events with more variables
+    static constexpr size_t MAX_FIELDS = 16;
+
+    explicit JsonReader(string_view json_str)
+        : pos(json_str.data()), begin(json_str.data()),
+          end(json_str.data() + json_str.size())
+    {
+    }
+
+    template <typename T>
+    JsonReader& field(string_view key, T& value)
+    {
+        assert(num_fields < MAX_FIELDS);
+
+        Field& f    = fields[num_fields++];
+        f.key       = key;
+        f.ptr       = &value;
+        f.set       = &Target<T>::set;
+        f.str       = &Target<T>::str;
+        f.clear     = Target<T>::clear;
+        f.type_name = Target<T>::type_name;
+        return *this;
+    }
+
+    /**
+     * @brief Parses the json and assigns the fields
+     *
+     * @throws nlohmann::json::exception if the json is invalid or a field is
+     * missing or has the wrong type
+     */
+    void read();
+
+    /**
+     * @brief Reads the "event_id" of an event. Parsing stops as soon as it is
+     * found: the rest of the json is not validated.
+     *
+     * @return false if the json is not an object with an "event_id"
+     * @throws nlohmann::json::exception if the json is invalid before the
+     * "event_id", or if the id is not an unsigned 16 bit number
+     */
+    static bool readEventId(string_view json_str, uint16_t& id);
+
+private:
+    using value_t = nlohmann::json::value_t;
+
+    /**
+     * @brief A non-string scalar value
+     */
+    struct Value
+    {
+        value_t type;
+
+        bool boolean      = false;
+        int64_t integer   = 0;
+        uint64_t uinteger = 0;
+        double number     = 0;
+    };
+
+    struct Field
+    {
+        string_view key;
+        void* ptr;
+
+        // Assigns a value, or appends it for vectors. False if the type
+        // does not match.
+        bool (*set)(void* ptr, const Value& value);
+        // String to parse a string value into, null if not a string
+        string* (*str)(void* ptr);
+        // Only for vectors, null otherwise
+        void (*clear)(void* ptr);
+        // Expected json type (of the elements, for vectors)
+        const char* type_name;
+
+        bool found = false;
+
+        // First value that could not be assigned, reported after the whole
+        // json has been validated, as nlohmann::json would do
+        const char* error_expected = nullptr;
+        value_t error_type;
+    };
+
+    template <typename T>
+    struct Target
+    {
+        static bool set(void* ptr, const Value& value)
+        {
+            return convert(value, *static_cast<T*>(ptr));
+        }
+
+        static string* str(void* ptr)
+        {
+            if constexpr (std::is_same_v<T, string>)
+                return static_cast<string*>(ptr);
+            else
+                return nullptr;
+        }
+
+        static constexpr void (*clear)(void*) = nullptr;
+
+        static constexpr const char* type_name =
+            std::is_same_v<T, bool>     ? "boolean"
+            : std::is_arithmetic_v<T>   ? "number"
+            : std::is_same_v<T, string> ? "string"
+                                        : "array";
+    };
+
+    template <typename T>
+    struct Target<vector<T>>
+    {
+        static bool set(void* ptr, const Value& value)
+        {
+            T elem{};
+            if (!convert(value, elem))
+                return false;
+            static_cast<vector<T>*>(ptr)->push_back(std::move(elem));
+            return true;
+        }
+
+        static string* str(void* ptr)
+        {
+            if constexpr (std::is_same_v<T, string>)
+                return &static_cast<vector<T>*>(ptr)->emplace_back();
+            else
+                return nullptr;
+        }
+
+        static void clear(void* ptr) { static_cast<vector<T>*>(ptr)->clear(); }
+
+        static constexpr const char* type_name = Target<T>::type_name;
+    };
+
+    template <typename T>
+    static bool convert(const Value& v, T& out)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            if (v.type != value_t::boolean)
+                return false;
+            out = v.boolean;
+        }
+        else if constexpr (std::is_arithmetic_v<T>)
+        {
+            switch (v.type)
+            {
+                case value_t::number_integer:
+                    out = static_cast<T>(v.integer);
+                    break;
+                case value_t::number_unsigned:
+                    out = static_cast<T>(v.uinteger);
+                    break;
+                case value_t::number_float:
+                    out = static_cast<T>(v.number);
+                    break;
+                case value_t::boolean:
+                    // nlohmann::json converts booleans too, except to its
+                    // own number types
+                    if constexpr (std::is_same_v<T, int64_t> ||
+                                  std::is_same_v<T, uint64_t> ||
+                                  std::is_same_v<T, double>)
+                        return false;
+                    out = static_cast<T>(v.boolean);
+                    break;
+                default:
+                    return false;
+            }
+        }
+        else
+        {
+            // Strings are parsed in place, any other value is a mismatch
+            return false;
+        }
+        return true;
+    }
+
+    Field* find(string_view key);
+
+    void readValue(Field* field);
+    void readElement(Field* field);
+    void setError(Field* field, const char* expected, value_t type);
+
+    void skipValue(unsigned int depth);
+
+    char peek();
+    void expect(char c);
+    void expectEnd();
+    string_view parseKey();
+    void parseString(string* out);
+    void parseEscape(string* out);
+    uint32_t parseHex4();
+    Value parseLiteral();
+    Value parseNumber();
+
+    static value_t typeOf(char c);
+
+    [[noreturn]] void syntaxError(const char* what);
+    static nlohmann::json::type_error typeError(const char* expected,
+                                                value_t type);
+
+    const char* pos;
+    const char* begin;
+    const char* end;
+
+    // Keys with escape sequences are decoded here
+    string scratch;
+
+    std::array<Field, MAX_FIELDS> fields;
+    size_t num_fields = 0;
+};
@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cmath>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <string_view>
+#include <type_traits>
+
+using std::string_view;
+
+/**
+ * @brief Writes a json object directly to a buffer, without building a
+ * nlohmann::json first.
+ *
+ * The output is the same as nlohmann::json::dump() with no indentation, as
+ * long as fields are written in the order nlohmann::json stores them, that is
+ * sorted by key.
+ */
+class JsonWriter
+{
+public:
+    explicit JsonWriter(fmt::memory_buffer& out) : out(out)
+    {
+        out.push_back('{');
+    }
+
+    template <typename T>
+    JsonWriter& field(string_view key, const T& value)
+    {
+        if (!first)
+            out.push_back(',');
+        first = false;
+
+        writeString(out, key);
+        out.push_back(':');
+        write(out, value);
+        return *this;
+    }
+
+    void end() { out.push_back('}'); }
+
+    /**
+     * @brief Writes a single json value: bools, numbers, strings and vectors
+     * of those
+     */
+    template <typename T>
+    static void write(fmt::memory_buffer& out, const T& value)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            append(out, value ? "true" : "false");
+        else if constexpr (std::is_integral_v<T>)
+            fmt::format_to(std::back_inserter(out), "{}", value);
+        else if constexpr (std::is_floating_point_v<T>)
+            writeFloat(out, value);
+        else if constexpr (std::is_convertible_v<const T&, string_view>)
+            writeString(out, value);
+        else
+        {
+            out.push_back('[');
+            bool first = true;
+            for (auto&& v : value)
+            {
+                if (!first)
+                    out.push_back(',');
+                first = false;
+                // Explicit type, as vector<bool> only returns proxies
+                write<typename T::value_type>(out, v);
+            }
+            out.push_back(']');
+        }
+    }
+
+    /**
+     * @brief Writes a string with the same escaping as nlohmann::json: only
+     * quotes, backslashes and control characters are escaped
+     */
+    static void writeString(fmt::memory_buffer& out, string_view str)
+    {
+        out.push_back('"');
+
+        size_t start = 0;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            unsigned char c = str[i];
+            if (c >= 0x20 && c != '"' && c != '\\')
+                continue;
+
+            out.append(str.data() + start, str.data() + i);
+            start = i + 1;
+
+            switch (c)
+            {
+                case '"':
+                    append(out, "\\\"");
+                    break;
+                case '\\':
+                    append(out, "\\\\");
+                    break;
+                case '\b':
+                    append(out, "\\b");
+                    break;
+                case '\f':
+                    append(out, "\\f");
+                    break;
+                case '\n':
+                    append(out, "\\n");
+                    break;
+                case '\r':
+                    append(out, "\\r");
+                    break;
+                case '\t':
+                    append(out, "\\t");
+                    break;
+                default:
+                    fmt::format_to(std::back_inserter(out), "\\u{:04x}", c);
+                    break;
+            }
+        }
+        out.append(str.data() + start, str.data() + str.size());
+
+        out.push_back('"');
+    }
+
+    /**
+     * @brief Writes a number the way nlohmann::json does: floats are stored as
+     * doubles, nan and inf become null
+     */
+    static void writeFloat(fmt::memory_buffer& out, double value)
+    {
+        if (!std::isfinite(value))
+        {
+            append(out, "null");
+            return;
+        }
+
+        // Same formatter used by dump(): its output is not always the
+        // shortest one, so fmt would differ in the last digits
+        char buf[64];
+        char* buf_end =
+            nlohmann::detail::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, buf_end);
+    }
+
+private:
+    static void append(fmt::memory_buffer& out, string_view str)
+    {
+        out.append(str.data(), str.data() + str.size());
+    }
+
+    fmt::memory_buffer& out;
+    bool first = true;
+};
@@ -1,11 +1,22 @@
 #!/bin/python3
 
+# Generates Events.h, Events.cpp and kotlin/Events.kt from the event list in
+# events.txt (or the file passed as first argument). Run from any directory.
+#
+# An event name may be followed by its priority class in brackets, e.g.
+# "EventCameraCmdCapture [COMMAND]" (see EventPriority.h). Events without one
+# are CONTROL.
+
 from string import Template
 import datetime
 import re
+import shutil
 import sys
 import os
 
+base_dir = os.path.dirname(os.path.abspath(__file__))
+schema = sys.argv[1] if len(sys.argv) > 1 else os.path.join(base_dir, "events.txt")
+
 includes = []
 events = []
 topics = []
@@ -13,19 +24,39 @@ topics = []
 re_topic = re.compile(r"\s*(?P<topic>[A-Z_0-9]+)\s*\n")
 re_include = re.compile(r"\s*(?P<include>\#include [\"\<][\w\d/\.]+[\"\>]\n)")
 
-re_event_name_vars = re.compile(r"\s*((?P<name>\w+)\s*{)")
-re_event_name_no_vars = re.compile(r"\s*((?P<name>\w+)\s*\n)")
+re_priority = r"([ \t]+\[(?P<priority>\w+)\])?"
+re_event_name_vars = re.compile(r"\s*((?P<name>\w+)" + re_priority + r"\s*{)")
+re_event_name_no_vars = re.compile(r"\s*((?P<name>\w+)" + re_priority + r"\s*\n)")
+
+priorities = ["COMMAND", "CONTROL", "TELEMETRY"]
+
+# JsonReader::MAX_FIELDS: read_json() registers a field per variable
+max_vars = 16
 
 re_vars = re.compile(r"\s*((?P<type>[\w:<>]+)[ \t]+(?P<name>\w+))+\s*")
 re_end_vars = re.compile(r"}\s*")
 
-json_case_template = Template(
-    "case $event_name::id:\n"
-    + "    return make_shared<$event_name>(\n"
-    + "           j.get<$event_name>());\n"
-    + "    break;\n"
+# Entry of the id -> decoder table used by jsonToEvent()
+json_decoder_template = Template("&eventFromJson<$event_name>,\n")
+
+# Entry of the id -> reader table used by jsonStringToEvent()
+json_reader_template = Template("&eventFromJsonString<$event_name>,\n")
+
+# Entry of the id -> EventValue table used by toEventValue()
+value_converter_template = Template("&eventToValue<$event_name>,\n")
+
+# Entry of the id -> priority table used by getEventPriority()
+priority_template = Template("EventPriority::$priority,  // $event_name\n")
+
+# to_string() formats the members directly, without going through json
+to_string_vars_template = Template(
+    'fmt::format("$event_name {{$to_string_format}}"$var_list)'
 )
 
+# write_json() emits the fields in the same order as nlohmann::json, which
+# keeps object keys sorted
+json_field_template = Template('.field("$var_name", $var_value)')
+
 kotlin_type_map = {
     "int8_t": "Byte",
     "int16_t": "Short",
@@ -74,7 +105,18 @@ def kotlinVarName(varname: str):
     return kot
 
 
-with open("./events.txt", "r") as event_list:
+def parsePriority(m):
+    priority = m.group("priority") or "CONTROL"
+    if priority not in priorities:
+        sys.exit(
+            "Error parsing event {}: unknown priority {}".format(
+                m.group("name"), priority
+            )
+        )
+    return priority
+
+
+with open(schema, "r") as event_list:
     state = "parse_topics"
     file_str = event_list.read()
 
@@ -100,14 +142,22 @@ with open("./events.txt", "r") as event_list:
                 if m_evt:
                     file_str = file_str[m_evt.end() :]
                     name = m_evt.group("name")
-                    events.append({"name": name, "vars": []})
+                    events.append(
+                        {"name": name, "vars": [], "priority": parsePriority(m_evt)}
+                    )
                     state = "parse_vars"
                 else:
                     m_evt = re_event_name_no_vars.match(file_str)
                     if m_evt:
                         file_str = file_str[m_evt.end() :]
                         name = m_evt.group("name")
-                        events.append({"name": name, "vars": []})
+                        events.append(
+                            {
+                                "name": name,
+                                "vars": [],
+                                "priority": parsePriority(m_evt),
+                            }
+                        )
                     else:
                         sys.exit(
                             "Error parsing event: expected event name. @\n{}...".format(
@@ -125,6 +175,12 @@ with open("./events.txt", "r") as event_list:
                     m = re_end_vars.match(file_str)
                     if m:
                         file_str = file_str[m.end() :]
+                        if len(events[-1]["vars"]) > max_vars:
+                            sys.exit(
+                                "Error parsing event {}: more than {} vars".format(
+                                    events[-1]["name"], max_vars
+                                )
+                            )
                         state = "parse_event_name"
                     else:
                         sys.exit(
@@ -134,13 +190,13 @@ with open("./events.txt", "r") as event_list:
                         )
 
 
-with open("./templates/event_dec.template", "r") as file:
+with open(os.path.join(base_dir, "templates", "event_dec.template"), "r") as file:
     event_dec_templ = Template(file.read())
 
-with open("./templates/event_def.template", "r") as file:
+with open(os.path.join(base_dir, "templates", "event_def.template"), "r") as file:
     event_def_templ = Template(file.read())
 
-with open("./templates/event_def.kt.template", "r") as file:
+with open(os.path.join(base_dir, "templates", "event_def.kt.template"), "r") as file:
     kotlin_event_template = Template(file.read())
 
 starting_id = 10
@@ -150,7 +206,11 @@ file_templ_d = {
     "includes": "",
     "event_dec": "",
     "event_def": "",
-    "json_to_event_cases": "",
+    "json_decoders": "",
+    "json_readers": "",
+    "value_converters": "",
+    "event_priorities": "",
+    "first_event_id": starting_id,
     "kotlin_event_def": "",
     "kotlin_event_switch": "",
     "year": dt.year,
@@ -161,6 +221,26 @@ for i, ev in enumerate(events):
     event_templ_d = {}
     event_templ_d["event_name"] = ev["name"]
     event_templ_d["id_val"] = starting_id + i
+    event_templ_d["priority"] = ev["priority"]
+
+    json_fields = [("event_id", "id")] + [
+        (var["name"], var["name"]) for var in ev["vars"]
+    ]
+    event_templ_d["json_fields"] = "".join(
+        [
+            json_field_template.substitute(var_name=name, var_value=value)
+            for name, value in sorted(json_fields)
+        ]
+    )
+    # The event id is read before the event, the reader ignores it
+    event_templ_d["json_read_fields"] = "".join(
+        [
+            json_field_template.substitute(
+                var_name=var["name"], var_value=var["name"]
+            )
+            for var in ev["vars"]
+        ]
+    )
 
     if ev["vars"]:
         event_templ_d["members"] = "\n".join(
@@ -179,6 +259,9 @@ for i, ev in enumerate(events):
             [var["name"] for var in ev["vars"]]
         )
         event_templ_d["def_constructor"] = "\n{}() : Event(id) {{}};".format(ev["name"])
+        event_templ_d["to_string_direct"] = to_string_vars_template.substitute(
+            **event_templ_d
+        )
         event_templ_d["no_macro_args"] = ""
         event_templ_d["kotlin_vars"] = "\n" + "\n".join(
             [
@@ -198,6 +281,7 @@ for i, ev in enumerate(events):
         event_templ_d["c_params_init"] = ""
         event_templ_d["var_list"] = ""
         event_templ_d["def_constructor"] = ""
+        event_templ_d["to_string_direct"] = "name()"
         event_templ_d["no_macro_args"] = "_NOARGS"
 
     file_templ_d["event_dec"] += event_dec_templ.substitute(**event_templ_d)
@@ -205,38 +289,52 @@ for i, ev in enumerate(events):
     file_templ_d["kotlin_event_def"] += kotlin_event_template.substitute(
         **event_templ_d
     )
-    file_templ_d["json_to_event_cases"] += json_case_template.substitute(
+    file_templ_d["json_decoders"] += json_decoder_template.substitute(
+        **event_templ_d
+    )
+    file_templ_d["json_readers"] += json_reader_template.substitute(
+        **event_templ_d
+    )
+    file_templ_d["value_converters"] += value_converter_template.substitute(
+        **event_templ_d
+    )
+    file_templ_d["event_priorities"] += priority_template.substitute(
         **event_templ_d
     )
     file_templ_d["kotlin_event_switch"] += kotlin_event_switch_templ.substitute(**event_templ_d)
 
 
 file_templ_d["includes"] = "\n".join(includes)
+# EventValue alternatives, in id order
+file_templ_d["event_values"] = ", ".join([ev["name"] for ev in events])
 file_templ_d["topic_enum"] = ",\n".join(topics)
-file_templ_d["topic_string_map"] = ",\n".join(
-    ['{{{t},"{t}"}}'.format(t=t) for t in topics]
-)
-file_templ_d["topic_id_map"] = ",\n".join(['{{"{t}",{t}}}'.format(t=t) for t in topics])
+# Topics are numbered from 0 in declaration order: names are looked up by index
+file_templ_d["topic_names"] = "".join(['"{t}",\n'.format(t=t) for t in topics])
 
-with open("./templates/Events.h.template", "r") as file:
+with open(os.path.join(base_dir, "templates", "Events.h.template"), "r") as file:
     events_h_templ = Template(file.read())
 
-with open("./templates/Events.cpp.template", "r") as file:
+with open(os.path.join(base_dir, "templates", "Events.cpp.template"), "r") as file:
     events_cpp_templ = Template(file.read())
 
-with open("Events.h", "w") as file:
+events_h = os.path.join(base_dir, "Events.h")
+events_cpp = os.path.join(base_dir, "Events.cpp")
+
+with open(events_h, "w") as file:
     file.write(events_h_templ.substitute(**file_templ_d))
 
-with open("Events.cpp", "w") as file:
+with open(events_cpp, "w") as file:
     file.write(events_cpp_templ.substitute(**file_templ_d))
 
-os.system("clang-format -i --style=file Events.h")
-os.system("clang-format -i --style=file Events.cpp")
+if shutil.which("clang-format"):
+    os.system("clang-format -i --style=file {} {}".format(events_h, events_cpp))
+else:
+    print("clang-format not found: generated files are not formatted")
 
 
 # Kotlin
-with open("./templates/Events.kt.template", "r") as file:
+with open(os.path.join(base_dir, "templates", "Events.kt.template"), "r") as file:
     events_kot_templ = Template(file.read())
 
-with open("./kotlin/Events.kt", "w") as file:
+with open(os.path.join(base_dir, "kotlin", "Events.kt"), "w") as file:
     file.write(events_kot_templ.substitute(**file_templ_d))
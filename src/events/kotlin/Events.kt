@@ -112,6 +112,10 @@ class EventCameraControllerState : Event(32)
     @SerializedName("state" ) var state : String? = null
     @SerializedName("camera_connected" ) var cameraConnected : Boolean? = null
     @SerializedName("download_enabled" ) var downloadEnabled : Boolean? = null
+    @SerializedName("low_latency" ) var lowLatency : Boolean? = null
+    @SerializedName("probe_latency_us" ) var probeLatencyUs : Int? = null
+    @SerializedName("probe_period_ms" ) var probePeriodMs : Int? = null
+    @SerializedName("recovery_time_ms" ) var recoveryTimeMs : Int? = null
 }
 
 class EventConfigGetShutterSpeed : Event(33) 
@@ -322,6 +326,7 @@ class EventIntervalometerStart : Event(77)
 {
     @SerializedName("intervalms" ) var intervalms : Int? = null
     @SerializedName("total_captures" ) var totalCaptures : Int? = null
+    @SerializedName("missed_policy" ) var missedPolicy : String? = null
 }
 
 class EventIntervalometerDeadlineExpired : Event(78) 
@@ -334,6 +339,9 @@ class EventIntervalometerState : Event(79)
     @SerializedName("intervalms" ) var intervalms : Int? = null
     @SerializedName("num_captures" ) var numCaptures : Int? = null
     @SerializedName("total_captures" ) var totalCaptures : Int? = null
+    @SerializedName("missed_frames" ) var missedFrames : Int? = null
+    @SerializedName("timing_error_us" ) var timingErrorUs : Int? = null
+    @SerializedName("max_timing_error_us" ) var maxTimingErrorUs : Int? = null
 }
 
 class EventEnableEventPassThrough : Event(80) 
@@ -344,6 +352,191 @@ class EventDisableEventPassThrough : Event(81)
 {
 }
 
+class EventModeIntervalometerAnchored : Event(82) 
+{
+    @SerializedName("intervalms" ) var intervalms : Int? = null
+    @SerializedName("total_captures" ) var totalCaptures : Int? = null
+    @SerializedName("missed_policy" ) var missedPolicy : String? = null
+}
+
+class EventModeBulbRamping : Event(83) 
+{
+    @SerializedName("intervalms" ) var intervalms : Int? = null
+    @SerializedName("total_captures" ) var totalCaptures : Int? = null
+    @SerializedName("max_ev_step" ) var maxEvStep : Float? = null
+    @SerializedName("max_iso" ) var maxIso : Int? = null
+}
+
+class EventBulbRampingStart : Event(84) 
+{
+    @SerializedName("intervalms" ) var intervalms : Int? = null
+    @SerializedName("total_captures" ) var totalCaptures : Int? = null
+    @SerializedName("max_ev_step" ) var maxEvStep : Float? = null
+    @SerializedName("max_iso" ) var maxIso : Int? = null
+}
+
+class EventBulbRampingDeadlineExpired : Event(85) 
+{
+}
+
+class EventBulbRampingState : Event(86) 
+{
+    @SerializedName("state" ) var state : String? = null
+    @SerializedName("num_captures" ) var numCaptures : Int? = null
+    @SerializedName("total_captures" ) var totalCaptures : Int? = null
+    @SerializedName("shutter_speed" ) var shutterSpeed : Int? = null
+    @SerializedName("iso" ) var iso : Int? = null
+    @SerializedName("aperture" ) var aperture : Int? = null
+    @SerializedName("exposure_ev" ) var exposureEv : Float? = null
+    @SerializedName("light_meter" ) var lightMeter : Float? = null
+    @SerializedName("late_writes" ) var lateWrites : Int? = null
+    @SerializedName("write_overrun_ms" ) var writeOverrunMs : Int? = null
+}
+
+class EventModeBracketing : Event(87) 
+{
+    @SerializedName("num_frames" ) var numFrames : Int? = null
+    @SerializedName("ev_step" ) var evStep : Float? = null
+    @SerializedName("pipelined" ) var pipelined : Boolean? = null
+}
+
+class EventBracketingStart : Event(88) 
+{
+    @SerializedName("num_frames" ) var numFrames : Int? = null
+    @SerializedName("ev_step" ) var evStep : Float? = null
+    @SerializedName("pipelined" ) var pipelined : Boolean? = null
+}
+
+class EventBracketingState : Event(89) 
+{
+    @SerializedName("state" ) var state : String? = null
+    @SerializedName("num_frames" ) var numFrames : Int? = null
+    @SerializedName("num_captures" ) var numCaptures : Int? = null
+    @SerializedName("shutter_speeds" ) var shutterSpeeds : ArrayList<Int>? = null
+    @SerializedName("pipelined" ) var pipelined : Boolean? = null
+    @SerializedName("bracket_time_ms" ) var bracketTimeMs : Int? = null
+}
+
+class EventCameraCmdFocusDrive : Event(90) 
+{
+    @SerializedName("steps" ) var steps : Int? = null
+}
+
+class EventCameraCmdAutofocus : Event(91) 
+{
+}
+
+class EventCameraFocusDriveDone : Event(92) 
+{
+    @SerializedName("steps" ) var steps : Int? = null
+    @SerializedName("drive_time_ms" ) var driveTimeMs : Int? = null
+}
+
+class EventModeFocusStacking : Event(93) 
+{
+    @SerializedName("num_frames" ) var numFrames : Int? = null
+    @SerializedName("focus_steps" ) var focusSteps : Int? = null
+    @SerializedName("autofocus" ) var autofocus : Boolean? = null
+}
+
+class EventFocusStackingStart : Event(94) 
+{
+    @SerializedName("num_frames" ) var numFrames : Int? = null
+    @SerializedName("focus_steps" ) var focusSteps : Int? = null
+    @SerializedName("autofocus" ) var autofocus : Boolean? = null
+}
+
+class EventFocusStackingState : Event(95) 
+{
+    @SerializedName("state" ) var state : String? = null
+    @SerializedName("num_frames" ) var numFrames : Int? = null
+    @SerializedName("num_captures" ) var numCaptures : Int? = null
+    @SerializedName("focus_steps" ) var focusSteps : Int? = null
+    @SerializedName("capture_time_ms" ) var captureTimeMs : Int? = null
+    @SerializedName("focus_time_ms" ) var focusTimeMs : Int? = null
+    @SerializedName("step_time_ms" ) var stepTimeMs : Int? = null
+    @SerializedName("avg_step_time_ms" ) var avgStepTimeMs : Int? = null
+    @SerializedName("stack_time_ms" ) var stackTimeMs : Int? = null
+}
+
+class EventCameraCmdPollEvents_Internal : Event(96) 
+{
+}
+
+class EventCameraCmdCaptureAll : Event(97) 
+{
+}
+
+class EventCaptureAllDone : Event(98) 
+{
+    @SerializedName("num_cameras" ) var numCameras : Int? = null
+    @SerializedName("num_captured" ) var numCaptured : Int? = null
+    @SerializedName("trigger_skew_us" ) var triggerSkewUs : Int? = null
+    @SerializedName("capture_time_ms" ) var captureTimeMs : Int? = null
+}
+
+class EventGetCameraList : Event(99) 
+{
+}
+
+class EventCameraList : Event(100) 
+{
+    @SerializedName("serials" ) var serials : ArrayList<String>? = null
+}
+
+class EventCameraCmdForward : Event(101) 
+{
+    @SerializedName("serial" ) var serial : String? = null
+    @SerializedName("event" ) var event : String? = null
+}
+
+class EventCameraForwarded : Event(102) 
+{
+    @SerializedName("serial" ) var serial : String? = null
+    @SerializedName("event" ) var event : String? = null
+}
+
+class EventCaptureAllFinish_Internal : Event(103) 
+{
+}
+
+class EventUsbDeviceAdded : Event(104) 
+{
+    @SerializedName("port" ) var port : String? = null
+}
+
+class EventUsbDeviceRemoved : Event(105) 
+{
+    @SerializedName("port" ) var port : String? = null
+}
+
+class EventCoroutineResume_Internal : Event(106) 
+{
+    @SerializedName("token" ) var token : Int? = null
+}
+
+class EventCameraOpDone_Internal : Event(107) 
+{
+    @SerializedName("success" ) var success : Boolean? = null
+}
+
+class EventHandlerOverrun : Event(108) 
+{
+    @SerializedName("handler" ) var handler : String? = null
+    @SerializedName("state" ) var state : String? = null
+    @SerializedName("event" ) var event : String? = null
+    @SerializedName("duration_ms" ) var durationMs : Int? = null
+    @SerializedName("finished" ) var finished : Boolean? = null
+}
+
+class EventBulbRampingReplyTimeout : Event(109) 
+{
+}
+
+class EventBracketingSetTimeout : Event(110) 
+{
+}
+
 
 
 fun jsonToEvent(json: String) : Event?
@@ -424,6 +617,35 @@ fun jsonToEvent(json: String) : Event?
         79 -> return gson.fromJson(json, EventIntervalometerState::class.java)
         80 -> return gson.fromJson(json, EventEnableEventPassThrough::class.java)
         81 -> return gson.fromJson(json, EventDisableEventPassThrough::class.java)
+        82 -> return gson.fromJson(json, EventModeIntervalometerAnchored::class.java)
+        83 -> return gson.fromJson(json, EventModeBulbRamping::class.java)
+        84 -> return gson.fromJson(json, EventBulbRampingStart::class.java)
+        85 -> return gson.fromJson(json, EventBulbRampingDeadlineExpired::class.java)
+        86 -> return gson.fromJson(json, EventBulbRampingState::class.java)
+        87 -> return gson.fromJson(json, EventModeBracketing::class.java)
+        88 -> return gson.fromJson(json, EventBracketingStart::class.java)
+        89 -> return gson.fromJson(json, EventBracketingState::class.java)
+        90 -> return gson.fromJson(json, EventCameraCmdFocusDrive::class.java)
+        91 -> return gson.fromJson(json, EventCameraCmdAutofocus::class.java)
+        92 -> return gson.fromJson(json, EventCameraFocusDriveDone::class.java)
+        93 -> return gson.fromJson(json, EventModeFocusStacking::class.java)
+        94 -> return gson.fromJson(json, EventFocusStackingStart::class.java)
+        95 -> return gson.fromJson(json, EventFocusStackingState::class.java)
+        96 -> return gson.fromJson(json, EventCameraCmdPollEvents_Internal::class.java)
+        97 -> return gson.fromJson(json, EventCameraCmdCaptureAll::class.java)
+        98 -> return gson.fromJson(json, EventCaptureAllDone::class.java)
+        99 -> return gson.fromJson(json, EventGetCameraList::class.java)
+        100 -> return gson.fromJson(json, EventCameraList::class.java)
+        101 -> return gson.fromJson(json, EventCameraCmdForward::class.java)
+        102 -> return gson.fromJson(json, EventCameraForwarded::class.java)
+        103 -> return gson.fromJson(json, EventCaptureAllFinish_Internal::class.java)
+        104 -> return gson.fromJson(json, EventUsbDeviceAdded::class.java)
+        105 -> return gson.fromJson(json, EventUsbDeviceRemoved::class.java)
+        106 -> return gson.fromJson(json, EventCoroutineResume_Internal::class.java)
+        107 -> return gson.fromJson(json, EventCameraOpDone_Internal::class.java)
+        108 -> return gson.fromJson(json, EventHandlerOverrun::class.java)
+        109 -> return gson.fromJson(json, EventBulbRampingReplyTimeout::class.java)
+        110 -> return gson.fromJson(json, EventBracketingSetTimeout::class.java)
 
         
         else -> return null
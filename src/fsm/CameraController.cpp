@@ -24,21 +24,67 @@
 
 #include <chrono>
 #include <filesystem>
+#include <memory>
 #include <thread>
 
 #include "events/EventBroker.h"
 
 using std::dynamic_pointer_cast;
+using std::make_shared;
 using namespace std::this_thread;
 using namespace gphotow;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
 using std::chrono::milliseconds;
 using std::chrono::seconds;
+using std::chrono::steady_clock;
 using std::filesystem::path;
 
 CameraController::CameraController(string download_dir)
-    : HSM(&CameraController::stateInit), download_dir(download_dir)
+    : CameraController(download_dir, std::make_unique<CameraWrapper>())
 {
-    sEventBroker.subscribe(this, TOPIC_CAMERA_CMD);
+}
+
+CameraController::CameraController(string download_dir,
+                                   unique_ptr<CameraBase> camera,
+                                   CameraTopics topics)
+    : HSM(&CameraController::stateInit), download_dir(download_dir),
+      topics(topics), camera_ptr(std::move(camera)), camera(*camera_ptr)
+{
+    // Only the last value of a setting is written to the camera, and a
+    // pending read answers all the requests for the same setting. Relative
+    // commands (focus drives, next focus mode) are all executed.
+    setCoalescing<EventConfigSetShutterSpeed>(Coalescing::LATEST);
+    setCoalescing<EventConfigSetAperture>(Coalescing::LATEST);
+    setCoalescing<EventConfigSetISO>(Coalescing::LATEST);
+    setCoalescing<EventConfigSetCaptureTarget>(Coalescing::LATEST);
+    setCoalescing<EventConfigSetLongExpNR>(Coalescing::LATEST);
+    setCoalescing<EventConfigSetAutoISO>(Coalescing::LATEST);
+    for (const auto& getter : config_getters)
+        setCoalescing(getter.first, Coalescing::FIRST);
+    setCoalescing<EventConfigGetAll>(Coalescing::FIRST);
+
+    // Times the exposures: must not be preempted by logging or networking
+    setThreadSpec(ThreadSpecs::camera("camera"));
+    coroutines.setThreadSpec(ThreadSpecs::camera("camera-io"));
+
+    // Names in the reports of the handlers taking longer than the budget
+    nameState(&CameraController::stateSuper, "Super");
+    nameState(&CameraController::stateDisconnected, "Disconnected");
+    nameState(&CameraController::stateConnected, "Connected");
+    nameState(&CameraController::stateReady, "Ready");
+    nameState(&CameraController::stateConnectionError, "ConnectionError");
+    nameState(&CameraController::stateError, "Error");
+    nameState(&CameraController::stateCapturing, "Capturing");
+    nameState(&CameraController::stateDownloading, "Downloading");
+
+    sEventBroker.subscribe(this, topics.cmd);
+}
+
+CameraController::~CameraController()
+{
+    // An in flight capture or download still uses the camera: wait for it
+    stop();
 }
 
 State CameraController::stateInit(const EventPtr& ev)
@@ -74,6 +120,7 @@ State CameraController::stateSuper(const EventPtr& ev)
             auto d_ev =
                 dynamic_pointer_cast<const EventCameraCmdLowLatency>(ev);
             low_latency = d_ev->low_latency;
+            getState();
             break;
         }
         case EventGetCameraControllerState::id:
@@ -95,6 +142,7 @@ State CameraController::stateDisconnected(const EventPtr& ev)
     switch (ev->getID())
     {
         case EventSMEntry::id:
+            connection_lost = false;
             onStateChanged(CCState::DISCONNECTED);
             LOG_STATE(slog, "ENTRY");
             break;
@@ -124,9 +172,22 @@ State CameraController::stateConnected(const EventPtr& ev)
     switch (ev->getID())
     {
         case EventSMEntry::id:
-            sEventBroker.post(EventCameraConnected{}, TOPIC_CAMERA_EVENT);
+            sEventBroker.post(EventCameraConnected{}, topics.event);
 
             LOG_STATE(slog, "ENTRY");
+            config_stale = true;
+            health.reset();
+
+            if (connection_lost)
+            {
+                connection_lost  = false;
+                recovery_time_ms = duration_cast<milliseconds>(
+                                       steady_clock::now() -
+                                       connection_lost_time)
+                                       .count();
+                LOG_INFO(slog, "Connection recovered in {} ms",
+                         recovery_time_ms);
+            }
 
             try
             {
@@ -144,11 +205,17 @@ State CameraController::stateConnected(const EventPtr& ev)
             break;
         case EventSMExit::id:
             LOG_STATE(slog, "EXIT");
+            connection_lost      = true;
+            connection_lost_time = steady_clock::now();
             onCameraConnected(false);
             break;
         case EventCameraError::id:
             retState = transition(&CameraController::stateError);
             break;
+        case EventUsbDeviceRemoved::id:
+            // Can't tell which device it was: check that ours is still there
+            checkConnection();
+            break;
         default:
             retState = tran_super(&CameraController::stateSuper);
             break;
@@ -166,27 +233,46 @@ State CameraController::stateReady(const EventPtr& ev)
             LOG_STATE(slog, "ENTRY");
             onStateChanged(CCState::READY);
             processDeferred();
-            
-            sEventBroker.post(EventCameraReady{}, TOPIC_CAMERA_EVENT);
 
-            if (!low_latency)
+            if (capture_done)
             {
-                if (!getAllConfig())
-                {
-                    checkConnection();
-                }
+                sEventBroker.post(capture_done, topics.event);
+                capture_done.reset();
             }
+            sEventBroker.post(EventCameraReady{}, topics.event);
+
+            if (!refreshConfig())
+                checkConnection();
+
+            schedulePoll();
             break;
         case EventSMInit::id:
             break;
         case EventSMExit::id:
-            sEventBroker.post(EventCameraBusyOrError{}, TOPIC_CAMERA_EVENT);
+            sEventBroker.removeDelayed(poll_events_event_id);
+            sEventBroker.post(EventCameraBusyOrError{}, topics.event);
             LOG_STATE(slog, "EXIT");
             break;
         case EventConfigGetAll::id:
             if (!getAllConfig())
                 checkConnection();
             break;
+        case EventCameraCmdPollEvents_Internal::id:
+            // Doubles as liveness probe
+            if (!pollCameraEvents())
+            {
+                checkConnection();
+            }
+            else if (config_stale)
+            {
+                // Settings changed on the body
+                if (getAllConfig())
+                    config_stale = false;
+                else
+                    checkConnection();
+            }
+            schedulePoll();
+            break;
         case EventCameraCmdCapture::id:
             retState = transition(&CameraController::stateCapturing);
             break;
@@ -209,15 +295,16 @@ State CameraController::stateConnectionError(const EventPtr& ev)
     {
         case EventSMEntry::id:
             onStateChanged(CCState::CONNECTION_ERROR);
-            sEventBroker.post(EventCameraConnectionError{}, TOPIC_CAMERA_EVENT);
+            sEventBroker.post(EventCameraConnectionError{}, topics.event);
             LOG_STATE(slog, "ENTRY");
             state_error_recover_event_id = sEventBroker.postDelayed(
-                EventCameraCmdRecoverError{}, TOPIC_CAMERA_CMD, RETRY_DELAY_MS);
+                EventCameraCmdRecoverError{}, topics.cmd, RETRY_DELAY_MS);
             break;
         case EventSMInit::id:
             break;
         case EventSMExit::id:
             LOG_STATE(slog, "EXIT");
+            sEventBroker.removeDelayed(state_error_recover_event_id);
             break;
         case EventCameraCmdConnect::id:
             if (connect())
@@ -226,6 +313,13 @@ State CameraController::stateConnectionError(const EventPtr& ev)
                 retState = transition(&CameraController::stateConnectionError);
 
             break;
+        case EventUsbDeviceAdded::id:
+        {
+            auto a_ev = dynamic_pointer_cast<const EventUsbDeviceAdded>(ev);
+            if (hotplugConnect(a_ev->port))
+                retState = transition(&CameraController::stateConnected);
+            break;
+        }
         case EventCameraCmdRecoverError::id:
             if (connect())
             {
@@ -253,9 +347,9 @@ State CameraController::stateError(const EventPtr& ev)
         case EventSMEntry::id:
             LOG_STATE(slog, "ENTRY");
             onStateChanged(CCState::ERROR);
-            sEventBroker.post(EventCameraError{}, TOPIC_CAMERA_EVENT);
+            sEventBroker.post(EventCameraError{}, topics.event);
             state_error_recover_event_id = sEventBroker.postDelayed(
-                EventCameraCmdRecoverError{}, TOPIC_CAMERA_CMD, RETRY_DELAY_MS);
+                EventCameraCmdRecoverError{}, topics.cmd, RETRY_DELAY_MS);
             processDeferred();
             break;
         case EventSMInit::id:
@@ -270,6 +364,13 @@ State CameraController::stateError(const EventPtr& ev)
             camera.disconnect();
             retState = transition(&CameraController::stateDisconnected);
             break;
+        case EventUsbDeviceAdded::id:
+        {
+            auto a_ev = dynamic_pointer_cast<const EventUsbDeviceAdded>(ev);
+            if (hotplugConnect(a_ev->port))
+                retState = transition(&CameraController::stateConnected);
+            break;
+        }
         case EventCameraCmdRecoverError::id:
             camera.disconnect();
             sleep_for(milliseconds(500));
@@ -299,7 +400,7 @@ State CameraController::stateCapturing(const EventPtr& ev)
             LOG_STATE(slog, "ENTRY");
             onStateChanged(CCState::CAPTURING);
             postEvent(EventCameraCmdCapture_Internal{});
-            sBroker.post(EventCameraCaptureStarted{}, TOPIC_CAMERA_EVENT);
+            sBroker.post(EventCameraCaptureStarted{}, topics.event);
             break;
         case EventSMInit::id:
             break;
@@ -307,38 +408,33 @@ State CameraController::stateCapturing(const EventPtr& ev)
             LOG_STATE(slog, "EXIT");
             break;
         case EventCameraCmdCapture_Internal::id:
+            // Other events are handled while the camera captures
+            camera_busy = true;
+            captureAsync();
+            break;
+        case EventCameraOpDone_Internal::id:
         {
-            try
+            auto d_ev =
+                dynamic_pointer_cast<const EventCameraOpDone_Internal>(ev);
+            camera_busy = false;
+            if (!d_ev->success)
             {
-                last_capture_path = camera.capture();
-                LOG_INFO(slog, "Capture successfull: {}",
-                         last_capture_path.getPath());
-                if (do_download)
-                {
-                    retState = transition(&CameraController::stateDownloading);
-                }
-                else
-                {
-                    retState = transition(&CameraController::stateReady);
-                    sEventBroker.post(EventCameraCaptureDone{false, "", ""},
-                                      TOPIC_CAMERA_EVENT);
-                }
+                retState = transition(&CameraController::stateError);
             }
-            catch (gphotow::GPhotoError& gpe)
+            else if (do_download)
             {
-                LOG_ERR(slog, "Camera capture error (GPhoto): {} = {}",
-                        gpe.error, gpe.what());
-                retState = transition(&CameraController::stateError);
+                retState = transition(&CameraController::stateDownloading);
             }
-            catch (std::exception& e)
+            else
             {
-                LOG_ERR(slog, "Camera capture error: {}", e.what());
-                retState = transition(&CameraController::stateError);
+                capture_done =
+                    make_shared<const EventCameraCaptureDone>(false, "", "");
+                retState = transition(&CameraController::stateReady);
             }
             break;
         }
         default:
-            if(!deferSetters(ev))
+            if (!deferWhileBusy(ev))
                 retState = tran_super(&CameraController::stateConnected);
             break;
     }
@@ -362,41 +458,82 @@ State CameraController::stateDownloading(const EventPtr& ev)
             LOG_STATE(slog, "EXIT");
             break;
         case EventCameraCmdDownload_Internal::id:
+            camera_busy = true;
+            downloadAsync();
+            break;
+        case EventCameraOpDone_Internal::id:
         {
-            try
+            auto d_ev =
+                dynamic_pointer_cast<const EventCameraOpDone_Internal>(ev);
+            camera_busy = false;
+            if (d_ev->success)
             {
-                camera.downloadFile(last_capture_path.toCameraFilePath(),
-                                    path(download_dir)
-                                        .append(last_capture_path.name)
-                                        .generic_string());
-
-                sEventBroker.post(
-                    EventCameraCaptureDone{
-                        true, download_dir, last_capture_path.name},
-                    TOPIC_CAMERA_EVENT);
+                capture_done = make_shared<const EventCameraCaptureDone>(
+                    true, download_dir, last_capture_path.name);
                 retState = transition(&CameraController::stateConnected);
             }
-            catch (gphotow::GPhotoError& gpe)
-            {
-                LOG_ERR(slog, "Camera download error (GPhoto): {} = {}",
-                        gpe.error, gpe.what());
-                retState = transition(&CameraController::stateError);
-            }
-            catch (std::exception& e)
+            else
             {
-                LOG_ERR(slog, "Camera download error: {}", e.what());
                 retState = transition(&CameraController::stateError);
             }
             break;
         }
         default:
-            if(!deferSetters(ev))
+            if (!deferWhileBusy(ev))
                 retState = tran_super(&CameraController::stateConnected);
             break;
     }
     return retState;
 }
 
+StateTask CameraController::captureAsync()
+{
+    auto slog    = log.getChild("Capture");
+    bool success = false;
+    try
+    {
+        last_capture_path =
+            co_await coroutines.offload([this] { return camera.capture(); });
+        LOG_INFO(slog, "Capture successfull: {}", last_capture_path.getPath());
+        success = true;
+    }
+    catch (gphotow::GPhotoError& gpe)
+    {
+        LOG_ERR(slog, "Camera capture error (GPhoto): {} = {}", gpe.error,
+                gpe.what());
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERR(slog, "Camera capture error: {}", e.what());
+    }
+    postEvent(EventCameraOpDone_Internal{success});
+}
+
+StateTask CameraController::downloadAsync()
+{
+    auto slog    = log.getChild("Download");
+    bool success = false;
+    try
+    {
+        CameraFilePath src = last_capture_path.toCameraFilePath();
+        string dst =
+            path(download_dir).append(last_capture_path.name).generic_string();
+
+        co_await coroutines.offload([&] { camera.downloadFile(src, dst); });
+        success = true;
+    }
+    catch (gphotow::GPhotoError& gpe)
+    {
+        LOG_ERR(slog, "Camera download error (GPhoto): {} = {}", gpe.error,
+                gpe.what());
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERR(slog, "Camera download error: {}", e.what());
+    }
+    postEvent(EventCameraOpDone_Internal{success});
+}
+
 State CameraController::handleConfigGetSet(const EventPtr& ev)
 {
     ConfigEventHandleResult s = getConfig(ev);
@@ -419,7 +556,14 @@ bool CameraController::connect()
 {
     try
     {
-        camera.connect();
+        string serial = camera.connect();
+        if (!expected_serial.empty() && serial != expected_serial)
+        {
+            LOG_ERR(log, "Connected to camera {} instead of {}", serial,
+                    expected_serial);
+            camera.disconnect();
+            return false;
+        }
         return true;
     }
     catch (gphotow::GPhotoError& gpe)
@@ -434,6 +578,13 @@ bool CameraController::connect()
     return false;
 }
 
+void CameraController::setCameraIndex(unsigned int index)
+{
+    setThreadSpec(ThreadSpecs::camera(fmt::format("camera-{}", index), index));
+    coroutines.setThreadSpec(
+        ThreadSpecs::camera(fmt::format("camera-io-{}", index), index));
+}
+
 bool CameraController::deferSetters(const EventPtr& ev)
 {
     if (config_setters.count(ev->getID()) > 0)
@@ -444,6 +595,25 @@ bool CameraController::deferSetters(const EventPtr& ev)
     return false;
 }
 
+bool CameraController::deferWhileBusy(const EventPtr& ev)
+{
+    if (deferSetters(ev))
+        return true;
+
+    if (!camera_busy)
+        return false;
+
+    uint16_t id = ev->getID();
+    if (config_getters.count(id) > 0 || id == EventConfigGetAll::id ||
+        id == EventCameraCmdCapture::id || id == EventUsbDeviceRemoved::id ||
+        id == EventCameraError::id)
+    {
+        defer(ev);
+        return true;
+    }
+    return false;
+}
+
 CameraController::ConfigEventHandleResult CameraController::setConfig(
     const EventPtr& ev)
 {
@@ -515,6 +685,91 @@ bool CameraController::getAllConfig()
     return false;
 }
 
+bool CameraController::getVolatileConfig()
+{
+    try
+    {
+        for (uint16_t id : volatile_config)
+        {
+            config_getters.at(id)(*this);
+        }
+        return true;
+    }
+    catch (gphotow::GPhotoError& gpe)
+    {
+        LOG_ERR(log, "Camera get config error (GPhoto): {} = {}", gpe.error,
+                gpe.what());
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERR(log, "Camera get config error: {}", e.what());
+    }
+    return false;
+}
+
+bool CameraController::refreshConfig()
+{
+    // Also collects the change notifications queued during the capture
+    if (!low_latency && !pollCameraEvents())
+        return false;
+
+    if (config_stale)
+    {
+        if (!getAllConfig())
+            return false;
+
+        config_stale = false;
+        return true;
+    }
+
+    return low_latency || getVolatileConfig();
+}
+
+bool CameraController::pollCameraEvents()
+{
+    static constexpr int MAX_POLLED_EVENTS = 32;
+
+    auto start = steady_clock::now();
+    bool ok    = true;
+    try
+    {
+        for (int i = 0; i < MAX_POLLED_EVENTS; ++i)
+        {
+            CameraEvent cev = camera.waitForEvent(0);
+            if (cev.first == GP_EVENT_TIMEOUT)
+                break;
+
+            // Property changes are reported as unknown events
+            if (cev.first == GP_EVENT_UNKNOWN)
+            {
+                LOG_DEBUG(log, "Camera settings changed on the body");
+                config_stale = true;
+            }
+        }
+    }
+    catch (gphotow::GPhotoError& gpe)
+    {
+        LOG_ERR(log, "Error reading camera events (GPhoto): {} = {}",
+                gpe.error, gpe.what());
+        ok = false;
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERR(log, "Error reading camera events: {}", e.what());
+        ok = false;
+    }
+
+    health.record(ok, duration_cast<microseconds>(steady_clock::now() - start));
+    return ok;
+}
+
+void CameraController::schedulePoll()
+{
+    poll_events_event_id = sEventBroker.postDelayed(
+        EventCameraCmdPollEvents_Internal{}, topics.cmd,
+        health.getPeriod().count());
+}
+
 void CameraController::onStateChanged(CCState state)
 {
     this->state = state;
@@ -533,27 +788,55 @@ void CameraController::getState()
     e.camera_connected = camera_connected;
     e.state            = state_names.at(state);
     e.download_enabled = do_download;
+    e.low_latency      = low_latency;
+    e.probe_latency_us = health.getAverageLatency().count();
+    e.probe_period_ms  = health.getPeriod().count();
+    e.recovery_time_ms = recovery_time_ms;
 
-    sEventBroker.post(std::move(e), TOPIC_CAMERA_CONFIG);
+    sEventBroker.post(std::move(e), topics.config);
 }
 
 void CameraController::checkConnection()
 {
-    try
-    {
-        auto ss = camera.getShutterSpeed().shutter_speed;
-        camera.setShutterSpeed(1000000);
-        camera.setShutterSpeed(ss);
-        return;
-    }
-    catch (gphotow::GPhotoError& gpe)
+    static constexpr int CHECK_CONNECTION_PROBES = 2;
+
+    // The failed operation may just have been refused: only give up if the
+    // camera does not answer anymore
+    for (int i = 0; i < CHECK_CONNECTION_PROBES; ++i)
     {
-        LOG_ERR(log, "Error communicating with camera (GPhoto): {} = {}",
-                gpe.error, gpe.what());
+        if (pollCameraEvents())
+            return;
     }
-    catch (std::exception& e)
+    postEvent(EventCameraError{});
+}
+
+bool CameraController::hotplugConnect(const string& port)
+{
+    static constexpr int HOTPLUG_CONNECT_ATTEMPTS = 5;
+    static constexpr int HOTPLUG_RETRY_DELAY_MS   = 200;
+
+    LOG_INFO(log, "Camera plugged on {}, reconnecting", port);
+
+    // Release the handle to the unplugged camera, if still open
+    camera.disconnect();
+
+    string prev_port = camera.getPort();
+    camera.setPort(port);
+    for (int i = 0; i < HOTPLUG_CONNECT_ATTEMPTS; ++i)
     {
-        LOG_ERR(log, "Error communicating with camera: {}", e.what());
+        if (i > 0)
+            sleep_for(milliseconds(HOTPLUG_RETRY_DELAY_MS));
+
+        if (connect())
+        {
+            // Follow the camera to its new port if it was bound to one,
+            // otherwise keep connecting to the first camera found
+            if (prev_port.empty())
+                camera.setPort(prev_port);
+            return true;
+        }
     }
-    postEvent(EventCameraError{});
-}
\ No newline at end of file
+
+    camera.setPort(prev_port);
+    return false;
+}
@@ -22,12 +22,16 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "Events.h"
+#include "HealthProbe.h"
 #include "camera/CameraWrapper.h"
 #include "events/HSM.h"
 #include "utils/logger/PrintLogger.h"
@@ -35,8 +39,22 @@
 using std::function;
 using std::map;
 using std::string;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::steady_clock;
 
-class CameraController : public HSM<CameraController>
+/**
+ * @brief Topics a CameraController receives commands from and publishes on.
+ * The default ones are those used by the modes and the remote clients.
+ */
+struct CameraTopics
+{
+    uint8_t cmd    = TOPIC_CAMERA_CMD;
+    uint8_t event  = TOPIC_CAMERA_EVENT;
+    uint8_t config = TOPIC_CAMERA_CONFIG;
+};
+
+class CameraController : public HSM<CameraController, 100>
 {
 public:
     enum class CCState : uint8_t
@@ -51,6 +69,20 @@ public:
 
     CameraController(string download_dir = ".");
 
+    /**
+     * @brief Creates a controller driving the provided camera, eg: a
+     * SimulatedCamera, on the provided topics
+     */
+    CameraController(string download_dir,
+                     unique_ptr<gphotow::CameraBase> camera,
+                     CameraTopics topics = {});
+
+    /**
+     * @brief Stops the controller and the worker of its coroutines before the
+     * camera they may be using is destroyed
+     */
+    ~CameraController();
+
     State stateInit(const EventPtr& ev);
     State stateSuper(const EventPtr& ev);
     State stateDisconnected(const EventPtr& ev);
@@ -64,6 +96,18 @@ public:
 
     void setDownloadDir(string download_dir);
 
+    /**
+     * @brief Only accept the camera with this serial number, eg: when another
+     * camera may be plugged on the port it used
+     */
+    void setExpectedSerial(string serial) { expected_serial = serial; }
+
+    /**
+     * @brief Runs the threads of the controller on the CPU of the camera with
+     * this index, see ThreadSpecs::camera(). Call it before start().
+     */
+    void setCameraIndex(unsigned int index);
+
 private:
     enum class ConfigEventHandleResult
     {
@@ -79,29 +123,97 @@ private:
     bool connect();
     void checkConnection();
 
+    /**
+     * @brief Connects to a camera that was just plugged on the provided port,
+     * without waiting for the next retry. Retries a few times while the camera
+     * starts up.
+     */
+    bool hotplugConnect(const string& port);
+
     bool deferSetters(const EventPtr& ev);
+
+    /**
+     * @brief Defers the setters and, while a capture or a download is in
+     * flight, the events that would touch the camera
+     */
+    bool deferWhileBusy(const EventPtr& ev);
+
+    /**
+     * @brief Capture and download, on the worker of the coroutines. They post
+     * an EventCameraOpDone_Internal when done.
+     */
+    StateTask captureAsync();
+    StateTask downloadAsync();
     State handleConfigGetSet(const EventPtr& ev);
     ConfigEventHandleResult getConfig(const EventPtr& ev);
     ConfigEventHandleResult setConfig(const EventPtr& ev);
     bool getAllConfig();
 
+    /**
+     * @brief Reads the settings that change on their own (battery, light
+     * meter). The others only change when we write them or when the camera
+     * notifies it.
+     */
+    bool getVolatileConfig();
+
+    /**
+     * @brief Reads the whole configuration if it has not been read since the
+     * camera connected or if the camera reported a change, otherwise only the
+     * volatile settings. In low latency the camera events are not polled and
+     * only the first read is performed.
+     */
+    bool refreshConfig();
+
+    /**
+     * @brief Drains the events queued by the camera, marking the
+     * configuration as stale if it reported a property change. This is also
+     * the liveness probe: it does not read or write any setting.
+     * @return False if the camera did not answer
+     */
+    bool pollCameraEvents();
+
+    /**
+     * @brief Schedules the next event poll, as often as the health probe says
+     */
+    void schedulePoll();
+
     CCState state;
     bool camera_connected;
     string download_dir;
+    CameraTopics topics;
+    string expected_serial;
     gphotow::CameraPath last_capture_path;
+    // Result of the last capture, published when entering Ready after the
+    // deferred commands, so that commands sent in reaction to it are queued
+    // behind them
+    EventPtr capture_done;
     bool do_download = false;
     bool low_latency = false;
+    // The whole configuration must be read at the next Ready entry
+    bool config_stale = true;
+    // A capture or a download is running on the worker of the coroutines
+    bool camera_busy = false;
+
+    unique_ptr<gphotow::CameraBase> camera_ptr;
+    gphotow::CameraBase& camera;
+
+    HealthProbe health;
 
-    gphotow::CameraWrapper camera{};
+    // Time from losing the connection to the camera to getting it back
+    bool connection_lost = false;
+    steady_clock::time_point connection_lost_time;
+    int32_t recovery_time_ms = 0;
 
     PrintLogger log = Logging::getLogger("CamCtrl");
 
     uint16_t state_error_recover_event_id = 0;
+    uint16_t poll_events_event_id         = 0;
 
     static const map<uint16_t, function<void(CameraController&)>>
         config_getters;
     static const map<uint16_t,
                      function<void(CameraController&, const EventPtr&)>>
         config_setters;
+    static const vector<uint16_t> volatile_config;
     static const map<CCState, string> state_names;
 };
\ No newline at end of file
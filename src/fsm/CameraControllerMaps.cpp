@@ -20,6 +20,7 @@
  * THE SOFTWARE.
  */
 
+#include <chrono>
 #include <memory>
 
 #include "CameraController.h"
@@ -28,6 +29,9 @@
 
 using namespace gphotow;
 using std::dynamic_pointer_cast;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 
 const map<uint16_t, function<void(CameraController&)>>
     CameraController::config_getters{
@@ -37,77 +41,77 @@ const map<uint16_t, function<void(CameraController&)>>
 
              sEventBroker.post(
                  EventConfigValueShutterSpeed{ss.shutter_speed, ss.bulb},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetChoicesShutterSpeed::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigChoicesShutterSpeed{
                      cc.camera.getShutterSpeedChoices(false)},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetAperture::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigValueAperture{cc.camera.getAperture()},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetChoicesAperture::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigChoicesAperture{cc.camera.getApertureChoices()},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetISO::id,
          [](CameraController& cc) {
              sEventBroker.post(EventConfigValueISO{cc.camera.getISO()},
-                               TOPIC_CAMERA_CONFIG);
+                               cc.topics.config);
          }},
         {EventConfigGetChoicesISO::id,
          [](CameraController& cc) {
              sEventBroker.post(EventConfigChoicesISO{cc.camera.getIsoChoices()},
-                               TOPIC_CAMERA_CONFIG);
+                               cc.topics.config);
          }},
         {EventConfigGetFocalLength::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigValueFocalLength{cc.camera.getFocalLength()},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetFocusMode::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigValueFocusMode{cc.camera.getFocusMode()},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetLongExpNR::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigValueLongExpNR{cc.camera.getLongExpNR()},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetAutoISO::id,
          [](CameraController& cc) {
              sEventBroker.post(EventConfigValueAutoISO{cc.camera.getAutoISO()},
-                               TOPIC_CAMERA_CONFIG);
+                               cc.topics.config);
          }},
         {EventConfigGetBattery::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigValueBattery{cc.camera.getBatteryPercent()},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetCaptureTarget::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigValueCaptureTarget{cc.camera.getCaptureTarget()},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetExposureProgram::id,
          [](CameraController& cc) {
              sEventBroker.post(
                  EventConfigValueExposureProgram{cc.camera.getExposureProgram()},
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }},
         {EventConfigGetLightMeter::id, [](CameraController& cc) {
              float val                      = cc.camera.getLightMeter();
@@ -115,7 +119,7 @@ const map<uint16_t, function<void(CameraController&)>>
 
              sEventBroker.post(
                  EventConfigValueLightMeter(val, range.min, range.max),
-                 TOPIC_CAMERA_CONFIG);
+                 cc.topics.config);
          }}};
 
 const map<uint16_t, function<void(CameraController&, const EventPtr&)>>
@@ -165,10 +169,40 @@ const map<uint16_t, function<void(CameraController&, const EventPtr&)>>
                  dynamic_pointer_cast<const EventConfigSetAutoISO>(ev);
              cc.camera.setAutoISO(set_ev->auto_iso);
              config_getters.at(EventConfigGetAutoISO::id)(cc);
+         }},
+        // Focus drives are not settings, but like them they must wait for the
+        // capture in progress to end
+        {EventCameraCmdFocusDrive::id,
+         [](CameraController& cc, const EventPtr& ev) {
+             auto drive_ev =
+                 dynamic_pointer_cast<const EventCameraCmdFocusDrive>(ev);
+             auto start = steady_clock::now();
+             cc.camera.manualFocusDrive(drive_ev->steps);
+             auto time =
+                 duration_cast<milliseconds>(steady_clock::now() - start);
+
+             sEventBroker.post(EventCameraFocusDriveDone{
+                                   drive_ev->steps,
+                                   static_cast<int32_t>(time.count())},
+                               cc.topics.event);
+         }},
+        {EventCameraCmdAutofocus::id,
+         [](CameraController& cc, const EventPtr& ev) {
+             auto start = steady_clock::now();
+             cc.camera.autoFocusDrive();
+             auto time =
+                 duration_cast<milliseconds>(steady_clock::now() - start);
+
+             sEventBroker.post(EventCameraFocusDriveDone{
+                                   0, static_cast<int32_t>(time.count())},
+                               cc.topics.event);
          }}
 
     };
 
+const vector<uint16_t> CameraController::volatile_config{
+    EventConfigGetBattery::id, EventConfigGetLightMeter::id};
+
 const map<CameraController::CCState, string> CameraController::state_names{
     {CCState::DISCONNECTED, "Disconnected"},
     {CCState::READY, "Ready"},
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "HealthProbe.h"
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+HealthProbe::HealthProbe(milliseconds min_period, milliseconds max_period)
+    : min_period(min_period), max_period(max_period), period(min_period)
+{
+}
+
+void HealthProbe::record(bool ok, microseconds latency)
+{
+    if (!ok)
+    {
+        ++failures;
+        period = min_period;
+        return;
+    }
+
+    bool slow = !history.isEmpty() &&
+                latency > max(MIN_SLOW_LATENCY,
+                              getAverageLatency() * SLOW_FACTOR);
+
+    if (history.isFull())
+        total_latency -= history.get(0);
+    history.put(latency);
+    total_latency += latency;
+    updateMaxLatency();
+
+    failures = 0;
+    period   = slow ? min_period : min(period * 2, max_period);
+}
+
+void HealthProbe::reset()
+{
+    while (!history.isEmpty())
+        history.pop();
+
+    total_latency = microseconds{0};
+    max_latency   = microseconds{0};
+    failures      = 0;
+    period        = min_period;
+}
+
+microseconds HealthProbe::getAverageLatency() const
+{
+    if (history.isEmpty())
+        return microseconds{0};
+
+    return total_latency / history.count();
+}
+
+void HealthProbe::updateMaxLatency()
+{
+    max_latency = microseconds{0};
+    for (unsigned int i = 0; i < history.count(); ++i)
+        max_latency = max(max_latency, history.get(i));
+}
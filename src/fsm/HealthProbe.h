@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "utils/collections/CircularBuffer.h"
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+/**
+ * @brief Keeps the latency history of the liveness probes sent to the camera
+ * and decides how often to send them.
+ *
+ * The probing period doubles after each normal probe, up to max_period, and
+ * drops back to min_period after a failed probe or one much slower than the
+ * recent ones, so that a camera going away is noticed quickly without
+ * keeping the bus busy while it is healthy.
+ */
+class HealthProbe
+{
+public:
+    HealthProbe(milliseconds min_period = milliseconds(250),
+                milliseconds max_period = milliseconds(4000));
+
+    /**
+     * @brief Records the outcome of a probe and adapts the probing period
+     * @param ok Whether the camera answered
+     * @param latency Time taken by the probe
+     */
+    void record(bool ok, microseconds latency);
+
+    /**
+     * @brief Forgets the history, eg: after reconnecting
+     */
+    void reset();
+
+    /**
+     * @brief Time to wait before the next probe
+     */
+    milliseconds getPeriod() const { return period; }
+
+    /**
+     * @brief Average latency of the successful probes in the history
+     */
+    microseconds getAverageLatency() const;
+
+    /**
+     * @brief Maximum latency of the successful probes in the history
+     */
+    microseconds getMaxLatency() const { return max_latency; }
+
+    /**
+     * @brief Number of probes failed in a row
+     */
+    unsigned int getFailures() const { return failures; }
+
+private:
+    static constexpr unsigned int HISTORY_SIZE = 32;
+    // A probe slower than this many times the average one is an anomaly
+    static constexpr int SLOW_FACTOR = 4;
+    // ...as long as it also takes at least this long
+    static constexpr microseconds MIN_SLOW_LATENCY{2000};
+
+    void updateMaxLatency();
+
+    milliseconds min_period;
+    milliseconds max_period;
+    milliseconds period;
+
+    CircularBuffer<microseconds, HISTORY_SIZE> history;
+    microseconds total_latency{0};
+    microseconds max_latency{0};
+    unsigned int failures = 0;
+};
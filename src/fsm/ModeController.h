@@ -46,6 +46,11 @@ class ModeController : public HSM<ModeController>
 public:
     ModeController() : HSM<ModeController>(&ModeController::stateInit)
     {
+        // Names in the reports of the handlers taking longer than the budget
+        nameState(&ModeController::stateSuper, "Super");
+        nameState(&ModeController::stateModeSelection, "ModeSelection");
+        nameState(&ModeController::stateRunning, "Running");
+
         sEventBroker.subscribe(this, TOPIC_REMOTE_CMD);
         sEventBroker.subscribe(this, TOPIC_MODE_CONTROLLER);
         sEventBroker.subscribe(this, TOPIC_HEARTBEAT);
@@ -181,15 +186,103 @@ private:
                              TOPIC_MODE_STATE);
                 auto ie =
                     dynamic_pointer_cast<const EventModeIntervalometer>(ev);
-                sEventBroker.post(EventIntervalometerStart{ie->intervalms,
-                                                           ie->total_captures},
-                                  TOPIC_MODE_FSM);
+                sEventBroker.post(
+                    EventIntervalometerStart{ie->intervalms,
+                                             ie->total_captures, ""},
+                    TOPIC_MODE_FSM);
                 LOG_INFO(slog,
                          "Starting intervalometer. interval: {:.1f}s, num: {}",
                          ie->intervalms / 1000.0f, ie->total_captures);
                 retState = transition(&ModeController::stateRunning);
                 break;
             }
+            case EventModeIntervalometerAnchored::id:
+            {
+                current_mode = "Intervalometer";
+                sBroker.post(EventValueCurrentMode{current_mode},
+                             TOPIC_MODE_STATE);
+                auto ie = dynamic_pointer_cast<
+                    const EventModeIntervalometerAnchored>(ev);
+                sEventBroker.post(
+                    EventIntervalometerStart{ie->intervalms, ie->total_captures,
+                                             ie->missed_policy},
+                    TOPIC_MODE_FSM);
+                LOG_INFO(slog,
+                         "Starting anchored intervalometer. interval: {:.1f}s, "
+                         "num: {}, missed frames: {}",
+                         ie->intervalms / 1000.0f, ie->total_captures,
+                         ie->missed_policy);
+                retState = transition(&ModeController::stateRunning);
+                break;
+            }
+            case EventModeBulbRamping::id:
+            {
+                auto be = dynamic_pointer_cast<const EventModeBulbRamping>(ev);
+                if (be->intervalms <= 0)
+                {
+                    LOG_ERR(slog, "Bulb ramping requires a positive interval");
+                    break;
+                }
+                current_mode = "BulbRamping";
+                sBroker.post(EventValueCurrentMode{current_mode},
+                             TOPIC_MODE_STATE);
+                sEventBroker.post(
+                    EventBulbRampingStart{be->intervalms, be->total_captures,
+                                          be->max_ev_step, be->max_iso},
+                    TOPIC_MODE_FSM);
+                LOG_INFO(slog,
+                         "Starting bulb ramping. interval: {:.1f}s, num: {}, "
+                         "max step: {:.2f} EV, max ISO: {}",
+                         be->intervalms / 1000.0f, be->total_captures,
+                         be->max_ev_step, be->max_iso);
+                retState = transition(&ModeController::stateRunning);
+                break;
+            }
+            case EventModeBracketing::id:
+            {
+                auto be = dynamic_pointer_cast<const EventModeBracketing>(ev);
+                if (be->num_frames <= 0)
+                {
+                    LOG_ERR(slog, "Bracketing requires at least one frame");
+                    break;
+                }
+                current_mode = "Bracketing";
+                sBroker.post(EventValueCurrentMode{current_mode},
+                             TOPIC_MODE_STATE);
+                sEventBroker.post(EventBracketingStart{be->num_frames,
+                                                       be->ev_step,
+                                                       be->pipelined},
+                                  TOPIC_MODE_FSM);
+                LOG_INFO(slog,
+                         "Starting bracketing. frames: {}, step: {:.2f} EV, "
+                         "pipelined: {}",
+                         be->num_frames, be->ev_step, be->pipelined);
+                retState = transition(&ModeController::stateRunning);
+                break;
+            }
+            case EventModeFocusStacking::id:
+            {
+                auto fe =
+                    dynamic_pointer_cast<const EventModeFocusStacking>(ev);
+                if (fe->num_frames <= 0)
+                {
+                    LOG_ERR(slog, "Focus stacking requires at least one frame");
+                    break;
+                }
+                current_mode = "FocusStacking";
+                sBroker.post(EventValueCurrentMode{current_mode},
+                             TOPIC_MODE_STATE);
+                sEventBroker.post(EventFocusStackingStart{fe->num_frames,
+                                                          fe->focus_steps,
+                                                          fe->autofocus},
+                                  TOPIC_MODE_FSM);
+                LOG_INFO(slog,
+                         "Starting focus stacking. frames: {}, focus steps: "
+                         "{}, autofocus: {}",
+                         fe->num_frames, fe->focus_steps, fe->autofocus);
+                retState = transition(&ModeController::stateRunning);
+                break;
+            }
             default:
                 retState = tran_super(&ModeController::stateSuper);
                 break;
@@ -0,0 +1,395 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MultiCameraController.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "EventBroker.h"
+#include "camera/CameraExceptions.h"
+
+using namespace gphotow;
+using std::dynamic_pointer_cast;
+using std::lock_guard;
+using std::make_unique;
+using std::unique_lock;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::filesystem::create_directories;
+using std::filesystem::path;
+
+static vector<unique_ptr<CameraBase>> detectCameras()
+{
+    PrintLogger log = Logging::getLogger("MultiCam");
+
+    vector<unique_ptr<CameraBase>> cameras;
+    try
+    {
+        for (auto& det : CameraWrapper::autodetect())
+        {
+            LOG_INFO(log, "Found {} on {}", det.model, det.port);
+            cameras.push_back(make_unique<CameraWrapper>(det.port));
+        }
+    }
+    catch (GPhotoError& gpe)
+    {
+        LOG_ERR(log, "Camera autodetection error: {} = {}", gpe.error,
+                gpe.what());
+    }
+
+    if (cameras.empty())
+    {
+        LOG_WARN(log, "No camera found, waiting for the first one");
+        cameras.push_back(make_unique<CameraWrapper>());
+    }
+    return cameras;
+}
+
+MultiCameraController::MultiCameraController(string download_dir)
+    : MultiCameraController(download_dir, detectCameras())
+{
+}
+
+MultiCameraController::MultiCameraController(
+    string download_dir, vector<unique_ptr<CameraBase>> cameras)
+{
+    // Triggers the cameras together
+    setThreadSpec(ThreadSpecs::camera("cameras"));
+
+    if (cameras.size() > MAX_CAMERAS)
+    {
+        LOG_ERR(log, "Too many cameras ({}), only using the first {}",
+                cameras.size(), MAX_CAMERAS);
+        cameras.resize(MAX_CAMERAS);
+    }
+
+    multi_dir = cameras.size() > 1;
+    for (auto& camera : cameras)
+    {
+        addCamera(download_dir, std::move(camera));
+    }
+
+    vector<uint8_t> topics{TOPIC_CAMERA_EVENT};
+    for (size_t i = 1; i < this->cameras.size(); ++i)
+    {
+        topics.push_back(this->cameras[i].topics.event);
+        topics.push_back(this->cameras[i].topics.config);
+    }
+    sniffer = make_unique<EventSniffer>(
+        sBroker, topics, [this](const EventPtr& ev, uint8_t topic)
+        { onCameraEvent(ev, topic); });
+
+    sBroker.subscribe(this, TOPIC_CAMERA_CMD);
+}
+
+MultiCameraController::~MultiCameraController()
+{
+    sBroker.unsubscribe(this);
+    sniffer.reset();
+    stop();
+}
+
+CameraTopics MultiCameraController::getTopics(unsigned int index)
+{
+    if (index == 0)
+        return CameraTopics{};
+
+    uint8_t first = FIRST_CAMERA_TOPIC + (index - 1) * 3;
+    return CameraTopics{first, static_cast<uint8_t>(first + 1),
+                        static_cast<uint8_t>(first + 2)};
+}
+
+void MultiCameraController::addCamera(string download_dir,
+                                      unique_ptr<CameraBase> camera)
+{
+    unsigned int index = cameras.size();
+
+    // The serial number is needed to route the commands, so connect now.
+    // The controller will find the camera already connected.
+    string serial;
+    bool serial_known = false;
+    try
+    {
+        serial       = camera->connect();
+        serial_known = true;
+    }
+    catch (CameraException& e)
+    {
+        serial = fmt::format("camera{}", index);
+        LOG_ERR(log, "Cannot connect to camera {}: {}", index, e.what());
+    }
+
+    if (multi_dir)
+    {
+        path dir = path{download_dir} / serial;
+        try
+        {
+            create_directories(dir);
+            download_dir = dir.string();
+        }
+        catch (std::filesystem::filesystem_error& e)
+        {
+            LOG_ERR(log, "Cannot create {}: {}", dir.string(), e.what());
+        }
+    }
+
+    CameraSlot slot;
+    slot.serial     = serial;
+    slot.topics     = getTopics(index);
+    slot.controller = make_unique<CameraController>(
+        download_dir, std::move(camera), slot.topics);
+    slot.controller->setCameraIndex(index);
+
+    // When a camera is plugged back every controller waiting for one tries
+    // it: make sure each one only takes its own
+    if (serial_known && multi_dir)
+        slot.controller->setExpectedSerial(serial);
+
+    LOG_INFO(log, "Camera {}: {}, topics: {}/{}/{}", index, serial,
+             slot.topics.cmd, slot.topics.event, slot.topics.config);
+
+    cameras.push_back(std::move(slot));
+}
+
+bool MultiCameraController::start()
+{
+    for (auto& cam : cameras)
+    {
+        cam.controller->start();
+    }
+    bool started = EventHandler::start();
+    postEvent(EventGetCameraList{});
+    return started;
+}
+
+void MultiCameraController::stop()
+{
+    EventHandler::stop();
+    for (auto& cam : cameras)
+    {
+        cam.controller->stop();
+    }
+}
+
+vector<string> MultiCameraController::getSerials() const
+{
+    vector<string> serials;
+    for (auto& cam : cameras)
+    {
+        serials.push_back(cam.serial);
+    }
+    return serials;
+}
+
+void MultiCameraController::handleEvent(const EventPtr& ev)
+{
+    switch (ev->getID())
+    {
+        case EventCameraCmdCaptureAll::id:
+            captureAll();
+            break;
+        case EventCaptureAllFinish_Internal::id:
+            finishCaptureAll();
+            break;
+        case EventCameraCmdForward::id:
+            forward(*dynamic_pointer_cast<const EventCameraCmdForward>(ev));
+            break;
+        case EventGetCameraList::id:
+            postCameraList();
+            break;
+        case EventCameraForwarded::id:
+            sBroker.post(ev, TOPIC_CAMERA_EVENT);
+            break;
+        // The first camera receives these directly
+        case EventCameraCmdConnect::id:
+        case EventCameraCmdDisconnect::id:
+        case EventCameraCmdRecoverError::id:
+        case EventCameraCmdDownload::id:
+        case EventCameraCmdLowLatency::id:
+        case EventUsbDeviceAdded::id:
+        case EventUsbDeviceRemoved::id:
+            for (size_t i = 1; i < cameras.size(); ++i)
+            {
+                sBroker.post(ev, cameras[i].topics.cmd);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void MultiCameraController::captureAll()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        if (capture_all_pending)
+        {
+            LOG_WARN(log, "Capture all already in progress");
+            return;
+        }
+
+        for (auto& cam : cameras)
+        {
+            cam.started = false;
+            cam.done    = false;
+            cam.ok      = false;
+        }
+        capture_all_pending    = true;
+        pending_results        = cameras.size();
+        capture_all_start      = steady_clock::now();
+        capture_all_timeout_id = sBroker.postDelayed(
+            EventCaptureAllFinish_Internal{}, TOPIC_CAMERA_CMD,
+            CAPTURE_ALL_TIMEOUT_MS);
+    }
+
+    // Each controller runs on its own thread, so the triggers are only
+    // apart by the time it takes to queue the commands. Do not hold the
+    // mutex here: the tap locks it from the controller threads.
+    auto capture = make_shared<const EventCameraCmdCapture>();
+    for (auto& cam : cameras)
+    {
+        sBroker.post(capture, cam.topics.cmd);
+    }
+}
+
+void MultiCameraController::finishCaptureAll()
+{
+    unique_lock<mutex> lock(mtx);
+    if (!capture_all_pending)
+        return;
+    capture_all_pending = false;
+
+    int32_t num_captured = 0;
+    steady_clock::time_point first_trigger = steady_clock::time_point::max();
+    steady_clock::time_point last_trigger  = steady_clock::time_point::min();
+    for (auto& cam : cameras)
+    {
+        if (cam.ok)
+            ++num_captured;
+        if (cam.started)
+        {
+            first_trigger = std::min(first_trigger, cam.trigger_time);
+            last_trigger  = std::max(last_trigger, cam.trigger_time);
+        }
+    }
+
+    int32_t skew_us = 0;
+    if (first_trigger <= last_trigger)
+        skew_us =
+            duration_cast<microseconds>(last_trigger - first_trigger).count();
+
+    int32_t capture_time_ms =
+        duration_cast<milliseconds>(steady_clock::now() - capture_all_start)
+            .count();
+    uint16_t timeout_id = capture_all_timeout_id;
+    lock.unlock();
+
+    sBroker.removeDelayed(timeout_id);
+
+    if (num_captured < (int32_t)cameras.size())
+        LOG_WARN(log, "Capture all: only {}/{} cameras captured",
+                 num_captured, cameras.size());
+    LOG_INFO(log, "Capture all done in {} ms, trigger skew: {} us",
+             capture_time_ms, skew_us);
+
+    sBroker.post(EventCaptureAllDone{(int32_t)cameras.size(), num_captured,
+                                     skew_us, capture_time_ms},
+                 TOPIC_CAMERA_EVENT);
+}
+
+void MultiCameraController::forward(const EventCameraCmdForward& fwd)
+{
+    auto it = std::find_if(cameras.begin(), cameras.end(),
+                           [&](const CameraSlot& cam)
+                           { return cam.serial == fwd.serial; });
+    if (it == cameras.end())
+    {
+        LOG_ERR(log, "Cannot forward command: no camera with serial {}",
+                fwd.serial);
+        return;
+    }
+
+    try
+    {
+        sBroker.post(jsonStringToEvent(fwd.event), it->topics.cmd);
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERR(log, "Cannot forward command to {}: {}", fwd.serial,
+                e.what());
+    }
+}
+
+void MultiCameraController::postCameraList()
+{
+    sBroker.post(EventCameraList{getSerials()}, TOPIC_CAMERA_EVENT);
+}
+
+void MultiCameraController::onCameraEvent(const EventPtr& ev, uint8_t topic)
+{
+    auto it = std::find_if(cameras.begin(), cameras.end(),
+                           [&](const CameraSlot& cam) {
+                               return cam.topics.event == topic ||
+                                      cam.topics.config == topic;
+                           });
+    if (it == cameras.end())
+        return;
+
+    if (it != cameras.begin())
+        postEvent(EventCameraForwarded{it->serial, ev->dump()});
+
+    if (topic != it->topics.event)
+        return;
+
+    lock_guard<mutex> lock(mtx);
+    if (!capture_all_pending || it->done)
+        return;
+
+    switch (ev->getID())
+    {
+        case EventCameraCaptureStarted::id:
+            if (!it->started)
+            {
+                it->started      = true;
+                it->trigger_time = steady_clock::now();
+            }
+            return;
+        case EventCameraCaptureDone::id:
+            // May be the result of a capture started before ours
+            if (!it->started)
+                return;
+            it->ok = true;
+            break;
+        case EventCameraError::id:
+        case EventCameraConnectionError::id:
+        case EventCameraDisconnected::id:
+            break;
+        default:
+            return;
+    }
+
+    it->done = true;
+    if (--pending_results == 0)
+        postEvent(EventCaptureAllFinish_Internal{});
+}
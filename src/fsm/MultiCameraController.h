@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CameraController.h"
+#include "EventHandler.h"
+#include "Events.h"
+#include "utils/EventSniffer.h"
+#include "utils/logger/PrintLogger.h"
+
+using std::mutex;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::steady_clock;
+
+/**
+ * @brief Runs one CameraController per connected camera, each on its own
+ * thread.
+ *
+ * The first camera uses the default topics, so the modes and the remote
+ * clients keep driving it as before. The others get their own command, event
+ * and config topics: commands are sent to them by serial number with
+ * EventCameraCmdForward and their events are published on TOPIC_CAMERA_EVENT
+ * wrapped in EventCameraForwarded. Connection, download and hot-plug commands
+ * are sent to all the cameras, and EventCameraCmdCaptureAll triggers all of
+ * them at once, reporting the skew between the triggers in
+ * EventCaptureAllDone.
+ */
+class MultiCameraController : public EventHandler<1000>
+{
+public:
+    // Cameras after the first one use topics starting from this one
+    static constexpr uint8_t FIRST_CAMERA_TOPIC = 64;
+    static constexpr unsigned int MAX_CAMERAS   = 32;
+    // Cameras that did not report a result by then are counted as failed
+    static constexpr unsigned int CAPTURE_ALL_TIMEOUT_MS = 60000;
+
+    /**
+     * @brief Creates a controller for each camera found by gphoto, or a
+     * single one connecting to the first camera if none is found yet.
+     */
+    MultiCameraController(string download_dir = ".");
+
+    /**
+     * @brief Creates a controller for each of the provided cameras, eg:
+     * SimulatedCamera
+     */
+    MultiCameraController(string download_dir,
+                          vector<unique_ptr<gphotow::CameraBase>> cameras);
+
+    ~MultiCameraController();
+
+    bool start() override;
+    void stop() override;
+
+    /**
+     * @brief Serial numbers of the cameras, in topic order
+     */
+    vector<string> getSerials() const;
+
+    /**
+     * @brief Topics used by the camera with the given index
+     */
+    static CameraTopics getTopics(unsigned int index);
+
+protected:
+    void handleEvent(const EventPtr& ev) override;
+
+private:
+    struct CameraSlot
+    {
+        string serial;
+        CameraTopics topics;
+        unique_ptr<CameraController> controller;
+
+        // Capture-all progress, guarded by mtx
+        bool started = false;
+        bool done    = false;
+        bool ok      = false;
+        steady_clock::time_point trigger_time;
+    };
+
+    void addCamera(string download_dir, unique_ptr<gphotow::CameraBase> camera);
+
+    void captureAll();
+    void finishCaptureAll();
+    void forward(const EventCameraCmdForward& fwd);
+    void postCameraList();
+
+    /**
+     * @brief Called from the broker on the thread of the camera that
+     * published the event, so it must not post to the broker
+     */
+    void onCameraEvent(const EventPtr& ev, uint8_t topic);
+
+    vector<CameraSlot> cameras;
+    bool multi_dir = false;
+
+    mutex mtx;
+    bool capture_all_pending = false;
+    unsigned int pending_results = 0;
+    steady_clock::time_point capture_all_start;
+    uint16_t capture_all_timeout_id = 0;
+
+    unique_ptr<EventSniffer> sniffer;
+
+    PrintLogger log = Logging::getLogger("MultiCam");
+};
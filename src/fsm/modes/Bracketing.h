@@ -0,0 +1,607 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "HSM.h"
+#include "PrintLogger.h"
+
+using std::dynamic_pointer_cast;
+using std::set;
+using std::string;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/**
+ * Exposure bracketing (HDR) mode: captures num_frames frames with the shutter
+ * speed changed by ev_step EV between each frame, centered on the current
+ * one, then restores the initial shutter speed.
+ *
+ * The camera controller is switched to low latency for the duration of the
+ * bracket so that it does not read the whole configuration after each frame.
+ * When pipelining is enabled, the shutter speed of frame k + 1 is sent
+ * together with the capture of frame k: the controller defers it and applies
+ * it as soon as the capture returns, while the body is still writing the
+ * frame to the card, instead of waiting for a full round trip after the
+ * capture is done. Frame k + 1 is still only captured once the controller
+ * confirmed its shutter speed. If the early write is not confirmed in time,
+ * the rest of the bracket falls back to writing the settings after each
+ * capture, so no frame is taken at the wrong exposure.
+ *
+ * A write the camera refuses is never confirmed: it is retried a few times
+ * and then the bracket is aborted instead of waiting for it forever.
+ */
+class Bracketing : public HSM<Bracketing, 100>
+{
+    using Super = HSM<Bracketing, 100>;
+
+    static constexpr int SET_TIMEOUT_MS   = 1000;
+    static constexpr int MAX_SET_ATTEMPTS = 3;
+
+public:
+    Bracketing() : Super(&Bracketing::stateInit)
+    {
+        // Names in the reports of the handlers taking longer than the budget
+        nameState(&Bracketing::stateSuper, "Super");
+        nameState(&Bracketing::stateCameraNotReady, "CameraNotReady");
+        nameState(&Bracketing::stateReady, "Ready");
+        nameState(&Bracketing::stateRunning, "Running");
+        nameState(&Bracketing::statePreparing, "Preparing");
+        nameState(&Bracketing::stateSetting, "Setting");
+        nameState(&Bracketing::stateConfirming, "Confirming");
+        nameState(&Bracketing::stateCapturing, "Capturing");
+        nameState(&Bracketing::stateError, "Error");
+        nameState(&Bracketing::stateAborted, "Aborted");
+
+        sEventBroker.subscribe(this, TOPIC_MODE_FSM);
+        sEventBroker.subscribe(this, TOPIC_REMOTE_CMD);
+        sEventBroker.subscribe(this, TOPIC_CAMERA_EVENT);
+        sEventBroker.subscribe(this, TOPIC_CAMERA_CONFIG);
+    }
+
+    ~Bracketing() { sEventBroker.unsubscribe(this); }
+
+private:
+    State stateInit(const EventPtr& ev)
+    {
+        return transition(&Bracketing::stateSuper);
+    }
+
+    State stateSuper(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Super");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                retState = transition(&Bracketing::stateCameraNotReady);
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventGetCurrentMode::id:
+                onStateChange();
+                break;
+            default:
+                retState = tran_super(&Bracketing::Hsm_top);
+                break;
+        }
+        return retState;
+    }
+
+    State stateCameraNotReady(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("CamNotRdy");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("CamNotReady");
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraReady::id:
+                retState = transition(&Bracketing::stateReady);
+                break;
+            default:
+                retState = tran_super(&Bracketing::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    State stateReady(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Ready");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Ready");
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraBusyOrError::id:
+                retState = transition(&Bracketing::stateCameraNotReady);
+                break;
+            case EventBracketingStart::id:
+            {
+                auto s = dynamic_pointer_cast<const EventBracketingStart>(ev);
+                num_frames        = s->num_frames;
+                ev_step           = s->ev_step;
+                pipelined         = s->pipelined;
+                num_captures      = 0;
+                bracket_time_ms   = 0;
+                stop_cmd_received = false;
+                shutter_speeds.clear();
+                retState = transition(&Bracketing::stateRunning);
+                break;
+            }
+            default:
+                retState = tran_super(&Bracketing::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    State stateRunning(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Running");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                retState = transition(&Bracketing::statePreparing);
+                break;
+            case EventSMExit::id:
+                if (prepared)
+                {
+                    // Back to the settings we found
+                    sBroker.post(EventConfigSetShutterSpeed{base_shutter_speed},
+                                 TOPIC_CAMERA_CMD);
+                    sBroker.post(EventCameraCmdLowLatency{prev_low_latency},
+                                 TOPIC_CAMERA_CMD);
+                    prepared = false;
+                }
+                sEventBroker.post(EventModeStopped{}, TOPIC_MODE_CONTROLLER);
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventModeStop::id:
+                retState = transition(&Bracketing::stateReady);
+                break;
+            case EventConfigValueShutterSpeed::id:
+                onShutterSpeedValue(ev);
+                break;
+            default:
+                retState = tran_super(&Bracketing::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    /**
+     * Reads the current shutter speed, which is the center of the bracket,
+     * and the controller settings we are going to change.
+     */
+    State statePreparing(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Preparing");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Preparing");
+                LOG_STATE(slog, "ENTRY");
+                // One request at a time: the controller handles them in order,
+                // so any reply to someone else's request comes before ours
+                pending = {EventCameraControllerState::id};
+                sBroker.post(EventGetCameraControllerState{}, TOPIC_CAMERA_CMD);
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraControllerState::id:
+                if (pending.erase(ev->getID()) > 0)
+                {
+                    prev_low_latency =
+                        dynamic_pointer_cast<const EventCameraControllerState>(
+                            ev)
+                            ->low_latency;
+                    pending = {EventConfigValueShutterSpeed::id};
+                    sBroker.post(EventConfigGetShutterSpeed{},
+                                 TOPIC_CAMERA_CMD);
+                }
+                break;
+            case EventConfigValueShutterSpeed::id:
+                if (pending.erase(ev->getID()) > 0)
+                {
+                    auto value = dynamic_pointer_cast<
+                        const EventConfigValueShutterSpeed>(ev);
+                    base_shutter_speed = value->shutter_speed;
+                    retState           = onPrepared();
+                }
+                break;
+            case EventCameraError::id:
+                history  = &Bracketing::statePreparing;
+                retState = transition(&Bracketing::stateError);
+                break;
+            default:
+                retState = tran_super(&Bracketing::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    /**
+     * Writes the shutter speed of the current frame and waits for the
+     * controller to confirm it before capturing.
+     */
+    State stateSetting(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Setting");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Setting");
+                LOG_STATE(slog, "ENTRY");
+                // Forget any value received for this frame, it is set again
+                if (shutter_speeds.size() > static_cast<size_t>(frame))
+                    shutter_speeds.resize(frame);
+                set_attempts = 1;
+                setShutterSpeed(frame);
+                scheduleSetTimeout();
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                cancelSetTimeout();
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventConfigValueShutterSpeed::id:
+                onShutterSpeedValue(ev);
+                if (shutter_speeds.size() > static_cast<size_t>(frame))
+                    retState = transition(&Bracketing::stateCapturing);
+                break;
+            case EventBracketingSetTimeout::id:
+                set_timeout_pending = false;
+                if (set_attempts >= MAX_SET_ATTEMPTS)
+                {
+                    LOG_ERR(slog,
+                            "Shutter speed for frame {} not confirmed after {} "
+                            "attempts, aborting the bracket",
+                            frame, set_attempts);
+                    retState = transition(&Bracketing::stateAborted);
+                    break;
+                }
+                LOG_WARN(slog,
+                         "Shutter speed for frame {} not confirmed, retrying",
+                         frame);
+                ++set_attempts;
+                setShutterSpeed(frame);
+                scheduleSetTimeout();
+                break;
+            case EventCameraError::id:
+                history  = &Bracketing::stateSetting;
+                retState = transition(&Bracketing::stateError);
+                break;
+            default:
+                retState = tran_super(&Bracketing::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    /**
+     * Waits for the controller to confirm the shutter speed of the current
+     * frame, written together with the capture of the previous one.
+     */
+    State stateConfirming(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Confirming");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                scheduleSetTimeout();
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                cancelSetTimeout();
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventConfigValueShutterSpeed::id:
+                onShutterSpeedValue(ev);
+                if (shutter_speeds.size() > static_cast<size_t>(frame))
+                    retState = transition(&Bracketing::stateCapturing);
+                break;
+            case EventBracketingSetTimeout::id:
+                set_timeout_pending = false;
+                // The body did not accept the early write while busy
+                LOG_WARN(slog,
+                         "Pipelined write for frame {} not confirmed, falling "
+                         "back to sequential writes",
+                         frame);
+                pipelined = false;
+                retState  = transition(&Bracketing::stateSetting);
+                break;
+            case EventCameraError::id:
+                history  = &Bracketing::stateSetting;
+                retState = transition(&Bracketing::stateError);
+                break;
+            default:
+                retState = tran_super(&Bracketing::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    State stateCapturing(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Capturing");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Capturing");
+                LOG_STATE(slog, "ENTRY");
+                if (frame == 0)
+                    start_time = steady_clock::now();
+                sEventBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+                // Queued behind the capture: applied as soon as it returns
+                if (pipelined && frame + 1 < num_frames)
+                    setShutterSpeed(frame + 1);
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraCaptureDone::id:
+                ++num_captures;
+                LOG_INFO(slog, "Bracketing progress: {}/{}", num_captures,
+                         num_frames);
+                if (num_captures >= num_frames)
+                {
+                    bracket_time_ms = static_cast<int32_t>(
+                        duration_cast<milliseconds>(steady_clock::now() -
+                                                    start_time)
+                            .count());
+                    LOG_INFO(slog, "Bracket of {} frames took {} ms",
+                             num_frames, bracket_time_ms);
+                    retState = transition(&Bracketing::stateReady);
+                    break;
+                }
+                if (stop_cmd_received)
+                {
+                    retState = transition(&Bracketing::stateReady);
+                    break;
+                }
+                ++frame;
+                if (!pipelined)
+                    retState = transition(&Bracketing::stateSetting);
+                else if (shutter_speeds.size() > static_cast<size_t>(frame))
+                    retState = transition(&Bracketing::stateCapturing);
+                else
+                    retState = transition(&Bracketing::stateConfirming);
+                break;
+            case EventCameraError::id:
+                history  = &Bracketing::stateSetting;
+                retState = transition(&Bracketing::stateError);
+                break;
+            case EventModeStop::id:
+                stop_cmd_received = true;
+                break;
+            default:
+                retState = tran_super(&Bracketing::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    State stateError(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Error");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                onStateChange("Error");
+                // Settings and capture are retried one at a time
+                pipelined = false;
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraConnected::id:
+                retState = transition(history);
+                break;
+            case EventModeStop::id:
+                retState = transition(&Bracketing::stateCameraNotReady);
+                break;
+            default:
+                retState = tran_super(&Bracketing::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    /**
+     * The camera refused the settings of a frame: the bracket cannot be
+     * completed. Behaves like Ready, a new bracket can be started.
+     */
+    State stateAborted(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Aborted");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Aborted");
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            default:
+                retState = tran_super(&Bracketing::stateReady);
+                break;
+        }
+        return retState;
+    }
+
+private:
+    State onPrepared()
+    {
+        prepared = true;
+        frame    = 0;
+        sBroker.post(EventCameraCmdLowLatency{true}, TOPIC_CAMERA_CMD);
+        return transition(&Bracketing::stateSetting);
+    }
+
+    /**
+     * @brief Shutter speed of frame k: the bracket goes from the darkest to
+     * the brightest frame.
+     */
+    int32_t frameShutterSpeed(int32_t k) const
+    {
+        float offset = (k - (num_frames - 1) / 2.0f) * ev_step;
+        return static_cast<int32_t>(
+            std::lround(base_shutter_speed * std::exp2(offset)));
+    }
+
+    void setShutterSpeed(int32_t k)
+    {
+        sBroker.post(EventConfigSetShutterSpeed{frameShutterSpeed(k)},
+                     TOPIC_CAMERA_CMD);
+    }
+
+    void scheduleSetTimeout()
+    {
+        cancelSetTimeout();
+        set_timeout_id = sBroker.postDelayed(EventBracketingSetTimeout{},
+                                             TOPIC_MODE_FSM, SET_TIMEOUT_MS);
+        set_timeout_pending = true;
+    }
+
+    void cancelSetTimeout()
+    {
+        if (set_timeout_pending)
+        {
+            sBroker.removeDelayed(set_timeout_id);
+            set_timeout_pending = false;
+        }
+    }
+
+    /**
+     * @brief Records the shutter speed confirmed by the controller for the
+     * next frame that does not have one yet.
+     */
+    void onShutterSpeedValue(const EventPtr& ev)
+    {
+        if (!prepared || shutter_speeds.size() >= (size_t)num_frames)
+            return;
+
+        shutter_speeds.push_back(
+            dynamic_pointer_cast<const EventConfigValueShutterSpeed>(ev)
+                ->shutter_speed);
+    }
+
+    void onStateChange()
+    {
+        sEventBroker.post(
+            EventBracketingState{state, num_frames, num_captures,
+                                 shutter_speeds, pipelined, bracket_time_ms},
+            TOPIC_MODE_STATE);
+    }
+
+    void onStateChange(string state)
+    {
+        this->state = state;
+        onStateChange();
+    }
+
+    string state            = "Ready";
+    int32_t num_frames      = 0;
+    float ev_step           = 0;
+    bool pipelined          = true;
+    int32_t num_captures    = 0;
+    int32_t bracket_time_ms = 0;
+
+    // Frame being set or captured
+    int32_t frame = 0;
+    // Shutter speeds confirmed by the controller, one per frame
+    vector<int32_t> shutter_speeds;
+
+    int32_t base_shutter_speed = 0;
+    bool prev_low_latency      = false;
+    bool prepared              = false;
+
+    // Replies we are waiting for from the camera controller
+    set<uint16_t> pending;
+
+    int set_attempts         = 0;
+    uint16_t set_timeout_id  = 0;
+    bool set_timeout_pending = false;
+
+    steady_clock::time_point start_time{};
+
+    bool stop_cmd_received = false;
+
+    State (Bracketing::*history)(const EventPtr& ev);
+
+    PrintLogger log = Logging::getLogger("Bracket");
+};
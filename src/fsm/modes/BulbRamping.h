@@ -0,0 +1,707 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "HSM.h"
+#include "PrintLogger.h"
+#include "fsm/modes/FrameSchedule.h"
+#include "fsm/modes/RampPlanner.h"
+
+using std::dynamic_pointer_cast;
+using std::optional;
+using std::set;
+using std::string;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/**
+ * Timelapse mode that ramps the exposure between frames following the light
+ * meter, to shoot through sunsets and sunrises ("holy grail" timelapse).
+ *
+ * Frames are captured on a fixed schedule, frame k at t0 + k * interval. After
+ * each capture the light meter is read and the settings of the next frame are
+ * planned and written to the camera, so that they are in place before its
+ * deadline. Writes that are expected to push the next frame past its deadline
+ * are reported in EventBulbRampingState. So are the writes the camera does not
+ * confirm by the deadline, eg. because it refused the value: the mode gives up
+ * on them and captures the next frame with the current settings.
+ */
+class BulbRamping : public HSM<BulbRamping, 100>
+{
+    using Super = HSM<BulbRamping, 100>;
+
+    // Longest exposure, as a fraction of the interval. The rest of the
+    // interval is left for the download and the config writes.
+    static constexpr float MAX_EXPOSURE_FRACTION = 0.75f;
+    // Initial estimate of the time needed for a config write
+    static constexpr int WRITE_TIME_MS = 200;
+    // Minimum time to wait for the replies of the camera controller. Replies
+    // to the writes for the next frame are also waited for until its deadline
+    static constexpr int REPLY_TIMEOUT_MS = 1000;
+
+public:
+    BulbRamping() : Super(&BulbRamping::stateInit)
+    {
+        // Names in the reports of the handlers taking longer than the budget
+        nameState(&BulbRamping::stateSuper, "Super");
+        nameState(&BulbRamping::stateCameraNotReady, "CameraNotReady");
+        nameState(&BulbRamping::stateReady, "Ready");
+        nameState(&BulbRamping::stateRunning, "Running");
+        nameState(&BulbRamping::statePreparing, "Preparing");
+        nameState(&BulbRamping::stateCapturing, "Capturing");
+        nameState(&BulbRamping::statePlanning, "Planning");
+        nameState(&BulbRamping::stateWaiting, "Waiting");
+        nameState(&BulbRamping::stateError, "Error");
+
+        sEventBroker.subscribe(this, TOPIC_MODE_FSM);
+        sEventBroker.subscribe(this, TOPIC_REMOTE_CMD);
+        sEventBroker.subscribe(this, TOPIC_CAMERA_EVENT);
+        sEventBroker.subscribe(this, TOPIC_CAMERA_CONFIG);
+    }
+
+    ~BulbRamping() { sEventBroker.unsubscribe(this); }
+
+private:
+    State stateInit(const EventPtr& ev)
+    {
+        return transition(&BulbRamping::stateSuper);
+    }
+
+    State stateSuper(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Super");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                retState = transition(&BulbRamping::stateCameraNotReady);
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventGetCurrentMode::id:
+                onStateChange();
+                break;
+            default:
+                retState = tran_super(&BulbRamping::Hsm_top);
+                break;
+        }
+        return retState;
+    }
+
+    State stateCameraNotReady(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("CamNotRdy");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("CamNotReady");
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraReady::id:
+                retState = transition(&BulbRamping::stateReady);
+                break;
+            default:
+                retState = tran_super(&BulbRamping::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    State stateReady(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Ready");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Ready");
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraBusyOrError::id:
+                retState = transition(&BulbRamping::stateCameraNotReady);
+                break;
+            case EventBulbRampingStart::id:
+            {
+                auto s = dynamic_pointer_cast<const EventBulbRampingStart>(ev);
+                interval          = s->intervalms;
+                total_captures    = s->total_captures;
+                max_ev_step       = s->max_ev_step;
+                max_iso           = s->max_iso;
+                num_captures      = 0;
+                late_writes       = 0;
+                write_overrun_ms  = 0;
+                light_meter       = 0;
+                stop_cmd_received = false;
+                retState          = transition(&BulbRamping::stateRunning);
+                break;
+            }
+            default:
+                retState = tran_super(&BulbRamping::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    State stateRunning(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Running");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                retState = transition(&BulbRamping::statePreparing);
+                break;
+            case EventSMExit::id:
+                schedule.cancel();
+                sEventBroker.post(EventModeStopped{}, TOPIC_MODE_CONTROLLER);
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventModeStop::id:
+                retState = transition(&BulbRamping::stateReady);
+                break;
+            case EventConfigValueShutterSpeed::id:
+            case EventConfigValueISO::id:
+            case EventConfigValueAperture::id:
+                // Someone else changed the settings: keep track of them, the
+                // light meter reading refers to what is set on the camera
+                updateSettings(ev);
+                break;
+            default:
+                retState = tran_super(&BulbRamping::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    /**
+     * Reads the available choices and the current settings to initialize the
+     * ramp planner.
+     */
+    State statePreparing(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Preparing");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Preparing");
+                LOG_STATE(slog, "ENTRY");
+                pending = {EventConfigChoicesShutterSpeed::id,
+                           EventConfigChoicesISO::id,
+                           EventConfigChoicesAperture::id,
+                           EventConfigValueShutterSpeed::id,
+                           EventConfigValueISO::id,
+                           EventConfigValueAperture::id};
+                sBroker.post(EventConfigGetChoicesShutterSpeed{},
+                             TOPIC_CAMERA_CMD);
+                sBroker.post(EventConfigGetChoicesISO{}, TOPIC_CAMERA_CMD);
+                sBroker.post(EventConfigGetChoicesAperture{}, TOPIC_CAMERA_CMD);
+                sBroker.post(EventConfigGetShutterSpeed{}, TOPIC_CAMERA_CMD);
+                sBroker.post(EventConfigGetISO{}, TOPIC_CAMERA_CMD);
+                sBroker.post(EventConfigGetAperture{}, TOPIC_CAMERA_CMD);
+                scheduleReplyTimeout(steady_clock::now() +
+                                     milliseconds(REPLY_TIMEOUT_MS));
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                cancelReplyTimeout();
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventConfigChoicesShutterSpeed::id:
+                shutter_choices =
+                    dynamic_pointer_cast<const EventConfigChoicesShutterSpeed>(
+                        ev)
+                        ->shutter_speed_choices;
+                retState = onPrepared(ev->getID());
+                break;
+            case EventConfigChoicesISO::id:
+                iso_choices =
+                    dynamic_pointer_cast<const EventConfigChoicesISO>(ev)
+                        ->iso_choices;
+                retState = onPrepared(ev->getID());
+                break;
+            case EventConfigChoicesAperture::id:
+                aperture_choices =
+                    dynamic_pointer_cast<const EventConfigChoicesAperture>(ev)
+                        ->aperture_choices;
+                retState = onPrepared(ev->getID());
+                break;
+            case EventConfigValueShutterSpeed::id:
+            case EventConfigValueISO::id:
+            case EventConfigValueAperture::id:
+                updateSettings(ev);
+                retState = onPrepared(ev->getID());
+                break;
+            case EventBulbRampingReplyTimeout::id:
+                reply_timeout_pending = false;
+                LOG_ERR(slog, "Cannot read the camera settings, stopping");
+                retState = transition(&BulbRamping::stateReady);
+                break;
+            case EventCameraError::id:
+                history  = &BulbRamping::statePreparing;
+                retState = transition(&BulbRamping::stateError);
+                break;
+            default:
+                retState = tran_super(&BulbRamping::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    State stateCapturing(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Capturing");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Capturing");
+                sEventBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+                schedule.schedule(frame + 1);
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraCaptureDone::id:
+                ++num_captures;
+                LOG_INFO(slog, "Bulb ramping progress: {}/{}", num_captures,
+                         total_captures);
+                if (stop_cmd_received ||
+                    (num_captures >= total_captures && total_captures > 0))
+                {
+                    stop_cmd_received = false;
+                    retState          = transition(&BulbRamping::stateReady);
+                    break;
+                }
+                retState = transition(&BulbRamping::statePlanning);
+                break;
+            case EventBulbRampingDeadlineExpired::id:
+                schedule.onExpired();
+                break;
+            case EventCameraError::id:
+                history  = &BulbRamping::stateCapturing;
+                retState = transition(&BulbRamping::stateError);
+                break;
+            case EventModeStop::id:
+                stop_cmd_received = true;
+                break;
+            default:
+                retState = tran_super(&BulbRamping::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    /**
+     * Reads the light meter and writes the settings of the next frame.
+     */
+    State statePlanning(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Planning");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Planning");
+                LOG_STATE(slog, "ENTRY");
+                pending = {EventConfigValueLightMeter::id};
+                sBroker.post(EventConfigGetLightMeter{}, TOPIC_CAMERA_CMD);
+                scheduleReplyTimeout(
+                    std::max(schedule.deadline(frame + 1),
+                             steady_clock::now() +
+                                 milliseconds(REPLY_TIMEOUT_MS)));
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                cancelReplyTimeout();
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventConfigValueLightMeter::id:
+                if (pending.erase(ev->getID()) > 0)
+                {
+                    light_meter =
+                        dynamic_pointer_cast<const EventConfigValueLightMeter>(
+                            ev)
+                            ->light_meter;
+                    writeNextSettings();
+                    if (pending.empty())
+                        retState = nextFrame();
+                }
+                break;
+            case EventConfigValueShutterSpeed::id:
+            case EventConfigValueISO::id:
+            case EventConfigValueAperture::id:
+                updateSettings(ev);
+                if (pending.erase(ev->getID()) > 0 && pending.empty())
+                {
+                    updateWriteTime();
+                    retState = nextFrame();
+                }
+                break;
+            case EventBulbRampingReplyTimeout::id:
+                reply_timeout_pending = false;
+                retState              = onReplyTimeout();
+                break;
+            case EventBulbRampingDeadlineExpired::id:
+                schedule.onExpired();
+                break;
+            case EventCameraError::id:
+                history  = &BulbRamping::statePlanning;
+                retState = transition(&BulbRamping::stateError);
+                break;
+            default:
+                retState = tran_super(&BulbRamping::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    State stateWaiting(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Waiting");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Waiting");
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventBulbRampingDeadlineExpired::id:
+                schedule.onExpired();
+                ++frame;
+                retState = transition(&BulbRamping::stateCapturing);
+                break;
+            case EventCameraError::id:
+                history  = &BulbRamping::stateWaiting;
+                retState = transition(&BulbRamping::stateError);
+                break;
+            default:
+                retState = tran_super(&BulbRamping::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    State stateError(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Error");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                onStateChange("Error");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventBulbRampingDeadlineExpired::id:
+                schedule.onExpired();
+                break;
+            case EventCameraConnected::id:
+                if (schedule.isExpired() &&
+                    history != &BulbRamping::statePreparing)
+                {
+                    ++frame;
+                    retState = transition(&BulbRamping::stateCapturing);
+                }
+                else
+                {
+                    retState = transition(history);
+                }
+                break;
+            case EventModeStop::id:
+                retState = transition(&BulbRamping::stateCameraNotReady);
+                break;
+            default:
+                retState = tran_super(&BulbRamping::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+private:
+    State onPrepared(uint16_t id)
+    {
+        pending.erase(id);
+        if (!pending.empty())
+            return State::HANDLED;
+
+        RampPlannerConfig cfg{};
+        cfg.max_ev_step       = max_ev_step;
+        cfg.max_iso           = max_iso;
+        cfg.max_shutter_speed = static_cast<int32_t>(
+            interval * 1000 * MAX_EXPOSURE_FRACTION);
+        try
+        {
+            planner.emplace(cfg, shutter_choices, iso_choices,
+                            aperture_choices);
+        }
+        catch (std::invalid_argument& e)
+        {
+            LOG_ERR(log, "Cannot start bulb ramping: {}", e.what());
+            return transition(&BulbRamping::stateReady);
+        }
+        planner->reset(current);
+
+        write_time = milliseconds(WRITE_TIME_MS);
+        frame      = 0;
+        schedule.start(milliseconds(interval));
+        return transition(&BulbRamping::stateCapturing);
+    }
+
+    /**
+     * @brief Plans the next frame and sends the config writes it needs,
+     * reporting them if they are not expected to complete before its
+     * deadline.
+     */
+    void writeNextSettings()
+    {
+        ExposureSettings next = planner->plan(current, light_meter);
+        int num_writes        = RampPlanner::numWrites(current, next);
+        writes_late           = false;
+        if (num_writes == 0)
+            return;
+
+        write_start = steady_clock::now();
+
+        auto needed = num_writes * write_time;
+        auto left   = duration_cast<milliseconds>(schedule.deadline(frame + 1) -
+                                                write_start);
+        if (needed > left)
+        {
+            ++late_writes;
+            writes_late      = true;
+            write_overrun_ms = static_cast<int32_t>((needed - left).count());
+            LOG_WARN(log,
+                     "{} config write(s) for frame {} expected to take {} ms, "
+                     "only {} ms left before its deadline",
+                     num_writes, frame + 1, needed.count(), left.count());
+        }
+
+        if (next.shutter_speed != current.shutter_speed)
+        {
+            pending.insert(EventConfigValueShutterSpeed::id);
+            sBroker.post(EventConfigSetShutterSpeed{next.shutter_speed},
+                         TOPIC_CAMERA_CMD);
+        }
+        if (next.iso != current.iso)
+        {
+            pending.insert(EventConfigValueISO::id);
+            sBroker.post(EventConfigSetISO{next.iso}, TOPIC_CAMERA_CMD);
+        }
+        if (next.aperture != current.aperture)
+        {
+            pending.insert(EventConfigValueAperture::id);
+            sBroker.post(EventConfigSetAperture{next.aperture},
+                         TOPIC_CAMERA_CMD);
+        }
+        num_pending_writes = num_writes;
+    }
+
+    /**
+     * @brief Updates the estimate of the time needed for a config write with
+     * the duration of the last ones.
+     */
+    void updateWriteTime()
+    {
+        auto elapsed = duration_cast<milliseconds>(steady_clock::now() -
+                                                   write_start) /
+                       num_pending_writes;
+        write_time = (write_time + elapsed) / 2;
+    }
+
+    void updateSettings(const EventPtr& ev)
+    {
+        switch (ev->getID())
+        {
+            case EventConfigValueShutterSpeed::id:
+                current.shutter_speed =
+                    dynamic_pointer_cast<const EventConfigValueShutterSpeed>(
+                        ev)
+                        ->shutter_speed;
+                break;
+            case EventConfigValueISO::id:
+                current.iso =
+                    dynamic_pointer_cast<const EventConfigValueISO>(ev)->iso;
+                break;
+            case EventConfigValueAperture::id:
+                current.aperture =
+                    dynamic_pointer_cast<const EventConfigValueAperture>(ev)
+                        ->aperture;
+                break;
+            default:
+                break;
+        }
+    }
+
+    /**
+     * @brief Gives up on the replies still pending for the next frame. The
+     * camera controller sends none when it cannot read or write a setting.
+     */
+    State onReplyTimeout()
+    {
+        if (pending.count(EventConfigValueLightMeter::id) > 0)
+        {
+            LOG_WARN(log, "No light meter reading for frame {}", frame + 1);
+        }
+        else
+        {
+            LOG_WARN(log,
+                     "{} config write(s) for frame {} not confirmed in time, "
+                     "capturing with the current settings",
+                     pending.size(), frame + 1);
+            if (!writes_late)
+                ++late_writes;
+            write_overrun_ms = static_cast<int32_t>(
+                duration_cast<milliseconds>(steady_clock::now() -
+                                            schedule.deadline(frame + 1))
+                    .count());
+        }
+        pending.clear();
+        return nextFrame();
+    }
+
+    void scheduleReplyTimeout(steady_clock::time_point timeout)
+    {
+        cancelReplyTimeout();
+        reply_timeout_id = sBroker.postAt(EventBulbRampingReplyTimeout{},
+                                          TOPIC_MODE_FSM, timeout);
+        reply_timeout_pending = true;
+    }
+
+    void cancelReplyTimeout()
+    {
+        if (reply_timeout_pending)
+        {
+            sBroker.removeDelayed(reply_timeout_id);
+            reply_timeout_pending = false;
+        }
+    }
+
+    State nextFrame()
+    {
+        if (schedule.isExpired())
+        {
+            ++frame;
+            return transition(&BulbRamping::stateCapturing);
+        }
+        return transition(&BulbRamping::stateWaiting);
+    }
+
+    void onStateChange()
+    {
+        float ev = planner ? planner->getPlannedEV() : 0;
+        sEventBroker.post(
+            EventBulbRampingState{state, num_captures, total_captures,
+                                  current.shutter_speed, current.iso,
+                                  current.aperture, ev, light_meter,
+                                  late_writes, write_overrun_ms},
+            TOPIC_MODE_STATE);
+    }
+
+    void onStateChange(string state)
+    {
+        this->state = state;
+        onStateChange();
+    }
+
+    string state           = "Ready";
+    int32_t interval       = 0;
+    int32_t num_captures   = 0;
+    int32_t total_captures = 0;
+    float max_ev_step      = 0;
+    int32_t max_iso        = 0;
+
+    vector<int32_t> shutter_choices;
+    vector<int32_t> iso_choices;
+    vector<int32_t> aperture_choices;
+
+    optional<RampPlanner> planner;
+    ExposureSettings current{};
+    float light_meter = 0;
+
+    // Replies we are waiting for from the camera controller
+    set<uint16_t> pending;
+
+    int num_pending_writes = 0;
+    steady_clock::time_point write_start{};
+    milliseconds write_time{WRITE_TIME_MS};
+    int32_t late_writes      = 0;
+    int32_t write_overrun_ms = 0;
+    // The writes for the next frame were already reported as late
+    bool writes_late = false;
+
+    uint16_t reply_timeout_id  = 0;
+    bool reply_timeout_pending = false;
+
+    FrameSchedule<EventBulbRampingDeadlineExpired> schedule;
+    // Index of the frame being captured (or that was captured last)
+    int64_t frame = 0;
+
+    bool stop_cmd_received = false;
+
+    State (BulbRamping::*history)(const EventPtr& ev);
+
+    PrintLogger log = Logging::getLogger("BulbRamp");
+};
@@ -0,0 +1,448 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "HSM.h"
+#include "PrintLogger.h"
+
+using std::dynamic_pointer_cast;
+using std::string;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/**
+ * Focus stacking mode: captures num_frames frames, moving the focus by
+ * focus_steps lens drive steps between each of them. Optionally runs an
+ * autofocus cycle before the first frame.
+ *
+ * The focus move for frame k + 1 is sent together with the capture of frame
+ * k: the controller defers it and drives the lens as soon as frame k has been
+ * downloaded, and the next capture is queued right behind it, so the camera
+ * never waits for a round trip through the mode between the steps. The
+ * controller is switched to low latency for the duration of the stack.
+ * Capture, download and focus times are reported for each step.
+ */
+class FocusStacking : public HSM<FocusStacking, 100>
+{
+    using Super = HSM<FocusStacking, 100>;
+
+public:
+    FocusStacking() : Super(&FocusStacking::stateInit)
+    {
+        // Names in the reports of the handlers taking longer than the budget
+        nameState(&FocusStacking::stateSuper, "Super");
+        nameState(&FocusStacking::stateCameraNotReady, "CameraNotReady");
+        nameState(&FocusStacking::stateReady, "Ready");
+        nameState(&FocusStacking::stateRunning, "Running");
+        nameState(&FocusStacking::statePreparing, "Preparing");
+        nameState(&FocusStacking::stateCapturing, "Capturing");
+        nameState(&FocusStacking::stateError, "Error");
+
+        sEventBroker.subscribe(this, TOPIC_MODE_FSM);
+        sEventBroker.subscribe(this, TOPIC_REMOTE_CMD);
+        sEventBroker.subscribe(this, TOPIC_CAMERA_EVENT);
+        sEventBroker.subscribe(this, TOPIC_CAMERA_CONFIG);
+    }
+
+    ~FocusStacking() { sEventBroker.unsubscribe(this); }
+
+private:
+    State stateInit(const EventPtr& ev)
+    {
+        return transition(&FocusStacking::stateSuper);
+    }
+
+    State stateSuper(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Super");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                retState = transition(&FocusStacking::stateCameraNotReady);
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventGetCurrentMode::id:
+                onStateChange();
+                break;
+            default:
+                retState = tran_super(&FocusStacking::Hsm_top);
+                break;
+        }
+        return retState;
+    }
+
+    State stateCameraNotReady(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("CamNotRdy");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("CamNotReady");
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraReady::id:
+                retState = transition(&FocusStacking::stateReady);
+                break;
+            default:
+                retState = tran_super(&FocusStacking::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    State stateReady(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Ready");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Ready");
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraBusyOrError::id:
+                retState = transition(&FocusStacking::stateCameraNotReady);
+                break;
+            case EventFocusStackingStart::id:
+            {
+                auto s =
+                    dynamic_pointer_cast<const EventFocusStackingStart>(ev);
+                num_frames        = s->num_frames;
+                focus_steps       = s->focus_steps;
+                autofocus         = s->autofocus;
+                num_captures      = 0;
+                capture_time_ms   = 0;
+                focus_time_ms     = 0;
+                step_time_ms      = 0;
+                avg_step_time_ms  = 0;
+                stack_time_ms     = 0;
+                stop_cmd_received = false;
+                retState          = transition(&FocusStacking::stateRunning);
+                break;
+            }
+            default:
+                retState = tran_super(&FocusStacking::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    State stateRunning(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Running");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                break;
+            case EventSMInit::id:
+                retState = transition(&FocusStacking::statePreparing);
+                break;
+            case EventSMExit::id:
+                if (prepared)
+                {
+                    sBroker.post(EventCameraCmdLowLatency{prev_low_latency},
+                                 TOPIC_CAMERA_CMD);
+                    prepared = false;
+                }
+                sEventBroker.post(EventModeStopped{}, TOPIC_MODE_CONTROLLER);
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventModeStop::id:
+                retState = transition(&FocusStacking::stateReady);
+                break;
+            case EventCameraFocusDriveDone::id:
+                onFocusDriveDone(ev);
+                break;
+            default:
+                retState = tran_super(&FocusStacking::stateSuper);
+                break;
+        }
+        return retState;
+    }
+
+    /**
+     * Reads the controller settings we are going to change and runs the
+     * initial autofocus, if requested.
+     */
+    State statePreparing(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Preparing");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Preparing");
+                LOG_STATE(slog, "ENTRY");
+                autofocus_pending = false;
+                sBroker.post(EventGetCameraControllerState{}, TOPIC_CAMERA_CMD);
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraControllerState::id:
+                if (autofocus_pending)
+                    break;
+
+                // Keep the settings found the first time, not our own
+                if (!prepared)
+                {
+                    prev_low_latency =
+                        dynamic_pointer_cast<const EventCameraControllerState>(
+                            ev)
+                            ->low_latency;
+                    prepared = true;
+                }
+                sBroker.post(EventCameraCmdLowLatency{true}, TOPIC_CAMERA_CMD);
+
+                if (autofocus)
+                {
+                    autofocus_pending = true;
+                    sBroker.post(EventCameraCmdAutofocus{}, TOPIC_CAMERA_CMD);
+                }
+                else
+                {
+                    retState = onPrepared();
+                }
+                break;
+            case EventCameraFocusDriveDone::id:
+                if (autofocus_pending)
+                {
+                    LOG_INFO(slog, "Autofocus took {} ms",
+                             dynamic_pointer_cast<
+                                 const EventCameraFocusDriveDone>(ev)
+                                 ->drive_time_ms);
+                    retState = onPrepared();
+                }
+                break;
+            case EventCameraError::id:
+                history  = &FocusStacking::statePreparing;
+                retState = transition(&FocusStacking::stateError);
+                break;
+            default:
+                retState = tran_super(&FocusStacking::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    State stateCapturing(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Capturing");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                onStateChange("Capturing");
+                LOG_STATE(slog, "ENTRY");
+                sEventBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+                // Queued behind the capture: the lens moves as soon as the
+                // frame is downloaded, then the next capture follows
+                if (frame + 1 < num_frames)
+                {
+                    sBroker.post(EventCameraCmdFocusDrive{focus_steps},
+                                 TOPIC_CAMERA_CMD);
+                }
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraCaptureStarted::id:
+                capture_start = steady_clock::now();
+                break;
+            case EventCameraCaptureDone::id:
+            {
+                auto now = steady_clock::now();
+                if (focused_frames < frame)
+                {
+                    LOG_WARN(slog, "Focus move for frame {} not confirmed",
+                             frame);
+                    focused_frames = frame;
+                }
+
+                ++num_captures;
+                capture_time_ms  = elapsedMs(capture_start, now);
+                step_time_ms     = elapsedMs(step_start, now);
+                stack_time_ms    = elapsedMs(start_time, now);
+                avg_step_time_ms = stack_time_ms / num_captures;
+                step_start       = now;
+
+                LOG_INFO(slog,
+                         "Focus stacking progress: {}/{}. step: {} ms, "
+                         "capture: {} ms, focus: {} ms",
+                         num_captures, num_frames, step_time_ms,
+                         capture_time_ms, focus_time_ms);
+
+                if (num_captures >= num_frames || stop_cmd_received)
+                {
+                    LOG_INFO(slog, "Stack of {} frames took {} ms",
+                             num_captures, stack_time_ms);
+                    retState = transition(&FocusStacking::stateReady);
+                    break;
+                }
+                ++frame;
+                retState = transition(&FocusStacking::stateCapturing);
+                break;
+            }
+            case EventCameraError::id:
+                history  = &FocusStacking::stateCapturing;
+                retState = transition(&FocusStacking::stateError);
+                break;
+            case EventModeStop::id:
+                stop_cmd_received = true;
+                break;
+            default:
+                retState = tran_super(&FocusStacking::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+    State stateError(const EventPtr& ev)
+    {
+        auto slog      = log.getChild("Error");
+        State retState = State::HANDLED;
+        switch (ev->getID())
+        {
+            case EventSMEntry::id:
+                LOG_STATE(slog, "ENTRY");
+                onStateChange("Error");
+                break;
+            case EventSMInit::id:
+                break;
+            case EventSMExit::id:
+                LOG_STATE(slog, "EXIT");
+                break;
+            case EventCameraConnected::id:
+                retState = transition(history);
+                break;
+            case EventModeStop::id:
+                retState = transition(&FocusStacking::stateCameraNotReady);
+                break;
+            default:
+                retState = tran_super(&FocusStacking::stateRunning);
+                break;
+        }
+        return retState;
+    }
+
+private:
+    State onPrepared()
+    {
+        frame          = 0;
+        focused_frames = 0;
+        start_time     = steady_clock::now();
+        step_start     = start_time;
+        return transition(&FocusStacking::stateCapturing);
+    }
+
+    void onFocusDriveDone(const EventPtr& ev)
+    {
+        focus_time_ms =
+            dynamic_pointer_cast<const EventCameraFocusDriveDone>(ev)
+                ->drive_time_ms;
+        ++focused_frames;
+    }
+
+    static int32_t elapsedMs(steady_clock::time_point from,
+                             steady_clock::time_point to)
+    {
+        return static_cast<int32_t>(
+            duration_cast<milliseconds>(to - from).count());
+    }
+
+    void onStateChange()
+    {
+        sEventBroker.post(
+            EventFocusStackingState{state, num_frames, num_captures,
+                                    focus_steps, capture_time_ms,
+                                    focus_time_ms, step_time_ms,
+                                    avg_step_time_ms, stack_time_ms},
+            TOPIC_MODE_STATE);
+    }
+
+    void onStateChange(string state)
+    {
+        this->state = state;
+        onStateChange();
+    }
+
+    string state             = "Ready";
+    int32_t num_frames       = 0;
+    int32_t focus_steps      = 0;
+    bool autofocus           = false;
+    int32_t num_captures     = 0;
+    int32_t capture_time_ms  = 0;
+    int32_t focus_time_ms    = 0;
+    int32_t step_time_ms     = 0;
+    int32_t avg_step_time_ms = 0;
+    int32_t stack_time_ms    = 0;
+
+    // Frame being captured
+    int32_t frame = 0;
+    // Number of focus moves confirmed by the controller
+    int32_t focused_frames = 0;
+
+    bool prev_low_latency  = false;
+    bool prepared          = false;
+    bool autofocus_pending = false;
+
+    steady_clock::time_point start_time{};
+    steady_clock::time_point step_start{};
+    steady_clock::time_point capture_start{};
+
+    bool stop_cmd_received = false;
+
+    State (FocusStacking::*history)(const EventPtr& ev);
+
+    PrintLogger log = Logging::getLogger("FocusStack");
+};
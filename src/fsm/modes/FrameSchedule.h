@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "EventBroker.h"
+#include "Events.h"
+
+/**
+ * Fixed rate schedule of the frames of a timelapse mode: frame k is due at
+ * t0 + k * interval. When the deadline of a frame expires, a DeadlineEvent is
+ * posted on TOPIC_MODE_FSM.
+ */
+template <typename DeadlineEvent>
+class FrameSchedule
+{
+    using milliseconds = std::chrono::milliseconds;
+    using steady_clock = std::chrono::steady_clock;
+
+public:
+    /**
+     * @brief Starts a new schedule, with frame 0 due now
+     */
+    void start(milliseconds interval)
+    {
+        cancel();
+        this->interval = interval;
+        t0             = steady_clock::now();
+        expired        = false;
+    }
+
+    /**
+     * @brief Time at which the given frame is due
+     */
+    steady_clock::time_point deadline(int64_t k) const
+    {
+        return t0 + k * interval;
+    }
+
+    /**
+     * @brief Index of the last frame due at or before t
+     */
+    int64_t frameAt(steady_clock::time_point t) const
+    {
+        return (t - t0) / interval;
+    }
+
+    /**
+     * @brief Moves the schedule so that frame k falls on the given time point
+     */
+    void anchorAt(int64_t k, steady_clock::time_point t)
+    {
+        t0 = t - k * interval;
+    }
+
+    /**
+     * @brief Posts the DeadlineEvent when frame k is due, replacing the one
+     * already scheduled
+     */
+    void schedule(int64_t k)
+    {
+        cancel();
+        expired     = false;
+        deadline_id = sBroker.postAt(DeadlineEvent{}, TOPIC_MODE_FSM,
+                                     deadline(k));
+        pending     = true;
+    }
+
+    void cancel()
+    {
+        if (pending)
+        {
+            sBroker.removeDelayed(deadline_id);
+            pending = false;
+        }
+    }
+
+    /**
+     * @brief Must be called when the DeadlineEvent is received
+     */
+    void onExpired()
+    {
+        pending = false;
+        expired = true;
+    }
+
+    /**
+     * @brief Whether the last scheduled deadline has expired
+     */
+    bool isExpired() const { return expired; }
+
+    void clearExpired() { expired = false; }
+
+private:
+    milliseconds interval{0};
+    steady_clock::time_point t0{};
+
+    uint16_t deadline_id = 0;
+    bool pending         = false;
+    bool expired         = false;
+};
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 
@@ -29,9 +31,43 @@
 #include "Events.h"
 #include "HSM.h"
 #include "PrintLogger.h"
+#include "fsm/modes/FrameSchedule.h"
 
 using std::dynamic_pointer_cast;
 using std::string;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/**
+ * What to do when the deadline of the next frame expires before the current
+ * capture has completed.
+ */
+enum class MissedFramePolicy
+{
+    /**
+     * Legacy behaviour: the next frame is scheduled relative to the start of
+     * the current one, so every delay shifts the rest of the sequence.
+     */
+    RELATIVE,
+    /**
+     * Drop the frames whose slot has already passed and wait for the next slot
+     * of the original schedule.
+     */
+    SKIP,
+    /**
+     * Capture the late frame immediately, keeping the original schedule. The
+     * following frames are captured back to back until the sequence is back on
+     * time.
+     */
+    CATCH_UP,
+    /**
+     * Capture the late frame immediately and shift the rest of the schedule by
+     * the accumulated delay.
+     */
+    STRETCH
+};
 
 class Intervalometer : public HSM<Intervalometer, 100>
 {
@@ -40,6 +76,15 @@ class Intervalometer : public HSM<Intervalometer, 100>
 public:
     Intervalometer() : Super(&Intervalometer::stateInit)
     {
+        // Names in the reports of the handlers taking longer than the budget
+        nameState(&Intervalometer::stateSuper, "Super");
+        nameState(&Intervalometer::stateReady, "Ready");
+        nameState(&Intervalometer::stateCameraNotReady, "CameraNotReady");
+        nameState(&Intervalometer::stateRunning, "Running");
+        nameState(&Intervalometer::stateCapturing, "Capturing");
+        nameState(&Intervalometer::stateWaiting, "Waiting");
+        nameState(&Intervalometer::stateError, "Error");
+
         sEventBroker.subscribe(this, TOPIC_MODE_FSM);
         sEventBroker.subscribe(this, TOPIC_REMOTE_CMD);
         sEventBroker.subscribe(this, TOPIC_CAMERA_EVENT);
@@ -69,10 +114,7 @@ private:
                 LOG_STATE(slog, "EXIT");
                 break;
             case EventGetCurrentMode::id:
-                sEventBroker.post(
-                    EventIntervalometerState{state, interval, num_captures,
-                                             total_captures},
-                    TOPIC_MODE_STATE);
+                onStateChange();
             default:
                 retState = tran_super(&Intervalometer::Hsm_top);
                 break;
@@ -102,10 +144,17 @@ private:
             {
                 auto s =
                     dynamic_pointer_cast<const EventIntervalometerStart>(ev);
-                interval       = s->intervalms;
-                total_captures = s->total_captures;
-                num_captures   = 0;
-                retState       = transition(&Intervalometer::stateCapturing);
+                interval            = s->intervalms;
+                total_captures      = s->total_captures;
+                policy              = parseMissedPolicy(s->missed_policy);
+                num_captures        = 0;
+                frame               = 0;
+                missed_frames       = 0;
+                timing_error_us     = 0;
+                max_timing_error_us = 0;
+                reanchor            = false;
+                schedule.start(milliseconds(interval));
+                retState = transition(&Intervalometer::stateCapturing);
                 break;
             }
             default:
@@ -155,6 +204,7 @@ private:
                 retState = transition(&Intervalometer::stateCapturing);
                 break;
             case EventSMExit::id:
+                schedule.cancel();
                 sEventBroker.post(EventModeStopped{}, TOPIC_MODE_CONTROLLER);
                 LOG_STATE(slog, "EXIT");
                 break;
@@ -175,14 +225,18 @@ private:
         switch (ev->getID())
         {
             case EventSMEntry::id:
-                deadline_expired = false;
-                onStateChange("Capturing");
-                sEventBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+                schedule.clearExpired();
                 if (interval > 0)
                 {
-                    sBroker.postDelayed(EventIntervalometerDeadlineExpired{},
-                                        TOPIC_MODE_FSM, interval);
+                    updateTimingError();
+                    if (policy == MissedFramePolicy::RELATIVE || reanchor)
+                        schedule.anchorAt(frame, steady_clock::now());
+                    reanchor = false;
                 }
+                onStateChange("Capturing");
+                sEventBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+                if (interval > 0)
+                    schedule.schedule(frame + 1);
                 LOG_STATE(slog, "ENTRY");
                 break;
             case EventSMInit::id:
@@ -201,17 +255,22 @@ private:
                     retState          = transition(&Intervalometer::stateReady);
                     break;
                 }
-                if (interval < 0 || deadline_expired)
+                if (interval < 0)
                 {
+                    ++frame;
                     retState = transition(&Intervalometer::stateCapturing);
                 }
+                else if (schedule.isExpired())
+                {
+                    retState = onDeadlineMissed();
+                }
                 else
                 {
                     retState = transition(&Intervalometer::stateWaiting);
                 }
                 break;
             case EventIntervalometerDeadlineExpired::id:
-                deadline_expired = true;
+                schedule.onExpired();
                 break;
             case EventCameraError::id:
                 history  = &Intervalometer::stateCapturing;
@@ -243,6 +302,8 @@ private:
                 LOG_STATE(slog, "EXIT");
                 break;
             case EventIntervalometerDeadlineExpired::id:
+                schedule.onExpired();
+                ++frame;
                 retState = transition(&Intervalometer::stateCapturing);
                 break;
             case EventCameraError::id:
@@ -272,11 +333,11 @@ private:
                 LOG_STATE(slog, "EXIT");
                 break;
             case EventIntervalometerDeadlineExpired::id:
-                deadline_expired = true;
+                schedule.onExpired();
                 break;
             case EventCameraConnected::id:
-                if (deadline_expired)
-                    retState = transition(&Intervalometer::stateCapturing);
+                if (schedule.isExpired())
+                    retState = onDeadlineMissed();
                 else
                     retState = transition(history);
                 break;
@@ -291,11 +352,72 @@ private:
     }
 
 private:
+    MissedFramePolicy parseMissedPolicy(const string& policy)
+    {
+        if (policy.empty())
+            return MissedFramePolicy::RELATIVE;
+        if (policy == "skip")
+            return MissedFramePolicy::SKIP;
+        if (policy == "stretch")
+            return MissedFramePolicy::STRETCH;
+        if (policy != "catch_up")
+            LOG_WARN(log, "Unknown missed frame policy '{}', using catch_up",
+                     policy);
+        return MissedFramePolicy::CATCH_UP;
+    }
+
+    /**
+     * @brief Records how late the current frame started with respect to its
+     * slot in the schedule.
+     */
+    void updateTimingError()
+    {
+        int64_t err = duration_cast<microseconds>(steady_clock::now() -
+                                                  schedule.deadline(frame))
+                          .count();
+        err = std::clamp<int64_t>(err, INT32_MIN, INT32_MAX);
+
+        timing_error_us     = static_cast<int32_t>(err);
+        max_timing_error_us = std::max(max_timing_error_us, timing_error_us);
+    }
+
+    /**
+     * @brief Decides what to do when the deadline of the next frame expired
+     * before we were ready to capture it.
+     */
+    State onDeadlineMissed()
+    {
+        switch (policy)
+        {
+            case MissedFramePolicy::SKIP:
+            {
+                // First slot strictly in the future
+                int64_t next = schedule.frameAt(steady_clock::now()) + 1;
+                missed_frames += static_cast<int32_t>(next - frame - 1);
+                LOG_WARN(log, "Missed {} frame(s), waiting for frame {}",
+                         next - frame - 1, next);
+                frame = next - 1;
+                schedule.schedule(frame + 1);
+                return transition(&Intervalometer::stateWaiting);
+            }
+            case MissedFramePolicy::STRETCH:
+                // Re-anchor once the late frame has been timed
+                ++frame;
+                reanchor = true;
+                break;
+            default:
+                ++frame;
+                break;
+        }
+        return transition(&Intervalometer::stateCapturing);
+    }
+
     void onStateChange()
     {
         sEventBroker.post(
             EventIntervalometerState{state, interval, num_captures,
-                                     total_captures},
+                                     total_captures, missed_frames,
+                                     timing_error_us, max_timing_error_us},
             TOPIC_MODE_STATE);
     }
     void onStateChange(string state)
@@ -308,9 +430,17 @@ private:
     int32_t num_captures   = 0;
     int32_t total_captures = 0;
 
+    MissedFramePolicy policy = MissedFramePolicy::RELATIVE;
+    FrameSchedule<EventIntervalometerDeadlineExpired> schedule;
+    // Index of the frame being captured (or that was captured last)
+    int64_t frame               = 0;
+    int32_t missed_frames       = 0;
+    int32_t timing_error_us     = 0;
+    int32_t max_timing_error_us = 0;
+    bool reanchor               = false;
+
     State (Intervalometer::*history)(const EventPtr& ev);
 
-    bool deadline_expired  = false;
     bool stop_cmd_received = false;
 
     PrintLogger log = Logging::getLogger("Interv");
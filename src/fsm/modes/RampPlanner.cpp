@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "RampPlanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using std::log2;
+using std::pow;
+
+/**
+ * @brief Index of the element of the sorted vector closest to value, in the
+ * logarithmic domain.
+ */
+static size_t nearestLog(const vector<int32_t>& v, float value)
+{
+    size_t best   = 0;
+    float best_d  = INFINITY;
+    float log_val = log2(std::max(value, 1.0f));
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        float d = std::abs(log2(static_cast<float>(v[i])) - log_val);
+        if (d < best_d)
+        {
+            best   = i;
+            best_d = d;
+        }
+    }
+    return best;
+}
+
+RampPlanner::RampPlanner(RampPlannerConfig cfg, vector<int32_t> shutter_speeds,
+                         vector<int32_t> isos, vector<int32_t> apertures)
+    : cfg(cfg), shutter_speeds(shutter_speeds), isos(isos),
+      apertures(apertures)
+{
+    // Bulb is reported as a negative value
+    std::erase_if(this->shutter_speeds, [](int32_t s) { return s <= 0; });
+
+    if (this->shutter_speeds.empty() || isos.empty() || apertures.empty())
+        throw std::invalid_argument("RampPlanner: empty choices");
+
+    std::sort(this->shutter_speeds.begin(), this->shutter_speeds.end());
+    std::sort(this->isos.begin(), this->isos.end());
+    std::sort(this->apertures.begin(), this->apertures.end());
+}
+
+void RampPlanner::reset(const ExposureSettings& current)
+{
+    base_aperture_id = nearestLog(apertures, current.aperture);
+    planned_ev       = exposureValue(current);
+    filtered_target  = planned_ev;
+}
+
+ExposureSettings RampPlanner::plan(const ExposureSettings& current,
+                                   float light_meter)
+{
+    float target    = exposureValue(current) - light_meter;
+    filtered_target = cfg.meter_smoothing * target +
+                      (1 - cfg.meter_smoothing) * filtered_target;
+
+    float step = std::clamp(filtered_target - planned_ev, -cfg.max_ev_step,
+                            cfg.max_ev_step);
+    planned_ev += step;
+
+    return settingsFor(planned_ev, current);
+}
+
+ExposureSettings RampPlanner::settingsFor(float ev,
+                                          const ExposureSettings& current) const
+{
+    size_t iso_id = nearestLog(isos, current.iso);
+    size_t ap_id  = nearestLog(apertures, current.aperture);
+
+    size_t max_iso_id = 0;
+    while (max_iso_id + 1 < isos.size() && isos[max_iso_id + 1] <= cfg.max_iso)
+        ++max_iso_id;
+    iso_id = std::min(iso_id, max_iso_id);
+
+    float max_shutter = cfg.max_shutter_speed;
+    auto shutter      = [&](size_t iso, size_t ap)
+    { return shutterFor(ev, isos[iso], apertures[ap]); };
+
+    // Getting darker: longer exposure first, then ISO, then aperture
+    while (shutter(iso_id, ap_id) > max_shutter && iso_id < max_iso_id)
+        ++iso_id;
+    while (shutter(iso_id, ap_id) > max_shutter && ap_id > 0)
+        --ap_id;
+
+    // Getting brighter: go back in the opposite order, but only once there is
+    // a stop of margin, to avoid toggling between two values
+    while (ap_id < base_aperture_id &&
+           shutter(iso_id, ap_id + 1) <= max_shutter / 2)
+        ++ap_id;
+    while (iso_id > 0 && shutter(iso_id - 1, ap_id) <= max_shutter / 2)
+        --iso_id;
+
+    float t = std::min(shutter(iso_id, ap_id), max_shutter);
+
+    return {.shutter_speed = quantizeShutter(t),
+            .iso           = isos[iso_id],
+            .aperture      = apertures[ap_id]};
+}
+
+float RampPlanner::exposureValue(const ExposureSettings& s)
+{
+    return log2(s.shutter_speed / 1e6f) + log2(s.iso / 100.0f) -
+           2 * log2(s.aperture / 100.0f);
+}
+
+int RampPlanner::numWrites(const ExposureSettings& a, const ExposureSettings& b)
+{
+    return (a.shutter_speed != b.shutter_speed) + (a.iso != b.iso) +
+           (a.aperture != b.aperture);
+}
+
+float RampPlanner::shutterFor(float ev, int32_t iso, int32_t aperture)
+{
+    return 1e6f * pow(2.0f, ev - log2(iso / 100.0f) +
+                                2 * log2(aperture / 100.0f));
+}
+
+int32_t RampPlanner::quantizeShutter(float shutter_speed) const
+{
+    if (shutter_speed > shutter_speeds.back())
+    {
+        // Bulb: any exposure time can be used
+        int32_t res = cfg.bulb_resolution;
+        return static_cast<int32_t>(std::round(shutter_speed / res)) * res;
+    }
+    return shutter_speeds[nearestLog(shutter_speeds, shutter_speed)];
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+/**
+ * Camera exposure settings, in the same units used by the camera events.
+ */
+struct ExposureSettings
+{
+    int32_t shutter_speed;  // us
+    int32_t iso;
+    int32_t aperture;  // f-number * 100
+
+    bool operator==(const ExposureSettings& other) const = default;
+};
+
+struct RampPlannerConfig
+{
+    // Maximum exposure change between two consecutive frames, in EV
+    float max_ev_step = 1.0f / 3;
+    // Weight of the latest light meter reading in the filtered value
+    float meter_smoothing = 0.3f;
+    // Longest exposure that still leaves enough time between two frames
+    int32_t max_shutter_speed = 30000000;
+    int32_t max_iso           = 6400;
+    // Exposures longer than the longest shutter choice are taken in bulb
+    // mode, with this resolution
+    int32_t bulb_resolution = 1000;
+};
+
+/**
+ * Plans the exposure settings of a day-to-night (or night-to-day) timelapse.
+ *
+ * The planner keeps a continuous exposure value that follows the light meter
+ * readings, limited to max_ev_step per frame, and maps it to the camera
+ * settings. When the scene gets darker the shutter speed is changed first,
+ * then the ISO and finally the aperture; the opposite order is used when the
+ * scene gets brighter. ISO and aperture changes have one stop of hysteresis
+ * so that they do not toggle back and forth between frames.
+ *
+ * Exposure values are expressed in EV relative to 1s, ISO 100, f/1: larger
+ * values mean more light reaching the sensor.
+ */
+class RampPlanner
+{
+public:
+    /**
+     * @throws std::invalid_argument if any of the choices is empty.
+     */
+    RampPlanner(RampPlannerConfig cfg, vector<int32_t> shutter_speeds,
+                vector<int32_t> isos, vector<int32_t> apertures);
+
+    /**
+     * @brief Starts a new ramp from the current camera settings.
+     */
+    void reset(const ExposureSettings& current);
+
+    /**
+     * @brief Computes the settings of the next frame.
+     *
+     * @param current Settings the light meter reading refers to
+     * @param light_meter Light meter reading in EV, positive if the scene is
+     * brighter than the current settings expose for.
+     */
+    ExposureSettings plan(const ExposureSettings& current, float light_meter);
+
+    /**
+     * @brief Settings that best approximate the given exposure value, starting
+     * from the current ones.
+     */
+    ExposureSettings settingsFor(float ev,
+                                 const ExposureSettings& current) const;
+
+    /**
+     * @brief Exposure value planned for the next frame.
+     */
+    float getPlannedEV() const { return planned_ev; }
+
+    /**
+     * @brief Exposure value of the provided settings.
+     */
+    static float exposureValue(const ExposureSettings& s);
+
+    /**
+     * @brief Number of config writes needed to go from a to b.
+     */
+    static int numWrites(const ExposureSettings& a, const ExposureSettings& b);
+
+private:
+    /**
+     * @brief Continuous shutter speed exposing for ev with iso and aperture.
+     */
+    static float shutterFor(float ev, int32_t iso, int32_t aperture);
+
+    int32_t quantizeShutter(float shutter_speed) const;
+
+    RampPlannerConfig cfg;
+
+    // Sorted in ascending order
+    vector<int32_t> shutter_speeds;
+    vector<int32_t> isos;
+    vector<int32_t> apertures;
+
+    // Narrowest aperture used, the one at the start of the ramp
+    size_t base_aperture_id = 0;
+
+    float planned_ev      = 0;
+    float filtered_target = 0;
+};
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <argparse/argparse.hpp>
+#include <iostream>
+#include <string>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "utils/EventSniffer.h"
+#include "utils/journal/EventJournal.h"
+#include "utils/logger/PrintLogger.h"
+
+using std::string;
+
+PrintLogger elog = Logging::getLogger("replay");
+
+void printEvent(const EventPtr& ev, uint8_t topic)
+{
+    LOG_EVENT(elog, "{} -> {}       {}", ev->name(), getTopicName(topic),
+              ev->dump());
+}
+
+/**
+ * Reads an event journal recorded by cc3 and replays it on a fresh
+ * EventBroker.
+ */
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser program("journal-replay");
+
+    program.add_argument("journal").help("Journal file to replay");
+
+    program.add_argument("-s", "--speed")
+        .default_value(1.0f)
+        .scan<'g', float>()
+        .help("Replay speed multiplier, 0 to replay as fast as possible");
+
+    program.add_argument("-l", "--list")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Only list the records in the journal");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err)
+    {
+        LOG_ERR(elog, err.what());
+        std::cerr << program;
+        std::exit(1);
+    }
+
+    vector<JournalRecord> records;
+    try
+    {
+        records = EventJournal::read(program.get<string>("journal"));
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERR(elog, "Cannot read journal: {}", e.what());
+        std::exit(1);
+    }
+
+    LOG_INFO(elog, "{} records in journal", records.size());
+
+    if (program.get<bool>("--list"))
+    {
+        for (const JournalRecord& r : records)
+        {
+            fmt::print("{:>8} {:.6f} {:<22} {:>4} {} bytes\n", r.seq,
+                       r.timestamp_ns / 1e9, getTopicName(r.topic), r.event_id,
+                       r.payload.size());
+        }
+        return 0;
+    }
+
+    sBroker.start();
+    EventSniffer sniffer{sEventBroker, &printEvent};
+
+    size_t posted =
+        replayJournal(sEventBroker, records, program.get<float>("--speed"));
+
+    LOG_INFO(elog, "Replayed {}/{} events", posted, records.size());
+
+    sBroker.stop();
+    return 0;
+}
@@ -31,19 +31,28 @@
 #include <memory>
 #include <thread>
 
+#include "DispatchWatchdog.h"
 #include "EventBroker.h"
 #include "JsonLogSink.h"
 #include "TcpLogSink.h"
+#include "camera/UsbHotplugMonitor.h"
 #include "comm/CommManager.h"
 #include "fsm/CameraController.h"
 #include "fsm/ModeController.h"
+#include "fsm/MultiCameraController.h"
+#include "fsm/modes/Bracketing.h"
+#include "fsm/modes/FocusStacking.h"
+#include "fsm/modes/BulbRamping.h"
 #include "fsm/modes/Intervalometer.h"
 #include "utils/EventSniffer.h"
+#include "utils/Executor.h"
 #include "utils/debug/cli.h"
+#include "utils/journal/EventJournal.h"
 #include "utils/logger/PrintLogger.h"
 
 using std::make_shared;
 using std::shared_ptr;
+using std::unique_ptr;
 using std::chrono::duration;
 using std::chrono::duration_cast;
 using std::chrono::high_resolution_clock;
@@ -60,7 +69,7 @@ void initLogger(argparse::ArgumentParser& program);
 void printEvent(const EventPtr& ev, uint8_t topic)
 {
     LOG_EVENT(elog, "{} -> {}       {}", ev->name(), getTopicName(topic),
-              ev->to_json().dump(-1));
+              ev->dump());
 }
 
 int main(int argc, char* argv[])
@@ -77,6 +86,26 @@ int main(int argc, char* argv[])
         .default_value(string{"."})
         .help("Directory where to save downloaded photos");
 
+    program.add_argument("-j", "--journal")
+        .help("File where to record the event journal");
+
+    program.add_argument("-r", "--max_rate")
+        .default_value(0.0f)
+        .scan<'g', float>()
+        .help("Max messages per second sent to the remote client (0: no "
+              "limit)");
+
+    program.add_argument("-m", "--multi_camera")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Control all the connected cameras instead of the first one");
+
+    program.add_argument("-b", "--handler_budget")
+        .default_value(1000)
+        .scan<'i', int>()
+        .help("Time in ms after which an event handler that has not finished "
+              "handling an event is reported");
+
     try
     {
         program.parse_args(argc, argv);
@@ -102,21 +131,71 @@ int main(int argc, char* argv[])
 
     LOG_DEBUG(mlog.getChild("arg_parse"), "Download directory = {}", dir);
 
+    unique_ptr<EventJournal> journal;
+    if (auto fn = program.present("-j"))
+    {
+        try
+        {
+            journal = std::make_unique<EventJournal>(*fn);
+            // Commands and diagnostics are rare, and the most useful to find
+            // out what happened before a crash. Not the camera events: they
+            // are posted by the thread timing the exposures.
+            journal->setSyncTopics(
+                TopicMask{}.set(TOPIC_REMOTE_CMD).set(TOPIC_DIAGNOSTICS));
+        }
+        catch (std::exception& e)
+        {
+            LOG_ERR(mlog, "Cannot create event journal: {}", e.what());
+            std::exit(1);
+        }
+    }
+
+    DispatchWatchdog::getInstance().setDefaultBudget(
+        milliseconds(program.get<int>("-b")));
+
     sBroker.start();
-    EventSniffer sniffer{sEventBroker, &printEvent};
-    CommManager comm(60099);
+    EventSniffer sniffer{sEventBroker,
+                         [&](const EventPtr& ev, uint8_t topic)
+                         {
+                             printEvent(ev, topic);
+                             if (journal)
+                                 journal->append(ev, topic);
+                         }};
+    CommManager comm(60099, program.get<float>("-r"));
+
+    // The modes only react to events and never block: they share two workers
+    // instead of a thread each
+    Executor executor{2, ThreadSpec{"modes"}};
+    executor.start();
 
     ModeController mode_ctrl{};
     Intervalometer intervalometer{};
+    BulbRamping bulb_ramping{};
+    Bracketing bracketing{};
+    FocusStacking focus_stacking{};
 
-    CameraController camera{dir};
+    unique_ptr<CameraController> camera;
+    unique_ptr<MultiCameraController> cameras;
+    if (program.get<bool>("-m"))
+        cameras = std::make_unique<MultiCameraController>(dir);
+    else
+        camera = std::make_unique<CameraController>(dir);
 
-    mode_ctrl.start();
-    intervalometer.start();
-    camera.start();
+    mode_ctrl.start(executor);
+    intervalometer.start(executor);
+    bulb_ramping.start(executor);
+    bracketing.start(executor);
+    focus_stacking.start(executor);
+    if (cameras)
+        cameras->start();
+    else
+        camera->start();
 
     sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
 
+    UsbHotplugMonitor hotplug{};
+    hotplug.start();
+
     CLI cli{};
     cli.start();
 
@@ -28,6 +28,8 @@
 #include <atomic>
 #include <fmt/core.h>
 
+#include "ThreadSpec.h"
+
 using std::make_unique;
 using std::thread;
 using std::unique_ptr;
@@ -44,11 +46,11 @@ class ActiveObject
 public:
     /**
      * Constructor. This will create the AO, but will NOT start the thread
-     * associated with it. call start() in order to start the thread. \param
-     * stacksize the stack of the thread that will be spawned \param priority
-     * priority of the thread that will be spawned
+     * associated with it. call start() in order to start the thread.
+     * \param spec name, stack size, priority and affinity of the thread that
+     * will be spawned
      */
-    ActiveObject() {}
+    ActiveObject(ThreadSpec spec = {}) : spec(std::move(spec)) {}
     ActiveObject(const ActiveObject& other) = delete;
     ActiveObject(ActiveObject&& other) = delete;
 
@@ -70,7 +72,8 @@ public:
         if (!started && !stopped)
         {
             // Start the thread
-            thread_obj.reset(new thread{&ActiveObject::threadLauncher, this});
+            thread_obj.reset(
+                new NativeThread{spec, &ActiveObject::threadLauncher, this});
             // thread_obj->detach();
 
             started = true;
@@ -105,6 +108,14 @@ public:
 
     bool isRunning() { return started && !stopped; }
 
+    /**
+     * @brief Sets the attributes of the thread. Only has effect before
+     * start().
+     */
+    void setThreadSpec(const ThreadSpec& spec) { this->spec = spec; }
+
+    const ThreadSpec& getThreadSpec() const { return spec; }
+
 protected:
     /**
      * The thread that will be spawned just calls this function.
@@ -125,13 +136,15 @@ protected:
      */
     bool shouldStop() { return should_stop; }
 
-    unique_ptr<thread> thread_obj;
+    unique_ptr<NativeThread> thread_obj;
 
     atomic_bool should_stop = false;
     atomic_bool stopped     = false;
     atomic_bool started     = false;
 
 private:
+    ThreadSpec spec;
+
     /**
      * Calls the run member function
      * \param arg the object pointer cast to void*
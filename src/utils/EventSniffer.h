@@ -24,20 +24,16 @@
 #pragma once
 
 #include <functional>
-#include <iostream>
-#include <string>
 #include <vector>
 
 #include "events/EventBroker.h"
 #include "events/Events.h"
 
-using std::cout;
 using std::function;
-using std::string;
 using std::vector;
 
 /**
- * Class that subscribe to many topics and calls a callback when an event is
+ * Class that taps many topics and calls a callback when an event is
  * received.
  */
 class EventSniffer
@@ -53,62 +49,37 @@ public:
      */
     EventSniffer(EventBroker& broker, vector<uint8_t> topics,
                  OnEventReceived on_event_received)
-        : broker(broker), on_event_received(on_event_received)
+        : broker(broker)
     {
+        TopicMask mask;
         for (uint8_t t : topics)
         {
-            sniffers.push_back(new Sniffer(*this, t));
+            mask.set(t);
         }
+        tap_id = broker.addTap(on_event_received, mask);
     }
 
     /**
-     * EventSniffer that sniffs all the possible topics (0-255)
+     * EventSniffer that sniffs all the possible topics (0-255), except for the
+     * heartbeat
      * @param broker Event broker to subscribe to
      * @param on_event_received Callback to call upon receiving an event
      */
     EventSniffer(EventBroker& broker, OnEventReceived on_event_received)
-        : broker(broker), on_event_received(on_event_received)
+        : broker(broker)
     {
-        for (int t = 0; t <= 255; t++)
-        {
-            if(t != TOPIC_HEARTBEAT)
-                sniffers.push_back(new Sniffer(*this, (uint8_t)t));
-        }
+        TopicMask mask;
+        mask.set();
+        mask.reset(TOPIC_HEARTBEAT);
+        tap_id = broker.addTap(on_event_received, mask);
     }
 
-    ~EventSniffer()
-    {
-        for (Sniffer* s : sniffers)
-        {
-            delete s;
-        }
-    }
+    ~EventSniffer() { broker.removeTap(tap_id); }
 
-private:
-    class Sniffer : public EventHandlerBase
-    {
-    public:
-        Sniffer(EventSniffer& parent, uint8_t topic)
-            : parent(parent), topic(topic)
-        {
-            parent.broker.subscribe(this, topic);
-        }
-
-        ~Sniffer() { parent.broker.unsubscribe(this); }
-
-    protected:
-        void doPostEvent(const EventPtr& ev)
-        {
-            parent.on_event_received(ev, topic);
-        }
-
-    private:
-        EventSniffer& parent;
-        uint8_t topic;
-    };
-
-    vector<Sniffer*> sniffers;
+    EventSniffer(const EventSniffer&) = delete;
+    EventSniffer& operator=(const EventSniffer&) = delete;
 
+private:
     EventBroker& broker;
-    OnEventReceived on_event_received;
-};
\ No newline at end of file
+    uint16_t tap_id;
+};
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "Executor.h"
+
+#include <algorithm>
+#include <string>
+
+using std::lock_guard;
+using std::unique_lock;
+
+// Worker the current thread belongs to, if any
+static thread_local Executor* current_executor = nullptr;
+static thread_local unsigned int current_worker = 0;
+
+Executor::Executor(unsigned int num_workers, ThreadSpec spec)
+    : spec(std::move(spec))
+{
+    for (unsigned int i = 0; i < std::max(num_workers, 1u); ++i)
+    {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->parent = this;
+        workers.back()->index  = i;
+    }
+}
+
+Executor::~Executor() { stop(); }
+
+void Executor::start()
+{
+    if (running)
+        return;
+
+    should_stop = false;
+    running     = true;
+    for (auto& worker : workers)
+    {
+        ThreadSpec worker_spec = spec;
+        if (!spec.name.empty())
+            worker_spec.name += "-" + std::to_string(worker->index);
+
+        worker->thread_obj = std::make_unique<NativeThread>(
+            worker_spec, &Executor::workerLauncher, worker.get());
+    }
+}
+
+void Executor::stop()
+{
+    if (!running)
+        return;
+
+    {
+        lock_guard<mutex> lock(mtx_idle);
+        should_stop = true;
+    }
+    cv_idle.notify_all();
+
+    for (auto& worker : workers)
+    {
+        if (worker->thread_obj->joinable())
+            worker->thread_obj->join();
+    }
+    running = false;
+}
+
+void Executor::submit(ExecutorTask* task)
+{
+    unsigned int index = current_executor == this
+                             ? current_worker
+                             : next_worker++ % workers.size();
+    // Counted before it can be popped: a worker taking it right away must
+    // not decrement pending below zero
+    {
+        lock_guard<mutex> lock(mtx_idle);
+        ++pending;
+    }
+
+    {
+        lock_guard<mutex> lock(workers[index]->mtx);
+        workers[index]->tasks.push_back(task);
+    }
+    cv_idle.notify_one();
+}
+
+void Executor::workerLauncher(void* arg)
+{
+    Worker* worker = reinterpret_cast<Worker*>(arg);
+    worker->parent->run(worker->index);
+}
+
+void Executor::run(unsigned int index)
+{
+    current_executor = this;
+    current_worker   = index;
+
+    while (!should_stop)
+    {
+        ExecutorTask* task = pop(index);
+        if (task == nullptr)
+            task = steal(index);
+
+        if (task != nullptr)
+        {
+            task->execute();
+            continue;
+        }
+
+        unique_lock<mutex> lock(mtx_idle);
+        cv_idle.wait(lock, [&] { return should_stop || pending > 0; });
+    }
+
+    current_executor = nullptr;
+}
+
+ExecutorTask* Executor::pop(unsigned int index)
+{
+    Worker& worker = *workers[index];
+    ExecutorTask* task;
+    {
+        lock_guard<mutex> lock(worker.mtx);
+        if (worker.tasks.empty())
+            return nullptr;
+
+        task = worker.tasks.front();
+        worker.tasks.pop_front();
+    }
+
+    lock_guard<mutex> lock(mtx_idle);
+    --pending;
+    return task;
+}
+
+ExecutorTask* Executor::steal(unsigned int index)
+{
+    for (unsigned int i = 1; i < workers.size(); ++i)
+    {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        ExecutorTask* task;
+        {
+            lock_guard<mutex> lock(victim.mtx);
+            if (victim.tasks.empty())
+                continue;
+
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+        }
+
+        ++stolen;
+        lock_guard<mutex> lock(mtx_idle);
+        --pending;
+        return task;
+    }
+    return nullptr;
+}
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ThreadSpec.h"
+
+using std::condition_variable;
+using std::deque;
+using std::mutex;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * @brief Unit of work scheduled on an Executor.
+ */
+class ExecutorTask
+{
+public:
+    virtual ~ExecutorTask() {}
+
+    /**
+     * @brief Runs a bounded amount of work on a worker thread. It should not
+     * block for long, as the worker cannot run anything else in the meantime.
+     */
+    virtual void execute() = 0;
+};
+
+/**
+ * @brief Small pool of worker threads running ExecutorTasks, used to run many
+ * mostly idle event handlers without a thread each (see
+ * EventHandler::start(Executor&)).
+ * Each worker has its own queue: tasks submitted by a worker go to its own
+ * queue, the others are distributed round robin. An idle worker steals the
+ * oldest tasks from the queues of the others.
+ * A task must not be submitted again before it starts executing: the
+ * executor never runs the same task on two workers at the same time as long
+ * as this holds.
+ */
+class Executor
+{
+public:
+    /**
+     * @param num_workers Number of worker threads, at least 1
+     * @param spec Spec of the workers, numbered after its name
+     */
+    Executor(unsigned int num_workers = 2, ThreadSpec spec = {});
+
+    Executor(const Executor& other) = delete;
+    Executor& operator=(const Executor& other) = delete;
+
+    /**
+     * @brief Stops the workers. Stop the event handlers running on the
+     * executor first.
+     */
+    ~Executor();
+
+    void start();
+
+    /**
+     * @brief Waits for the tasks being executed and stops the workers. Tasks
+     * still in the queues are not executed.
+     */
+    void stop();
+
+    bool isRunning() const { return running; }
+
+    void submit(ExecutorTask* task);
+
+    unsigned int getNumWorkers() const { return workers.size(); }
+
+    /**
+     * @brief Number of tasks executed by a worker other than the one they
+     * were queued on.
+     */
+    uint64_t getStolenCount() const { return stolen; }
+
+private:
+    struct Worker
+    {
+        Executor* parent;
+        unsigned int index;
+
+        mutex mtx;
+        deque<ExecutorTask*> tasks;
+        unique_ptr<NativeThread> thread_obj;
+    };
+
+    static void workerLauncher(void* arg);
+    void run(unsigned int index);
+
+    ExecutorTask* pop(unsigned int index);
+    ExecutorTask* steal(unsigned int index);
+
+    ThreadSpec spec;
+    vector<unique_ptr<Worker>> workers;
+
+    // Queued tasks, to let idle workers sleep
+    mutex mtx_idle;
+    condition_variable cv_idle;
+    size_t pending = 0;
+
+    std::atomic<unsigned int> next_worker{0};
+    std::atomic<uint64_t> stolen{0};
+    std::atomic_bool running{false};
+    std::atomic_bool should_stop{false};
+};
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "ThreadSpec.h"
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <system_error>
+#include <thread>
+
+#include "utils/logger/PrintLogger.h"
+
+// Priority of the camera threads: below the threaded interrupt handlers (50),
+// which serve the USB transfers of the camera
+static constexpr int CAMERA_PRIORITY = 20;
+
+static constexpr int LOGGING_NICE = 10;
+static constexpr int NETWORK_NICE = 5;
+
+// pthread_setname_np() fails with names longer than this
+static constexpr size_t MAX_NAME_LENGTH = 15;
+
+/**
+ * @brief The last CPU is reserved to the camera threads, if there is more
+ * than one
+ */
+static vector<unsigned int> otherCpus()
+{
+    vector<unsigned int> cpus;
+    unsigned int n = std::thread::hardware_concurrency();
+    for (unsigned int i = 0; n > 1 && i < n - 1; ++i)
+        cpus.push_back(i);
+    return cpus;
+}
+
+static vector<unsigned int> cameraCpus(unsigned int camera_index)
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    if (n > 1)
+        return {n - 1 - camera_index % n};
+    return {};
+}
+
+namespace ThreadSpecs
+{
+ThreadSpec camera(const string& name, unsigned int camera_index)
+{
+    ThreadSpec spec{};
+    spec.name     = name;
+    spec.policy   = SchedPolicy::FIFO;
+    spec.priority = CAMERA_PRIORITY;
+    spec.cpus     = cameraCpus(camera_index);
+    return spec;
+}
+
+ThreadSpec logging(const string& name)
+{
+    ThreadSpec spec{};
+    spec.name = name;
+    spec.nice = LOGGING_NICE;
+    spec.cpus = otherCpus();
+    return spec;
+}
+
+ThreadSpec network(const string& name)
+{
+    ThreadSpec spec{};
+    spec.name = name;
+    spec.nice = NETWORK_NICE;
+    spec.cpus = otherCpus();
+    return spec;
+}
+}  // namespace ThreadSpecs
+
+bool applyThreadSpec(const ThreadSpec& spec)
+{
+    PrintLogger log = Logging::getLogger("ThreadSpec");
+    pthread_t self  = pthread_self();
+    bool ok         = true;
+
+    if (!spec.name.empty())
+    {
+        string name = spec.name.substr(0, MAX_NAME_LENGTH);
+        if (int err = pthread_setname_np(self, name.c_str()))
+        {
+            LOG_WARN(log, "Cannot set the name of thread {}: {}", name,
+                     strerror(err));
+            ok = false;
+        }
+    }
+
+    if (!spec.cpus.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (unsigned int cpu : spec.cpus)
+            CPU_SET(cpu, &set);
+
+        if (int err = pthread_setaffinity_np(self, sizeof(set), &set))
+        {
+            LOG_WARN(log, "Cannot set the affinity of thread {}: {}",
+                     spec.name, strerror(err));
+            ok = false;
+        }
+    }
+
+    if (spec.policy == SchedPolicy::FIFO)
+    {
+        sched_param param{};
+        param.sched_priority = spec.priority;
+        if (int err = pthread_setschedparam(self, SCHED_FIFO, &param))
+        {
+            LOG_WARN(log, "Cannot run thread {} with SCHED_FIFO priority {}: {}",
+                     spec.name, spec.priority, strerror(err));
+            ok = false;
+        }
+    }
+    else if (spec.nice != 0)
+    {
+        // The nice value is per thread on Linux
+        if (setpriority(PRIO_PROCESS, gettid(), spec.nice) != 0)
+        {
+            LOG_WARN(log, "Cannot set the nice value of thread {} to {}: {}",
+                     spec.name, spec.nice, strerror(errno));
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+NativeThread::NativeThread(const ThreadSpec& spec, void (*fun)(void*),
+                           void* arg)
+    : spec(spec), fun(fun), arg(arg)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+
+    int err = 0;
+    if (spec.stack_size > 0)
+        err = pthread_attr_setstacksize(&attr, spec.stack_size);
+
+    if (err == 0)
+        err = pthread_create(&handle, &attr, &NativeThread::launcher, this);
+
+    pthread_attr_destroy(&attr);
+
+    if (err != 0)
+        throw std::system_error(err, std::generic_category(),
+                                "Cannot create thread " + spec.name);
+
+    is_joinable = true;
+}
+
+NativeThread::~NativeThread()
+{
+    if (is_joinable)
+        std::terminate();
+}
+
+void NativeThread::join()
+{
+    if (!is_joinable)
+        throw std::system_error(EINVAL, std::generic_category(),
+                                "Thread not joinable");
+
+    if (int err = pthread_join(handle, nullptr))
+        throw std::system_error(err, std::generic_category(),
+                                "Cannot join thread " + spec.name);
+
+    is_joinable = false;
+}
+
+void* NativeThread::launcher(void* arg)
+{
+    NativeThread* t = reinterpret_cast<NativeThread*>(arg);
+    applyThreadSpec(t->spec);
+    t->fun(t->arg);
+    return nullptr;
+}
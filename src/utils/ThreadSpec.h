@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+enum class SchedPolicy : uint8_t
+{
+    OTHER = 0,  // Time sharing, tuned with the nice value
+    FIFO  = 1   // Real time: preempts every OTHER thread
+};
+
+/**
+ * @brief Attributes of a thread. Default values leave the attribute as
+ * inherited from the process.
+ */
+struct ThreadSpec
+{
+    // At most 15 characters, longer names are truncated
+    string name;
+
+    // Bytes, 0 for the default
+    size_t stack_size = 0;
+
+    SchedPolicy policy = SchedPolicy::OTHER;
+
+    // SCHED_FIFO priority, from 1 to 99
+    int priority = 0;
+
+    // SCHED_OTHER only, from -20 (favoured) to 19
+    int nice = 0;
+
+    // CPUs the thread may run on, empty for any
+    vector<unsigned int> cpus;
+};
+
+/**
+ * @brief Default thread specs of the controller. The camera threads time
+ * the exposures: they run at real time priority, and on a CPU of their own
+ * when there is more than one, away from logging and networking, which run
+ * at a lower priority on the other CPUs.
+ * With several cameras, each one gets its own CPU, assigned round robin from
+ * the last one: the threads of camera 0 run on the last CPU, those of camera
+ * 1 on the one before...
+ */
+namespace ThreadSpecs
+{
+ThreadSpec camera(const string& name, unsigned int camera_index = 0);
+ThreadSpec logging(const string& name);
+ThreadSpec network(const string& name);
+}  // namespace ThreadSpecs
+
+/**
+ * @brief Applies the spec to the calling thread, except the stack size.
+ * Attributes that cannot be set (eg real time priority without
+ * CAP_SYS_NICE) are logged and skipped.
+ *
+ * @return true if every attribute was set
+ */
+bool applyThreadSpec(const ThreadSpec& spec);
+
+/**
+ * @brief Thread started with a ThreadSpec. Like std::thread, it must be
+ * joined before being destroyed.
+ */
+class NativeThread
+{
+public:
+    /**
+     * @brief Starts the thread, which applies the spec and calls fun(arg)
+     *
+     * @throws std::system_error if the thread cannot be created
+     */
+    NativeThread(const ThreadSpec& spec, void (*fun)(void*), void* arg);
+
+    NativeThread(const NativeThread& other) = delete;
+    NativeThread& operator=(const NativeThread& other) = delete;
+
+    ~NativeThread();
+
+    bool joinable() const { return is_joinable; }
+
+    void join();
+
+    pthread_t nativeHandle() const { return handle; }
+
+private:
+    static void* launcher(void* arg);
+
+    ThreadSpec spec;
+    void (*fun)(void*);
+    void* arg;
+
+    pthread_t handle;
+    bool is_joinable = false;
+};
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstring>
 #include <stdexcept>
 #include <type_traits>
@@ -29,6 +30,17 @@
 
 using std::range_error;
 
+/**
+ * Outcome of offering a new element to one already in the buffer, see
+ * CircularBuffer::merge()
+ */
+enum class MergeResult : uint8_t
+{
+    SKIP   = 0,  // Not merged, keep looking at older elements
+    MERGED = 1,  // Merged: the new element must not be added
+    STOP   = 2   // Not merged, stop looking
+};
+
 /**
  * Implementation of an non-synchronized circular buffer.
  */
@@ -121,6 +133,31 @@ public:
             throw range_error("CircularBuffer is empty!");
     }
 
+    /**
+     * @brief Offers a new element to the elements in the buffer, from the
+     * newest to the oldest, calling fun(elem_in_buffer, elem) until it returns
+     * something other than MergeResult::SKIP. The new element is not added.
+     *
+     * @return True if fun returned MergeResult::MERGED.
+     */
+    template <typename Fun>
+    bool merge(T& elem, Fun&& fun)
+    {
+        for (size_t i = count(); i > 0; --i)
+        {
+            switch (fun(get(i - 1), elem))
+            {
+                case MergeResult::MERGED:
+                    return true;
+                case MergeResult::STOP:
+                    return false;
+                default:
+                    break;
+            }
+        }
+        return false;
+    }
+
     /**
      * @brief Counts the elements in the buffer.
      *
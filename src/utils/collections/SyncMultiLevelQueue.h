@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <type_traits>
+
+#include "CircularBuffer.h"
+
+using std::condition_variable;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+/**
+ * Synchronized queue with multiple priority levels, each one a circular
+ * buffer of Size elements: a full level overwrites its oldest element, as
+ * SyncCircularBuffer does, without affecting the other levels.
+ * Elements are popped from the highest priority (lowest index) level that is
+ * not empty. To avoid starvation, a level that has been passed over
+ * StarvationLimit times while not empty is served next.
+ */
+template <typename T, unsigned int Size, unsigned int Levels,
+          unsigned int StarvationLimit = 8>
+class SyncMultiLevelQueue
+{
+    static_assert(Levels > 0, "The queue must have at least one level!");
+    using Me = SyncMultiLevelQueue<T, Size, Levels, StarvationLimit>;
+
+public:
+    SyncMultiLevelQueue() {}
+
+    ~SyncMultiLevelQueue() {}
+
+    /**
+     * @brief Puts a copy of the element in the given level.
+     *
+     * @param elem Element to be added to the queue.
+     * @param level Priority level, 0 is the highest.
+     */
+    template <typename T1 = T,
+              typename    = std::enable_if_t<std::is_copy_assignable_v<T1>>>
+    Me& put(const T& elem, unsigned int level)
+    {
+        unique_lock<mutex> lock(mut);
+        buf[level].put(elem);
+
+        lock.unlock();
+        cv.notify_one();
+        return *this;
+    }
+
+    /**
+     * @brief Moves the element in the given level.
+     *
+     * @param elem Element to be added to the queue.
+     * @param level Priority level, 0 is the highest.
+     */
+    Me& put(T&& elem, unsigned int level)
+    {
+        unique_lock<mutex> lock(mut);
+        buf[level].put(std::move(elem));
+
+        lock.unlock();
+        cv.notify_one();
+        return *this;
+    }
+
+    /**
+     * @brief Puts the element in the given level, unless it is merged in one
+     * of the elements already there. See CircularBuffer::merge().
+     *
+     * @param elem Element to be added to the queue.
+     * @param level Priority level, 0 is the highest.
+     * @param fun Called as fun(elem_in_queue, elem), returns a MergeResult.
+     * @return True if the element was merged.
+     */
+    template <typename Fun>
+    bool putOrMerge(T elem, unsigned int level, Fun&& fun)
+    {
+        unique_lock<mutex> lock(mut);
+        if (buf[level].merge(elem, fun))
+            return true;
+
+        buf[level].put(std::move(elem));
+
+        lock.unlock();
+        cv.notify_one();
+        return false;
+    }
+
+    /**
+     * @brief Pops the next element to be served.
+     *
+     * @warning Remember to catch the exception!
+     * @throw range_error if the queue is empty.
+     * @return The element that has been popped.
+     */
+    T pop()
+    {
+        lock_guard<mutex> lock(mut);
+        if (isEmptyUnsafe())
+            throw range_error("SyncMultiLevelQueue is empty!");
+
+        return std::move(buf[nextLevel()].pop());
+    }
+
+    /**
+     * @brief Pops the next element to be served. This call blocks until an
+     * element is available.
+     *
+     * @return The element that has been popped.
+     */
+    T popBlocking()
+    {
+        unique_lock<mutex> lock(mut);
+        cv.wait(lock, [&] { return !isEmptyUnsafe(); });
+        return std::move(buf[nextLevel()].pop());
+    }
+
+    /**
+     * @brief Counts the elements in all the levels.
+     */
+    size_t count() const
+    {
+        lock_guard<mutex> lock(mut);
+        size_t n = 0;
+        for (const auto& level : buf)
+            n += level.count();
+        return n;
+    }
+
+    /**
+     * @brief Counts the elements in a level.
+     */
+    size_t count(unsigned int level) const
+    {
+        lock_guard<mutex> lock(mut);
+        return buf[level].count();
+    }
+
+    bool isEmpty() const
+    {
+        lock_guard<mutex> lock(mut);
+        return isEmptyUnsafe();
+    }
+
+    /**
+     * @brief Returns the maximum number of elements that can be stored in
+     * each level.
+     */
+    size_t getSize() const { return Size; }
+
+private:
+    bool isEmptyUnsafe() const
+    {
+        for (const auto& level : buf)
+        {
+            if (!level.isEmpty())
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Level of the next element to pop. The queue must not be empty.
+     */
+    unsigned int nextLevel()
+    {
+        unsigned int next = Levels;
+        for (unsigned int l = 0; l < Levels; ++l)
+        {
+            if (buf[l].isEmpty())
+                continue;
+
+            if (next == Levels)
+            {
+                next = l;
+            }
+            else if (skipped[l] >= StarvationLimit)
+            {
+                next = l;
+                break;
+            }
+        }
+
+        for (unsigned int l = 0; l < Levels; ++l)
+        {
+            if (l != next && !buf[l].isEmpty())
+                ++skipped[l];
+        }
+        skipped[next] = 0;
+
+        return next;
+    }
+
+    std::array<CircularBuffer<T, Size>, Levels> buf;
+    // How many times each level has been passed over while not empty
+    std::array<unsigned int, Levels> skipped{};
+
+    mutable mutex mut;
+    mutable condition_variable cv;
+};
@@ -121,6 +121,31 @@ const map<string, function<bool(string)>> CameraCLI::actions{
          sBroker.post(EventCameraCmdCapture{}, TOPIC_REMOTE_CMD);
          return true;
      }},
+    {"focus",
+     [](string cmd) {
+         if (auto res = scan_value<int32_t>(cmd))
+         {
+             sBroker.post(EventCameraCmdFocusDrive{res.value()},
+                          TOPIC_REMOTE_CMD);
+             return true;
+         }
+         return false;
+     }},
+    {"autofocus",
+     [](string cmd) {
+         sBroker.post(EventCameraCmdAutofocus{}, TOPIC_REMOTE_CMD);
+         return true;
+     }},
+    {"capture_all",
+     [](string cmd) {
+         sBroker.post(EventCameraCmdCaptureAll{}, TOPIC_REMOTE_CMD);
+         return true;
+     }},
+    {"list",
+     [](string cmd) {
+         sBroker.post(EventGetCameraList{}, TOPIC_REMOTE_CMD);
+         return true;
+     }},
     {"download",
      [](string cmd) {
          if (auto res = scan_value<bool>(cmd))
@@ -324,9 +349,21 @@ public:
                 if (auto res2 = scan(res1.range_as_string(), "{} {}", interval,
                                      total_captures))
                 {
-                    sEventBroker.post(
-                        EventModeIntervalometer{interval, total_captures},
-                        TOPIC_REMOTE_CMD);
+                    // Optional missed frame policy: skip, catch_up, stretch
+                    string policy;
+                    if (scan(res2.range_as_string(), "{}", policy))
+                    {
+                        sEventBroker.post(
+                            EventModeIntervalometerAnchored{
+                                interval, total_captures, policy},
+                            TOPIC_REMOTE_CMD);
+                    }
+                    else
+                    {
+                        sEventBroker.post(
+                            EventModeIntervalometer{interval, total_captures},
+                            TOPIC_REMOTE_CMD);
+                    }
                     return true;
                 }
             }
@@ -335,6 +372,95 @@ public:
     }
 };
 
+class BulbRampingCLI
+{
+public:
+    static bool parseCommand(string cmd)
+    {
+        static constexpr float DEFAULT_MAX_EV_STEP = 1.0f / 3;
+        static constexpr int32_t DEFAULT_MAX_ISO   = 6400;
+
+        string action;
+        auto res1 = scan(cmd, "{}", action);
+        if (res1 && action == "start")
+        {
+            int32_t interval;
+            int32_t total_captures;
+            if (auto res2 = scan(res1.range_as_string(), "{} {}", interval,
+                                 total_captures))
+            {
+                // Optional: max exposure step per frame (EV), max ISO
+                float max_ev_step = DEFAULT_MAX_EV_STEP;
+                int32_t max_iso   = DEFAULT_MAX_ISO;
+                if (auto res3 = scan(res2.range_as_string(), "{}", max_ev_step))
+                    scan(res3.range_as_string(), "{}", max_iso);
+
+                sEventBroker.post(EventModeBulbRamping{interval, total_captures,
+                                                       max_ev_step, max_iso},
+                                  TOPIC_REMOTE_CMD);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+class BracketingCLI
+{
+public:
+    static bool parseCommand(string cmd)
+    {
+        string action;
+        auto res1 = scan(cmd, "{}", action);
+        if (res1 && action == "start")
+        {
+            int32_t num_frames;
+            float ev_step;
+            if (auto res2 = scan(res1.range_as_string(), "{} {}", num_frames,
+                                 ev_step))
+            {
+                // Optional: disable pipelined config writes
+                bool pipelined = true;
+                scan(res2.range_as_string(), "{}", pipelined);
+
+                sEventBroker.post(
+                    EventModeBracketing{num_frames, ev_step, pipelined},
+                    TOPIC_REMOTE_CMD);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+class FocusStackingCLI
+{
+public:
+    static bool parseCommand(string cmd)
+    {
+        string action;
+        auto res1 = scan(cmd, "{}", action);
+        if (res1 && action == "start")
+        {
+            int32_t num_frames;
+            int32_t focus_steps;
+            if (auto res2 = scan(res1.range_as_string(), "{} {}", num_frames,
+                                 focus_steps))
+            {
+                // Optional: autofocus before the first frame
+                bool autofocus = false;
+                scan(res2.range_as_string(), "{}", autofocus);
+
+                sEventBroker.post(
+                    EventModeFocusStacking{num_frames, focus_steps, autofocus},
+                    TOPIC_REMOTE_CMD);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
 class ModeCLI
 {
 public:
@@ -359,12 +485,27 @@ public:
             {
                 return IntervalometerCLI::parseCommand(res.range_as_string());
             }
+
+            if (action == "ramp")
+            {
+                return BulbRampingCLI::parseCommand(res.range_as_string());
+            }
+
+            if (action == "hdr")
+            {
+                return BracketingCLI::parseCommand(res.range_as_string());
+            }
+
+            if (action == "stack")
+            {
+                return FocusStackingCLI::parseCommand(res.range_as_string());
+            }
         }
         return false;
     }
 };
 
-CLI::CLI() {}
+CLI::CLI() : ActiveObject(ThreadSpec{"cli"}) {}
 
 CLI::~CLI() { stop(); }
 
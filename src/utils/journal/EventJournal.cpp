@@ -0,0 +1,483 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "EventJournal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include "Events.h"
+#include "PrintLogger.h"
+
+using std::lock_guard;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
+
+namespace
+{
+constexpr char JOURNAL_MAGIC[8]     = {'C', 'C', 'E', 'V', 'J', 'R', 'N', 'L'};
+constexpr uint32_t JOURNAL_VERSION  = 1;
+constexpr uint32_t RECORD_MAGIC     = 0x45564A52;  // "EVJR"
+constexpr size_t JOURNAL_HEADER_LEN = 64;
+
+struct JournalFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_size;
+    uint32_t num_slots;
+    uint32_t reserved;
+    uint64_t created_ns;
+    uint8_t padding[32];
+};
+static_assert(sizeof(JournalFileHeader) == JOURNAL_HEADER_LEN);
+
+struct RecordHeader
+{
+    uint32_t magic;
+    uint32_t crc;  // Covers the rest of the header and the payload
+    uint64_t seq;
+    uint64_t timestamp_ns;
+    uint32_t payload_len;
+    uint16_t event_id;
+    uint8_t topic;
+    uint8_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 32);
+
+constexpr size_t CRC_OFFSET = offsetof(RecordHeader, seq);
+
+constexpr std::array<uint32_t, 256> makeCrcTable()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = makeCrcTable();
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i)
+        crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t recordCrc(const RecordHeader& h, const uint8_t* payload)
+{
+    uint32_t crc = crc32(reinterpret_cast<const uint8_t*>(&h) + CRC_OFFSET,
+                         sizeof(RecordHeader) - CRC_OFFSET);
+    return crc32(payload, h.payload_len, crc);
+}
+
+uint32_t slotsFor(size_t payload_len, uint32_t slot_size)
+{
+    return (sizeof(RecordHeader) + payload_len + slot_size - 1) / slot_size;
+}
+
+/**
+ * Copies @p len bytes from @p src into the ring, starting at byte @p offset
+ * and wrapping around at @p ring_len.
+ */
+void ringWrite(uint8_t* ring, size_t ring_len, size_t offset,
+               const uint8_t* src, size_t len)
+{
+    size_t first = std::min(len, ring_len - offset);
+    memcpy(ring + offset, src, first);
+    memcpy(ring, src + first, len - first);
+}
+
+void ringRead(const uint8_t* ring, size_t ring_len, size_t offset,
+              uint8_t* dst, size_t len)
+{
+    size_t first = std::min(len, ring_len - offset);
+    memcpy(dst, ring + offset, first);
+    memcpy(dst + first, ring, len - first);
+}
+
+/**
+ * Parses all the valid records in the ring.
+ */
+vector<JournalRecord> parseRing(const uint8_t* ring, uint32_t num_slots,
+                                uint32_t slot_size)
+{
+    size_t ring_len = (size_t)num_slots * slot_size;
+    vector<JournalRecord> records;
+
+    for (uint32_t slot = 0; slot < num_slots; ++slot)
+    {
+        size_t offset = (size_t)slot * slot_size;
+
+        RecordHeader h;
+        memcpy(&h, ring + offset, sizeof(h));
+
+        if (h.magic != RECORD_MAGIC ||
+            slotsFor(h.payload_len, slot_size) > num_slots)
+            continue;
+
+        JournalRecord r;
+        r.seq          = h.seq;
+        r.timestamp_ns = h.timestamp_ns;
+        r.topic        = h.topic;
+        r.event_id     = h.event_id;
+        r.payload.resize(h.payload_len);
+
+        ringRead(ring, ring_len, (offset + sizeof(h)) % ring_len,
+                 r.payload.data(), h.payload_len);
+
+        if (recordCrc(h, r.payload.data()) != h.crc)
+            continue;
+
+        records.push_back(std::move(r));
+    }
+
+    std::sort(records.begin(), records.end(),
+              [](const JournalRecord& a, const JournalRecord& b)
+              { return a.seq < b.seq; });
+
+    return records;
+}
+
+uint64_t nowNs()
+{
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+EventPtr JournalRecord::toEvent() const
+{
+    return jsonToEvent(nlohmann::json::from_msgpack(payload));
+}
+
+EventJournal::EventJournal(string path, uint32_t num_slots, uint32_t slot_size,
+                           size_t queue_capacity)
+    : ActiveObject(ThreadSpecs::logging("journal")), path(path),
+      num_slots(num_slots), slot_size(slot_size),
+      queue_capacity(queue_capacity)
+{
+    if (num_slots == 0 || slot_size < sizeof(RecordHeader))
+        throw std::invalid_argument("Invalid journal geometry");
+
+    map_size = JOURNAL_HEADER_LEN + (size_t)num_slots * slot_size;
+
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(),
+                                "Cannot open journal " + path);
+
+    struct stat st;
+    bool resume = fstat(fd, &st) == 0 && (size_t)st.st_size == map_size;
+
+    if (ftruncate(fd, map_size) != 0)
+    {
+        int err = errno;
+        close(fd);
+        throw std::system_error(err, std::generic_category(),
+                                "Cannot resize journal " + path);
+    }
+
+    void* m = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                   0);
+    if (m == MAP_FAILED)
+    {
+        int err = errno;
+        close(fd);
+        throw std::system_error(err, std::generic_category(),
+                                "Cannot map journal " + path);
+    }
+    map = static_cast<uint8_t*>(m);
+
+    auto* header = reinterpret_cast<JournalFileHeader*>(map);
+    resume       = resume &&
+             memcmp(header->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0 &&
+             header->version == JOURNAL_VERSION &&
+             header->slot_size == slot_size && header->num_slots == num_slots;
+
+    if (resume)
+    {
+        // Continue after the most recent valid record
+        auto records = parseRing(map + JOURNAL_HEADER_LEN, num_slots, slot_size);
+        if (!records.empty())
+        {
+            const JournalRecord& last = records.back();
+            for (uint32_t slot = 0; slot < num_slots; ++slot)
+            {
+                RecordHeader h;
+                memcpy(&h, map + JOURNAL_HEADER_LEN + (size_t)slot * slot_size,
+                       sizeof(h));
+                if (h.magic == RECORD_MAGIC && h.seq == last.seq)
+                {
+                    next_slot = (slot + slotsFor(h.payload_len, slot_size)) %
+                                num_slots;
+                    break;
+                }
+            }
+            next_seq = last.seq + 1;
+        }
+    }
+    else
+    {
+        memset(map, 0, map_size);
+
+        JournalFileHeader h{};
+        memcpy(h.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        h.version    = JOURNAL_VERSION;
+        h.slot_size  = slot_size;
+        h.num_slots  = num_slots;
+        h.created_ns = nowNs();
+        memcpy(map, &h, sizeof(h));
+    }
+
+    start();
+}
+
+EventJournal::~EventJournal()
+{
+    stop();
+
+    if (map != nullptr)
+    {
+        msync(map, map_size, MS_SYNC);
+        munmap(map, map_size);
+    }
+    if (fd >= 0)
+        close(fd);
+}
+
+void EventJournal::append(const EventPtr& ev, uint8_t topic)
+{
+    PendingEvent p{ev, topic, nowNs()};
+
+    std::unique_lock<mutex> lock(mtx_queue);
+    if (queue.size() >= queue_capacity)
+    {
+        ++dropped;
+        return;
+    }
+    queue.push_back(std::move(p));
+    uint64_t ticket = ++num_queued;
+
+    // Once stopped, run() may have already returned
+    bool sync = accepting && topic < sync_topics.size() && sync_topics[topic];
+
+    lock.unlock();
+    cv_queue.notify_one();
+
+    if (sync)
+    {
+        lock.lock();
+        cv_drained.wait(lock, [&] { return num_written >= ticket; });
+    }
+}
+
+void EventJournal::setSyncTopics(const TopicMask& topics)
+{
+    lock_guard<mutex> lock(mtx_queue);
+    sync_topics = topics;
+}
+
+void EventJournal::flush()
+{
+    std::unique_lock<mutex> lock(mtx_queue);
+    cv_drained.wait(lock, [&] { return queue.empty() && in_flight == 0; });
+}
+
+uint64_t EventJournal::getDroppedCount()
+{
+    lock_guard<mutex> lock(mtx_queue);
+    return dropped;
+}
+
+void EventJournal::stop()
+{
+    {
+        lock_guard<mutex> lock(mtx_queue);
+        accepting = false;
+    }
+    cv_queue.notify_all();
+
+    // run() only returns once the queue is empty
+    ActiveObject::stop();
+}
+
+void EventJournal::run()
+{
+    deque<PendingEvent> batch;
+
+    std::unique_lock<mutex> lock(mtx_queue);
+    for (;;)
+    {
+        cv_queue.wait(lock, [&] { return !queue.empty() || !accepting; });
+
+        if (queue.empty())  // Stopped and fully drained
+            break;
+
+        batch.swap(queue);
+        in_flight = batch.size();
+        lock.unlock();
+
+        for (const PendingEvent& p : batch)
+            write(p);
+        batch.clear();
+
+        lock.lock();
+        num_written += in_flight;
+        in_flight    = 0;
+        cv_drained.notify_all();
+    }
+}
+
+void EventJournal::write(const PendingEvent& p)
+{
+    vector<uint8_t> payload = nlohmann::json::to_msgpack(p.ev->to_json());
+
+    if (slotsFor(payload.size(), slot_size) > num_slots)
+        return;
+
+    lock_guard<mutex> lock(mtx);
+    writeRecord(next_seq++, p.timestamp_ns, p.topic, p.ev->getID(), payload);
+}
+
+void EventJournal::writeRecord(uint64_t seq, uint64_t timestamp_ns,
+                               uint8_t topic, uint16_t event_id,
+                               const vector<uint8_t>& payload)
+{
+    uint8_t* ring   = map + JOURNAL_HEADER_LEN;
+    size_t ring_len = (size_t)num_slots * slot_size;
+    size_t offset   = (size_t)next_slot * slot_size;
+
+    RecordHeader h{};
+    h.seq          = seq;
+    h.timestamp_ns = timestamp_ns;
+    h.payload_len  = payload.size();
+    h.event_id     = event_id;
+    h.topic        = topic;
+    h.crc          = recordCrc(h, payload.data());
+
+    // Invalidate the slot before writing, then publish the magic last so that
+    // a record interrupted half way is never considered valid.
+    const uint32_t no_magic = 0;
+    memcpy(ring + offset, &no_magic, sizeof(no_magic));
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    ringWrite(ring, ring_len, (offset + sizeof(h)) % ring_len, payload.data(),
+              payload.size());
+    memcpy(ring + offset + sizeof(h.magic),
+           reinterpret_cast<const uint8_t*>(&h) + sizeof(h.magic),
+           sizeof(h) - sizeof(h.magic));
+
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    memcpy(ring + offset, &RECORD_MAGIC, sizeof(RECORD_MAGIC));
+
+    next_slot = (next_slot + slotsFor(payload.size(), slot_size)) % num_slots;
+}
+
+void EventJournal::sync()
+{
+    lock_guard<mutex> lock(mtx);
+    msync(map, map_size, MS_ASYNC);
+}
+
+vector<JournalRecord> EventJournal::read(string path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::system_error(errno, std::generic_category(),
+                                "Cannot open journal " + path);
+
+    vector<uint8_t> data{std::istreambuf_iterator<char>(in),
+                         std::istreambuf_iterator<char>()};
+
+    JournalFileHeader h;
+    if (data.size() < sizeof(h))
+        throw std::runtime_error("Not a journal file: " + path);
+
+    memcpy(&h, data.data(), sizeof(h));
+    if (memcmp(h.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+        h.version != JOURNAL_VERSION || h.slot_size < sizeof(RecordHeader) ||
+        data.size() < JOURNAL_HEADER_LEN + (size_t)h.num_slots * h.slot_size)
+    {
+        throw std::runtime_error("Not a journal file: " + path);
+    }
+
+    return parseRing(data.data() + JOURNAL_HEADER_LEN, h.num_slots,
+                     h.slot_size);
+}
+
+size_t replayJournal(EventBroker& broker, const vector<JournalRecord>& records,
+                     float speed)
+{
+    PrintLogger log = Logging::getLogger("Replay");
+
+    if (records.empty())
+        return 0;
+
+    size_t posted = 0;
+    uint64_t t0   = records.front().timestamp_ns;
+    auto start    = steady_clock::now();
+
+    for (const JournalRecord& r : records)
+    {
+        if (speed > 0 && r.timestamp_ns > t0)
+        {
+            auto offset = nanoseconds((int64_t)((r.timestamp_ns - t0) / speed));
+            std::this_thread::sleep_until(start + offset);
+        }
+
+        try
+        {
+            broker.post(r.toEvent(), r.topic);
+            ++posted;
+        }
+        catch (std::exception& e)
+        {
+            LOG_ERR(log, "Cannot decode record {} (event id {}): {}", r.seq,
+                    r.event_id, e.what());
+        }
+    }
+
+    return posted;
+}
@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "EventBase.h"
+#include "EventBroker.h"
+#include "utils/ActiveObject.h"
+
+using std::condition_variable;
+using std::deque;
+using std::mutex;
+using std::string;
+using std::vector;
+
+/**
+ * A single event read back from a journal file.
+ */
+struct JournalRecord
+{
+    uint64_t seq;
+    uint64_t timestamp_ns;  // Wall clock time when the event was posted
+    uint8_t topic;
+    uint16_t event_id;
+    vector<uint8_t> payload;  // Event serialized with MessagePack
+
+    /**
+     * @brief Deserializes the payload into an event.
+     * @throw nlohmann::json::exception, std::out_of_range
+     */
+    EventPtr toEvent() const;
+};
+
+/**
+ * Append-only journal of the events posted on the broker, stored in a
+ * memory-mapped ring file.
+ *
+ * The file is divided in fixed size slots. Each record starts on a slot and
+ * spans as many consecutive slots as needed; when the end of the file is
+ * reached the oldest records are overwritten. Every record carries a sequence
+ * number and a checksum, so records torn by a crash or partially overwritten
+ * are discarded when reading the file back. Since the mapping is shared, the
+ * data written before a crash of the process is preserved by the kernel.
+ *
+ * Events are serialized and written by a thread of the journal, so that
+ * append() can be called from the broker on every post without slowing down
+ * the publisher. Until then they are only in memory and are lost if the
+ * process crashes: the thread wakes up on every append(), so these are only
+ * the events appended while it was writing the previous ones, at most
+ * queue_capacity.
+ * Events on the topics set with setSyncTopics() are written before append()
+ * returns: none of them is lost, at the cost of blocking the publisher.
+ */
+class EventJournal final : private ActiveObject
+{
+public:
+    /**
+     * @brief Opens or creates a journal file. If the file already contains a
+     * journal with the same geometry, new records are appended after the
+     * existing ones.
+     *
+     * @throw std::system_error if the file cannot be created or mapped
+     * @param path Path of the journal file
+     * @param num_slots Number of slots in the ring
+     * @param slot_size Size of each slot in bytes
+     * @param queue_capacity Maximum number of events waiting to be written
+     */
+    EventJournal(string path, uint32_t num_slots = DEFAULT_NUM_SLOTS,
+                 uint32_t slot_size    = DEFAULT_SLOT_SIZE,
+                 size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+
+    /**
+     * @brief Writes the events still in the queue, then closes the file.
+     */
+    ~EventJournal();
+
+    EventJournal(const EventJournal&) = delete;
+    EventJournal& operator=(const EventJournal&) = delete;
+
+    /**
+     * @brief Queues an event to be appended to the journal. Thread safe and
+     * never blocks on the file: if the writer falls behind and the queue is
+     * full, the event is dropped and counted.
+     * Events larger than the whole ring are not recorded.
+     */
+    void append(const EventPtr& ev, uint8_t topic);
+
+    /**
+     * @brief Sets the topics whose events are written before append()
+     * returns. Meant for the low rate topics that must survive a crash.
+     */
+    void setSyncTopics(const TopicMask& topics);
+
+    /**
+     * @brief Blocks until every event appended before this call has been
+     * written to the ring.
+     */
+    void flush();
+
+    /**
+     * @brief Number of events dropped because the queue was full
+     */
+    uint64_t getDroppedCount();
+
+    /**
+     * @brief Schedules the write-back of the mapped pages to disk, to survive
+     * a power loss as well as a crash of the process.
+     */
+    void sync();
+
+    /**
+     * @brief Reads all the valid records in a journal file, ordered by
+     * sequence number.
+     *
+     * @throw std::system_error if the file cannot be read
+     * @throw std::runtime_error if the file is not a valid journal
+     */
+    static vector<JournalRecord> read(string path);
+
+    static constexpr uint32_t DEFAULT_NUM_SLOTS = 16384;
+    static constexpr uint32_t DEFAULT_SLOT_SIZE = 256;
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+
+private:
+    struct PendingEvent
+    {
+        EventPtr ev;
+        uint8_t topic;
+        uint64_t timestamp_ns;
+    };
+
+    void run() override;
+    void stop() override;
+
+    void write(const PendingEvent& p);
+
+    void writeRecord(uint64_t seq, uint64_t timestamp_ns, uint8_t topic,
+                     uint16_t event_id, const vector<uint8_t>& payload);
+
+    string path;
+    uint32_t num_slots;
+    uint32_t slot_size;
+
+    int fd             = -1;
+    uint8_t* map       = nullptr;
+    size_t map_size    = 0;
+    uint64_t next_seq  = 0;
+    uint32_t next_slot = 0;
+
+    // Protects the mapping
+    mutex mtx;
+
+    size_t queue_capacity;
+    deque<PendingEvent> queue;
+    size_t in_flight     = 0;
+    uint64_t dropped     = 0;
+    uint64_t num_queued  = 0;  // Events ever queued
+    uint64_t num_written = 0;  // Events ever taken out of the queue
+    bool accepting       = true;  // False once stop() has been called
+    TopicMask sync_topics;
+    mutex mtx_queue;
+    condition_variable cv_queue;
+    condition_variable cv_drained;
+};
+
+/**
+ * @brief Posts the events in @p records on @p broker, respecting the original
+ * time between them.
+ *
+ * @param broker Broker where to post the events
+ * @param records Records returned by EventJournal::read()
+ * @param speed Replay speed multiplier. Values <= 0 replay the events as
+ * fast as possible
+ * @return Number of events posted
+ */
+size_t replayJournal(EventBroker& broker, const vector<JournalRecord>& records,
+                     float speed = 1.0f);
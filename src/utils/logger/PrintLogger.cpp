@@ -116,31 +116,199 @@ void Logging::log(const LogRecord& record)
     }
 }
 
-void Logging::logAsync(const LogRecord& record) { asyncLog.log(record); }
+void Logging::logAsync(LogRecord&& record)
+{
+    asyncLog.log(std::move(record));
+}
+
+Logging::AsyncLogger::AsyncLogger(Logging& parent)
+    : ActiveObject(ThreadSpecs::logging("log")), parent(parent)
+{
+}
 
-Logging::AsyncLogger::AsyncLogger(Logging& parent) : parent(parent) {}
+Logging::AsyncLogger::~AsyncLogger() { stop(); }
 
-void Logging::AsyncLogger::log(const LogRecord& record)
+bool Logging::AsyncLogger::start(AsyncLogConfig config)
 {
+    if (started || stopped || config.capacity == 0 ||
+        config.num_consumers == 0)
+    {
+        return false;
+    }
+
+    // Treat an interval of 0 as 1 instead of dividing by zero in log()
+    if (config.sample_interval == 0)
+        config.sample_interval = 1;
+
+    // Same for a batch of 0, which would never drain the buffer
+    if (config.max_batch == 0)
+        config.max_batch = 1;
+
     {
         lock_guard<mutex> guard(mutex_log);
-        records.put(record);
+        this->config = config;
+        records.resize(config.capacity);
+        accepting = true;
+    }
+
+    ActiveObject::start();
+
+    for (unsigned int i = 1; i < config.num_consumers; ++i)
+    {
+        consumers.push_back(std::make_unique<Consumer>(*this));
+        consumers.back()->setThreadSpec(
+            ThreadSpecs::logging(fmt::format("log-{}", i)));
+        consumers.back()->start();
     }
 
-    cv.notify_all();
+    return true;
 }
 
-void Logging::AsyncLogger::run()
+void Logging::AsyncLogger::stop()
 {
-    while (!shouldStop())
+    if (started && !stopped)
     {
-        LogRecord rec;
         {
-            unique_lock<mutex> lk(mutex_log);
-            cv.wait(lk, [&] { return !records.isEmpty(); });
-            rec = records.pop();
+            lock_guard<mutex> guard(mutex_log);
+            accepting = false;
         }
+        cv_not_empty.notify_all();
+        cv_not_full.notify_all();
 
-        parent.log(rec);
+        // Consumers only return once the queue is empty
+        for (auto& c : consumers)
+        {
+            c->stop();
+        }
+
+        should_stop = true;
+        if (thread_obj->joinable())
+            thread_obj->join();
+        stopped = true;
     }
 }
+
+void Logging::AsyncLogger::flush()
+{
+    unique_lock<mutex> lk(mutex_log);
+    cv_drained.wait(lk, [&] { return count == 0 && in_flight == 0; });
+}
+
+void Logging::AsyncLogger::log(LogRecord&& record)
+{
+    unique_lock<mutex> lk(mutex_log);
+
+    if (accepting && count == records.size())
+    {
+        switch (config.policy)
+        {
+            case AsyncLogOverflowPolicy::BLOCK:
+                cv_not_full.wait(lk, [&] {
+                    return !accepting || count < records.size();
+                });
+                break;
+            case AsyncLogOverflowPolicy::DROP:
+                ++dropped;
+                ++dropped_pending;
+                return;
+            case AsyncLogOverflowPolicy::SAMPLE:
+                ++dropped;
+                ++dropped_pending;
+                if (num_overflows++ % config.sample_interval != 0)
+                    return;
+
+                // Make room for the sampled record
+                pop();
+                break;
+        }
+    }
+
+    if (!accepting)
+    {
+        // Not started or already stopped: do not lose the record
+        lk.unlock();
+        parent.log(record);
+        return;
+    }
+
+    push(std::move(record));
+
+    bool wake = waiting_consumers > 0;
+    lk.unlock();
+
+    if (wake)
+        cv_not_empty.notify_one();
+}
+
+void Logging::AsyncLogger::run() { drain(); }
+
+void Logging::AsyncLogger::drain()
+{
+    vector<LogRecord> batch;
+    batch.reserve(config.max_batch);
+
+    unique_lock<mutex> lk(mutex_log);
+    for (;;)
+    {
+        ++waiting_consumers;
+        cv_not_empty.wait(lk, [&] { return count > 0 || !accepting; });
+        --waiting_consumers;
+
+        if (count == 0)  // Stopped and fully drained
+            break;
+
+        size_t n = std::min(count, config.max_batch);
+        for (size_t i = 0; i < n; ++i)
+        {
+            batch.push_back(std::move(pop()));
+        }
+        in_flight += n;
+
+        uint64_t num_dropped = dropped_pending;
+        dropped_pending      = 0;
+
+        lk.unlock();
+        cv_not_full.notify_all();
+
+        if (num_dropped > 0)
+        {
+            LogRecord rec;
+            rec.created  = (high_resolution_clock::now().time_since_epoch() /
+                           milliseconds(1)) /
+                          1000.0;
+            rec.level    = LOGL_WARNING;
+            rec.function = __FUNCTION__;
+            rec.file     = __FILE__;
+            rec.line     = __LINE__;
+            rec.name     = "Logging";
+            rec.message =
+                fmt::format("{} async log records dropped", num_dropped);
+            parent.log(rec);
+        }
+
+        for (auto& rec : batch)
+        {
+            parent.log(rec);
+        }
+        batch.clear();
+
+        lk.lock();
+        in_flight -= n;
+        if (count == 0 && in_flight == 0)
+            cv_drained.notify_all();
+    }
+}
+
+void Logging::AsyncLogger::push(LogRecord&& record)
+{
+    records[(read_ptr + count) % records.size()] = std::move(record);
+    ++count;
+}
+
+LogRecord& Logging::AsyncLogger::pop()
+{
+    LogRecord& rec = records[read_ptr];
+    read_ptr       = (read_ptr + 1) % records.size();
+    --count;
+    return rec;
+}
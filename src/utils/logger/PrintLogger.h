@@ -26,8 +26,8 @@
 #include <fmt/format.h>
 #include <utils/ActiveObject.h>
 #include <utils/Singleton.h>
-#include <utils/collections/CircularBuffer.h>
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -45,7 +45,28 @@ using std::vector;
 #define DEFAULT_STDOUT_LOG_LEVEL 0
 #endif
 
-static constexpr unsigned int ASYNC_LOG_BUFFER_SIZE = 100;
+static constexpr unsigned int ASYNC_LOG_BUFFER_SIZE = 4096;
+
+/**
+ * @brief What the async logger should do with a new record when its queue is
+ * full.
+ */
+enum class AsyncLogOverflowPolicy : uint8_t
+{
+    BLOCK,  // Block the caller until there is room in the queue
+    DROP,   // Discard the new record
+    SAMPLE  // Keep one record every `sample_interval` (0 is treated as 1),
+            // evicting the oldest
+};
+
+struct AsyncLogConfig
+{
+    size_t capacity               = ASYNC_LOG_BUFFER_SIZE;
+    AsyncLogOverflowPolicy policy = AsyncLogOverflowPolicy::BLOCK;
+    unsigned int sample_interval  = 100;
+    unsigned int num_consumers    = 1;
+    size_t max_batch              = 64;  // Records per write, 0 is treated as 1
+};
 
 class Logging;
 
@@ -113,26 +134,108 @@ public:
 
     static LogSink& getStdOutLogSink() { return *getInstance().sinks.at(0); }
 
-    static void startAsyncLogger() { getInstance().asyncLog.start(); }
+    /**
+     * @brief Starts the async logger. Must be called before adding any
+     * additional sink, as the sink list is not protected by a mutex.
+     *
+     * @param config Queue capacity, overflow policy and number of consumers.
+     * Ignored if the async logger is already running.
+     */
+    static void startAsyncLogger(AsyncLogConfig config = {})
+    {
+        getInstance().asyncLog.start(config);
+    }
+
+    /**
+     * @brief Drains all the pending async records and stops the consumers.
+     * Records logged asynchronously after this call are logged synchronously.
+     */
+    static void stopAsyncLogger() { getInstance().asyncLog.stop(); }
+
+    /**
+     * @brief Blocks until every async record logged before this call has been
+     * written to the sinks.
+     */
+    static void flushAsyncLogger() { getInstance().asyncLog.flush(); }
+
+    /**
+     * @brief Number of async records discarded due to the overflow policy.
+     */
+    static uint64_t getAsyncDroppedCount()
+    {
+        return getInstance().asyncLog.getDroppedCount();
+    }
+
+    ~Logging() { asyncLog.stop(); }
 
 private:
     void log(const LogRecord& record);
-    void logAsync(const LogRecord& record);
+    void logAsync(LogRecord&& record);
 
+    /**
+     * Bounded MPMC queue of log records. Producers only take the lock to
+     * enqueue a record, consumers drain it in batches and write the records
+     * to the sinks without holding the lock.
+     */
     class AsyncLogger : public ActiveObject
     {
     public:
         explicit AsyncLogger(Logging& parent);
-        void log(const LogRecord& record);
+        ~AsyncLogger();
+
+        bool start() override { return start(config); }
+        bool start(AsyncLogConfig config);
+        void stop() override;
+        void flush();
+
+        void log(LogRecord&& record);
+
+        uint64_t getDroppedCount() { return dropped; }
 
     protected:
         void run() override;
 
     private:
+        /**
+         * Additional consumer thread draining the same queue.
+         */
+        class Consumer : public ActiveObject
+        {
+        public:
+            explicit Consumer(AsyncLogger& parent) : parent(parent) {}
+            ~Consumer() { stop(); }
+
+        protected:
+            void run() override { parent.drain(); }
+
+        private:
+            AsyncLogger& parent;
+        };
+
+        void drain();
+        void push(LogRecord&& record);
+        LogRecord& pop();
+
         Logging& parent;
-        CircularBuffer<LogRecord, ASYNC_LOG_BUFFER_SIZE> records;
+        AsyncLogConfig config;
+
+        vector<LogRecord> records;
+        size_t read_ptr          = 0;
+        size_t count             = 0;
+        size_t in_flight         = 0;
+        uint64_t num_overflows   = 0;
+        uint64_t dropped_pending = 0;
+
+        std::atomic<uint64_t> dropped  = 0;
+        bool accepting                 = false;
+        unsigned int waiting_consumers = 0;
+
         std::mutex mutex_log;
-        std::condition_variable cv;
+        std::condition_variable cv_not_empty;
+        std::condition_variable cv_not_full;
+        std::condition_variable cv_drained;
+
+        vector<unique_ptr<Consumer>> consumers;
     };
 
     Logging() : asyncLog(*this)
@@ -36,7 +36,8 @@ using std::chrono::milliseconds;
 using std::this_thread::sleep_for;
 
 TcpLogSink::TcpLogSink(string ip, uint16_t port)
-    : ip(ip), port(port), sockInit(), conn()
+    : ActiveObject(ThreadSpecs::logging("tcp-log")), ip(ip), port(port),
+      sockInit(), conn()
 {
     start();
 }
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "PrintLogger.h"
+
+using std::make_shared;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+static constexpr int NUM_THREADS        = 4;
+static constexpr int RECORDS_PER_THREAD = 250000;
+
+/**
+ * Sink that only counts the records it receives.
+ */
+class CountingLogSink : public LogSink
+{
+public:
+    std::atomic<uint64_t> num_records = 0;
+
+protected:
+    void logImpl(const LogRecord& record) override { ++num_records; }
+};
+
+/**
+ * Logs 1M records from 4 threads through the async logger.
+ * Usage: test_async_log_bench [block|drop|sample] [num_consumers]
+ */
+int main(int argc, char* argv[])
+{
+    AsyncLogConfig cfg{};
+    if (argc > 1 && strcmp(argv[1], "drop") == 0)
+        cfg.policy = AsyncLogOverflowPolicy::DROP;
+    else if (argc > 1 && strcmp(argv[1], "sample") == 0)
+        cfg.policy = AsyncLogOverflowPolicy::SAMPLE;
+
+    if (argc > 2)
+        cfg.num_consumers = std::atoi(argv[2]);
+
+    Logging::getStdOutLogSink().disable();
+
+    auto sink = make_shared<CountingLogSink>();
+    Logging::addLogSink(sink);
+    Logging::startAsyncLogger(cfg);
+
+    auto start = steady_clock::now();
+
+    vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t)
+    {
+        threads.emplace_back([t] {
+            PrintLogger log = Logging::getLogger(fmt::format("bench{}", t));
+            for (int i = 0; i < RECORDS_PER_THREAD; ++i)
+            {
+                LOG_INFO_ASYNC(log, "Record {} from thread {}", i, t);
+            }
+        });
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    auto produced = steady_clock::now();
+
+    Logging::stopAsyncLogger();
+
+    auto drained = steady_clock::now();
+
+    uint64_t total   = (uint64_t)NUM_THREADS * RECORDS_PER_THREAD;
+    uint64_t dropped = Logging::getAsyncDroppedCount();
+
+    double t_prod  = duration<double>(produced - start).count();
+    double t_total = duration<double>(drained - start).count();
+
+    fmt::print("records: {}, dropped: {}, received: {}\n", total, dropped,
+               sink->num_records.load());
+    fmt::print("produce: {:.3f} s ({:.0f} rec/s), drain: {:.3f} s ({:.0f} "
+               "rec/s)\n",
+               t_prod, total / t_prod, t_total, total / t_total);
+
+    // Every record must either reach the sink or be counted as dropped. The
+    // sink may also receive the "records dropped" warnings.
+    assert(sink->num_records >= total - dropped);
+    if (cfg.policy == AsyncLogOverflowPolicy::BLOCK)
+        assert(dropped == 0 && sink->num_records == total);
+
+    return 0;
+}
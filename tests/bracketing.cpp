@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "event_waiter.h"
+#include "fsm/CameraController.h"
+#include "fsm/modes/Bracketing.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using std::function;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+static constexpr int NUM_FRAMES = 5;
+
+EventWaiter waiter;
+int ready_count   = 0;
+int started_count = 0;
+int stopped_count = 0;
+EventBracketingState last_state;
+
+/**
+ * Runs a bracket and returns the final state reported by the mode.
+ * @param during Called once the bracket has been started
+ */
+EventBracketingState runBracket(bool pipelined,
+                                function<void()> during = [] {})
+{
+    static int num_runs = 0;
+
+    sBroker.post(EventBracketingStart{NUM_FRAMES, 1.0f, pipelined},
+                 TOPIC_MODE_FSM);
+    during();
+    assert(waiter.waitFor(stopped_count, ++num_runs, seconds(10)));
+
+    // Let the initial settings be restored
+    std::this_thread::sleep_for(milliseconds(100));
+
+    unique_lock<mutex> lock(waiter.mtx);
+
+    fmt::print("pipelined: {}, shutter speeds: {}, time: {} ms\n", pipelined,
+               last_state.shutter_speeds, last_state.bracket_time_ms);
+    return last_state;
+}
+
+int main()
+{
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+    sBroker.start();
+
+    EventSniffer sniffer{
+        sEventBroker,
+        {TOPIC_MODE_STATE, TOPIC_MODE_CONTROLLER, TOPIC_CAMERA_EVENT},
+        [&](const EventPtr& ev, uint8_t topic)
+        {
+            {
+                unique_lock<mutex> lock(waiter.mtx);
+                if (ev->getID() == EventBracketingState::id)
+                    last_state =
+                        *dynamic_pointer_cast<const EventBracketingState>(ev);
+                if (ev->getID() == EventModeStopped::id)
+                    ++stopped_count;
+                if (ev->getID() == EventCameraReady::id)
+                    ++ready_count;
+                if (ev->getID() == EventCameraCaptureStarted::id)
+                    ++started_count;
+            }
+            waiter.cv.notify_all();
+        }};
+
+    // Reading the whole configuration takes more than 10 config round trips
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time  = milliseconds(1);
+    cfg.config_rtt    = milliseconds(10);
+    cfg.capture_time  = milliseconds(50);
+    cfg.wait_exposure = false;
+
+    auto sim             = make_unique<SimulatedCamera>(cfg);
+    SimulatedCamera& cam = *sim;
+
+    CameraController controller{"/tmp", std::move(sim)};
+    Bracketing bracketing{};
+    controller.start();
+    bracketing.start();
+
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, 1));
+
+    int32_t base = cam.getShutterSpeed().shutter_speed;
+
+    auto seq  = runBracket(false);
+    auto pipe = runBracket(true);
+
+    for (auto& s : {seq, pipe})
+    {
+        assert(s.num_captures == NUM_FRAMES);
+        assert(s.shutter_speeds.size() == NUM_FRAMES);
+        // Darkest to brightest, centered on the initial shutter speed
+        for (int i = 1; i < NUM_FRAMES; ++i)
+            assert(s.shutter_speeds[i] > s.shutter_speeds[i - 1]);
+        assert(s.shutter_speeds[NUM_FRAMES / 2] == base);
+
+        // A capture and a config write per frame, without reading the whole
+        // configuration in between
+        assert(s.bracket_time_ms < NUM_FRAMES * (50 + 5 * 10));
+    }
+
+    // Initial shutter speed restored
+    assert(cam.getShutterSpeed().shutter_speed == base);
+
+    // The early write for the second frame is refused while the first one is
+    // being captured: it is written again before capturing the frame, instead
+    // of taking it at the wrong exposure and then again
+    uint64_t captures = cam.getStats().captures;
+    int started       = 0;
+    {
+        unique_lock<mutex> lock(waiter.mtx);
+        started = started_count;
+    }
+    auto fallback = runBracket(true, [&] {
+        assert(waiter.waitFor(started_count, started + 1));
+        cam.setExposureLocked(true);
+        std::this_thread::sleep_for(milliseconds(500));
+        cam.setExposureLocked(false);
+    });
+    assert(fallback.num_captures == NUM_FRAMES);
+    assert(!fallback.pipelined);
+    assert(fallback.shutter_speeds.size() == NUM_FRAMES);
+    for (int i = 0; i < NUM_FRAMES; ++i)
+        assert(fallback.shutter_speeds[i] == seq.shutter_speeds[i]);
+    assert(cam.getStats().captures == captures + NUM_FRAMES);
+    assert(cam.getShutterSpeed().shutter_speed == base);
+
+    // Every write is refused: the bracket is aborted instead of waiting for
+    // a confirmation that never comes
+    cam.setExposureLocked(true);
+    auto aborted = runBracket(false);
+    assert(aborted.state == "Aborted");
+    assert(aborted.num_captures == 0);
+    assert(cam.getStats().captures == 3 * NUM_FRAMES);
+    cam.setExposureLocked(false);
+
+    bracketing.stop();
+    controller.stop();
+    sBroker.stop();
+
+    fmt::print("Bracketing OK\n");
+    return 0;
+}
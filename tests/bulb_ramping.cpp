@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "event_waiter.h"
+#include "fsm/CameraController.h"
+#include "fsm/modes/BulbRamping.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+static constexpr int NUM_FRAMES  = 4;
+static constexpr int INTERVAL_MS = 300;
+
+EventWaiter waiter;
+int ready_count   = 0;
+int stopped_count = 0;
+EventBulbRampingState last_state;
+
+int main()
+{
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_ERROR);
+    sBroker.start();
+
+    EventSniffer sniffer{
+        sEventBroker,
+        {TOPIC_MODE_STATE, TOPIC_MODE_CONTROLLER, TOPIC_CAMERA_EVENT},
+        [&](const EventPtr& ev, uint8_t topic)
+        {
+            {
+                unique_lock<mutex> lock(waiter.mtx);
+                if (ev->getID() == EventBulbRampingState::id)
+                    last_state =
+                        *dynamic_pointer_cast<const EventBulbRampingState>(ev);
+                if (ev->getID() == EventModeStopped::id)
+                    ++stopped_count;
+                if (ev->getID() == EventCameraReady::id)
+                    ++ready_count;
+            }
+            waiter.cv.notify_all();
+        }};
+
+    // The scene is getting darker: the planner changes the exposure before
+    // every frame
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time  = milliseconds(1);
+    cfg.config_rtt    = milliseconds(5);
+    cfg.capture_time  = milliseconds(20);
+    cfg.wait_exposure = false;
+    cfg.light_meter   = -3;
+
+    auto sim             = make_unique<SimulatedCamera>(cfg);
+    SimulatedCamera& cam = *sim;
+
+    CameraController controller{"/tmp", std::move(sim)};
+    BulbRamping ramping{};
+    controller.start();
+    ramping.start();
+
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, 1));
+
+    // Every write is refused: the camera controller sends no reply, the mode
+    // must give up on them and keep capturing. In low latency the controller
+    // does not read the whole configuration after a capture, which would
+    // answer some of them.
+    cam.setExposureLocked(true);
+    sBroker.post(EventCameraCmdLowLatency{true}, TOPIC_CAMERA_CMD);
+
+    sBroker.post(EventBulbRampingStart{INTERVAL_MS, NUM_FRAMES, 1.0f, 6400},
+                 TOPIC_MODE_FSM);
+    assert(waiter.waitFor(stopped_count, 1, seconds(15)));
+
+    // The final state is posted after the mode stopped
+    std::this_thread::sleep_for(milliseconds(100));
+    {
+        unique_lock<mutex> lock(waiter.mtx);
+        fmt::print("captures: {}, late writes: {}, overrun: {} ms\n",
+                   last_state.num_captures, last_state.late_writes,
+                   last_state.write_overrun_ms);
+
+        assert(last_state.num_captures == NUM_FRAMES);
+        // The writes before each frame but the first timed out
+        assert(last_state.late_writes == NUM_FRAMES - 1);
+    }
+    assert(cam.getStats().captures == NUM_FRAMES);
+
+    ramping.stop();
+    controller.stop();
+    sBroker.stop();
+
+    fmt::print("Bulb ramping OK\n");
+    return 0;
+}
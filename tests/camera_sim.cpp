@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "camera/CameraExceptions.h"
+#include "camera/SimulatedCamera.h"
+#include "event_waiter.h"
+#include "fsm/CameraController.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::chrono::milliseconds;
+
+static constexpr int NUM_CAPTURES = 5;
+
+EventWaiter waiter;
+int ready_count   = 0;
+int capture_count = 0;
+int iso_count     = 0;
+int32_t last_iso  = 0;
+
+void testFailureInjection()
+{
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time = milliseconds(0);
+    cfg.config_rtt   = milliseconds(0);
+    cfg.failure_rate = 0.5f;
+    cfg.seed         = 42;
+
+    SimulatedCamera cam{cfg};
+
+    int failures = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        try
+        {
+            cam.connect();
+            cam.getISO();
+        }
+        catch (GPhotoError& gpe)
+        {
+            ++failures;
+        }
+    }
+
+    assert(failures > 0 && failures < 100);
+    assert(cam.getStats().failures == (uint64_t)failures);
+}
+
+int main()
+{
+    testFailureInjection();
+
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+    sBroker.start();
+
+    EventSniffer sniffer{sEventBroker,
+                         {TOPIC_CAMERA_EVENT, TOPIC_CAMERA_CONFIG},
+                         [&](const EventPtr& ev, uint8_t topic)
+                         {
+                             {
+                                 unique_lock<mutex> lock(waiter.mtx);
+                                 if (ev->getID() == EventCameraReady::id)
+                                     ++ready_count;
+                                 if (ev->getID() == EventCameraCaptureDone::id)
+                                     ++capture_count;
+                                 if (ev->getID() == EventConfigValueISO::id)
+                                 {
+                                     ++iso_count;
+                                     last_iso = dynamic_pointer_cast<
+                                                    const EventConfigValueISO>(
+                                                    ev)
+                                                    ->iso;
+                                 }
+                             }
+                             waiter.cv.notify_all();
+                         }};
+
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time   = milliseconds(1);
+    cfg.config_rtt     = milliseconds(1);
+    cfg.capture_time   = milliseconds(5);
+    cfg.wait_exposure  = false;
+    cfg.file_size      = 1000000;
+    cfg.usb_throughput = 100000000;
+
+    auto sim             = make_unique<SimulatedCamera>(cfg);
+    SimulatedCamera& cam = *sim;
+
+    CameraController controller{"/tmp", std::move(sim)};
+    controller.start();
+
+    sBroker.post(EventCameraCmdDownload{true}, TOPIC_CAMERA_CMD);
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, 1));
+    assert(cam.isConnected());
+
+    // Let the controller read the whole configuration once
+    std::this_thread::sleep_for(milliseconds(100));
+    uint64_t connect_ops = cam.getStats().config_ops;
+
+    for (int i = 1; i <= NUM_CAPTURES; ++i)
+    {
+        assert(waiter.waitFor(ready_count, i));
+        sBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+        assert(waiter.waitFor(capture_count, i));
+    }
+
+    assert(cam.getStats().captures == NUM_CAPTURES);
+    assert(cam.getStats().downloads == NUM_CAPTURES);
+    assert(cam.getStats().bytes_downloaded == NUM_CAPTURES * cfg.file_size);
+    // Only the battery and the light meter are read again after each capture
+    assert(cam.getStats().config_ops <= connect_ops + NUM_CAPTURES * 3);
+
+    // Settings changed on the body are read again
+    int isos        = iso_count;
+    int32_t old_iso = last_iso;
+    cam.simulateBodyChange();
+    assert(waiter.waitFor(iso_count, isos + 1));
+    assert(last_iso != old_iso);
+
+    controller.stop();
+    sBroker.stop();
+
+    fmt::print("Simulated camera OK\n");
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <memory>
+
+#include "Events.h"
+#include "comm/ConfigSnapshot.h"
+
+using nlohmann::json;
+using std::make_shared;
+
+int main()
+{
+    ConfigSnapshot snap;
+    assert(snap.getVersion() == 0);
+
+    assert(snap.update(make_shared<EventConfigValueISO>(100)));
+    assert(snap.update(make_shared<EventConfigValueAperture>(56)));
+    assert(snap.update(make_shared<EventConfigChoicesISO>(
+        std::vector<int32_t>{100, 200, 400})));
+    assert(snap.getVersion() == 3);
+
+    // Same value: no new version
+    assert(!snap.update(make_shared<EventConfigValueISO>(100)));
+    assert(snap.getVersion() == 3);
+
+    json full = snap.changesSince(0, 0)["config_sync"];
+    assert(full["full"] == true);
+    assert(full["version"] == 3);
+    assert(full["epoch"] == snap.getEpoch());
+    assert(full["changes"].size() == 3);
+
+    uint64_t epoch = snap.getEpoch();
+
+    // Up to date client: nothing to send
+    json delta = snap.changesSince(epoch, 3)["config_sync"];
+    assert(delta["full"] == false);
+    assert(delta["changes"].empty());
+
+    assert(snap.update(make_shared<EventConfigValueISO>(800)));
+    assert(snap.update(make_shared<EventConfigValueAperture>(80)));
+
+    delta = snap.changesSince(epoch, 3)["config_sync"];
+    assert(delta["full"] == false);
+    assert(delta["version"] == 5);
+    assert(delta["changes"].size() == 2);
+    assert(delta["changes"][0]["event_id"] == EventConfigValueISO::id);
+    assert(delta["changes"][0]["iso"] == 800);
+    assert(delta["changes"][1]["aperture"] == 80);
+
+    // Only the latest change of each value is sent
+    delta = snap.changesSince(epoch, 4)["config_sync"];
+    assert(delta["changes"].size() == 1);
+
+    // Versions from the future or from another epoch: full state
+    assert(snap.changesSince(epoch, 10)["config_sync"]["full"] == true);
+    assert(snap.changesSince(epoch + 1, 4)["config_sync"]["changes"].size() ==
+           3);
+
+    fmt::print("ConfigSnapshot OK\n");
+    return 0;
+}
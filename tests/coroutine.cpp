@@ -0,0 +1,288 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "events/HSM.h"
+#include "fsm/CameraController.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using std::atomic;
+using std::condition_variable;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+static constexpr int OPERATION_MS = 100;
+static constexpr int NUM_QUERIES  = 5;
+
+/**
+ * Starts a coroutine on EventCameraCmdCapture, counts the
+ * EventGetCameraControllerState handled while it is suspended
+ */
+class CoroutineHsm : public HSM<CoroutineHsm>
+{
+public:
+    CoroutineHsm() : HSM(&CoroutineHsm::stateInit) {}
+
+    State stateInit(const EventPtr& ev)
+    {
+        return transition(&CoroutineHsm::stateIdle);
+    }
+
+    State stateIdle(const EventPtr& ev)
+    {
+        switch (ev->getID())
+        {
+            case EventCameraCmdCapture::id:
+                hsm_thread = std::this_thread::get_id();
+                work();
+                break;
+            case EventGetCameraControllerState::id:
+                if (!done)
+                    ++queries;
+                break;
+            case EventCameraOpDone_Internal::id:
+            {
+                unique_lock<mutex> lock(mtx);
+                success =
+                    dynamic_pointer_cast<const EventCameraOpDone_Internal>(ev)
+                        ->success;
+                done = true;
+                cv.notify_all();
+                break;
+            }
+            case EventCameraCmdDisconnect::id:
+                sleepForever();
+                break;
+            default:
+                return tran_super(&CoroutineHsm::Hsm_top);
+        }
+        return HANDLED;
+    }
+
+    bool waitDone()
+    {
+        unique_lock<mutex> lock(mtx);
+        return cv.wait_for(lock, seconds(5), [&] { return done.load(); });
+    }
+
+    atomic<int> queries{0};
+    atomic<bool> done{false};
+    bool success = false;
+    bool resumed_on_hsm_thread = false;
+    atomic<int> destroyed{0};
+
+private:
+    struct Guard
+    {
+        atomic<int>& destroyed;
+        ~Guard() { ++destroyed; }
+    };
+
+    StateTask work()
+    {
+        co_await coroutines.sleepFor(milliseconds(10));
+
+        int value = co_await coroutines.offload(
+            [&]
+            {
+                std::this_thread::sleep_for(milliseconds(OPERATION_MS));
+                return 42;
+            });
+        resumed_on_hsm_thread = std::this_thread::get_id() == hsm_thread;
+
+        bool caught = false;
+        try
+        {
+            co_await coroutines.offload(
+                [&] { throw std::runtime_error("camera error"); });
+        }
+        catch (std::runtime_error& e)
+        {
+            caught = true;
+        }
+
+        // Captures by value are copied into the awaiter
+        string name   = "a name longer than the small string buffer";
+        auto name_len = [name] { return name.size(); };
+        size_t size   = co_await coroutines.offload(name_len);
+
+        postEvent(EventCameraOpDone_Internal{value == 42 && caught &&
+                                             size == name.size()});
+    }
+
+    StateTask sleepForever()
+    {
+        Guard guard{destroyed};
+        co_await coroutines.sleepFor(seconds(3600));
+        ++queries;
+    }
+
+    std::thread::id hsm_thread;
+    mutex mtx;
+    condition_variable cv;
+};
+
+void testHsm()
+{
+    CoroutineHsm hsm;
+    hsm.start();
+
+    hsm.postEvent(EventCameraCmdCapture{});
+    for (int i = 0; i < NUM_QUERIES; ++i)
+        hsm.postEvent(EventGetCameraControllerState{});
+
+    assert(hsm.waitDone());
+    assert(hsm.success);
+    assert(hsm.resumed_on_hsm_thread);
+    // Handled while the operation was running
+    assert(hsm.queries == NUM_QUERIES);
+
+    // Suspended coroutines are destroyed, not resumed, when stopping
+    hsm.postEvent(EventCameraCmdDisconnect{});
+    std::this_thread::sleep_for(milliseconds(20));
+    auto start = steady_clock::now();
+    hsm.stop();
+    assert(steady_clock::now() - start < seconds(1));
+    assert(hsm.destroyed == 1);
+    assert(hsm.queries == NUM_QUERIES);
+}
+
+/**
+ * The controller answers while the camera captures
+ */
+void testCameraController()
+{
+    mutex mtx;
+    condition_variable cv;
+    steady_clock::time_point query_time;
+    int capturing_latency_ms = -1;
+    bool ready               = false;
+    bool started             = false;
+    int captures             = 0;
+
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time  = milliseconds(1);
+    cfg.config_rtt    = milliseconds(1);
+    cfg.capture_time  = milliseconds(300);
+    cfg.wait_exposure = false;
+
+    EventSniffer sniffer{
+        sEventBroker,
+        {TOPIC_CAMERA_EVENT, TOPIC_CAMERA_CONFIG},
+        [&](const EventPtr& ev, uint8_t topic)
+        {
+            {
+                unique_lock<mutex> lock(mtx);
+                switch (ev->getID())
+                {
+                    case EventCameraReady::id:
+                        ready = true;
+                        break;
+                    case EventCameraCaptureStarted::id:
+                        started = true;
+                        break;
+                    case EventCameraControllerState::id:
+                    {
+                        auto s = dynamic_pointer_cast<
+                            const EventCameraControllerState>(ev);
+                        if (s->state == "Capturing" &&
+                            capturing_latency_ms < 0 &&
+                            query_time != steady_clock::time_point{})
+                        {
+                            capturing_latency_ms =
+                                duration_cast<milliseconds>(
+                                    steady_clock::now() - query_time)
+                                    .count();
+                        }
+                        break;
+                    }
+                    case EventCameraCaptureDone::id:
+                        ++captures;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            cv.notify_all();
+        }};
+
+    CameraController controller{"/tmp", make_unique<SimulatedCamera>(cfg)};
+    controller.start();
+
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    {
+        unique_lock<mutex> lock(mtx);
+        assert(cv.wait_for(lock, seconds(5), [&] { return ready; }));
+    }
+
+    sBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+    {
+        unique_lock<mutex> lock(mtx);
+        assert(cv.wait_for(lock, seconds(5), [&] { return started; }));
+        query_time = steady_clock::now();
+    }
+    sBroker.post(EventGetCameraControllerState{}, TOPIC_CAMERA_CMD);
+    {
+        unique_lock<mutex> lock(mtx);
+        assert(cv.wait_for(lock, seconds(5), [&] { return captures == 1; }));
+    }
+
+    fmt::print("State query answered {} ms into a {} ms capture\n",
+               capturing_latency_ms, cfg.capture_time.count());
+    assert(capturing_latency_ms >= 0);
+    assert(capturing_latency_ms < cfg.capture_time.count() / 2);
+
+    controller.stop();
+}
+
+int main()
+{
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+    sBroker.start();
+
+    testHsm();
+    testCameraController();
+
+    sBroker.stop();
+
+    fmt::print("Coroutines OK\n");
+    return 0;
+}
@@ -0,0 +1,224 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DispatchWatchdog.h"
+#include "EventBroker.h"
+#include "Events.h"
+#include "events/HSM.h"
+#include "utils/EventSniffer.h"
+#include "utils/logger/PrintLogger.h"
+
+using std::condition_variable;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+static constexpr int BUDGET_MS = 100;
+static constexpr int STALL_MS  = 400;
+
+/**
+ * Stalls for STALL_MS on EventCameraCmdCapture, like a state handler waiting
+ * for a camera that does not answer
+ */
+class StallingHsm : public HSM<StallingHsm>
+{
+public:
+    StallingHsm() : HSM(&StallingHsm::stateInit)
+    {
+        nameState(&StallingHsm::stateIdle, "Idle");
+    }
+
+    State stateInit(const EventPtr& ev)
+    {
+        return transition(&StallingHsm::stateIdle);
+    }
+
+    State stateIdle(const EventPtr& ev)
+    {
+        switch (ev->getID())
+        {
+            case EventCameraCmdCapture::id:
+                std::this_thread::sleep_for(milliseconds(STALL_MS));
+                break;
+            case EventCameraCmdConnect::id:
+                return transition(&StallingHsm::stateBusy);
+            default:
+                return tran_super(&StallingHsm::Hsm_top);
+        }
+        return HANDLED;
+    }
+
+    // Not named
+    State stateBusy(const EventPtr& ev)
+    {
+        switch (ev->getID())
+        {
+            case EventCameraCmdCapture::id:
+                break;
+            default:
+                return tran_super(&StallingHsm::Hsm_top);
+        }
+        return HANDLED;
+    }
+};
+
+void testHistogram()
+{
+    DispatchHistogram h;
+    assert(h.percentile(50) == 0);
+
+    for (int i = 0; i < 98; ++i)
+        h.record(std::chrono::microseconds(10));
+    h.record(std::chrono::microseconds(0));
+    h.record(std::chrono::microseconds(5000));
+
+    assert(h.count == 100);
+    assert(h.max_us == 5000);
+    assert(h.buckets[0] == 1);
+    assert(h.buckets[3] == 98);  // [8, 16) us
+    assert(h.buckets[12] == 1);  // [4096, 8192) us
+    assert(h.percentile(50) == 16);
+    assert(h.percentile(99) == 16);
+    assert(h.percentile(100) == 5000);
+    assert(h.mean() == (98 * 10 + 5000) / 100);
+
+    h.record(seconds(3600));
+    assert(h.buckets[DispatchHistogram::NUM_BUCKETS - 1] == 1);
+}
+
+int main()
+{
+    testHistogram();
+
+    Logging::getStdOutLogSink().disable();
+
+    DispatchWatchdog::getInstance().setDefaultBudget(milliseconds(BUDGET_MS));
+    DispatchWatchdog::getInstance().setPeriod(milliseconds(10));
+
+    mutex mtx;
+    condition_variable cv;
+    vector<EventHandlerOverrun> overruns;
+    vector<int> received_at_ms;
+    steady_clock::time_point start;
+
+    EventSniffer sniffer{sBroker,
+                         {TOPIC_DIAGNOSTICS},
+                         [&](const EventPtr& ev, uint8_t topic)
+                         {
+                             unique_lock<mutex> lock(mtx);
+                             overruns.push_back(
+                                 static_cast<const EventHandlerOverrun&>(*ev));
+                             received_at_ms.push_back(
+                                 duration_cast<milliseconds>(
+                                     steady_clock::now() - start)
+                                     .count());
+                             cv.notify_all();
+                         }};
+
+    StallingHsm hsm;
+    hsm.start();
+    assert(hsm.getDispatchMonitor().getName() == "StallingHsm");
+
+    // Within the budget: not reported
+    for (int i = 0; i < 10; ++i)
+        hsm.postEvent(EventCameraReady{});
+    std::this_thread::sleep_for(milliseconds(50));
+    assert(overruns.empty());
+
+    start = steady_clock::now();
+    hsm.postEvent(EventCameraCmdCapture{});
+
+    {
+        unique_lock<mutex> lock(mtx);
+        assert(cv.wait_for(lock, seconds(5),
+                           [&] { return overruns.size() >= 2; }));
+    }
+
+    // Reported once while still stalled, then again when done
+    assert(overruns.size() == 2);
+    assert(!overruns[0].finished);
+    assert(received_at_ms[0] >= BUDGET_MS && received_at_ms[0] < STALL_MS);
+    assert(overruns[0].handler == "StallingHsm");
+    assert(overruns[0].state == "Idle");
+    assert(overruns[0].event == "EventCameraCmdCapture");
+
+    assert(overruns[1].finished);
+    assert(overruns[1].duration_ms >= STALL_MS);
+    assert(overruns[1].state == "Idle");
+    assert(overruns[1].event == "EventCameraCmdCapture");
+    assert(hsm.getDispatchMonitor().getNumOverruns() == 1);
+
+    // A larger budget of its own
+    hsm.getDispatchMonitor().setBudget(milliseconds(STALL_MS * 2));
+    hsm.postEvent(EventCameraCmdCapture{});
+    hsm.postEvent(EventCameraCmdConnect{});
+    hsm.postEvent(EventCameraCmdCapture{});
+    std::this_thread::sleep_for(milliseconds(STALL_MS + 100));
+    assert(overruns.size() == 2);
+
+    hsm.stop();
+
+    // Durations by state and event
+    bool found_ready = false, found_capture = false, found_busy = false;
+    for (const auto& s : hsm.getDispatchMonitor().getStats())
+    {
+        fmt::print("{:>6} {:<24} n: {:>2}, p50: {:>7} us, max: {:>7} us\n",
+                   s.state, s.event, s.histogram.count,
+                   s.histogram.percentile(50), s.histogram.max_us);
+
+        if (s.state == "Idle" && s.event == "EventCameraReady")
+        {
+            found_ready = true;
+            assert(s.histogram.count == 10);
+            assert(s.histogram.max_us < BUDGET_MS * 1000);
+        }
+        if (s.state == "Idle" && s.event == "EventCameraCmdCapture")
+        {
+            found_capture = true;
+            assert(s.histogram.count == 2);
+            assert(s.histogram.percentile(50) >= STALL_MS * 1000);
+        }
+        // Unnamed states are numbered
+        if (s.state.starts_with("State") && s.event == "EventCameraCmdCapture")
+        {
+            found_busy = true;
+            assert(s.histogram.count == 1);
+        }
+    }
+    assert(found_ready && found_capture && found_busy);
+
+    fmt::print("Dispatch watchdog OK\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <vector>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "utils/EventSniffer.h"
+
+using std::vector;
+
+class CountingHandler : public EventHandlerBase
+{
+public:
+    int count = 0;
+
+protected:
+    void doPostEvent(const EventPtr& ev) override { ++count; }
+};
+
+int main()
+{
+    EventBroker broker;
+
+    vector<uint8_t> all_topics;
+    {
+        EventSniffer sniffer{broker, [&](const EventPtr& ev, uint8_t topic)
+                             { all_topics.push_back(topic); }};
+
+        vector<uint8_t> cmd_topics;
+        EventSniffer cmd_sniffer{broker,
+                                 {TOPIC_CAMERA_CMD, TOPIC_REMOTE_CMD},
+                                 [&](const EventPtr& ev, uint8_t topic)
+                                 { cmd_topics.push_back(topic); }};
+
+        broker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+        broker.post(EventCameraReady{}, TOPIC_CAMERA_EVENT);
+        broker.post(EventCameraCmdCapture{}, TOPIC_REMOTE_CMD);
+        broker.post(EventHeartBeat{}, TOPIC_HEARTBEAT);
+        broker.post(EventCameraReady{}, 200);
+
+        assert((all_topics == vector<uint8_t>{TOPIC_CAMERA_CMD,
+                                              TOPIC_CAMERA_EVENT,
+                                              TOPIC_REMOTE_CMD, 200}));
+        assert((cmd_topics ==
+                vector<uint8_t>{TOPIC_CAMERA_CMD, TOPIC_REMOTE_CMD}));
+    }
+
+    // Sniffers removed their taps
+    broker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+    assert(all_topics.size() == 4);
+
+    CountingHandler handler;
+    TopicMask mask;
+    mask.set(TOPIC_CAMERA_EVENT).set(TOPIC_MODE_STATE);
+    broker.subscribe(&handler, mask);
+
+    broker.post(EventCameraReady{}, TOPIC_CAMERA_EVENT);
+    broker.post(EventCameraReady{}, TOPIC_MODE_STATE);
+    broker.post(EventCameraReady{}, TOPIC_CAMERA_CMD);
+    assert(handler.count == 2);
+
+    broker.unsubscribe(&handler);
+    broker.post(EventCameraReady{}, TOPIC_CAMERA_EVENT);
+    assert(handler.count == 2);
+
+    fmt::print("Broker taps OK\n");
+    return 0;
+}
@@ -0,0 +1,216 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EventBroker.h"
+#include "EventHandler.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "event_waiter.h"
+#include "fsm/CameraController.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::milliseconds;
+
+static constexpr int NUM_SETTERS = 30;
+
+/**
+ * Not started: the queue is emptied by drain(), on the calling thread
+ */
+class RecordingHandler : public EventHandler<>
+{
+public:
+    RecordingHandler()
+    {
+        setCoalescing<EventConfigSetISO>(Coalescing::LATEST);
+        setCoalescing<EventConfigSetShutterSpeed>(Coalescing::LATEST);
+        setCoalescing<EventConfigGetISO>(Coalescing::FIRST);
+    }
+
+    vector<EventPtr> drain()
+    {
+        vector<EventPtr> handled;
+        while (!eventList.isEmpty())
+            handled.push_back(eventList.pop());
+        return handled;
+    }
+
+protected:
+    void handleEvent(const EventPtr& ev) override {}
+};
+
+int32_t isoOf(const EventPtr& ev)
+{
+    return dynamic_pointer_cast<const EventConfigSetISO>(ev)->iso;
+}
+
+void testRules()
+{
+    RecordingHandler handler;
+
+    handler.postEvent(EventConfigSetISO{100});
+    handler.postEvent(EventConfigSetShutterSpeed{1000});
+    handler.postEvent(EventConfigGetISO{});
+    handler.postEvent(EventConfigSetISO{200});
+    handler.postEvent(EventConfigGetISO{});
+    // Setters are not coalesced across a capture
+    handler.postEvent(EventCameraCmdCapture{});
+    handler.postEvent(EventConfigSetISO{400});
+    handler.postEvent(EventConfigSetISO{800});
+    handler.postEvent(EventConfigGetISO{});
+
+    vector<EventPtr> handled = handler.drain();
+    assert(handled.size() == 5);
+    assert(handled[0]->getID() == EventConfigSetISO::id);
+    assert(isoOf(handled[0]) == 200);
+    assert(handled[1]->getID() == EventConfigSetShutterSpeed::id);
+    assert(handled[2]->getID() == EventCameraCmdCapture::id);
+    assert(isoOf(handled[3]) == 800);
+    assert(handled[4]->getID() == EventConfigGetISO::id);
+    assert(handler.getCoalescedCount() == 4);
+}
+
+EventWaiter waiter;
+int ready_count      = 0;
+int capture_count    = 0;
+int focus_done_count = 0;
+int32_t last_iso     = 0;
+
+bool waitForISO(int32_t iso)
+{
+    return waiter.waitUntil([&] { return last_iso == iso; });
+}
+
+void testController()
+{
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+    sBroker.start();
+
+    EventSniffer sniffer{sEventBroker,
+                         {TOPIC_CAMERA_EVENT, TOPIC_CAMERA_CONFIG},
+                         [&](const EventPtr& ev, uint8_t topic)
+                         {
+                             {
+                                 unique_lock<mutex> lock(waiter.mtx);
+                                 if (ev->getID() == EventCameraReady::id)
+                                     ++ready_count;
+                                 if (ev->getID() == EventCameraCaptureDone::id)
+                                     ++capture_count;
+                                 if (ev->getID() ==
+                                     EventCameraFocusDriveDone::id)
+                                     ++focus_done_count;
+                                 if (ev->getID() == EventConfigValueISO::id)
+                                     last_iso = dynamic_pointer_cast<
+                                                    const EventConfigValueISO>(
+                                                    ev)
+                                                    ->iso;
+                             }
+                             waiter.cv.notify_all();
+                         }};
+
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time  = milliseconds(1);
+    cfg.config_rtt    = milliseconds(5);
+    cfg.capture_time  = milliseconds(50);
+    cfg.wait_exposure = false;
+
+    auto sim             = make_unique<SimulatedCamera>(cfg);
+    SimulatedCamera& cam = *sim;
+
+    CameraController controller{"/tmp", std::move(sim)};
+    controller.start();
+
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, 1));
+    std::this_thread::sleep_for(milliseconds(300));
+
+    // A slider dragged while the camera is idle: the first setter is being
+    // written while the others are queued
+    uint64_t ops = cam.getStats().config_ops;
+    for (int i = 0; i < NUM_SETTERS; ++i)
+        sBroker.post(EventConfigSetISO{i % 2 ? 200 : 400}, TOPIC_CAMERA_CMD);
+    sBroker.post(EventConfigSetISO{1600}, TOPIC_CAMERA_CMD);
+    assert(waitForISO(1600));
+
+    uint64_t idle_ops = cam.getStats().config_ops - ops;
+
+    // Same, during a capture: setters are deferred until it is done
+    int captures = capture_count;
+    sBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+    for (int i = 0; i < NUM_SETTERS; ++i)
+        sBroker.post(EventConfigSetISO{i % 2 ? 200 : 400}, TOPIC_CAMERA_CMD);
+    sBroker.post(EventConfigSetISO{3200}, TOPIC_CAMERA_CMD);
+    ops = cam.getStats().config_ops;
+    assert(waiter.waitFor(capture_count, captures + 1));
+    assert(waitForISO(3200));
+
+    // Give the controller time to apply anything left over
+    std::this_thread::sleep_for(milliseconds(100));
+    uint64_t capture_ops = cam.getStats().config_ops - ops;
+
+    fmt::print("{} setters: {} config ops when idle, {} during a capture\n",
+               NUM_SETTERS + 1, idle_ops, capture_ops);
+
+    // Each setter is a write and a read back, plus the volatile settings
+    // read again after the capture
+    assert(idle_ops <= 4);
+    assert(capture_ops <= 8);
+    assert(controller.getCoalescedCount() >= 2 * NUM_SETTERS - 4);
+
+    // Relative commands are not coalesced: both drives are executed, even
+    // when queued behind a capture
+    int32_t position = cam.getFocusPosition();
+    uint64_t drives  = cam.getStats().focus_drives;
+    captures         = capture_count;
+    sBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+    sBroker.post(EventCameraCmdFocusDrive{100}, TOPIC_CAMERA_CMD);
+    sBroker.post(EventCameraCmdFocusDrive{100}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(capture_count, captures + 1));
+    assert(waiter.waitFor(focus_done_count, 2));
+    assert(cam.getStats().focus_drives == drives + 2);
+    assert(cam.getFocusPosition() == position + 200);
+
+    controller.stop();
+    sBroker.stop();
+}
+
+int main()
+{
+    testRules();
+    testController();
+
+    fmt::print("Event coalescing OK\n");
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "utils/EventSniffer.h"
+#include "utils/journal/EventJournal.h"
+
+using std::dynamic_pointer_cast;
+using std::make_shared;
+using std::string;
+
+int main()
+{
+    string file = "/tmp/test_event_journal.bin";
+    std::remove(file.c_str());
+
+    // Small ring: 32 slots of 64 bytes
+    {
+        EventJournal journal{file, 32, 64};
+        for (int i = 0; i < 10; ++i)
+        {
+            journal.append(make_shared<EventConfigValueISO>(100 * (i + 1)),
+                           TOPIC_CAMERA_CONFIG);
+        }
+
+        // Written by the journal thread
+        journal.flush();
+        assert(journal.getDroppedCount() == 0);
+        assert(EventJournal::read(file).size() == 10);
+    }
+
+    auto records = EventJournal::read(file);
+    assert(records.size() == 10);
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        assert(records[i].seq == i);
+        assert(records[i].topic == TOPIC_CAMERA_CONFIG);
+        assert(records[i].event_id == EventConfigValueISO::id);
+
+        auto ev = dynamic_pointer_cast<const EventConfigValueISO>(
+            records[i].toEvent());
+        assert(ev && ev->iso == 100 * ((int)i + 1));
+    }
+
+    // Reopening resumes after the last record, then the ring wraps around
+    // and the oldest records are overwritten.
+    {
+        EventJournal journal{file, 32, 64};
+        for (int i = 0; i < 100; ++i)
+        {
+            journal.append(
+                make_shared<EventCameraCaptureDone>(true, "/tmp", "DSC.JPG"),
+                TOPIC_CAMERA_EVENT);
+        }
+    }
+
+    records = EventJournal::read(file);
+    assert(!records.empty() && records.size() < 110);
+    assert(records.back().seq == 109);
+    for (size_t i = 1; i < records.size(); ++i)
+        assert(records[i].seq == records[i - 1].seq + 1);
+
+    // Replay everything as fast as possible on a fresh broker
+    EventBroker broker;
+    std::atomic<size_t> received = 0;
+    EventSniffer sniffer{broker, {TOPIC_CAMERA_EVENT},
+                         [&](const EventPtr& ev, uint8_t topic)
+                         {
+                             assert(ev->getID() == EventCameraCaptureDone::id);
+                             ++received;
+                         }};
+
+    size_t posted = replayJournal(broker, records, 0);
+    assert(posted == records.size());
+    assert(received == records.size());
+
+    // Events on a sync topic are in the file as soon as append() returns
+    std::remove(file.c_str());
+    {
+        EventJournal journal{file, 32, 64};
+        journal.setSyncTopics(TopicMask{}.set(TOPIC_REMOTE_CMD));
+        for (size_t i = 1; i <= 5; ++i)
+        {
+            journal.append(make_shared<EventCameraCmdCapture>(),
+                           TOPIC_REMOTE_CMD);
+            assert(EventJournal::read(file).size() == i);
+        }
+    }
+
+    fmt::print("Journal OK: {} records replayed\n", posted);
+
+    std::remove(file.c_str());
+    return 0;
+}
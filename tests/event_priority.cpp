@@ -0,0 +1,212 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EventBroker.h"
+#include "EventPriority.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "event_waiter.h"
+#include "fsm/CameraController.h"
+#include "utils/EventSniffer.h"
+#include "utils/collections/SyncMultiLevelQueue.h"
+
+using namespace gphotow;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+static constexpr int STORM_SIZE = 100;
+
+void testQueue()
+{
+    SyncMultiLevelQueue<int, 10, 3, 2> queue;
+
+    queue.put(1, 2).put(2, 1).put(3, 0);
+    assert(queue.count() == 3);
+    assert(queue.pop() == 3);
+    assert(queue.pop() == 2);
+    assert(queue.pop() == 1);
+    assert(queue.isEmpty());
+
+    // The lowest level is served after being passed over twice
+    queue.put(100, 2);
+    for (int i = 0; i < 5; ++i)
+        queue.put(i, 0);
+
+    vector<int> order;
+    while (!queue.isEmpty())
+        order.push_back(queue.popBlocking());
+    assert((order == vector<int>{0, 1, 100, 2, 3, 4}));
+
+    // A full level only overwrites its own elements
+    queue.put(-1, 0);
+    for (int i = 0; i < 15; ++i)
+        queue.put(i, 2);
+    assert(queue.count(0) == 1);
+    assert(queue.count(2) == 10);
+    assert(queue.pop() == -1);
+    assert(queue.pop() == 5);
+}
+
+void testClassification()
+{
+    assert(getEventPriority(EventCameraCmdCapture::id) ==
+           EventPriority::COMMAND);
+    assert(getEventPriority(EventCameraCmdCapture_Internal::id) ==
+           EventPriority::COMMAND);
+    assert(getEventPriority(EventConfigSetISO::id) == EventPriority::COMMAND);
+    assert(getEventPriority(EventConfigNextFocusMode::id) ==
+           EventPriority::COMMAND);
+
+    assert(getEventPriority(EventConfigGetISO::id) ==
+           EventPriority::TELEMETRY);
+    assert(getEventPriority(EventConfigGetAll::id) ==
+           EventPriority::TELEMETRY);
+    assert(getEventPriority(EventGetCameraControllerState::id) ==
+           EventPriority::TELEMETRY);
+    assert(getEventPriority(EventCameraCmdPollEvents_Internal::id) ==
+           EventPriority::TELEMETRY);
+
+    // Camera notifications and mode commands are handled in order
+    for (uint16_t id :
+         {EventCameraConnected::id, EventCameraReady::id,
+          EventCameraBusyOrError::id, EventCameraError::id,
+          EventCameraCaptureDone::id, EventIntervalometerStart::id,
+          EventModeStop::id, EventModeStopped::id, EventGetCurrentMode::id})
+        assert(getEventPriority(id) == EventPriority::CONTROL);
+    assert(getEventPriority(EventSMEntry::id) == EventPriority::CONTROL);
+}
+
+/**
+ * Does not coalesce the getters: the storm is handled one request at a time
+ */
+class UncoalescedController : public CameraController
+{
+public:
+    UncoalescedController(unique_ptr<CameraBase> camera)
+        : CameraController("/tmp", std::move(camera))
+    {
+        for (uint16_t id = 0; id < 256; ++id)
+            setCoalescing(id, Coalescing::NONE);
+    }
+};
+
+EventWaiter waiter;
+int ready_count   = 0;
+int capture_count = 0;
+int iso_count     = 0;
+
+/**
+ * Time from the capture command to the end of the capture
+ */
+int captureLatency(int storm)
+{
+    int captures = capture_count;
+    int isos     = iso_count;
+
+    for (int i = 0; i < storm; ++i)
+        sBroker.post(EventConfigGetISO{}, TOPIC_CAMERA_CMD);
+
+    auto start = steady_clock::now();
+    sBroker.post(EventCameraCmdCapture{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(capture_count, captures + 1));
+    auto latency = duration_cast<milliseconds>(steady_clock::now() - start);
+
+    // No getter is lost
+    assert(waiter.waitFor(iso_count, isos + storm));
+    assert(waiter.waitFor(ready_count, captures + 2));
+
+    return latency.count();
+}
+
+void testCaptureLatency()
+{
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+    sBroker.start();
+
+    EventSniffer sniffer{sEventBroker,
+                         {TOPIC_CAMERA_EVENT, TOPIC_CAMERA_CONFIG},
+                         [&](const EventPtr& ev, uint8_t topic)
+                         {
+                             {
+                                 unique_lock<mutex> lock(waiter.mtx);
+                                 if (ev->getID() == EventCameraReady::id)
+                                     ++ready_count;
+                                 if (ev->getID() == EventCameraCaptureDone::id)
+                                     ++capture_count;
+                                 if (ev->getID() == EventConfigValueISO::id)
+                                     ++iso_count;
+                             }
+                             waiter.cv.notify_all();
+                         }};
+
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time  = milliseconds(1);
+    cfg.config_rtt    = milliseconds(2);
+    cfg.capture_time  = milliseconds(5);
+    cfg.wait_exposure = false;
+
+    UncoalescedController controller{make_unique<SimulatedCamera>(cfg)};
+    controller.start();
+
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, 1));
+
+    // Let the controller read the whole configuration once
+    std::this_thread::sleep_for(milliseconds(200));
+
+    int idle  = captureLatency(0);
+    int storm = captureLatency(STORM_SIZE);
+
+    fmt::print("Capture latency: idle {} ms, behind {} getters {} ms\n", idle,
+               STORM_SIZE, storm);
+
+    // In order, the capture would wait for all the getters (~200 ms)
+    assert(storm < idle + 30);
+
+    controller.stop();
+    sBroker.stop();
+}
+
+int main()
+{
+    testQueue();
+    testClassification();
+    testCaptureLatency();
+
+    fmt::print("Event priority OK\n");
+    return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "EventBroker.h"
+#include "EventHandler.h"
+#include "Events.h"
+#include "utils/EventSniffer.h"
+
+using std::condition_variable;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::seconds;
+
+static_assert(is_event_value_v<EventConfigValueISO>);
+static_assert(!is_event_value_v<EventSMEntry>);
+
+/**
+ * Handles the events synchronously, when drain() is called
+ */
+class RecordingHandler : public ValueEventHandler<10>
+{
+public:
+    vector<EventValue> handled;
+
+    void drain()
+    {
+        while (!eventList.isEmpty())
+            handleEvent(eventList.pop());
+    }
+
+protected:
+    void handleEvent(const EventValue& ev) override { handled.push_back(ev); }
+};
+
+class PointerHandler : public EventHandlerBase
+{
+public:
+    vector<EventPtr> received;
+
+protected:
+    void doPostEvent(const EventPtr& ev) override { received.push_back(ev); }
+};
+
+template <size_t... I>
+void testAlternatives(std::index_sequence<I...>)
+{
+    auto check = [](auto index)
+    {
+        EventValue ev{std::in_place_index<index>};
+        assert(asEvent(ev).getID() == 10 + index);
+
+        EventPtr ptr = toEventPtr(EventValue{ev});
+        assert(ptr->getID() == 10 + index);
+        assert(toEventValue(*ptr).index() == index);
+    };
+    (check(std::integral_constant<size_t, I>{}), ...);
+}
+
+void testConversions()
+{
+    testAlternatives(
+        std::make_index_sequence<std::variant_size_v<EventValue>>{});
+
+    EventCameraCaptureDone done{true, "/home/pi", "IMG_0001.CR2"};
+    EventValue ev = toEventValue(done);
+    auto* stored  = std::get_if<EventCameraCaptureDone>(&ev);
+    assert(stored != nullptr);
+    assert(stored->download_dir == "/home/pi");
+    assert(stored->file == "IMG_0001.CR2");
+
+    auto ptr = dynamic_pointer_cast<const EventCameraCaptureDone>(
+        toEventPtr(std::move(ev)));
+    assert(ptr != nullptr);
+    assert(ptr->dump() == done.dump());
+
+    bool thrown = false;
+    try
+    {
+        toEventValue(*C_EV_ENTRY);
+    }
+    catch (std::out_of_range&)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void testBroker()
+{
+    EventBroker broker;
+
+    RecordingHandler values1;
+    RecordingHandler values2;
+    PointerHandler pointers;
+    broker.subscribe(&values1, TOPIC_CAMERA_CONFIG);
+    broker.subscribe(&values2, TOPIC_CAMERA_CONFIG);
+    broker.subscribe(&pointers, TOPIC_CAMERA_CONFIG);
+    broker.subscribe(&values1, TOPIC_CAMERA_EVENT);
+    broker.subscribe(&pointers, TOPIC_MODE_STATE);
+
+    vector<EventPtr> tapped;
+    EventSniffer sniffer{broker,
+                         {TOPIC_CAMERA_CONFIG},
+                         [&](const EventPtr& ev, uint8_t topic)
+                         { tapped.push_back(ev); }};
+
+    broker.post(EventConfigValueISO{800}, TOPIC_CAMERA_CONFIG);
+    broker.post(EventCameraCaptureDone{true, "/tmp", "a.jpg"},
+                TOPIC_CAMERA_EVENT);
+    // Still delivered by value, as a copy of the pointed event
+    broker.post(std::make_shared<EventConfigValueISO>(1600),
+                TOPIC_CAMERA_EVENT);
+    values1.drain();
+    values2.drain();
+
+    assert(values1.handled.size() == 3);
+    assert(std::get<EventConfigValueISO>(values1.handled[0]).iso == 800);
+    assert(std::get<EventCameraCaptureDone>(values1.handled[1]).file ==
+           "a.jpg");
+    assert(std::get<EventConfigValueISO>(values1.handled[2]).iso == 1600);
+
+    assert(values2.handled.size() == 1);
+    assert(std::get<EventConfigValueISO>(values2.handled[0]).iso == 800);
+
+    // Pointer subscribers and taps share the same event
+    assert(pointers.received.size() == 1);
+    assert(tapped.size() == 1);
+    assert(pointers.received[0] == tapped[0]);
+    assert(dynamic_pointer_cast<const EventConfigValueISO>(tapped[0])->iso ==
+           800);
+
+    // Events that are not values are still delivered to pointer handlers
+    broker.post(EventSMEntry{}, TOPIC_MODE_STATE);
+    assert(pointers.received.back()->getID() == EventSMEntry::id);
+}
+
+class CountingHandler : public ValueEventHandler<>
+{
+public:
+    mutex mtx;
+    condition_variable cv;
+    int32_t iso_sum = 0;
+    int count       = 0;
+
+protected:
+    void handleEvent(const EventValue& ev) override
+    {
+        unique_lock<mutex> lock(mtx);
+        std::visit(
+            [&](const auto& e)
+            {
+                if constexpr (std::is_same_v<std::decay_t<decltype(e)>,
+                                             EventConfigValueISO>)
+                    iso_sum += e.iso;
+            },
+            ev);
+        ++count;
+        cv.notify_all();
+    }
+};
+
+void testThread()
+{
+    CountingHandler handler;
+    handler.start();
+
+    handler.postEvent(EventConfigValueISO{100});
+    handler.postEvent(EventValue{EventConfigValueISO{200}});
+    handler.postEvent(EventCameraReady{});
+
+    {
+        unique_lock<mutex> lock(handler.mtx);
+        bool ok = handler.cv.wait_for(lock, seconds(5),
+                                      [&] { return handler.count == 3; });
+        assert(ok);
+        assert(handler.iso_sum == 300);
+    }
+
+    handler.stop();
+    assert(handler.count == 3);
+}
+
+int main()
+{
+    testConversions();
+    testBroker();
+    testThread();
+
+    fmt::print("Event values OK\n");
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+
+#include "EventBroker.h"
+#include "EventHandler.h"
+#include "Events.h"
+#include "alloc_counter.h"
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+static constexpr int DEFAULT_ITERATIONS = 100000;
+static constexpr unsigned QUEUE_SIZE    = 100;
+
+/**
+ * Handlers are not started: their queue is emptied by drain(), on the
+ * calling thread, so that only posting and dispatching are measured
+ */
+class PointerHandler : public EventHandler<QUEUE_SIZE>
+{
+public:
+    uint64_t sum = 0;
+
+    void drain()
+    {
+        while (!eventList.isEmpty())
+            handleEvent(eventList.pop());
+    }
+
+protected:
+    void handleEvent(const EventPtr& ev) override { sum += ev->getID(); }
+};
+
+class ValueHandler : public ValueEventHandler<QUEUE_SIZE>
+{
+public:
+    uint64_t sum = 0;
+
+    void drain()
+    {
+        while (!eventList.isEmpty())
+            handleEvent(eventList.pop());
+    }
+
+protected:
+    void handleEvent(const EventValue& ev) override
+    {
+        sum += std::visit([](const auto& e) { return e.id; }, ev);
+    }
+};
+
+struct Result
+{
+    double ns_per_event;
+    double allocs_per_event;
+};
+
+template <typename Handler>
+Result measure(int iterations)
+{
+    EventBroker broker;
+    Handler handler;
+    broker.subscribe(&handler, TOPIC_CAMERA_CONFIG);
+
+    uint64_t allocs = num_allocs;
+    auto start      = steady_clock::now();
+
+    // Fill the queue, then empty it: it never overwrites
+    for (int i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < QUEUE_SIZE / 4; ++j)
+        {
+            broker.post(EventConfigValueISO{400}, TOPIC_CAMERA_CONFIG);
+            broker.post(EventConfigValueLightMeter{-0.3f, -3.0f, 3.0f},
+                        TOPIC_CAMERA_CONFIG);
+            broker.post(EventCameraCaptureDone{true, "/home/pi", "0042.CR2"},
+                        TOPIC_CAMERA_CONFIG);
+            broker.post(EventCameraReady{}, TOPIC_CAMERA_CONFIG);
+        }
+        handler.drain();
+    }
+
+    double ns =
+        duration<double, std::nano>(steady_clock::now() - start).count();
+    uint64_t total = (uint64_t)iterations * QUEUE_SIZE;
+    assert(handler.sum > 0);
+
+    return {ns / total, (double)(num_allocs - allocs) / total};
+}
+
+/**
+ * Posts a mix of events through the broker to a single subscriber, which
+ * stores them as EventPtr or in place as EventValue.
+ * Usage: event_value_bench [iterations]
+ */
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : DEFAULT_ITERATIONS;
+
+    Result ptr = measure<PointerHandler>(iterations);
+    Result val = measure<ValueHandler>(iterations);
+
+    fmt::print("EventPtr:   {:6.0f} ns/event, {:5.2f} allocs/event\n",
+               ptr.ns_per_event, ptr.allocs_per_event);
+    fmt::print("EventValue: {:6.0f} ns/event, {:5.2f} allocs/event\n",
+               val.ns_per_event, val.allocs_per_event);
+    fmt::print("saved:      {:6.0f} ns/event, {:5.2f} allocs/event\n",
+               ptr.ns_per_event - val.ns_per_event,
+               ptr.allocs_per_event - val.allocs_per_event);
+
+    return 0;
+}
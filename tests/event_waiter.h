@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * Shared state between the thread running a test and the EventSniffer
+ * callbacks counting the events it waits for. Update the counters while
+ * holding mtx, then notify cv.
+ */
+struct EventWaiter
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    /**
+     * @brief Waits up to timeout for pred to become true.
+     */
+    template <typename Predicate>
+    bool waitUntil(Predicate pred,
+                   std::chrono::milliseconds timeout = std::chrono::seconds(5))
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_for(lock, timeout, pred);
+    }
+
+    /**
+     * @brief Waits up to timeout for counter to reach value.
+     */
+    bool waitFor(int& counter, int value,
+                 std::chrono::milliseconds timeout = std::chrono::seconds(5))
+    {
+        return waitUntil([&] { return counter >= value; }, timeout);
+    }
+};
@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "EventHandler.h"
+#include "Events.h"
+#include "utils/Executor.h"
+
+using std::atomic;
+using std::vector;
+using std::chrono::milliseconds;
+
+static constexpr int NUM_SENDERS  = 4;
+static constexpr int NUM_EVENTS   = 1000;
+static constexpr int NUM_HANDLERS = 8;
+
+/**
+ * Checks that the events from each sender are handled in order and never by
+ * two workers at the same time. The ISO field carries sender and sequence
+ * number.
+ */
+class OrderedHandler : public EventHandler<NUM_SENDERS * NUM_EVENTS>
+{
+public:
+    atomic<int> handled{0};
+    bool ok = true;
+
+protected:
+    void handleEvent(const EventPtr& ev) override
+    {
+        if (busy.exchange(true))
+            ok = false;
+
+        if (ev->getID() != EventConfigValueISO::id)
+        {
+            busy = false;
+            return;
+        }
+
+        int32_t iso = dynamic_pointer_cast<const EventConfigValueISO>(ev)->iso;
+        int sender  = iso / NUM_EVENTS;
+        int seq     = iso % NUM_EVENTS;
+        if (seq != next[sender])
+            ok = false;
+        next[sender] = seq + 1;
+
+        // Posting to itself from a worker does not run it twice
+        if (seq == 0)
+            postEvent(EventCameraReady{});
+
+        busy = false;
+        ++handled;
+    }
+
+private:
+    atomic<bool> busy{false};
+    int next[NUM_SENDERS] = {};
+};
+
+class SlowHandler : public EventHandler<>
+{
+public:
+    atomic<int> handled{0};
+
+protected:
+    void handleEvent(const EventPtr& ev) override
+    {
+        std::this_thread::sleep_for(milliseconds(10));
+        ++handled;
+    }
+};
+
+void testOrdering()
+{
+    Executor executor{3};
+    executor.start();
+
+    vector<OrderedHandler> handlers(NUM_HANDLERS);
+    for (auto& h : handlers)
+        assert(h.start(executor));
+
+    vector<std::thread> senders;
+    for (int s = 0; s < NUM_SENDERS; ++s)
+    {
+        senders.emplace_back(
+            [&, s]
+            {
+                for (int i = 0; i < NUM_EVENTS; ++i)
+                {
+                    for (auto& h : handlers)
+                        h.postEvent(EventConfigValueISO{s * NUM_EVENTS + i});
+                }
+            });
+    }
+    for (auto& t : senders)
+        t.join();
+
+    for (auto& h : handlers)
+    {
+        for (int i = 0; i < 500 && h.handled < NUM_SENDERS * NUM_EVENTS; ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+
+        assert(h.handled == NUM_SENDERS * NUM_EVENTS);
+        assert(h.ok);
+        h.stop();
+    }
+
+    executor.stop();
+}
+
+void testStop()
+{
+    Executor executor{1};
+    executor.start();
+
+    SlowHandler handler;
+    handler.start(executor);
+    // Already started
+    assert(!handler.start(executor));
+    assert(!handler.start());
+
+    for (int i = 0; i < 50; ++i)
+        handler.postEvent(EventCameraReady{});
+
+    std::this_thread::sleep_for(milliseconds(25));
+
+    // Returns after the event being handled, dropping the others
+    handler.stop();
+    int handled = handler.handled;
+    assert(handled > 0 && handled < 50);
+
+    handler.postEvent(EventCameraReady{});
+    std::this_thread::sleep_for(milliseconds(30));
+    assert(handler.handled == handled);
+
+    executor.stop();
+}
+
+int main()
+{
+    testOrdering();
+    testStop();
+
+    fmt::print("Executor OK\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+#include <sys/resource.h>
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "EventHandler.h"
+#include "Events.h"
+#include "utils/Executor.h"
+
+using std::condition_variable;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+static constexpr int DEFAULT_HANDLERS = 64;
+static constexpr int NUM_TOKENS       = 8;
+static constexpr int NUM_HOPS         = 20000;
+static constexpr int NUM_WORKERS      = 2;
+
+mutex mtx;
+condition_variable cv;
+int hops = 0;
+
+/**
+ * Passes the tokens it receives to the next handler of the ring, like the
+ * modes and the mode controller exchanging events through the broker
+ */
+class RingHandler : public EventHandler<NUM_TOKENS * 2>
+{
+public:
+    RingHandler* next = nullptr;
+
+protected:
+    void handleEvent(const EventPtr& ev) override
+    {
+        {
+            unique_lock<mutex> lock(mtx);
+            if (++hops >= NUM_HOPS)
+            {
+                cv.notify_all();
+                return;
+            }
+        }
+        next->postEvent(ev);
+    }
+};
+
+struct Usage
+{
+    long threads;
+    long vm_size_kb;
+    long vm_rss_kb;
+    long ctx_switches;
+};
+
+long readStatus(const string& key)
+{
+    std::ifstream status{"/proc/self/status"};
+    string line;
+    while (std::getline(status, line))
+    {
+        if (line.rfind(key + ":", 0) == 0)
+            return std::atol(line.c_str() + key.size() + 1);
+    }
+    return 0;
+}
+
+Usage usage()
+{
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return {readStatus("Threads"), readStatus("VmSize"), readStatus("VmRSS"),
+            ru.ru_nvcsw + ru.ru_nivcsw};
+}
+
+/**
+ * Starts the ring of handlers, on an executor with num_workers workers or on
+ * a thread each (num_workers = 0), and passes the tokens around until
+ * NUM_HOPS events have been handled
+ */
+void measure(const char* name, int num_handlers, unsigned int num_workers)
+{
+    hops = 0;
+
+    Usage before = usage();
+
+    unique_ptr<Executor> executor;
+    if (num_workers > 0)
+    {
+        executor = std::make_unique<Executor>(num_workers);
+        executor->start();
+    }
+
+    vector<unique_ptr<RingHandler>> ring;
+    for (int i = 0; i < num_handlers; ++i)
+        ring.push_back(std::make_unique<RingHandler>());
+    for (int i = 0; i < num_handlers; ++i)
+        ring[i]->next = ring[(i + 1) % num_handlers].get();
+
+    for (auto& h : ring)
+    {
+        if (executor != nullptr)
+            h->start(*executor);
+        else
+            h->start();
+    }
+
+    Usage started = usage();
+    auto start    = steady_clock::now();
+
+    for (int i = 0; i < NUM_TOKENS; ++i)
+        ring[i * num_handlers / NUM_TOKENS]->postEvent(EventHeartBeat{});
+
+    {
+        unique_lock<mutex> lock(mtx);
+        cv.wait(lock, [] { return hops >= NUM_HOPS; });
+    }
+
+    double us =
+        duration<double, std::micro>(steady_clock::now() - start).count();
+    Usage after = usage();
+
+    for (auto& h : ring)
+        h->stop();
+    if (executor)
+        executor->stop();
+
+    fmt::print("{:>9}: {:4} threads, VmSize {:+8} kB, VmRSS {:+6} kB, "
+               "{:6.2f} ctx switches/event, {:5.2f} us/event\n",
+               name, started.threads - before.threads,
+               started.vm_size_kb - before.vm_size_kb,
+               started.vm_rss_kb - before.vm_rss_kb,
+               (double)(after.ctx_switches - started.ctx_switches) / NUM_HOPS,
+               us / NUM_HOPS);
+}
+
+/**
+ * Compares running event handlers on a thread each and on a shared executor.
+ * Usage: executor_bench [num_handlers]
+ */
+int main(int argc, char* argv[])
+{
+    int num_handlers = argc > 1 ? std::atoi(argv[1]) : DEFAULT_HANDLERS;
+    assert(num_handlers >= NUM_TOKENS);
+
+    measure("executor", num_handlers, NUM_WORKERS);
+    measure("threads", num_handlers, 0);
+
+    return 0;
+}
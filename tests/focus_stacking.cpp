@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "event_waiter.h"
+#include "fsm/CameraController.h"
+#include "fsm/modes/FocusStacking.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+static constexpr int NUM_FRAMES  = 10;
+static constexpr int FOCUS_STEPS = 100;
+
+EventWaiter waiter;
+int ready_count   = 0;
+int stopped_count = 0;
+EventFocusStackingState last_state;
+// Focus position at the start of each capture
+vector<int32_t> positions;
+
+int main()
+{
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+    sBroker.start();
+
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time    = milliseconds(1);
+    cfg.config_rtt      = milliseconds(10);
+    cfg.capture_time    = milliseconds(50);
+    cfg.wait_exposure   = false;
+    cfg.file_size       = 1000000;
+    cfg.usb_throughput  = 100000000;
+    cfg.focus_step_time = microseconds(50);
+    cfg.autofocus_time  = milliseconds(20);
+
+    auto sim             = make_unique<SimulatedCamera>(cfg);
+    SimulatedCamera& cam = *sim;
+
+    EventSniffer sniffer{
+        sEventBroker,
+        {TOPIC_MODE_STATE, TOPIC_MODE_CONTROLLER, TOPIC_CAMERA_EVENT},
+        [&](const EventPtr& ev, uint8_t topic)
+        {
+            {
+                unique_lock<mutex> lock(waiter.mtx);
+                // Posted by the controller thread, the only one moving the
+                // focus
+                if (ev->getID() == EventCameraCaptureStarted::id)
+                    positions.push_back(cam.getFocusPosition());
+                if (ev->getID() == EventFocusStackingState::id)
+                    last_state =
+                        *dynamic_pointer_cast<const EventFocusStackingState>(
+                            ev);
+                if (ev->getID() == EventModeStopped::id)
+                    ++stopped_count;
+                if (ev->getID() == EventCameraReady::id)
+                    ++ready_count;
+            }
+            waiter.cv.notify_all();
+        }};
+
+    CameraController controller{"/tmp", std::move(sim)};
+    FocusStacking stacking{};
+    controller.start();
+    stacking.start();
+
+    sBroker.post(EventCameraCmdDownload{true}, TOPIC_CAMERA_CMD);
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, 1));
+
+    sBroker.post(EventFocusStackingStart{NUM_FRAMES, FOCUS_STEPS, true},
+                 TOPIC_MODE_FSM);
+    // The final state is published when entering Ready, after the mode
+    // stopped
+    assert(waiter.waitUntil(
+        [] { return stopped_count == 1 && last_state.state == "Ready"; },
+        seconds(10)));
+    {
+        unique_lock<mutex> lock(waiter.mtx);
+        fmt::print("positions: {}\n", positions);
+        fmt::print("capture: {} ms, focus: {} ms, avg step: {} ms, total: {} "
+                   "ms\n",
+                   last_state.capture_time_ms, last_state.focus_time_ms,
+                   last_state.avg_step_time_ms, last_state.stack_time_ms);
+    }
+
+    assert(last_state.num_captures == NUM_FRAMES);
+    assert(cam.getStats().captures == NUM_FRAMES);
+    assert(cam.getStats().downloads == NUM_FRAMES);
+    // One autofocus and a move between each frame
+    assert(cam.getStats().focus_drives == NUM_FRAMES);
+
+    // Every frame captured after its own focus move
+    assert(positions.size() == NUM_FRAMES);
+    for (int i = 0; i < NUM_FRAMES; ++i)
+        assert(positions[i] == i * FOCUS_STEPS);
+
+    // Capture, download and focus move back to back, without reading the
+    // whole configuration in between
+    assert(last_state.focus_time_ms >= 5);
+    assert(last_state.avg_step_time_ms < 50 + 10 + 10 + 5 + 30);
+
+    stacking.stop();
+    controller.stop();
+    sBroker.stop();
+
+    fmt::print("Focus stacking OK\n");
+    return 0;
+}
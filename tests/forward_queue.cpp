@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <memory>
+
+#include "Events.h"
+#include "comm/ForwardQueue.h"
+
+using std::make_shared;
+
+int main()
+{
+    ForwardQueue q{3};
+
+    // Coalesced events keep their position, but carry the latest value
+    assert(q.push(make_shared<EventConfigValueISO>(100), true));
+    assert(q.push(make_shared<EventCameraReady>(), false));
+    assert(q.push(make_shared<EventConfigValueISO>(200), true));
+    assert(q.push(make_shared<EventConfigValueISO>(400), true));
+    assert(q.size() == 2);
+    assert(q.getCoalescedCount() == 2);
+
+    assert(q.push(make_shared<EventConfigValueAperture>(56), true));
+    assert(!q.push(make_shared<EventCameraReady>(), false));
+    assert(q.getDroppedCount() == 1);
+
+    // Replacing a pending value is always possible, even when full
+    assert(q.push(make_shared<EventConfigValueAperture>(80), true));
+
+    auto ev = q.pop();
+    assert(ev->getID() == EventConfigValueISO::id);
+    assert(std::static_pointer_cast<const EventConfigValueISO>(ev)->iso ==
+           400);
+
+    assert(q.pop()->getID() == EventCameraReady::id);
+
+    ev = q.pop();
+    assert(ev->getID() == EventConfigValueAperture::id);
+    assert(std::static_pointer_cast<const EventConfigValueAperture>(ev)
+               ->aperture == 80);
+    assert(q.empty());
+
+    // Once popped, a new value is queued again
+    assert(q.push(make_shared<EventConfigValueISO>(800), true));
+    assert(q.size() == 1);
+
+    q.clear();
+    assert(q.empty());
+
+    fmt::print("ForwardQueue OK\n");
+    return 0;
+}
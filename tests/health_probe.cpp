@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "event_waiter.h"
+#include "fsm/CameraController.h"
+#include "fsm/HealthProbe.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::chrono::duration_cast;
+using std::chrono::steady_clock;
+
+void testAdaptivePeriod()
+{
+    HealthProbe probe{milliseconds(100), milliseconds(1600)};
+    assert(probe.getPeriod() == milliseconds(100));
+
+    // Backs off while the camera is healthy
+    for (int i = 0; i < 10; ++i)
+        probe.record(true, microseconds(500));
+    assert(probe.getPeriod() == milliseconds(1600));
+    assert(probe.getAverageLatency() == microseconds(500));
+    assert(probe.getMaxLatency() == microseconds(500));
+
+    // A much slower probe is an anomaly: probe often again
+    probe.record(true, microseconds(10000));
+    assert(probe.getPeriod() == milliseconds(100));
+    assert(probe.getMaxLatency() == microseconds(10000));
+
+    probe.record(true, microseconds(500));
+    assert(probe.getPeriod() == milliseconds(200));
+
+    // Failures too
+    probe.record(false, microseconds(0));
+    probe.record(false, microseconds(0));
+    assert(probe.getPeriod() == milliseconds(100));
+    assert(probe.getFailures() == 2);
+
+    probe.record(true, microseconds(500));
+    assert(probe.getFailures() == 0);
+
+    // Old samples leave the history
+    for (int i = 0; i < 100; ++i)
+        probe.record(true, microseconds(100));
+    assert(probe.getAverageLatency() == microseconds(100));
+    assert(probe.getMaxLatency() == microseconds(100));
+
+    probe.reset();
+    assert(probe.getPeriod() == milliseconds(100));
+    assert(probe.getAverageLatency() == microseconds(0));
+}
+
+EventWaiter waiter;
+int ready_count = 0;
+int error_count = 0;
+
+int main()
+{
+    testAdaptivePeriod();
+
+    Logging::getStdOutLogSink().disable();
+    sBroker.start();
+
+    EventSniffer sniffer{sEventBroker,
+                         {TOPIC_CAMERA_EVENT},
+                         [&](const EventPtr& ev, uint8_t topic)
+                         {
+                             {
+                                 unique_lock<mutex> lock(waiter.mtx);
+                                 if (ev->getID() == EventCameraReady::id)
+                                     ++ready_count;
+                                 if (ev->getID() == EventCameraError::id)
+                                     ++error_count;
+                             }
+                             waiter.cv.notify_all();
+                         }};
+
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time = milliseconds(1);
+    cfg.config_rtt   = milliseconds(10);
+
+    auto sim             = make_unique<SimulatedCamera>(cfg);
+    SimulatedCamera& cam = *sim;
+
+    CameraController controller{"/tmp", std::move(sim)};
+    controller.start();
+
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, 1));
+
+    // Probing an idle camera does not touch its settings
+    std::this_thread::sleep_for(milliseconds(300));
+    uint64_t ops = cam.getStats().config_ops;
+    std::this_thread::sleep_for(milliseconds(2000));
+    assert(cam.getStats().config_ops == ops);
+
+    // Unplugging is noticed within a probe period
+    auto unplugged = steady_clock::now();
+    cam.setUnplugged(true);
+    assert(waiter.waitFor(error_count, 1));
+    auto detection =
+        duration_cast<milliseconds>(steady_clock::now() - unplugged);
+    fmt::print("Unplug detected in {} ms\n", detection.count());
+    assert(detection < milliseconds(4500));
+
+    controller.stop();
+    sBroker.stop();
+
+    fmt::print("Health probe OK\n");
+    return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "fsm/modes/Intervalometer.h"
+#include "utils/EventSniffer.h"
+
+using std::condition_variable;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::seconds;
+
+static constexpr int INTERVAL_MS  = 50;
+static constexpr int TOLERANCE_MS = 20;
+
+struct RunResult
+{
+    // Capture start times, in ms from the first capture
+    vector<int> captures;
+    EventIntervalometerState last_state;
+};
+
+/**
+ * Runs the intervalometer against a fake camera, where the i-th capture takes
+ * capture_ms[i] milliseconds (the last value is used for the remaining ones).
+ */
+RunResult run(const string& policy, int total,
+              vector<unsigned int> capture_ms)
+{
+    mutex mtx;
+    condition_variable cv;
+    bool stopped = false;
+
+    RunResult res;
+    steady_clock::time_point first;
+
+    EventSniffer sniffer{
+        sBroker,
+        {TOPIC_CAMERA_CMD, TOPIC_MODE_STATE, TOPIC_MODE_CONTROLLER},
+        [&](const EventPtr& ev, uint8_t topic)
+        {
+            unique_lock<mutex> lock(mtx);
+            switch (ev->getID())
+            {
+                case EventCameraCmdCapture::id:
+                {
+                    auto now = steady_clock::now();
+                    if (res.captures.empty())
+                        first = now;
+                    res.captures.push_back(
+                        duration_cast<milliseconds>(now - first).count());
+
+                    size_t i = std::min(res.captures.size(), capture_ms.size());
+                    sBroker.postDelayed(EventCameraCaptureDone{true, "", ""},
+                                        TOPIC_CAMERA_EVENT, capture_ms[i - 1]);
+                    break;
+                }
+                case EventIntervalometerState::id:
+                {
+                    auto state =
+                        dynamic_pointer_cast<const EventIntervalometerState>(ev);
+                    res.last_state = *state;
+                    break;
+                }
+                case EventModeStopped::id:
+                    stopped = true;
+                    cv.notify_all();
+                    break;
+                default:
+                    break;
+            }
+        }};
+
+    sBroker.post(EventIntervalometerStart{INTERVAL_MS, total, policy},
+                 TOPIC_MODE_FSM);
+
+    unique_lock<mutex> lock(mtx);
+    bool ok = cv.wait_for(lock, seconds(5), [&] { return stopped; });
+    assert(ok);
+
+    // Let the Ready state publish itself before the next run
+    lock.unlock();
+    std::this_thread::sleep_for(milliseconds(20));
+    lock.lock();
+
+    fmt::print("{:>9}: captures at {}, missed: {}, max error: {} us\n",
+               policy.empty() ? "relative" : policy,
+               fmt::join(res.captures, " "), res.last_state.missed_frames,
+               res.last_state.max_timing_error_us);
+    return res;
+}
+
+bool near(int t, int expected)
+{
+    return std::abs(t - expected) <= TOLERANCE_MS;
+}
+
+int main()
+{
+    Logging::getStdOutLogSink().disable();
+    sBroker.start();
+
+    Intervalometer interv{};
+    interv.start();
+
+    sBroker.post(EventCameraReady{}, TOPIC_CAMERA_EVENT);
+    std::this_thread::sleep_for(milliseconds(20));
+
+    // On time: frame k starts at k * interval
+    auto r = run("catch_up", 8, {10});
+    assert(r.captures.size() == 8);
+    for (int k = 0; k < 8; ++k)
+        assert(near(r.captures[k], k * INTERVAL_MS));
+    assert(r.last_state.missed_frames == 0);
+    assert(r.last_state.max_timing_error_us < TOLERANCE_MS * 1000);
+
+    // First frame is late: the following ones are captured back to back
+    // until the sequence is back on schedule
+    r = run("catch_up", 6, {130, 10});
+    assert(near(r.captures[1], 130));
+    assert(near(r.captures[2], 140));
+    assert(near(r.captures[3], 150));
+    assert(near(r.captures[5], 250));
+    assert(r.last_state.max_timing_error_us >= 70000);
+
+    // Same, but the schedule is shifted by the delay
+    r = run("stretch", 6, {130, 10});
+    assert(near(r.captures[1], 130));
+    assert(near(r.captures[2], 180));
+    assert(near(r.captures[5], 330));
+    assert(r.last_state.missed_frames == 0);
+    assert(r.last_state.max_timing_error_us >= 70000);
+
+    // Late frames are dropped, the others stay on the original schedule
+    r = run("skip", 4, {130, 10});
+    assert(near(r.captures[1], 150));
+    assert(near(r.captures[2], 200));
+    assert(near(r.captures[3], 250));
+    assert(r.last_state.missed_frames == 2);
+
+    // Legacy scheduling: each frame is relative to the start of the previous
+    r = run("", 4, {130, 10});
+    assert(near(r.captures[1], 130));
+    assert(near(r.captures[2], 180));
+    assert(near(r.captures[3], 230));
+
+    interv.stop();
+    sBroker.stop();
+
+    fmt::print("Anchored intervalometer OK\n");
+    return 0;
+}
@@ -50,4 +50,37 @@ int main()
 
     assert(ev.shutter_speed == ev2_c->shutter_speed);
 
+    // First and last entries of the decoder table
+    assert(jsonToEvent(EventHeartBeat{}.to_json())->getID() ==
+           EventHeartBeat::id);
+    EventUsbDeviceRemoved removed{"usb:001,002"};
+    auto removed2 = std::dynamic_pointer_cast<const EventUsbDeviceRemoved>(
+        jsonToEvent(removed.to_json()));
+    assert(removed2 && removed2->port == removed.port);
+
+    for (uint16_t id : {0, 9, 10000})
+    {
+        bool thrown = false;
+        try
+        {
+            jsonToEvent(json{{"event_id", id}});
+        }
+        catch (std::out_of_range& e)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    assert(getTopicName(TOPIC_CAMERA_CMD) == "TOPIC_CAMERA_CMD");
+    assert(getTopicName(TOPIC_HEARTBEAT) == "TOPIC_HEARTBEAT");
+    assert(getTopicName(200) == "200");
+    assert(getTopicID("TOPIC_MODE_FSM") == TOPIC_MODE_FSM);
+    assert(getTopicID("TOPIC_UNKNOWN") == 255);
+
+    assert(ev.to_string() ==
+           "EventConfigSetShutterSpeed {shutter_speed = 1234}");
+    assert((EventCameraList{{"A", "B"}}.to_string() ==
+            "EventCameraList {serials = [\"A\", \"B\"]}"));
+    assert(EventHeartBeat{}.to_string() == "EventHeartBeat");
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Events.h"
+#include "JsonReader.h"
+
+using nlohmann::json;
+using std::string;
+using std::vector;
+
+/**
+ * Result of decoding, or the kind of error that was thrown
+ */
+template <typename Fun>
+string decode(Fun&& fun)
+{
+    try
+    {
+        return fun()->dump();
+    }
+    catch (json::parse_error& e)
+    {
+        return "parse_error";
+    }
+    catch (json::type_error& e)
+    {
+        return "type_error";
+    }
+    catch (json::out_of_range& e)
+    {
+        return "json_out_of_range";
+    }
+    catch (std::out_of_range& e)
+    {
+        return "out_of_range";
+    }
+}
+
+/**
+ * Events decoded straight from the string must be the same as the ones
+ * decoded through a json object, errors included
+ */
+string check(const string& str)
+{
+    string dom = decode([&] { return jsonToEvent(json::parse(str)); });
+    string sax = decode([&] { return jsonStringToEvent(str); });
+    if (dom != sax)
+        fmt::print(stderr, "Mismatch for {}:\n  {}\n  {}\n", str, dom, sax);
+    assert(dom == sax);
+    return sax;
+}
+
+int main()
+{
+    // Round trip
+    vector<EventPtr> events{
+        std::make_shared<EventHeartBeat>(),
+        std::make_shared<EventCameraCmdDownload>(true),
+        std::make_shared<EventCameraCaptureDone>(true, "/tmp/\"photos\"\n",
+                                                 "città.jpg"),
+        std::make_shared<EventCameraControllerState>("Ready", true, false,
+                                                     true, 1234, -1, 0),
+        std::make_shared<EventConfigValueLightMeter>(-1.5f, 0.1f, 1e20f),
+        std::make_shared<EventConfigChoicesISO>(vector<int32_t>{100, 200}),
+        std::make_shared<EventConfigChoicesISO>(vector<int32_t>{}),
+        std::make_shared<EventCameraList>(vector<string>{"a", "", "b\\c"}),
+    };
+    for (const EventPtr& ev : events)
+        assert(check(ev->dump()) == ev->dump());
+
+    const string iso = fmt::format("\"event_id\":{}", EventConfigValueISO::id);
+    const string choices =
+        fmt::format("\"event_id\":{}", EventConfigChoicesISO::id);
+    const string dl =
+        fmt::format("\"event_id\":{}", EventCameraCmdDownload::id);
+
+    // Phone clients put the id after the fields, unknown keys are ignored
+    assert(check("{\"iso\":400," + iso + "}") ==
+           EventConfigValueISO{400}.dump());
+    assert(check("{\"x\":{\"iso\":1,\"event_id\":2},\"iso\":400,\"y\":[[{}]]," +
+                 iso + "}") == EventConfigValueISO{400}.dump());
+
+    // Numbers are converted, the last duplicate wins
+    assert(check("{" + iso + ",\"iso\":400.7}") ==
+           EventConfigValueISO{400}.dump());
+    assert(check("{" + iso + ",\"iso\":1,\"iso\":2}") ==
+           EventConfigValueISO{2}.dump());
+    assert(check("{" + choices +
+                 ",\"iso_choices\":[1],\"iso_choices\":[2.5]}") ==
+           EventConfigChoicesISO{{2}}.dump());
+
+    // Errors
+    assert(check("{" + iso + "}") == "json_out_of_range");
+    assert(check("{" + iso + ",\"iso\":\"400\"}") == "type_error");
+    assert(check("{" + iso + ",\"iso\":null}") == "type_error");
+    assert(check("{" + iso + ",\"iso\":[400]}") == "type_error");
+    assert(check("{" + dl + ",\"download\":1}") == "type_error");
+    assert(check("{" + choices + ",\"iso_choices\":5}") == "type_error");
+    assert(check("{" + choices + ",\"iso_choices\":[1,\"a\"]}") ==
+           "type_error");
+    assert(check("{" + choices + ",\"iso_choices\":[[1]]}") == "type_error");
+    assert(check("{" + iso + ",\"iso\":400") == "parse_error");
+    assert(check("{\"iso\":400,]" + iso + "}") == "parse_error");
+    assert(check("{\"event_id\":10000}") == "out_of_range");
+    assert(check("{\"event_id\":9}") == "out_of_range");
+    assert(check("{\"event_id\":\"10\"}") == "type_error");
+    assert(check("[10]") == "type_error");
+    assert(check("{}") == "json_out_of_range");
+    assert(check("{" + iso + ",\"iso\":1e400}") == "json_out_of_range");
+    assert(check("{" + iso + ",\"iso\":400} x") == "parse_error");
+    assert(check("{" + iso + ",\"iso\":0400}") == "parse_error");
+    assert(check("") == "parse_error");
+
+    // Booleans are converted to numbers, as nlohmann::json does
+    assert(check("{" + iso + ",\"iso\":true}") ==
+           EventConfigValueISO{1}.dump());
+
+    // Escapes and UTF-8
+    const string list = fmt::format("\"event_id\":{}", EventCameraList::id);
+    EventCameraList decoded{{"è😀/\"", "è😀"}};
+    assert(check("{" + list +
+                 ",\"serials\":[\"\\u00e8\\ud83d\\ude00\\/\\\"\",\"è😀\"]}") ==
+           decoded.dump());
+    for (string bad : {"\\ud83d", "\\ude00", "\\u00zz", "\\x", "\xff",
+                       "\xc3", "\xed\xa0\x80", "\x01"})
+        assert(check("{" + list + ",\"serials\":[\"" + bad + "\"]}") ==
+               "parse_error");
+
+    // Not events
+    uint16_t id;
+    assert(!JsonReader::readEventId("{\"comm_config\":{\"max_rate\":2}}",
+                                    id));
+    assert(!JsonReader::readEventId("{\"a\":{\"event_id\":10}}", id));
+    assert(!JsonReader::readEventId("[10]", id));
+    assert(!JsonReader::readEventId("10", id));
+
+    // The id is found without parsing the rest of the packet
+    assert(JsonReader::readEventId("{\"event_id\":42,\"iso\":", id));
+    assert(id == 42);
+
+    // Random corruptions of valid commands are either decoded to the same
+    // event or rejected with the same error
+    vector<string> commands{
+        "{" + iso + ",\"iso\":400}",
+        "{\"x\":[1,-2.5e3,{\"y\":null}],\"iso\":true," + iso + "}",
+        "{" + list + ",\"serials\":[\"a\\n\",\"\\u00e8\",\"è\"]}",
+        "{" + choices + ",\"iso_choices\":[100,200,400]}",
+        EventCameraControllerState{"Ready", true, false, true, 1, 2, 3}.dump(),
+        EventConfigValueLightMeter{-1.5f, 0.1f, 1e20f}.dump(),
+    };
+    const string alphabet = "{}[]\":,-.+0123456789eEtrufalsn\\ \x01\xc3\xa8";
+
+    std::mt19937 rng{42};
+    int mismatches = 0;
+    for (int i = 0; i < 50000; ++i)
+    {
+        string str = commands[rng() % commands.size()];
+        for (int m = 1 + rng() % 3; m > 0; --m)
+        {
+            size_t p = rng() % (str.size() + 1);
+            char c   = alphabet[rng() % alphabet.size()];
+            switch (rng() % 3)
+            {
+                case 0:
+                    if (p < str.size())
+                        str[p] = c;
+                    break;
+                case 1:
+                    str.insert(p, 1, c);
+                    break;
+                default:
+                    if (p < str.size())
+                        str.erase(p, 1);
+                    break;
+            }
+        }
+
+        string dom = decode([&] { return jsonToEvent(json::parse(str)); });
+        string sax = decode([&] { return jsonStringToEvent(str); });
+        if (dom == sax)
+            continue;
+
+        // Ids that are not unsigned 16 bit numbers are converted by
+        // jsonToEvent(), but rejected when decoding from the string
+        json j = json::parse(str, nullptr, false);
+        if (j.is_object() && j.contains("event_id") &&
+            j["event_id"].is_number() &&
+            (!j["event_id"].is_number_unsigned() || j["event_id"] > 65535))
+            continue;
+
+        fmt::print(stderr, "Mismatch for {}:\n  {}\n  {}\n", str, dom, sax);
+        ++mismatches;
+    }
+    assert(mismatches == 0);
+
+    fmt::print("Json reader OK\n");
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Events.h"
+#include "JsonReader.h"
+#include "alloc_counter.h"
+
+using nlohmann::json;
+using std::string;
+using std::string_view;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+static constexpr int DEFAULT_ITERATIONS = 100000;
+
+/**
+ * Json of a command as sent by the app: Gson writes the event id after the
+ * fields of the event
+ */
+string command(const Event& ev)
+{
+    json j = ev.to_json();
+    j.erase("event_id");
+
+    string str = j.dump();
+    str.insert(str.size() - 1, fmt::format("{}\"event_id\":{}",
+                                           j.empty() ? "" : ",", ev.getID()));
+    return str;
+}
+
+struct Result
+{
+    double ns_per_command;
+    double allocs_per_command;
+};
+
+template <typename Fun>
+Result measure(const vector<string>& commands, int iterations, Fun&& fun)
+{
+    uint64_t allocs = num_allocs;
+    auto start      = steady_clock::now();
+
+    uint64_t ids = 0;
+    for (int i = 0; i < iterations; ++i)
+        for (const string& cmd : commands)
+            ids += fun(cmd)->getID();
+
+    double ns =
+        duration<double, std::nano>(steady_clock::now() - start).count();
+    uint64_t total = (uint64_t)iterations * commands.size();
+    assert(ids > 0);
+
+    return {ns / total, (double)(num_allocs - allocs) / total};
+}
+
+/**
+ * Decodes a mix of commands sent by the app, through a json object as the
+ * receiver used to, versus with the SAX reader.
+ * Usage: json_reader_bench [iterations]
+ */
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : DEFAULT_ITERATIONS;
+
+    vector<string> commands{
+        command(EventCameraCmdCapture{}),
+        command(EventConfigSetISO{800}),
+        command(EventConfigSetShutterSpeed{1250}),
+        command(EventConfigSetAperture{56}),
+        command(EventGetCameraControllerState{}),
+        command(EventCameraCmdDownload{false}),
+        command(EventModeIntervalometer{5000, 300}),
+        command(EventModeBracketing{5, 0.7f, true}),
+        command(EventCameraCmdForward{"032021001234",
+                                      command(EventCameraCmdCapture{})}),
+    };
+
+    for (const string& cmd : commands)
+        assert(jsonStringToEvent(cmd)->dump() ==
+               jsonToEvent(json::parse(cmd))->dump());
+
+    Result dom = measure(commands, iterations,
+                         [](const string& cmd)
+                         {
+                             // Copy of the packet, as the receiver did
+                             vector<uint8_t> packet(cmd.begin(), cmd.end());
+                             json j = json::parse(packet);
+                             assert(j.contains("event_id") &&
+                                    j.at("event_id").is_number_unsigned());
+                             return jsonToEvent(j);
+                         });
+
+    Result sax = measure(commands, iterations,
+                         [](const string& cmd)
+                         {
+                             uint16_t id;
+                             bool is_event = JsonReader::readEventId(cmd, id);
+                             assert(is_event);
+                             return jsonStringToEvent(id, cmd);
+                         });
+
+    fmt::print("json::parse():       {:6.0f} ns/command, {:5.2f} "
+               "allocs/command\n",
+               dom.ns_per_command, dom.allocs_per_command);
+    fmt::print("jsonStringToEvent(): {:6.0f} ns/command, {:5.2f} "
+               "allocs/command\n",
+               sax.ns_per_command, sax.allocs_per_command);
+    fmt::print("saved:               {:6.0f} ns/command, {:5.2f} "
+               "allocs/command\n",
+               dom.ns_per_command - sax.ns_per_command,
+               dom.allocs_per_command - sax.allocs_per_command);
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Events.h"
+#include "JsonWriter.h"
+
+using nlohmann::json;
+using std::numeric_limits;
+using std::string;
+using std::vector;
+
+/**
+ * The writers must produce exactly what clients parse today, that is the
+ * output of nlohmann::json::dump()
+ */
+void check(const Event& ev)
+{
+    fmt::memory_buffer buf;
+    ev.write_json(buf);
+
+    string expected = ev.to_json().dump();
+    string written  = fmt::to_string(buf);
+    if (written != expected)
+        fmt::print(stderr, "Mismatch:\n  {}\n  {}\n", expected, written);
+    assert(written == expected);
+    assert(ev.dump() == expected);
+}
+
+template <typename T>
+void checkValue(const T& value)
+{
+    fmt::memory_buffer buf;
+    JsonWriter::write(buf, value);
+
+    string expected = json(value).dump();
+    string written  = fmt::to_string(buf);
+    if (written != expected)
+        fmt::print(stderr, "Mismatch: {} vs {}\n", expected, written);
+    assert(written == expected);
+}
+
+int main()
+{
+    check(EventHeartBeat{});
+    check(EventCameraCmdDownload{true});
+    check(EventCameraCaptureDone{true, "/tmp/photos", "IMG_0001.jpg"});
+    check(EventCameraControllerState{"Ready", true, false, true, 1234, 1000,
+                                     -1});
+    check(EventConfigValueLightMeter{-1.5f, 0.1f, 1e20f});
+    check(EventConfigValueLightMeter{numeric_limits<float>::quiet_NaN(),
+                                     numeric_limits<float>::infinity(),
+                                     -0.0f});
+    check(EventModeBracketing{5, 1.0f / 3, false});
+    check(EventConfigChoicesISO{{100, 200, 400, 6400}});
+    check(EventConfigChoicesISO{{}});
+    check(EventCameraList{{"", "serial \"1\"", "città"}});
+    check(EventCameraCmdForward{
+        "1234", EventCameraCmdDownload{false}.to_json().dump()});
+    check(EventCameraCaptureDone{false, "C:\\photos\n", "\t\b\f\r\x01\x1f\x7f"});
+
+    // All ASCII characters, control characters included
+    string ascii;
+    for (char c = 1; c > 0; ++c)
+        ascii.push_back(c);
+    checkValue(ascii);
+
+    for (int64_t v : {numeric_limits<int64_t>::min(), (int64_t)-1, (int64_t)0,
+                      numeric_limits<int64_t>::max()})
+        checkValue(v);
+    checkValue(numeric_limits<uint64_t>::max());
+    checkValue(vector<bool>{true, false});
+
+    // Formatting switches between fixed and exponential notation at the
+    // same points as nlohmann::json
+    for (double v : {1.0, 10.0, 0.1, 1e-4, 1.5e-4, 1e-5, 123.456, 1e15, 1e16,
+                     9.999e15, 123456789012345678.0, 5e-324, 2.2250738585072014e-308,
+                     numeric_limits<double>::max()})
+    {
+        checkValue(v);
+        checkValue(-v);
+    }
+
+    std::mt19937_64 rng{42};
+    std::uniform_real_distribution<double> mantissa{1, 10};
+    std::uniform_int_distribution<int> exponent{-30, 30};
+    for (int i = 0; i < 100000; ++i)
+    {
+        double v = mantissa(rng) * std::pow(10.0, exponent(rng));
+        checkValue(v);
+        checkValue((float)v);
+    }
+
+    fmt::print("Json writer OK\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "Events.h"
+#include "alloc_counter.h"
+
+using std::string_view;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+static constexpr int DEFAULT_ITERATIONS = 100000;
+
+/**
+ * Same framing as JsonTcpServer: 4 bytes of length, then the json string
+ */
+vector<uint8_t> frame(string_view str)
+{
+    vector<uint8_t> v(str.size() + 4);
+    uint32_t len = str.size();
+    memcpy(v.data(), &len, 4);
+    memcpy(v.data() + 4, str.data(), str.size());
+    return v;
+}
+
+struct Result
+{
+    double ns_per_event;
+    double allocs_per_event;
+};
+
+template <typename Fun>
+Result measure(const vector<EventPtr>& events, int iterations, Fun&& fun)
+{
+    uint64_t allocs = num_allocs;
+    auto start      = steady_clock::now();
+
+    size_t bytes = 0;
+    for (int i = 0; i < iterations; ++i)
+        for (const EventPtr& ev : events)
+            bytes += fun(*ev).size();
+
+    double ns =
+        duration<double, std::nano>(steady_clock::now() - start).count();
+    uint64_t total = (uint64_t)iterations * events.size();
+    assert(bytes > 0);
+
+    return {ns / total, (double)(num_allocs - allocs) / total};
+}
+
+/**
+ * Serializes a mix of outbound events, building the json object and dumping
+ * it versus writing it directly to a reused buffer. Both are then framed as
+ * a TCP packet.
+ * Usage: json_writer_bench [iterations]
+ */
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : DEFAULT_ITERATIONS;
+
+    vector<EventPtr> events{
+        std::make_shared<EventCameraControllerState>("Ready", true, true,
+                                                     false, 850, 1000, -1),
+        std::make_shared<EventConfigValueISO>(400),
+        std::make_shared<EventConfigValueLightMeter>(-0.3f, -3.0f, 3.0f),
+        std::make_shared<EventConfigChoicesISO>(
+            vector<int32_t>{100, 200, 400, 800, 1600, 3200, 6400}),
+        std::make_shared<EventCameraCaptureDone>(true, "/home/pi/photos",
+                                                 "IMG_0042.CR2"),
+        std::make_shared<EventIntervalometerState>("Running", 5000, 42, 100,
+                                                   0, 120, 850),
+    };
+
+    for (const EventPtr& ev : events)
+        assert(ev->dump() == ev->to_json().dump());
+
+    Result dom = measure(events, iterations, [](const Event& ev)
+                         { return frame(ev.to_json().dump()); });
+
+    fmt::memory_buffer buf;
+    Result direct = measure(events, iterations,
+                            [&](const Event& ev)
+                            {
+                                buf.clear();
+                                ev.write_json(buf);
+                                return frame({buf.data(), buf.size()});
+                            });
+
+    fmt::print("to_json().dump(): {:6.0f} ns/event, {:5.2f} allocs/event\n",
+               dom.ns_per_event, dom.allocs_per_event);
+    fmt::print("write_json():     {:6.0f} ns/event, {:5.2f} allocs/event\n",
+               direct.ns_per_event, direct.allocs_per_event);
+    fmt::print("saved:            {:6.0f} ns/event, {:5.2f} allocs/event\n",
+               dom.ns_per_event - direct.ns_per_event,
+               dom.allocs_per_event - direct.allocs_per_event);
+
+    return 0;
+}
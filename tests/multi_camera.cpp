@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "fsm/MultiCameraController.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using nlohmann::json;
+using std::condition_variable;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+static constexpr int NUM_CAMERAS = 3;
+
+mutex mtx;
+condition_variable cv;
+int ready_count = 0;
+vector<EventCaptureAllDone> capture_all;
+vector<EventCameraForwarded> forwarded;
+vector<string> serials;
+
+template <typename Pred>
+bool waitFor(Pred pred)
+{
+    unique_lock<mutex> lock(mtx);
+    return cv.wait_for(lock, seconds(5), pred);
+}
+
+int main()
+{
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+    sBroker.start();
+
+    EventSniffer sniffer{
+        sEventBroker,
+        {TOPIC_CAMERA_EVENT},
+        [&](const EventPtr& ev, uint8_t topic)
+        {
+            {
+                unique_lock<mutex> lock(mtx);
+                switch (ev->getID())
+                {
+                    case EventCameraReady::id:
+                        ++ready_count;
+                        break;
+                    case EventCaptureAllDone::id:
+                        capture_all.push_back(
+                            *dynamic_pointer_cast<const EventCaptureAllDone>(
+                                ev));
+                        break;
+                    case EventCameraForwarded::id:
+                        forwarded.push_back(
+                            *dynamic_pointer_cast<const EventCameraForwarded>(
+                                ev));
+                        break;
+                    case EventCameraList::id:
+                        serials =
+                            dynamic_pointer_cast<const EventCameraList>(ev)
+                                ->serials;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            cv.notify_all();
+        }};
+
+    vector<SimulatedCamera*> sims;
+    vector<unique_ptr<CameraBase>> cameras;
+    for (int i = 0; i < NUM_CAMERAS; ++i)
+    {
+        SimulatedCameraConfig cfg{};
+        cfg.serial        = fmt::format("SIM00000{}", i + 1);
+        cfg.connect_time  = milliseconds(1);
+        cfg.config_rtt    = milliseconds(1);
+        cfg.capture_time  = milliseconds(20);
+        cfg.wait_exposure = false;
+
+        auto sim = make_unique<SimulatedCamera>(cfg);
+        sims.push_back(sim.get());
+        cameras.push_back(std::move(sim));
+    }
+
+    MultiCameraController controller{"/tmp", std::move(cameras)};
+    assert((controller.getSerials() ==
+            vector<string>{"SIM000001", "SIM000002", "SIM000003"}));
+    assert(MultiCameraController::getTopics(0).cmd == TOPIC_CAMERA_CMD);
+    assert(MultiCameraController::getTopics(2).cmd ==
+           MultiCameraController::FIRST_CAMERA_TOPIC + 3);
+
+    controller.start();
+    assert(waitFor([] { return serials.size() == NUM_CAMERAS; }));
+
+    // Connection commands reach all the cameras
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waitFor(
+        []
+        {
+            int fwd_ready = 0;
+            for (auto& f : forwarded)
+                if (json::parse(f.event)["event_id"] == EventCameraReady::id)
+                    ++fwd_ready;
+            return ready_count >= 1 && fwd_ready >= NUM_CAMERAS - 1;
+        }));
+    std::this_thread::sleep_for(milliseconds(100));
+
+    // All the cameras are triggered together
+    sBroker.post(EventCameraCmdCaptureAll{}, TOPIC_CAMERA_CMD);
+    assert(waitFor([] { return capture_all.size() == 1; }));
+    {
+        unique_lock<mutex> lock(mtx);
+        auto& done = capture_all[0];
+        fmt::print("Captured {}/{} in {} ms, trigger skew: {} us\n",
+                   done.num_captured, done.num_cameras, done.capture_time_ms,
+                   done.trigger_skew_us);
+        assert(done.num_cameras == NUM_CAMERAS);
+        assert(done.num_captured == NUM_CAMERAS);
+        // Triggers are only delayed by the queueing of the commands
+        assert(done.trigger_skew_us < 10000);
+    }
+    for (auto sim : sims)
+        assert(sim->getStats().captures == 1);
+
+    // Commands routed by serial only reach that camera
+    sBroker.post(EventCameraCmdForward{"SIM000003",
+                                       EventCameraCmdCapture{}.to_json().dump()},
+                 TOPIC_CAMERA_CMD);
+    assert(waitFor([&] { return sims[2]->getStats().captures == 2; }));
+    std::this_thread::sleep_for(milliseconds(100));
+    assert(sims[0]->getStats().captures == 1);
+    assert(sims[1]->getStats().captures == 1);
+
+    controller.stop();
+    sBroker.stop();
+
+    fmt::print("Multi camera OK\n");
+    return 0;
+}
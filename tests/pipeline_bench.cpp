@@ -0,0 +1,334 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <arpa/inet.h>
+#include <fmt/core.h>
+#include <sockpp/tcp_connector.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "alloc_counter.h"
+#include "camera/SimulatedCamera.h"
+#include "comm/CommManager.h"
+#include "fsm/CameraController.h"
+#include "fsm/ModeController.h"
+#include "fsm/modes/Intervalometer.h"
+#include "utils/ActiveObject.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using nlohmann::json;
+using std::condition_variable;
+using std::lock_guard;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+using std::this_thread::sleep_for;
+
+/*
+ * End to end benchmark of the controller pipeline: a TCP client sends
+ * commands to the CommManager, which are routed through the ModeController,
+ * the Intervalometer and the CameraController (driving a SimulatedCamera),
+ * and the resulting events are forwarded back to the client.
+ *
+ * Usage: bench_pipeline_bench [num_captures] [output.json]
+ */
+
+static constexpr uint16_t PORT = 60199;
+
+/**
+ * Remote client, speaking the same length-prefixed JSON protocol as the
+ * phone app.
+ */
+class BenchClient : public ActiveObject
+{
+public:
+    BenchClient(uint16_t port)
+    {
+        while (!conn.connect(sockpp::inet_address("localhost", port)))
+            sleep_for(milliseconds(100));
+        start();
+    }
+
+    ~BenchClient() { stop(); }
+
+    void stop() override
+    {
+        if (started && !stopped)
+        {
+            should_stop = true;
+            conn.shutdown();
+
+            if (thread_obj->joinable())
+                thread_obj->join();
+            stopped = true;
+        }
+    }
+
+    void send(const json& j)
+    {
+        string str   = j.dump();
+        uint32_t len = htonl(str.length());
+
+        // Single write: avoids Nagle + delayed ACK stalls on the payload
+        vector<uint8_t> packet((uint8_t*)&len, (uint8_t*)&len + 4);
+        packet.insert(packet.end(), str.begin(), str.end());
+
+        lock_guard<mutex> lock(mtx_send);
+        conn.write_n(packet.data(), packet.size());
+    }
+
+    /**
+     * @brief Waits until at least @p count events with the given id have been
+     * received
+     */
+    bool waitFor(uint16_t event_id, uint64_t count)
+    {
+        unique_lock<mutex> lock(mtx);
+        return cv.wait_for(lock, seconds(30),
+                           [&] { return received[event_id] >= count; });
+    }
+
+    bool waitForSync()
+    {
+        unique_lock<mutex> lock(mtx);
+        return cv.wait_for(lock, seconds(30), [&] { return synced; });
+    }
+
+    uint64_t getMessageCount()
+    {
+        lock_guard<mutex> lock(mtx);
+        return num_messages;
+    }
+
+protected:
+    void run() override
+    {
+        vector<uint8_t> buf;
+        while (!shouldStop())
+        {
+            uint32_t len;
+            if (conn.read_n(&len, 4) != 4)
+                break;
+
+            buf.resize(ntohl(len));
+            if (conn.read_n(buf.data(), buf.size()) != (ssize_t)buf.size())
+                break;
+
+            json j = json::parse(buf);
+            {
+                lock_guard<mutex> lock(mtx);
+                ++num_messages;
+                if (j.contains("config_sync"))
+                    synced = true;
+                else if (j.contains("event_id"))
+                    ++received[j["event_id"].get<uint16_t>()];
+            }
+            cv.notify_all();
+        }
+    }
+
+private:
+    sockpp::socket_initializer sock_init;
+    sockpp::tcp_connector conn;
+
+    mutex mtx_send;
+
+    mutex mtx;
+    condition_variable cv;
+    std::map<uint16_t, uint64_t> received;
+    uint64_t num_messages = 0;
+    bool synced           = false;
+};
+
+/**
+ * Process-wide counters at a point in time
+ */
+struct Sample
+{
+    steady_clock::time_point time;
+    double cpu_s;
+    uint64_t allocs;
+    uint64_t events;
+
+    static Sample take(std::atomic<uint64_t>& num_events)
+    {
+        rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        double cpu = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+                     (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+
+        return {steady_clock::now(), cpu, num_allocs.load(), num_events.load()};
+    }
+};
+
+json phaseStats(const Sample& from, const Sample& to, uint64_t captures)
+{
+    double elapsed = duration<double>(to.time - from.time).count();
+
+    json j;
+    j["elapsed_s"]          = elapsed;
+    j["captures_per_s"]     = captures / elapsed;
+    j["events_per_s"]       = (to.events - from.events) / elapsed;
+    j["cpu_us_per_capture"] = (to.cpu_s - from.cpu_s) * 1e6 / captures;
+    j["allocs_per_capture"] = (double)(to.allocs - from.allocs) / captures;
+    return j;
+}
+
+double percentile(vector<double> v, double p)
+{
+    std::sort(v.begin(), v.end());
+    return v.at(std::min(v.size() - 1, (size_t)(p * v.size())));
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t num_captures = argc > 1 ? std::atoi(argv[1]) : 200;
+
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+
+    std::atomic<uint64_t> num_events{0};
+    sBroker.start();
+    EventSniffer counter{sEventBroker, [&](const EventPtr& ev, uint8_t topic)
+                         { ++num_events; }};
+
+    mutex mtx;
+    condition_variable cv;
+    bool camera_ready = false;
+    EventSniffer ready_sniffer{sEventBroker,
+                               {TOPIC_CAMERA_EVENT},
+                               [&](const EventPtr& ev, uint8_t topic)
+                               {
+                                   if (ev->getID() == EventCameraReady::id)
+                                   {
+                                       lock_guard<mutex> lock(mtx);
+                                       camera_ready = true;
+                                       cv.notify_all();
+                                   }
+                               }};
+
+    // Fast camera: measure the controller, not the camera
+    SimulatedCameraConfig cam_cfg{};
+    cam_cfg.connect_time  = milliseconds(0);
+    cam_cfg.config_rtt    = milliseconds(0);
+    cam_cfg.capture_time  = milliseconds(1);
+    cam_cfg.wait_exposure = false;
+
+    CommManager comm{PORT};
+    ModeController mode_ctrl{};
+    Intervalometer intervalometer{};
+    CameraController camera{"/tmp", make_unique<SimulatedCamera>(cam_cfg)};
+
+    mode_ctrl.start();
+    intervalometer.start();
+    camera.start();
+
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    {
+        unique_lock<mutex> lock(mtx);
+        if (!cv.wait_for(lock, seconds(10), [&] { return camera_ready; }))
+        {
+            fmt::print(stderr, "Camera not ready\n");
+            return 1;
+        }
+    }
+
+    BenchClient client{PORT};
+    client.send({{"config_sync", json::object()}});
+    if (!client.waitForSync())
+    {
+        fmt::print(stderr, "No reply from CommManager\n");
+        return 1;
+    }
+
+    // Phase 1: single captures, one at a time, from the remote client
+    vector<double> latencies;
+    Sample s0 = Sample::take(num_events);
+    for (uint64_t i = 1; i <= num_captures; ++i)
+    {
+        auto start = steady_clock::now();
+        client.send(EventCameraCmdCapture{}.to_json());
+        if (!client.waitFor(EventCameraCaptureDone::id, i))
+        {
+            fmt::print(stderr, "Capture {} timed out\n", i);
+            return 1;
+        }
+        latencies.push_back(
+            duration<double, std::micro>(steady_clock::now() - start).count());
+    }
+    Sample s1 = Sample::take(num_events);
+
+    // Phase 2: back to back intervalometer captures
+    client.send(EventModeIntervalometer{-1, (int32_t)num_captures}.to_json());
+    if (!client.waitFor(EventCameraCaptureDone::id, 2 * num_captures))
+    {
+        fmt::print(stderr, "Intervalometer timed out\n");
+        return 1;
+    }
+    Sample s2 = Sample::take(num_events);
+
+    double mean = 0;
+    for (double l : latencies)
+        mean += l / latencies.size();
+
+    json result;
+    result["captures"]                   = num_captures;
+    result["command_latency_us"]["mean"] = mean;
+    result["command_latency_us"]["p50"]  = percentile(latencies, 0.5);
+    result["command_latency_us"]["p99"]  = percentile(latencies, 0.99);
+    result["command_latency_us"]["max"] =
+        *std::max_element(latencies.begin(), latencies.end());
+    result["remote_capture"]  = phaseStats(s0, s1, num_captures);
+    result["intervalometer"]  = phaseStats(s1, s2, num_captures);
+    result["client_messages"] = client.getMessageCount();
+
+    string out = result.dump(4);
+    fmt::print("{}\n", out);
+    std::fflush(stdout);
+
+    if (argc > 2)
+        std::ofstream{argv[2]} << out << "\n";
+
+    // Modes and controllers keep posting delayed events (eg: heartbeat):
+    // exit without tearing them down.
+    std::_Exit(0);
+}
@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "fsm/modes/RampPlanner.h"
+
+using std::vector;
+
+static const vector<int32_t> SHUTTER_SPEEDS{
+    250,    500,    1000,   2000,    4000,    8000,    16667,   33333,  66667,
+    125000, 250000, 500000, 1000000, 2000000, 4000000, 8000000, 15000000,
+    30000000, -1};
+
+static const vector<int32_t> APERTURES{180, 200, 280,  400, 560,
+                                       800, 1100, 1600, 2200};
+
+static const vector<int32_t> ISOS{100, 200, 400, 800, 1600, 3200, 6400, 12800};
+
+static constexpr ExposureSettings DAY{
+    .shutter_speed = 1000, .iso = 100, .aperture = 800};
+
+RampPlanner makePlanner()
+{
+    RampPlannerConfig cfg{};
+    cfg.max_shutter_speed = 20000000;
+    cfg.max_iso           = 6400;
+    return RampPlanner{cfg, SHUTTER_SPEEDS, ISOS, APERTURES};
+}
+
+/**
+ * Scene getting 22 EV darker over 440 frames: the ramp must follow it
+ * smoothly, changing shutter, then ISO, then aperture, never going back.
+ */
+void testSunset()
+{
+    RampPlanner planner = makePlanner();
+    planner.reset(DAY);
+
+    ExposureSettings s = DAY;
+    float scene_ev     = RampPlanner::exposureValue(DAY);
+    float prev_ev      = planner.getPlannedEV();
+
+    for (int k = 0; k < 440; ++k)
+    {
+        scene_ev += 0.05f;
+        float meter = RampPlanner::exposureValue(s) - scene_ev;
+
+        ExposureSettings next = planner.plan(s, meter);
+
+        assert(std::abs(planner.getPlannedEV() - prev_ev) <= 1.0f / 3 + 1e-4f);
+        assert(next.shutter_speed <= 20000000);
+        assert(next.iso >= s.iso);
+        assert(next.aperture <= s.aperture);
+        // ISO only goes up once the shutter speed is at its limit
+        if (next.iso > s.iso)
+            assert(next.shutter_speed >= 8000000);
+
+        prev_ev = planner.getPlannedEV();
+        s       = next;
+    }
+
+    fmt::print("Sunset: {}us ISO {} f/{:.1f}, exposure error {:.2f} EV\n",
+               s.shutter_speed, s.iso, s.aperture / 100.0f,
+               RampPlanner::exposureValue(s) - scene_ev);
+
+    assert(s.iso == 6400);
+    assert(s.aperture < DAY.aperture);
+    assert(std::abs(RampPlanner::exposureValue(s) - scene_ev) < 0.5f);
+}
+
+/**
+ * Noisy readings of a constant scene must not cause continuous writes.
+ */
+void testNoise()
+{
+    RampPlanner planner = makePlanner();
+    ExposureSettings s{.shutter_speed = 8000000, .iso = 400, .aperture = 280};
+    planner.reset(s);
+
+    std::mt19937 rng{1};
+    std::normal_distribution<float> noise{0, 0.5f};
+
+    int writes = 0;
+    for (int k = 0; k < 200; ++k)
+    {
+        ExposureSettings next = planner.plan(s, noise(rng));
+        writes += RampPlanner::numWrites(s, next);
+        assert(next.iso == 400 && next.aperture == 280);
+        s = next;
+    }
+    fmt::print("Noise: {} writes in 200 frames\n", writes);
+    assert(writes < 100);
+}
+
+/**
+ * A scene oscillating around the point where the ISO has to change must not
+ * make the ISO toggle at every frame.
+ */
+void testHysteresis()
+{
+    RampPlanner planner = makePlanner();
+    ExposureSettings s{
+        .shutter_speed = 15000000, .iso = 100, .aperture = 800};
+    planner.reset(s);
+
+    float edge_ev  = RampPlanner::exposureValue(
+        {.shutter_speed = 20000000, .iso = 100, .aperture = 800});
+    int iso_writes = 0;
+    for (int k = 0; k < 100; ++k)
+    {
+        float scene_ev        = edge_ev + ((k / 5) % 2 ? 0.3f : -0.3f);
+        float meter           = RampPlanner::exposureValue(s) - scene_ev;
+        ExposureSettings next = planner.plan(s, meter);
+        iso_writes += next.iso != s.iso;
+        s = next;
+    }
+    fmt::print("Hysteresis: {} ISO changes\n", iso_writes);
+    assert(iso_writes <= 1);
+}
+
+int main()
+{
+    testSunset();
+    testNoise();
+    testHysteresis();
+
+    fmt::print("Ramp planner OK\n");
+    return 0;
+}
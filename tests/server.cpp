@@ -30,12 +30,11 @@ using namespace nlohmann;
 using namespace std;
 using std::chrono::seconds;
 
-void receive(json j)
+void receive(string_view packet)
 {
     PrintLogger log =  Logging::getLogger("Receive");
-    // string str = j.dump(4);
 
-    LOG_INFO(log, "Received json: {}", j.size());
+    LOG_INFO(log, "Received json: {}", packet.size());
 }
 
 int main()
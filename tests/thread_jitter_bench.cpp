@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/ActiveObject.h"
+#include "utils/ThreadSpec.h"
+#include "utils/logger/PrintLogger.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+static constexpr int DEFAULT_PERIODS     = 2000;
+static constexpr int PERIOD_US           = 1000;
+static constexpr unsigned int NUM_LOADS  = 4;
+
+/**
+ * Wakes up every PERIOD_US, like the camera thread timing a bulb exposure,
+ * and records how late it wakes up
+ */
+class PeriodicThread : public ActiveObject
+{
+public:
+    PeriodicThread(ThreadSpec spec, int periods)
+        : ActiveObject(spec), periods(periods)
+    {
+    }
+
+    vector<int64_t> lateness_us;
+
+protected:
+    void run() override
+    {
+        auto next = steady_clock::now();
+        for (int i = 0; i < periods; ++i)
+        {
+            next += microseconds(PERIOD_US);
+            std::this_thread::sleep_until(next);
+            lateness_us.push_back(
+                duration_cast<microseconds>(steady_clock::now() - next)
+                    .count());
+        }
+    }
+
+private:
+    int periods;
+};
+
+/**
+ * Formats log lines and flushes them to /dev/null without pausing, like the
+ * log sinks under a burst of records
+ */
+class LoadThread : public ActiveObject
+{
+public:
+    using ActiveObject::ActiveObject;
+
+protected:
+    void run() override
+    {
+        FILE* out = std::fopen("/dev/null", "w");
+        uint64_t n = 0;
+        while (!shouldStop())
+        {
+            string line = fmt::format("{:>8} INFO Bench > record {} {:.3f}\n",
+                                      n, n, n * 0.001);
+            std::fputs(line.c_str(), out);
+            if (++n % 64 == 0)
+                std::fflush(out);
+        }
+        std::fclose(out);
+    }
+};
+
+void measure(const char* name, const ThreadSpec& timer_spec,
+             const ThreadSpec& load_spec, int periods)
+{
+    vector<unique_ptr<LoadThread>> loads;
+    for (unsigned int i = 0; i < NUM_LOADS; ++i)
+    {
+        loads.push_back(std::make_unique<LoadThread>(load_spec));
+        loads.back()->start();
+    }
+
+    PeriodicThread timer{timer_spec, periods};
+    timer.start();
+    timer.stop();
+
+    for (auto& l : loads)
+        l->stop();
+
+    vector<int64_t>& l = timer.lateness_us;
+    std::sort(l.begin(), l.end());
+    fmt::print("{:>8}: lateness median {:5} us, p99 {:6} us, max {:6} us\n",
+               name, l[l.size() / 2], l[l.size() * 99 / 100], l.back());
+}
+
+/**
+ * Measures the wake up lateness of a periodic thread competing with threads
+ * formatting and flushing logs, with the default attributes and with the
+ * default specs of the camera and logging threads.
+ * Usage: thread_jitter_bench [periods]
+ */
+int main(int argc, char* argv[])
+{
+    int periods = argc > 1 ? std::atoi(argv[1]) : DEFAULT_PERIODS;
+
+    // Failures to set the attributes are printed
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+
+    measure("default", ThreadSpec{"timer"}, ThreadSpec{"load"}, periods);
+    measure("specs", ThreadSpecs::camera("timer"), ThreadSpecs::logging("load"),
+            periods);
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "utils/ActiveObject.h"
+#include "utils/Executor.h"
+#include "utils/ThreadSpec.h"
+#include "utils/logger/PrintLogger.h"
+
+using std::string;
+
+/**
+ * Records the attributes of its own thread
+ */
+class SpecProbe : public ActiveObject
+{
+public:
+    using ActiveObject::ActiveObject;
+
+    string name;
+    size_t stack_size = 0;
+    int policy        = -1;
+    int priority      = -1;
+    int nice          = 0;
+    cpu_set_t cpus;
+
+protected:
+    void run() override
+    {
+        pthread_t self = pthread_self();
+
+        char buf[16];
+        pthread_getname_np(self, buf, sizeof(buf));
+        name = buf;
+
+        pthread_attr_t attr;
+        pthread_getattr_np(self, &attr);
+        pthread_attr_getstacksize(&attr, &stack_size);
+        pthread_attr_destroy(&attr);
+
+        sched_param param{};
+        pthread_getschedparam(self, &policy, &param);
+        priority = param.sched_priority;
+
+        nice = getpriority(PRIO_PROCESS, gettid());
+        pthread_getaffinity_np(self, sizeof(cpus), &cpus);
+    }
+};
+
+class NamedTask : public ExecutorTask
+{
+public:
+    string name;
+    std::atomic_bool done{false};
+
+    void execute() override
+    {
+        char buf[16];
+        pthread_getname_np(pthread_self(), buf, sizeof(buf));
+        name = buf;
+        done = true;
+    }
+};
+
+/**
+ * Real time priority needs CAP_SYS_NICE: only checked where it can be set
+ */
+bool canUseFifo()
+{
+    bool ok = false;
+    std::thread t(
+        [&]
+        {
+            sched_param param{};
+            param.sched_priority = 1;
+            ok = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+        });
+    t.join();
+    return ok;
+}
+
+int main()
+{
+    Logging::getStdOutLogSink().disable();
+
+    // Default spec: inherited attributes
+    {
+        SpecProbe probe{};
+        probe.start();
+        probe.stop();
+        assert(probe.policy == SCHED_OTHER);
+        assert(probe.nice == getpriority(PRIO_PROCESS, 0));
+    }
+
+    // Time sharing: name (truncated), stack, nice value and affinity
+    {
+        ThreadSpec spec{};
+        spec.name       = "a-very-long-thread-name";
+        spec.stack_size = 1024 * 1024;
+        spec.nice       = 7;
+        spec.cpus       = {0};
+
+        SpecProbe probe{spec};
+        probe.start();
+        probe.stop();
+
+        assert(probe.name == "a-very-long-thr");
+        assert(probe.stack_size == spec.stack_size);
+        assert(probe.policy == SCHED_OTHER);
+        assert(probe.nice == 7);
+        assert(CPU_COUNT(&probe.cpus) == 1 && CPU_ISSET(0, &probe.cpus));
+    }
+
+    // Real time, set after construction
+    if (canUseFifo())
+    {
+        SpecProbe probe{};
+        probe.setThreadSpec(ThreadSpecs::camera("camera"));
+        probe.start();
+        probe.stop();
+
+        assert(probe.name == "camera");
+        assert(probe.policy == SCHED_FIFO);
+        assert(probe.priority == probe.getThreadSpec().priority);
+    }
+    else
+    {
+        fmt::print("SCHED_FIFO not permitted, skipped\n");
+    }
+
+    // Isolation: the camera never shares a CPU with logging and networking
+    ThreadSpec camera  = ThreadSpecs::camera("camera");
+    ThreadSpec logging = ThreadSpecs::logging("log");
+    ThreadSpec network = ThreadSpecs::network("comm");
+    for (unsigned int cpu : camera.cpus)
+    {
+        for (unsigned int other : logging.cpus)
+            assert(cpu != other);
+        for (unsigned int other : network.cpus)
+            assert(cpu != other);
+    }
+    assert(logging.nice > 0 && network.nice > 0);
+
+    // Several cameras do not share a CPU
+    if (std::thread::hardware_concurrency() > 1)
+    {
+        ThreadSpec second = ThreadSpecs::camera("camera-1", 1);
+        assert(camera.cpus.size() == 1 && second.cpus.size() == 1);
+        assert(camera.cpus[0] != second.cpus[0]);
+    }
+
+    // Executor workers are numbered
+    {
+        Executor executor{1, ThreadSpec{"worker"}};
+        executor.start();
+
+        NamedTask task;
+        executor.submit(&task);
+        while (!task.done)
+            std::this_thread::yield();
+        executor.stop();
+
+        assert(task.name == "worker-0");
+    }
+
+    fmt::print("Thread spec OK\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2022 Luca Erbetta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fmt/core.h>
+
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "EventBroker.h"
+#include "Events.h"
+#include "camera/SimulatedCamera.h"
+#include "camera/UsbHotplugMonitor.h"
+#include "event_waiter.h"
+#include "fsm/CameraController.h"
+#include "utils/EventSniffer.h"
+
+using namespace gphotow;
+using std::make_unique;
+using std::mutex;
+using std::ofstream;
+using std::string;
+using std::unique_lock;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::filesystem::path;
+
+static const string DEVICE = "/devices/pci0000:00/0000:00:14.0/usb1/1-2";
+
+EventWaiter waiter;
+int ready_count          = 0;
+int error_count          = 0;
+int32_t last_recovery_ms = 0;
+
+string uevent(std::initializer_list<string> entries)
+{
+    string msg;
+    for (auto& e : entries)
+    {
+        msg += e;
+        msg += '\0';
+    }
+    return msg;
+}
+
+void testParse()
+{
+    path sysfs = std::filesystem::temp_directory_path() / "hotplug_sysfs";
+    path dev   = sysfs / path{DEVICE}.relative_path();
+    std::filesystem::create_directories(dev);
+    ofstream{dev / "busnum"} << "1\n";
+    ofstream{dev / "devnum"} << "12\n";
+
+    UsbHotplugMonitor monitor{sysfs.string()};
+
+    string added = uevent({"add@" + DEVICE + "/1-2:1.0", "ACTION=add",
+                           "DEVPATH=" + DEVICE + "/1-2:1.0", "SUBSYSTEM=usb",
+                           "DEVTYPE=usb_interface", "INTERFACE=6/1/1"});
+    auto ev = monitor.parseUevent(added.data(), added.size());
+    assert(ev && ev->getID() == EventUsbDeviceAdded::id);
+    assert(dynamic_pointer_cast<const EventUsbDeviceAdded>(ev)->port ==
+           "usb:001,012");
+
+    // Not a camera
+    string keyboard = uevent({"add@" + DEVICE + "/1-2:1.0", "ACTION=add",
+                              "DEVPATH=" + DEVICE + "/1-2:1.0",
+                              "SUBSYSTEM=usb", "DEVTYPE=usb_interface",
+                              "INTERFACE=3/1/1"});
+    assert(!monitor.parseUevent(keyboard.data(), keyboard.size()));
+
+    string block = uevent({"add@/devices/virtual/block/loop0", "ACTION=add",
+                           "SUBSYSTEM=block"});
+    assert(!monitor.parseUevent(block.data(), block.size()));
+
+    string removed =
+        uevent({"remove@" + DEVICE, "ACTION=remove", "DEVPATH=" + DEVICE,
+                "SUBSYSTEM=usb", "DEVTYPE=usb_device", "BUSNUM=001",
+                "DEVNUM=012"});
+    ev = monitor.parseUevent(removed.data(), removed.size());
+    assert(ev && ev->getID() == EventUsbDeviceRemoved::id);
+    assert(dynamic_pointer_cast<const EventUsbDeviceRemoved>(ev)->port ==
+           "usb:001,012");
+
+    std::filesystem::remove_all(sysfs);
+}
+
+int main()
+{
+    testParse();
+
+    Logging::getStdOutLogSink().setLevel(LogLevel::LOGL_WARNING);
+    sBroker.start();
+
+    EventSniffer sniffer{
+        sEventBroker,
+        {TOPIC_CAMERA_EVENT, TOPIC_CAMERA_CONFIG},
+        [&](const EventPtr& ev, uint8_t topic)
+        {
+            {
+                unique_lock<mutex> lock(waiter.mtx);
+                if (ev->getID() == EventCameraReady::id)
+                    ++ready_count;
+                if (ev->getID() == EventCameraError::id)
+                    ++error_count;
+                if (ev->getID() == EventCameraControllerState::id)
+                    last_recovery_ms =
+                        dynamic_pointer_cast<const EventCameraControllerState>(
+                            ev)
+                            ->recovery_time_ms;
+            }
+            waiter.cv.notify_all();
+        }};
+
+    SimulatedCameraConfig cfg{};
+    cfg.connect_time = milliseconds(20);
+    cfg.config_rtt   = milliseconds(1);
+
+    auto sim             = make_unique<SimulatedCamera>(cfg);
+    SimulatedCamera& cam = *sim;
+
+    CameraController controller{"/tmp", std::move(sim)};
+    controller.start();
+
+    sBroker.post(EventCameraCmdConnect{}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, 1));
+
+    // Unplugging is noticed right away, without waiting for the next probe
+    auto unplug_time = steady_clock::now();
+    cam.setUnplugged(true);
+    sBroker.post(EventUsbDeviceRemoved{"usb:001,012"}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(error_count, 1));
+    auto detect_ms = duration_cast<milliseconds>(steady_clock::now() -
+                                                 unplug_time)
+                         .count();
+
+    // Plugging it back reconnects without waiting for the next retry
+    int readies = ready_count;
+    cam.setUnplugged(false);
+    auto plug_time = steady_clock::now();
+    sBroker.post(EventUsbDeviceAdded{"usb:001,013"}, TOPIC_CAMERA_CMD);
+    assert(waiter.waitFor(ready_count, readies + 1));
+    auto reconnect_ms =
+        duration_cast<milliseconds>(steady_clock::now() - plug_time).count();
+
+    fmt::print("Unplug detected in {} ms, reconnected in {} ms, recovery "
+               "time: {} ms\n",
+               detect_ms, reconnect_ms, last_recovery_ms);
+
+    assert(detect_ms < 200);
+    assert(reconnect_ms < 1000);
+    assert(last_recovery_ms > 0 && last_recovery_ms < 2000);
+    // Not bound to the port it was found on
+    assert(cam.getPort().empty());
+
+    controller.stop();
+    sBroker.stop();
+
+    fmt::print("USB hot-plug OK\n");
+    return 0;
+}